@@ -234,7 +234,9 @@ else:
         "bmesh.geometry",
         "bpy.app",
         "bpy.app.handlers",
+        "bpy.app.memory_profile",
         "bpy.app.timers",
+        "bpy.app.trace",
         "bpy.app.translations",
         "bpy.context",
         "bpy.data",
@@ -1943,7 +1945,9 @@ def write_rst_importable_modules(basepath):
         "bpy.app.handlers": "Application Handlers",
         "bpy.app.translations": "Application Translations",
         "bpy.app.icons": "Application Icons",
+        "bpy.app.memory_profile": "Application Memory Profiler",
         "bpy.app.timers": "Application Timers",
+        "bpy.app.trace": "Application Trace Recording",
         "bpy.props": "Property Definitions",
         "idprop.types": "ID Property Access",
         "mathutils": "Math Types & Utilities",
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+#
+# Copyright 2011-2020 Blender Foundation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Distributed rendering harness, not intended for end users.
+#
+# Starts a number of cycles_server processes on this machine and renders a scene with
+# cycles_standalone on the network device using all of them, for measuring how rendering
+# time scales with the number of servers and for testing recovery from servers going away.
+#
+# Example:
+#   cycles_network_harness.py --bin-dir build/bin --servers 1,2,4 --threads 2 scene.xml
+
+import argparse
+import os
+import subprocess
+import sys
+import threading
+import time
+
+
+def start_servers(args, num_servers):
+    servers = []
+    for i in range(num_servers):
+        port = args.port + i
+        command = [os.path.join(args.bin_dir, "cycles_server"),
+                   "--device", "CPU",
+                   "--port", str(port)]
+        if args.threads:
+            command += ["--threads", str(args.threads)]
+        servers.append(subprocess.Popen(command,
+                                        stdout=subprocess.DEVNULL,
+                                        stderr=subprocess.DEVNULL))
+
+    # Give servers time to start listening.
+    time.sleep(1.0)
+    return servers
+
+
+def stop_servers(servers):
+    for server in servers:
+        if server.poll() is None:
+            server.kill()
+        server.wait()
+
+
+def render(args, num_servers, output):
+    servers = start_servers(args, num_servers)
+    addresses = ",".join("127.0.0.1:%d" % (args.port + i) for i in range(num_servers))
+
+    env = dict(os.environ)
+    env["CYCLES_NETWORK_SERVERS"] = addresses
+
+    command = [os.path.join(args.bin_dir, "cycles"),
+               "--device", "NETWORK",
+               "--background",
+               "--quiet",
+               "--output", output]
+    if args.samples:
+        command += ["--samples", str(args.samples)]
+    command.append(args.scene)
+
+    # Kill one server part way through the render, its tiles must be rendered by the others.
+    killer = None
+    if args.kill_after > 0.0 and num_servers > 1:
+        killer = threading.Timer(args.kill_after, servers[-1].kill)
+        killer.start()
+
+    start_time = time.time()
+    result = subprocess.run(command, env=env)
+    elapsed = time.time() - start_time
+
+    if killer:
+        killer.cancel()
+    stop_servers(servers)
+
+    return result.returncode, elapsed
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Distributed rendering harness")
+    parser.add_argument("scene", help="Cycles XML scene to render")
+    parser.add_argument("--bin-dir", default=".",
+                        help="Directory containing the cycles and cycles_server executables")
+    parser.add_argument("--servers", default="1,2,4",
+                        help="Comma separated numbers of servers to render with")
+    parser.add_argument("--port", type=int, default=5200,
+                        help="Port of the first server, the others use the following ports")
+    parser.add_argument("--threads", type=int, default=0,
+                        help="Number of render threads per server")
+    parser.add_argument("--samples", type=int, default=0,
+                        help="Number of samples, defaults to the scene settings")
+    parser.add_argument("--kill-after", type=float, default=0.0,
+                        help="Kill one server this many seconds into each render")
+    parser.add_argument("--output-dir", default=".",
+                        help="Directory to write rendered images to")
+    args = parser.parse_args()
+
+    baseline = None
+    failed = False
+
+    for num_servers in [int(n) for n in args.servers.split(",")]:
+        output = os.path.join(args.output_dir, "network_%d.png" % num_servers)
+        returncode, elapsed = render(args, num_servers, output)
+
+        if returncode != 0:
+            print("%d servers: render failed with exit code %d" % (num_servers, returncode))
+            failed = True
+            continue
+
+        # Speedup relative to the first run, scaled as if it had used a single server.
+        if baseline is None:
+            baseline = elapsed * num_servers
+
+        print("%d servers: %.2fs, %.2fx speedup" % (num_servers, elapsed, baseline / elapsed))
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -37,7 +37,7 @@ int main(int argc, const char **argv)
   string devicelist = "";
   string devicename = "cpu";
   bool list = false, debug = false;
-  int threads = 0, verbosity = 1;
+  int threads = 0, verbosity = 1, port = 0;
 
   vector<DeviceType> &types = Device::available_types();
 
@@ -61,6 +61,9 @@ int main(int argc, const char **argv)
              "--threads %d",
              &threads,
              "Number of threads to use for CPU device",
+             "--port %d",
+             &port,
+             "Port to listen on, defaults to 5120",
 #ifdef WITH_CYCLES_LOGGING
              "--debug",
              &debug,
@@ -112,7 +115,7 @@ int main(int argc, const char **argv)
     Stats stats;
     Device *device = Device::create(device_info, stats, true);
     printf("Cycles Server with device: %s\n", device->info.description.c_str());
-    device->server_run();
+    device->server_run(port);
     delete device;
   }
 
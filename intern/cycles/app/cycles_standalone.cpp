@@ -19,10 +19,13 @@
 #include "device/device.h"
 #include "render/buffers.h"
 #include "render/camera.h"
+#include "render/film.h"
 #include "render/integrator.h"
 #include "render/scene.h"
 #include "render/session.h"
+#include "render/stats.h"
 
+#include "util/util_algorithm.h"
 #include "util/util_args.h"
 #include "util/util_foreach.h"
 #include "util/util_function.h"
@@ -54,6 +57,8 @@ struct Options {
   bool quiet;
   bool show_help, interactive, pause;
   string output_path;
+  bool benchmark;
+  string benchmark_output;
 } options;
 
 static void session_print(const string &str)
@@ -91,6 +96,10 @@ static void session_print_status()
 
 static bool write_render(const uchar *pixels, int w, int h, int channels)
 {
+  if (options.output_path.empty()) {
+    return false;
+  }
+
   string msg = string_printf("Writing image %s", options.output_path.c_str());
   session_print(msg);
 
@@ -120,6 +129,7 @@ static BufferParams &session_buffer_params()
   buffer_params.height = options.height;
   buffer_params.full_width = options.width;
   buffer_params.full_height = options.height;
+  buffer_params.denoising_data_pass = options.session_params.denoising.use;
 
   return buffer_params;
 }
@@ -143,6 +153,12 @@ static void scene_init()
 
   /* Calculate Viewplane */
   options.scene->camera->compute_auto_viewplane();
+
+  /* Denoising needs feature passes written while rendering. */
+  if (options.session_params.denoising.use) {
+    options.scene->film->denoising_data_pass = true;
+    options.scene->film->tag_update(options.scene);
+  }
 }
 
 static void session_init()
@@ -355,6 +371,192 @@ static void keyboard(unsigned char key)
 }
 #endif
 
+/* Benchmark
+ *
+ * Renders a fixed set of scenes on the CPU with fixed settings and reports timings and
+ * profiling statistics as JSON, for comparing performance between builds. Scenes are read
+ * from the benchmark directory next to the executable, or the directory given on the
+ * command line. */
+
+static const struct BenchmarkScene {
+  const char *filename;
+  int samples;
+} benchmark_scenes[] = {
+    {"cornell_box.xml", 64},
+    {"subdivision.xml", 16},
+    {"textures.xml", 32},
+    {"node_chains.xml", 32},
+};
+
+struct BenchmarkResult {
+  string name;
+  int width, height, samples;
+  double sync_time;
+  RenderStats stats;
+};
+
+static string json_string(const string &str)
+{
+  string result = "\"";
+  foreach (char c, str) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    }
+    else if ((unsigned char)c < 0x20) {
+      result += string_printf("\\u%04x", (int)c);
+    }
+    else {
+      result += c;
+    }
+  }
+  return result + "\"";
+}
+
+static string json_kernel_stats(const NamedNestedSampleStats &stats, const string &indent)
+{
+  /* Profiler samples are taken every millisecond per thread. */
+  string result = "{\n";
+  result += indent + "  \"name\": " + json_string(stats.name) + ",\n";
+  result += indent + string_printf("  \"time\": %.3f,\n", stats.sum_samples * 0.001);
+  result += indent + string_printf("  \"self_time\": %.3f,\n", stats.self_samples * 0.001);
+  result += indent + "  \"entries\": [";
+  for (size_t i = 0; i < stats.entries.size(); i++) {
+    result += (i == 0) ? "\n" : ",\n";
+    result += indent + "    " + json_kernel_stats(stats.entries[i], indent + "    ");
+  }
+  result += (stats.entries.empty()) ? "]\n" : "\n" + indent + "  ]\n";
+  return result + indent + "}";
+}
+
+static bool json_name_compare(const NamedSampleCountPair &a, const NamedSampleCountPair &b)
+{
+  return a.name < b.name;
+}
+
+static string json_sample_count_stats(const NamedSampleCountStats &stats, const string &indent)
+{
+  /* Sort by name, so the output order does not change between runs. */
+  vector<NamedSampleCountPair> entries;
+  foreach (NamedSampleCountStats::entry_map::const_reference entry, stats.entries) {
+    entries.push_back(entry.second);
+  }
+  sort(entries.begin(), entries.end(), json_name_compare);
+
+  string result = "[";
+  for (size_t i = 0; i < entries.size(); i++) {
+    result += (i == 0) ? "\n" : ",\n";
+    result += indent + string_printf("  {\"name\": %s, \"time\": %.3f, \"hits\": %llu}",
+                                     json_string(entries[i].name.string()).c_str(),
+                                     entries[i].samples * 0.001,
+                                     (unsigned long long)entries[i].hits);
+  }
+  return result + ((entries.empty()) ? "]" : "\n" + indent + "]");
+}
+
+static string json_benchmark_result(BenchmarkResult &result)
+{
+  const TimeStats &time = result.stats.time;
+  result.stats.kernel.update_sum();
+
+  string json = "    {\n";
+  json += "      \"name\": " + json_string(result.name) + ",\n";
+  json += string_printf("      \"width\": %d,\n", result.width);
+  json += string_printf("      \"height\": %d,\n", result.height);
+  json += string_printf("      \"samples\": %d,\n", result.samples);
+  json += "      \"time\": {\n";
+  json += string_printf("        \"sync\": %.3f,\n", result.sync_time);
+  json += string_printf("        \"scene_update\": %.3f,\n", time.scene_update);
+  json += string_printf("        \"bvh_build\": %.3f,\n", time.bvh_build);
+  json += string_printf("        \"texture_load\": %.3f,\n", time.image_load);
+  json += string_printf("        \"render\": %.3f,\n", time.render);
+  json += string_printf("        \"denoise\": %.3f\n", time.denoise);
+  json += "      },\n";
+  json += "      \"kernel\": " + json_kernel_stats(result.stats.kernel, "      ") + ",\n";
+  json += "      \"shaders\": " + json_sample_count_stats(result.stats.shaders, "      ") + ",\n";
+  json += "      \"objects\": " + json_sample_count_stats(result.stats.objects, "      ") + "\n";
+  json += "    }";
+  return json;
+}
+
+static bool benchmark_run()
+{
+  const string directory = (options.filepath != "") ? options.filepath : path_get("benchmark");
+  vector<BenchmarkResult> results;
+
+  for (const BenchmarkScene &bench : benchmark_scenes) {
+    options.filepath = path_join(directory, bench.filename);
+    options.session_params.samples = bench.samples;
+    options.width = 0;
+    options.height = 0;
+
+    if (!path_exists(options.filepath)) {
+      fprintf(stderr, "Benchmark scene not found: %s\n", options.filepath.c_str());
+      return false;
+    }
+
+    BenchmarkResult result;
+    result.name = path_filename(options.filepath);
+    result.samples = bench.samples;
+
+    options.session_params.write_render_cb = write_render;
+    options.session = new Session(options.session_params);
+
+    {
+      scoped_timer sync_timer(&result.sync_time);
+      scene_init();
+    }
+    options.session->scene = options.scene;
+
+    result.width = options.width;
+    result.height = options.height;
+
+    options.session->reset(session_buffer_params(), options.session_params.samples);
+    options.session->start();
+    options.session->wait();
+
+    if (options.session->progress.get_error()) {
+      fprintf(stderr,
+              "Benchmark scene %s failed: %s\n",
+              result.name.c_str(),
+              options.session->progress.get_error_message().c_str());
+      session_exit();
+      return false;
+    }
+
+    options.session->collect_statistics(&result.stats);
+    session_exit();
+
+    results.push_back(result);
+  }
+
+  string json = "{\n";
+  json += "  \"version\": " + json_string(CYCLES_VERSION_STRING) + ",\n";
+  json += "  \"device\": " + json_string(options.session_params.device.description) + ",\n";
+  json += string_printf("  \"threads\": %d,\n", options.session_params.threads);
+  json += "  \"scenes\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    json += (i == 0) ? "\n" : ",\n";
+    json += json_benchmark_result(results[i]);
+  }
+  json += "\n  ]\n}\n";
+
+  FILE *f = (options.benchmark_output != "") ? fopen(options.benchmark_output.c_str(), "w") :
+                                                stdout;
+  if (!f) {
+    fprintf(stderr, "Failed to write benchmark results to %s\n", options.benchmark_output.c_str());
+    return false;
+  }
+
+  fputs(json.c_str(), f);
+
+  if (f != stdout) {
+    fclose(f);
+  }
+
+  return true;
+}
+
 static int files_parse(int argc, const char *argv[])
 {
   if (argc > 0)
@@ -370,6 +572,7 @@ static void options_parse(int argc, const char **argv)
   options.filepath = "";
   options.session = NULL;
   options.quiet = false;
+  options.benchmark = false;
 
   /* device names */
   string device_names = "";
@@ -432,6 +635,13 @@ static void options_parse(int argc, const char **argv)
              "--tile-height %d",
              &options.session_params.tile_size.y,
              "Tile height in pixels",
+             "--benchmark",
+             &options.benchmark,
+             "Render the benchmark scenes on the CPU and print timings as JSON, optionally "
+             "reading the scenes from the given directory",
+             "--benchmark-output %s",
+             &options.benchmark_output,
+             "File path to write benchmark results to, instead of standard output",
              "--list-devices",
              &list,
              "List information about all available devices",
@@ -479,7 +689,7 @@ static void options_parse(int argc, const char **argv)
     printf("%s\n", CYCLES_VERSION_STRING);
     exit(EXIT_SUCCESS);
   }
-  else if (help || options.filepath == "") {
+  else if (help || (options.filepath == "" && !options.benchmark)) {
     ap.usage();
     exit(EXIT_SUCCESS);
   }
@@ -496,6 +706,20 @@ static void options_parse(int argc, const char **argv)
   /* Use progressive rendering */
   options.session_params.progressive = true;
 
+  if (options.benchmark) {
+    /* Fixed settings, so results only depend on the build and the machine. Sample counts are
+     * set per scene, and threads may be set to match the machine the benchmark runs on. */
+    devicename = "CPU";
+    options.quiet = true;
+    options.output_path = "";
+    options.session_params.background = true;
+    options.session_params.progressive = false;
+    options.session_params.use_profiling = true;
+    options.session_params.tile_size = make_int2(64, 64);
+    options.session_params.denoising.use = true;
+    options.session_params.denoising.type = DENOISER_NLM;
+  }
+
   /* find matching device */
   DeviceType device_type = Device::type_from_string(devicename.c_str());
   vector<DeviceInfo> devices = Device::available_devices(DEVICE_MASK(device_type));
@@ -526,7 +750,7 @@ static void options_parse(int argc, const char **argv)
     fprintf(stderr, "Invalid number of samples: %d\n", options.session_params.samples);
     exit(EXIT_FAILURE);
   }
-  else if (options.filepath == "") {
+  else if (options.filepath == "" && !options.benchmark) {
     fprintf(stderr, "No file path specified\n");
     exit(EXIT_FAILURE);
   }
@@ -545,6 +769,10 @@ int main(int argc, const char **argv)
   path_init();
   options_parse(argc, argv);
 
+  if (options.benchmark) {
+    return benchmark_run() ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
 #ifdef WITH_CYCLES_STANDALONE_GUI
   if (options.session_params.background) {
 #endif
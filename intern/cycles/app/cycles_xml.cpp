@@ -202,6 +202,9 @@ static void xml_read_camera(XMLReadState &state, xml_node node)
 
   cam->need_update = true;
   cam->update(state.scene);
+
+  /* Dice subdivision surfaces for the render camera. */
+  *state.scene->dicing_camera = *cam;
 }
 
 /* Shader */
@@ -397,6 +400,13 @@ static void xml_read_mesh(const XMLReadState &state, xml_node node)
   Mesh *mesh = xml_add_mesh(state.scene, state.tfm);
   mesh->used_shaders.push_back(state.shader);
 
+  /* optional name, used for statistics */
+  string object_name;
+  if (xml_read_string(&object_name, node, "name")) {
+    mesh->name = ustring(object_name);
+    state.scene->objects.back()->name = ustring(object_name);
+  }
+
   /* read state */
   int shader = 0;
   bool smooth = state.smooth;
@@ -412,6 +412,25 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         default=0,
     )
 
+    use_path_guiding: BoolProperty(
+        name="Use Path Guiding",
+        description="Learn the distribution of incident light while rendering and use it to guide indirect rays towards bright regions "
+        "(CPU path tracing only)",
+        default=False,
+    )
+    path_guiding_training_samples: IntProperty(
+        name="Path Guiding Training Samples",
+        description="Number of AA samples during which the light distribution is learned, later samples use the final distribution",
+        min=1, max=(1 << 24),
+        default=128,
+    )
+    path_guiding_fraction: FloatProperty(
+        name="Path Guiding Fraction",
+        description="Probability of sampling directions from the learned light distribution rather than the BSDF",
+        min=0.0, max=1.0,
+        default=0.5,
+    )
+
     min_light_bounces: IntProperty(
             name="Min Light Bounces",
             description="Minimum number of light bounces. Setting this higher reduces noise in the first bounces, "
@@ -548,6 +567,19 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         min=1.0, soft_max=25.0,
         default=4.0,
     )
+    use_dice_cache: BoolProperty(
+        name="Dice Cache",
+        description="Reuse diced geometry of meshes that did not change since the previous update, "
+        "in the viewport and for animation renders with persistent data",
+        default=True,
+    )
+    dice_cache_memory: IntProperty(
+        name="Dice Cache Memory",
+        description="Maximum memory in megabytes used for cached diced geometry, least recently "
+        "used meshes are removed from the cache first",
+        min=1, soft_max=4096,
+        default=512,
+    )
 
     film_exposure: FloatProperty(
         name="Exposure",
@@ -702,6 +734,13 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         "but time can be saved by manually stopping the render when the noise is low enough)",
         default=False,
     )
+    use_compact_tile_buffers: BoolProperty(
+        name="Compact Tile Buffers",
+        description="Keep tiles that are waiting to be denoised at reduced precision, "
+        "using half floats for colors and quantized normals, denoising features stay float "
+        "(reduces memory usage when denoising large images with many passes)",
+        default=False,
+    )
 
     bake_type: EnumProperty(
         name="Bake Type",
@@ -248,6 +248,37 @@ class CYCLES_RENDER_PT_sampling_adaptive(CyclesButtonsPanel, Panel):
         col.prop(cscene, "adaptive_min_samples", text="Min Samples")
 
 
+class CYCLES_RENDER_PT_sampling_path_guiding(CyclesButtonsPanel, Panel):
+    bl_label = "Path Guiding"
+    bl_parent_id = "CYCLES_RENDER_PT_sampling"
+    bl_options = {'DEFAULT_CLOSED'}
+
+    @classmethod
+    def poll(cls, context):
+        return use_cpu(context) and not use_branched_path(context)
+
+    def draw_header(self, context):
+        layout = self.layout
+        scene = context.scene
+        cscene = scene.cycles
+
+        layout.prop(cscene, "use_path_guiding", text="")
+
+    def draw(self, context):
+        layout = self.layout
+        layout.use_property_split = True
+        layout.use_property_decorate = False
+
+        scene = context.scene
+        cscene = scene.cycles
+
+        layout.active = cscene.use_path_guiding
+
+        col = layout.column(align=True)
+        col.prop(cscene, "path_guiding_training_samples", text="Training Samples")
+        col.prop(cscene, "path_guiding_fraction", text="Fraction")
+
+
 class CYCLES_RENDER_PT_sampling_denoising(CyclesButtonsPanel, Panel):
     bl_label = "Denoising"
     bl_parent_id = "CYCLES_RENDER_PT_sampling"
@@ -409,6 +440,13 @@ class CYCLES_RENDER_PT_subdivision(CyclesButtonsPanel, Panel):
         col.prop(cscene, "offscreen_dicing_scale", text="Offscreen Scale")
         col.prop(cscene, "max_subdivisions")
 
+        col.separator()
+
+        col.prop(cscene, "use_dice_cache")
+        sub = col.column()
+        sub.active = cscene.use_dice_cache
+        sub.prop(cscene, "dice_cache_memory", text="Memory")
+
         col.prop(cscene, "dicing_camera")
 
 
@@ -690,6 +728,10 @@ class CYCLES_RENDER_PT_performance_tiles(CyclesButtonsPanel, Panel):
         sub.active = not rd.use_save_buffers
         sub.prop(cscene, "use_progressive_refine")
 
+        sub = col.column()
+        sub.active = not cscene.use_progressive_refine
+        sub.prop(cscene, "use_compact_tile_buffers")
+
 
 class CYCLES_RENDER_PT_performance_acceleration_structure(CyclesButtonsPanel, Panel):
     bl_label = "Acceleration Structure"
@@ -2270,6 +2312,7 @@ classes = (
     CYCLES_RENDER_PT_sampling,
     CYCLES_RENDER_PT_sampling_sub_samples,
     CYCLES_RENDER_PT_sampling_adaptive,
+    CYCLES_RENDER_PT_sampling_path_guiding,
     CYCLES_RENDER_PT_sampling_denoising,
     CYCLES_RENDER_PT_sampling_advanced,
     CYCLES_RENDER_PT_light_paths,
@@ -308,6 +308,10 @@ void BlenderSync::sync_integrator()
   integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
   integrator->light_sampling_threshold = get_float(cscene, "light_sampling_threshold");
 
+  integrator->use_path_guiding = get_boolean(cscene, "use_path_guiding");
+  integrator->path_guiding_training_samples = get_int(cscene, "path_guiding_training_samples");
+  integrator->path_guiding_fraction = get_float(cscene, "path_guiding_fraction");
+
   if (RNA_boolean_get(&cscene, "use_adaptive_sampling")) {
     integrator->sampling_pattern = SAMPLING_PATTERN_PMJ;
     integrator->adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
@@ -783,6 +787,12 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene, bool background)
     params.texture_limit = 0;
   }
 
+  /* Diced geometry can only be reused by later updates of the same scene, which a single
+   * frame final render never has. */
+  params.use_dice_cache = get_boolean(cscene, "use_dice_cache") &&
+                          (!background || params.persistent_data);
+  params.dice_cache_memory = (size_t)get_int(cscene, "dice_cache_memory") * 1024 * 1024;
+
   params.bvh_layout = DebugFlags().cpu.bvh_layout;
 
   params.background = background;
@@ -910,6 +920,8 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine &b_engine,
   if (b_r.use_save_buffers())
     params.progressive_refine = false;
 
+  params.compact_tile_buffers = get_boolean(cscene, "use_compact_tile_buffers");
+
   if (background) {
     if (params.progressive_refine)
       params.progressive = true;
@@ -398,9 +398,13 @@ Device *Device::create(DeviceInfo &info, Stats &stats, Profiler &profiler, bool
       break;
 #endif
 #ifdef WITH_NETWORK
-    case DEVICE_NETWORK:
-      device = device_network_create(info, stats, profiler, "127.0.0.1");
+    case DEVICE_NETWORK: {
+      /* Comma separated list of render servers, each as host[:port]. */
+      const char *servers = getenv("CYCLES_NETWORK_SERVERS");
+      device = device_network_create(
+          info, stats, profiler, (servers && servers[0]) ? servers : "127.0.0.1");
       break;
+    }
 #endif
 #ifdef WITH_OPENCL
     case DEVICE_OPENCL:
@@ -425,8 +425,8 @@ class Device {
   }
 
 #ifdef WITH_NETWORK
-  /* networking */
-  void server_run();
+  /* networking, port 0 listens on the default server port */
+  void server_run(int port = 0);
 #endif
 
   /* multi device */
@@ -27,6 +27,7 @@
 #include "device/device.h"
 #include "device/device_denoising.h"
 #include "device/device_intern.h"
+#include "device/device_path_guiding.h"
 #include "device/device_split_kernel.h"
 
 // clang-format off
@@ -186,6 +187,8 @@ class CPUDevice : public Device {
 
   bool use_split_kernel;
 
+  PathGuiding path_guiding;
+
   DeviceRequestedFeatures requested_features;
 
   KernelFunctions<void (*)(KernelGlobals *, float *, int, int, int, int, int)> path_trace_kernel;
@@ -459,6 +462,14 @@ class CPUDevice : public Device {
   void const_copy_to(const char *name, void *host, size_t size)
   {
     kernel_const_copy(&kernel_globals, name, host, size);
+
+    if (strcmp(name, "__data") == 0) {
+      /* Scene changed, the learned radiance field is no longer valid. */
+      const KernelData *data = &kernel_globals.__data;
+      path_guiding.reset(data->integrator.use_path_guiding && !use_split_kernel,
+                         (int)data->cam.width * (int)data->cam.height,
+                         data->integrator.path_guiding_training_samples);
+    }
   }
 
   void global_alloc(device_memory &mem)
@@ -910,6 +921,10 @@ class CPUDevice : public Device {
       }
 
       if (tile.task == RenderTile::PATH_TRACE) {
+        /* Pick up the latest learned field for every pass, so it is refined while
+         * rendering the first samples of the tile. */
+        kg->path_guiding = path_guiding.acquire();
+
         for (int y = tile.y; y < tile.y + tile.h; y++) {
           for (int x = tile.x; x < tile.x + tile.w; x++) {
             if (use_coverage) {
@@ -918,6 +933,9 @@ class CPUDevice : public Device {
             path_trace_kernel()(kg, render_buffer, sample, x, y, tile.offset, tile.stride);
           }
         }
+
+        path_guiding.release(kg->path_guiding, tile.w * tile.h);
+        kg->path_guiding = NULL;
       }
       else {
         for (int y = tile.y; y < tile.y + tile.h; y++) {
@@ -1432,6 +1450,8 @@ class CPUDevice : public Device {
     }
     kg.decoupled_volume_steps_index = 0;
     kg.coverage_asset = kg.coverage_object = kg.coverage_material = NULL;
+    kg.path_guiding = NULL;
+    kg.path_guiding_num_vertices = -1;
 #ifdef WITH_OSL
     OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
 #endif
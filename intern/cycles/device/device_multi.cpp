@@ -127,8 +127,10 @@ class MultiDevice : public Device {
 
     foreach (string &server, servers) {
       Device *device = device_network_create(info, stats, profiler, server.c_str());
-      if (device)
-        devices.push_back(SubDevice(device));
+      if (device) {
+        devices.emplace_back();
+        devices.back().device = device;
+      }
     }
 #endif
   }
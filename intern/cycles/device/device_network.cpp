@@ -18,11 +18,21 @@
 #include "device/device.h"
 #include "device/device_intern.h"
 
+#include "util/util_algorithm.h"
+#include "util/util_deque.h"
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
+#include "util/util_md5.h"
+#include "util/util_set.h"
+#include "util/util_time.h"
+#include "util/util_unique_ptr.h"
+
+#include <atomic>
 
 #if defined(WITH_NETWORK)
 
+#  include <zlib.h>
+
 CCL_NAMESPACE_BEGIN
 
 typedef map<device_ptr, device_ptr> PtrMap;
@@ -41,14 +51,207 @@ static TileList::iterator tile_list_find(TileList &tile_list, RenderTile &tile)
   return tile_list.end();
 }
 
-class NetworkDevice : public Device {
+/* Scene Data Transfer
+ *
+ * Buffers above a minimum size are identified by their hash, and servers keep the compressed
+ * data of recently received buffers around. Re-rendering the same scene, or rendering it on a
+ * server that already received it from another client, then only needs the hash sent. */
+
+static const size_t NETWORK_CACHE_MIN_SIZE = 64 * 1024;
+static const size_t NETWORK_COMPRESS_BLOCK_SIZE = 64 * 1024 * 1024;
+static const size_t SERVER_CACHE_SIZE = 1024 * 1024 * 1024;
+
+static string network_data_hash(const void *data, size_t size)
+{
+  MD5Hash md5;
+
+  /* Append in blocks, MD5Hash takes the size as int. */
+  const uint8_t *bytes = (const uint8_t *)data;
+  for (size_t offset = 0; offset < size; offset += NETWORK_COMPRESS_BLOCK_SIZE) {
+    md5.append(bytes + offset, (int)min(NETWORK_COMPRESS_BLOCK_SIZE, size - offset));
+  }
+
+  return md5.get_hex() + string_printf("-%zu", size);
+}
+
+/* Compressed data is a sequence of blocks, each prefixed by its raw and compressed size. */
+static void network_data_compress(const void *data, size_t size, DataVector &compressed)
+{
+  const uint8_t *bytes = (const uint8_t *)data;
+  compressed.clear();
+
+  for (size_t offset = 0; offset < size; offset += NETWORK_COMPRESS_BLOCK_SIZE) {
+    const uLong block_size = min(NETWORK_COMPRESS_BLOCK_SIZE, size - offset);
+    const size_t header_offset = compressed.size();
+    uint32_t header[2] = {(uint32_t)block_size, 0};
+
+    uLongf compressed_size = compressBound(block_size);
+    compressed.resize(header_offset + sizeof(header) + compressed_size);
+    compress2(&compressed[header_offset + sizeof(header)],
+              &compressed_size,
+              bytes + offset,
+              block_size,
+              Z_BEST_SPEED);
+
+    header[1] = (uint32_t)compressed_size;
+    memcpy(&compressed[header_offset], header, sizeof(header));
+    compressed.resize(header_offset + sizeof(header) + compressed_size);
+  }
+}
+
+static bool network_data_decompress(const DataVector &compressed, void *data, size_t size)
+{
+  uint8_t *bytes = (uint8_t *)data;
+  size_t offset = 0, data_offset = 0;
+
+  while (offset < compressed.size()) {
+    uint32_t header[2];
+    if (offset + sizeof(header) > compressed.size()) {
+      return false;
+    }
+
+    memcpy(header, &compressed[offset], sizeof(header));
+    offset += sizeof(header);
+
+    if (data_offset + header[0] > size || offset + header[1] > compressed.size()) {
+      return false;
+    }
+
+    uLongf block_size = header[0];
+    if (uncompress(bytes + data_offset, &block_size, &compressed[offset], header[1]) != Z_OK ||
+        block_size != header[0]) {
+      return false;
+    }
+
+    offset += header[1];
+    data_offset += block_size;
+  }
+
+  return data_offset == size;
+}
+
+/* Connection to a single render server. */
+
+class NetworkConnection {
  public:
+  explicit NetworkConnection(const string &address_)
+      : socket(io_service),
+        address(address_),
+        failed(false),
+        busy_time(0.0),
+        task_start_time(0.0),
+        completed_work(0.0),
+        num_tiles(0),
+        num_stolen_tiles(0)
+  {
+    error_func = NetworkError();
+
+    string host = address;
+    string port = string_printf("%d", SERVER_PORT);
+
+    size_t port_separator = address.rfind(':');
+    if (port_separator != string::npos) {
+      host = address.substr(0, port_separator);
+      port = address.substr(port_separator + 1);
+    }
+
+    try {
+      tcp::resolver resolver(io_service);
+      tcp::resolver::query query(host, port);
+      tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
+      tcp::resolver::iterator end;
+
+      boost::system::error_code error = boost::asio::error::host_not_found;
+      while (error && endpoint_iterator != end) {
+        socket.close();
+        socket.connect(*endpoint_iterator++, error);
+      }
+
+      if (error)
+        error_func.network_error(error.message());
+    }
+    catch (exception &e) {
+      error_func.network_error(e.what());
+    }
+
+    failed = error_func.have_error();
+  }
+
+  /* Rendered pixel samples per second, zero while unknown. */
+  double throughput() const
+  {
+    double time = busy_time;
+    if (task_start_time != 0.0) {
+      time += time_dt() - task_start_time;
+    }
+
+    return (time > 0.0 && completed_work > 0.0) ? completed_work / time : 0.0;
+  }
+
+  double queued_work() const
+  {
+    double work = 0.0;
+    foreach (const RenderTile &tile, queue) {
+      work += (double)tile.w * tile.h * tile.num_samples;
+    }
+    return work;
+  }
+
   boost::asio::io_service io_service;
   tcp::socket socket;
+  NetworkError error_func;
+  string address;
+  bool failed;
+
+  /* Messages from the server are only read with the receive lock held, so requests that wait
+   * for a reply hold both. The server never sends a message of its own while a request of ours
+   * is in flight, as it waits for a reply to its tile requests before sending the next one. */
+  thread_mutex send_lock;
+  thread_mutex receive_lock;
+
+  /* Tiles acquired ahead for this server, and the tiles it is rendering. */
+  deque<RenderTile> queue;
+  TileList tiles;
+
+  /* Statistics for scheduling. */
+  double busy_time;
+  double task_start_time;
+  double completed_work;
+  int num_tiles;
+  int num_stolen_tiles;
+};
+
+/* Seconds a server may take to send its next message while serving tiles, in addition to the
+ * time it is expected to take for the tiles it holds. A server that takes longer is handled
+ * like one that disconnected. */
+static const double SERVE_TILES_TIMEOUT = 120.0;
+
+/* Network Device
+ *
+ * Renders with one or more servers. Scene data is sent to every server and tiles are handed
+ * out as servers ask for them. Each server gets a few tiles ahead depending on its measured
+ * throughput, and a server that runs out of work steals queued tiles from the server that
+ * would take longest to get to them. Tiles of a server that disconnects are rendered by the
+ * remaining servers. */
+
+class NetworkDevice : public Device {
+ public:
+  vector<NetworkConnection *> connections;
   device_ptr mem_counter;
   DeviceTask the_task; /* todo: handle multiple tasks */
 
-  thread_mutex rpc_lock;
+  /* Tile scheduling across servers. */
+  thread_mutex tile_mutex;
+  deque<RenderTile> retry_tiles;
+  /* Read by threads uploading memory while tiles are served. */
+  std::atomic<bool> in_task_wait;
+
+  /* Servers that rendered into a buffer since it was last uploaded or zeroed, results are
+   * read back from them. */
+  map<device_ptr, set<NetworkConnection *>> buffer_owners;
+  /* Contents of render buffers as last uploaded to every server, which is part of the data
+   * read back from each owner and must only be counted once. */
+  map<device_ptr, vector<float>> buffer_uploads;
 
   virtual bool show_samples() const
   {
@@ -56,33 +259,40 @@ class NetworkDevice : public Device {
   }
 
   NetworkDevice(DeviceInfo &info, Stats &stats, Profiler &profiler, const char *address)
-      : Device(info, stats, profiler, true), socket(io_service)
+      : Device(info, stats, profiler, true), mem_counter(0), in_task_wait(false)
   {
-    error_func = NetworkError();
-    stringstream portstr;
-    portstr << SERVER_PORT;
+    vector<string> addresses;
+    string_split(addresses, address, ", ");
 
-    tcp::resolver resolver(io_service);
-    tcp::resolver::query query(address, portstr.str());
-    tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
-    tcp::resolver::iterator end;
+    foreach (const string &server_address, addresses) {
+      NetworkConnection *conn = new NetworkConnection(server_address);
 
-    boost::system::error_code error = boost::asio::error::host_not_found;
-    while (error && endpoint_iterator != end) {
-      socket.close();
-      socket.connect(*endpoint_iterator++, error);
-    }
+      if (conn->failed) {
+        LOG(WARNING) << "Failed to connect to render server " << server_address << ".";
+      }
+      else {
+        VLOG(1) << "Connected to render server " << server_address << ".";
+      }
 
-    if (error)
-      error_func.network_error(error.message());
+      connections.push_back(conn);
+    }
 
-    mem_counter = 0;
+    if (live_connections().empty()) {
+      set_error("Failed to connect to any render server");
+    }
   }
 
   ~NetworkDevice()
   {
-    RPCSend snd(socket, &error_func, "stop");
-    snd.write();
+    foreach (NetworkConnection *conn, live_connections()) {
+      thread_scoped_lock lock(conn->send_lock);
+      RPCSend snd(conn->socket, &conn->error_func, "stop");
+      snd.write();
+    }
+
+    foreach (NetworkConnection *conn, connections) {
+      delete conn;
+    }
   }
 
   virtual BVHLayoutMask get_bvh_layout_mask() const
@@ -90,6 +300,67 @@ class NetworkDevice : public Device {
     return BVH_LAYOUT_BVH2;
   }
 
+  vector<NetworkConnection *> live_connections()
+  {
+    thread_scoped_lock lock(tile_mutex);
+
+    vector<NetworkConnection *> live;
+    foreach (NetworkConnection *conn, connections) {
+      if (!conn->failed) {
+        live.push_back(conn);
+      }
+    }
+
+    return live;
+  }
+
+  /* Stop using a server after a network error, its tiles are rendered by the others. */
+  void connection_failed(NetworkConnection *conn)
+  {
+    thread_scoped_lock lock(tile_mutex);
+
+    if (conn->failed) {
+      return;
+    }
+
+    conn->failed = true;
+    LOG(WARNING) << "Lost connection to render server " << conn->address << ", "
+                 << conn->tiles.size() + conn->queue.size() << " tiles will be re-rendered.";
+
+    foreach (RenderTile &tile, conn->tiles) {
+      retry_tiles.push_back(tile);
+    }
+    foreach (RenderTile &tile, conn->queue) {
+      retry_tiles.push_back(tile);
+    }
+    conn->tiles.clear();
+    conn->queue.clear();
+
+    for (map<device_ptr, set<NetworkConnection *>>::iterator it = buffer_owners.begin();
+         it != buffer_owners.end();
+         ++it) {
+      it->second.erase(conn);
+    }
+
+    bool any_live = false;
+    foreach (NetworkConnection *other, connections) {
+      any_live |= !other->failed;
+    }
+
+    if (!any_live) {
+      set_error("Lost connection to all render servers");
+    }
+  }
+
+  bool check_connection(NetworkConnection *conn)
+  {
+    if (conn->error_func.have_error()) {
+      connection_failed(conn);
+      return false;
+    }
+    return true;
+  }
+
   void mem_alloc(device_memory &mem)
   {
     if (mem.name) {
@@ -98,64 +369,211 @@ class NetworkDevice : public Device {
               << string_human_readable_size(mem.memory_size()) << ")";
     }
 
-    thread_scoped_lock lock(rpc_lock);
+    {
+      thread_scoped_lock lock(tile_mutex);
+      mem.device_pointer = ++mem_counter;
+    }
 
-    mem.device_pointer = ++mem_counter;
+    foreach (NetworkConnection *conn, live_connections()) {
+      thread_scoped_lock lock(conn->send_lock);
 
-    RPCSend snd(socket, &error_func, "mem_alloc");
-    snd.add(mem);
-    snd.write();
+      RPCSend snd(conn->socket, &conn->error_func, "mem_alloc");
+      snd.add(mem);
+      snd.write();
+
+      lock.unlock();
+      check_connection(conn);
+    }
   }
 
   void mem_copy_to(device_memory &mem)
   {
-    thread_scoped_lock lock(rpc_lock);
+    const size_t data_size = mem.memory_size();
 
-    RPCSend snd(socket, &error_func, "mem_copy_to");
+    /* All servers hold the same data after this, samples rendered before are included. */
+    {
+      thread_scoped_lock lock(tile_mutex);
+      buffer_owners.erase(mem.device_pointer);
+      if (mem.type == MEM_READ_WRITE && mem.data_type == TYPE_FLOAT) {
+        const float *data = (const float *)mem.host_pointer;
+        buffer_uploads[mem.device_pointer].assign(data, data + data_size / sizeof(float));
+      }
+    }
 
-    snd.add(mem);
-    snd.write();
-    snd.write_buffer(mem.host_pointer, mem.memory_size());
+    /* Replies can't be waited for while servers are rendering, the receive lock is held by
+     * the thread serving tiles then. */
+    const bool use_cache = data_size >= NETWORK_CACHE_MIN_SIZE && !in_task_wait;
+    const string hash = (use_cache) ? network_data_hash(mem.host_pointer, data_size) : "";
+    DataVector compressed;
+
+    foreach (NetworkConnection *conn, live_connections()) {
+      thread_scoped_lock lock(conn->send_lock);
+
+      if (!use_cache) {
+        RPCSend snd(conn->socket, &conn->error_func, "mem_copy_to");
+        snd.add(mem);
+        snd.write();
+        snd.write_buffer(mem.host_pointer, data_size);
+      }
+      else {
+        thread_scoped_lock receive_lock(conn->receive_lock);
+
+        RPCSend snd(conn->socket, &conn->error_func, "mem_copy_to_cached");
+        snd.add(mem);
+        snd.add(hash);
+        snd.write();
+
+        bool cached = false;
+        RPCReceive rcv(conn->socket, &conn->error_func);
+        if (!conn->error_func.have_error()) {
+          rcv.read(cached);
+        }
+
+        if (!cached && !conn->error_func.have_error()) {
+          if (compressed.empty()) {
+            network_data_compress(mem.host_pointer, data_size, compressed);
+          }
+
+          RPCSend data_snd(conn->socket, &conn->error_func, "mem_copy_to_data");
+          data_snd.add(compressed.size());
+          data_snd.write();
+          data_snd.write_buffer(&compressed[0], compressed.size());
+        }
+
+        if (mem.name) {
+          VLOG(2) << "Buffer upload: " << mem.name << " to " << conn->address << ", "
+                  << ((cached) ? string("cached") :
+                                 string_human_readable_size(compressed.size()) + " compressed");
+        }
+      }
+
+      lock.unlock();
+      check_connection(conn);
+    }
   }
 
   void mem_copy_from(device_memory &mem, int y, int w, int h, int elem)
   {
-    thread_scoped_lock lock(rpc_lock);
-
     size_t data_size = mem.memory_size();
 
-    RPCSend snd(socket, &error_func, "mem_copy_from");
+    /* Read from the servers that rendered into the buffer. Buffers rendered by multiple
+     * servers hold a part of the samples on each, which add up to the full result. Uploaded
+     * contents are held by every server and only counted for the first one. */
+    vector<NetworkConnection *> owners;
+    vector<float> upload;
+    {
+      thread_scoped_lock lock(tile_mutex);
+      map<device_ptr, set<NetworkConnection *>>::iterator it = buffer_owners.find(
+          mem.device_pointer);
+      if (it != buffer_owners.end()) {
+        owners.assign(it->second.begin(), it->second.end());
+      }
+      map<device_ptr, vector<float>>::iterator upload_it = buffer_uploads.find(
+          mem.device_pointer);
+      if (owners.size() > 1 && upload_it != buffer_uploads.end() &&
+          upload_it->second.size() * sizeof(float) == data_size) {
+        upload = upload_it->second;
+      }
+    }
 
-    snd.add(mem);
-    snd.add(y);
-    snd.add(w);
-    snd.add(h);
-    snd.add(elem);
-    snd.write();
+    if (owners.empty()) {
+      vector<NetworkConnection *> live = live_connections();
+      if (live.empty()) {
+        return;
+      }
+      owners.push_back(live[0]);
+    }
+    else if (mem.data_type != TYPE_FLOAT) {
+      owners.resize(1);
+    }
 
-    RPCReceive rcv(socket, &error_func);
-    rcv.read_buffer(mem.host_pointer, data_size);
+    vector<float> partial;
+    if (owners.size() > 1) {
+      partial.resize(data_size / sizeof(float));
+    }
+
+    for (size_t i = 0; i < owners.size(); i++) {
+      NetworkConnection *conn = owners[i];
+      thread_scoped_lock lock(conn->send_lock);
+      thread_scoped_lock receive_lock(conn->receive_lock);
+
+      RPCSend snd(conn->socket, &conn->error_func, "mem_copy_from");
+
+      snd.add(mem);
+      snd.add(y);
+      snd.add(w);
+      snd.add(h);
+      snd.add(elem);
+      snd.write();
+
+      RPCReceive rcv(conn->socket, &conn->error_func);
+
+      if (i == 0) {
+        rcv.read_buffer(mem.host_pointer, data_size);
+      }
+      else {
+        rcv.read_buffer(&partial[0], data_size);
+
+        float *data = (float *)mem.host_pointer;
+        if (upload.empty()) {
+          for (size_t j = 0; j < partial.size(); j++) {
+            data[j] += partial[j];
+          }
+        }
+        else {
+          for (size_t j = 0; j < partial.size(); j++) {
+            data[j] += partial[j] - upload[j];
+          }
+        }
+      }
+
+      receive_lock.unlock();
+      lock.unlock();
+      check_connection(conn);
+    }
   }
 
   void mem_zero(device_memory &mem)
   {
-    thread_scoped_lock lock(rpc_lock);
+    {
+      thread_scoped_lock lock(tile_mutex);
+      buffer_owners.erase(mem.device_pointer);
+      buffer_uploads.erase(mem.device_pointer);
+    }
 
-    RPCSend snd(socket, &error_func, "mem_zero");
+    foreach (NetworkConnection *conn, live_connections()) {
+      thread_scoped_lock lock(conn->send_lock);
 
-    snd.add(mem);
-    snd.write();
+      RPCSend snd(conn->socket, &conn->error_func, "mem_zero");
+
+      snd.add(mem);
+      snd.write();
+
+      lock.unlock();
+      check_connection(conn);
+    }
   }
 
   void mem_free(device_memory &mem)
   {
     if (mem.device_pointer) {
-      thread_scoped_lock lock(rpc_lock);
+      {
+        thread_scoped_lock lock(tile_mutex);
+        buffer_owners.erase(mem.device_pointer);
+        buffer_uploads.erase(mem.device_pointer);
+      }
 
-      RPCSend snd(socket, &error_func, "mem_free");
+      foreach (NetworkConnection *conn, live_connections()) {
+        thread_scoped_lock lock(conn->send_lock);
 
-      snd.add(mem);
-      snd.write();
+        RPCSend snd(conn->socket, &conn->error_func, "mem_free");
+
+        snd.add(mem);
+        snd.write();
+
+        lock.unlock();
+        check_connection(conn);
+      }
 
       mem.device_pointer = 0;
     }
@@ -163,133 +581,351 @@ class NetworkDevice : public Device {
 
   void const_copy_to(const char *name, void *host, size_t size)
   {
-    thread_scoped_lock lock(rpc_lock);
+    string name_string(name);
 
-    RPCSend snd(socket, &error_func, "const_copy_to");
+    foreach (NetworkConnection *conn, live_connections()) {
+      thread_scoped_lock lock(conn->send_lock);
 
-    string name_string(name);
+      RPCSend snd(conn->socket, &conn->error_func, "const_copy_to");
 
-    snd.add(name_string);
-    snd.add(size);
-    snd.write();
-    snd.write_buffer(host, size);
+      snd.add(name_string);
+      snd.add(size);
+      snd.write();
+      snd.write_buffer(host, size);
+
+      lock.unlock();
+      check_connection(conn);
+    }
   }
 
   bool load_kernels(const DeviceRequestedFeatures &requested_features)
   {
-    if (error_func.have_error())
-      return false;
+    bool result = false;
 
-    thread_scoped_lock lock(rpc_lock);
+    foreach (NetworkConnection *conn, live_connections()) {
+      thread_scoped_lock lock(conn->send_lock);
+      thread_scoped_lock receive_lock(conn->receive_lock);
 
-    RPCSend snd(socket, &error_func, "load_kernels");
-    snd.add(requested_features.experimental);
-    snd.add(requested_features.max_closure);
-    snd.add(requested_features.max_nodes_group);
-    snd.add(requested_features.nodes_features);
-    snd.write();
+      RPCSend snd(conn->socket, &conn->error_func, "load_kernels");
+      snd.add(requested_features.experimental);
+      snd.add(requested_features.max_nodes_group);
+      snd.add(requested_features.nodes_features);
+      snd.write();
 
-    bool result;
-    RPCReceive rcv(socket, &error_func);
-    rcv.read(result);
+      bool conn_result = false;
+      RPCReceive rcv(conn->socket, &conn->error_func);
+      if (!conn->error_func.have_error()) {
+        rcv.read(conn_result);
+      }
+
+      receive_lock.unlock();
+      lock.unlock();
+
+      /* Servers that can't render the scene are not used. */
+      if (!conn_result) {
+        conn->error_func.network_error("Failed to load kernels");
+      }
+
+      result |= check_connection(conn);
+    }
 
     return result;
   }
 
   void task_add(DeviceTask &task)
   {
-    thread_scoped_lock lock(rpc_lock);
+    {
+      thread_scoped_lock lock(tile_mutex);
 
-    the_task = task;
+      the_task = task;
+      retry_tiles.clear();
 
-    RPCSend snd(socket, &error_func, "task_add");
-    snd.add(task);
-    snd.write();
+      foreach (NetworkConnection *conn, connections) {
+        conn->queue.clear();
+        conn->tiles.clear();
+      }
+    }
+
+    foreach (NetworkConnection *conn, live_connections()) {
+      thread_scoped_lock lock(conn->send_lock);
+
+      RPCSend snd(conn->socket, &conn->error_func, "task_add");
+      snd.add(task);
+      snd.write();
+
+      lock.unlock();
+      check_connection(conn);
+    }
   }
 
   void task_wait()
   {
-    thread_scoped_lock lock(rpc_lock);
+    vector<NetworkConnection *> live = live_connections();
 
-    RPCSend snd(socket, &error_func, "task_wait");
-    snd.write();
+    foreach (NetworkConnection *conn, live) {
+      thread_scoped_lock lock(conn->send_lock);
+
+      RPCSend snd(conn->socket, &conn->error_func, "task_wait");
+      snd.write();
+    }
+
+    in_task_wait = true;
+
+    for (;;) {
+      /* Serve tile requests of each server from its own thread. */
+      vector<thread *> threads;
+      foreach (NetworkConnection *conn, live) {
+        threads.push_back(new thread(function_bind(&NetworkDevice::serve_tiles, this, conn)));
+      }
+
+      foreach (thread *t, threads) {
+        t->join();
+        delete t;
+      }
+
+      /* Servers may have finished before tiles of a disconnected server were handed back,
+       * render those with another pass over the task. */
+      live = live_connections();
+      {
+        thread_scoped_lock lock(tile_mutex);
+        if (retry_tiles.empty() || live.empty()) {
+          break;
+        }
+      }
+
+      foreach (NetworkConnection *conn, live) {
+        thread_scoped_lock lock(conn->send_lock);
+
+        RPCSend snd(conn->socket, &conn->error_func, "task_add");
+        snd.add(the_task);
+        snd.write();
+
+        RPCSend wait_snd(conn->socket, &conn->error_func, "task_wait");
+        wait_snd.write();
+      }
+    }
+
+    in_task_wait = false;
 
-    lock.unlock();
+    foreach (NetworkConnection *conn, connections) {
+      VLOG(1) << "Render server " << conn->address << ": " << conn->num_tiles << " tiles ("
+              << conn->num_stolen_tiles << " stolen), "
+              << string_human_readable_number((size_t)conn->throughput())
+              << " samples per second" << ((conn->failed) ? ", disconnected." : ".");
+    }
+  }
 
-    TileList the_tiles;
+  void serve_tiles(NetworkConnection *conn)
+  {
+    conn->task_start_time = time_dt();
 
-    /* todo: run this threaded for connecting to multiple clients */
     for (;;) {
-      if (error_func.have_error())
+      if (!check_connection(conn))
         break;
 
       RenderTile tile;
 
-      lock.lock();
-      RPCReceive rcv(socket, &error_func);
+      thread_scoped_lock receive_lock(conn->receive_lock);
+      RPCReceive rcv(
+          conn->socket, &conn->error_func, &conn->io_service, serve_tiles_timeout(conn));
+      receive_lock.unlock();
+
+      if (rcv.timed_out) {
+        /* The rest of a late message can't be told apart from the next one, stop using the
+         * connection. Both locks are held so no request is using the socket. */
+        thread_scoped_lock lock(conn->send_lock);
+        thread_scoped_lock socket_receive_lock(conn->receive_lock);
+        boost::system::error_code error;
+        conn->socket.close(error);
+      }
 
-      if (rcv.name == "acquire_tile") {
-        lock.unlock();
+      if (!check_connection(conn))
+        break;
 
+      if (rcv.name == "acquire_tile") {
         /* todo: watch out for recursive calls! */
-        if (the_task.acquire_tile(this, tile)) { /* write return as bool */
-          the_tiles.push_back(tile);
-
-          lock.lock();
-          RPCSend snd(socket, &error_func, "acquire_tile");
+        if (acquire_tile(conn, tile)) { /* write return as bool */
+          thread_scoped_lock lock(conn->send_lock);
+          RPCSend snd(conn->socket, &conn->error_func, "acquire_tile");
           snd.add(tile);
           snd.write();
-          lock.unlock();
         }
         else {
-          lock.lock();
-          RPCSend snd(socket, &error_func, "acquire_tile_none");
+          thread_scoped_lock lock(conn->send_lock);
+          RPCSend snd(conn->socket, &conn->error_func, "acquire_tile_none");
           snd.write();
-          lock.unlock();
         }
       }
       else if (rcv.name == "release_tile") {
         rcv.read(tile);
-        lock.unlock();
-
-        TileList::iterator it = tile_list_find(the_tiles, tile);
-        if (it != the_tiles.end()) {
-          tile.buffers = it->buffers;
-          the_tiles.erase(it);
-        }
 
-        assert(tile.buffers != NULL);
+        release_tile(conn, tile);
 
-        the_task.release_tile(tile);
-
-        lock.lock();
-        RPCSend snd(socket, &error_func, "release_tile");
+        thread_scoped_lock lock(conn->send_lock);
+        RPCSend snd(conn->socket, &conn->error_func, "release_tile");
         snd.write();
-        lock.unlock();
       }
       else if (rcv.name == "task_wait_done") {
-        lock.unlock();
         break;
       }
-      else
-        lock.unlock();
     }
+
+    thread_scoped_lock lock(tile_mutex);
+    conn->busy_time += time_dt() - conn->task_start_time;
+    conn->task_start_time = 0.0;
+  }
+
+  static double tile_work(const RenderTile &tile)
+  {
+    return (double)tile.w * tile.h * tile.num_samples;
+  }
+
+  /* Time to wait for the next message of a server, a few times as long as it is expected to
+   * take to render the tiles it holds. */
+  double serve_tiles_timeout(NetworkConnection *conn)
+  {
+    thread_scoped_lock lock(tile_mutex);
+
+    double work = 0.0;
+    foreach (const RenderTile &tile, conn->tiles) {
+      work += tile_work(tile);
+    }
+
+    const double throughput = conn->throughput();
+    return SERVE_TILES_TIMEOUT + ((throughput > 0.0) ? 4.0 * work / throughput : 0.0);
+  }
+
+  bool acquire_tile(NetworkConnection *conn, RenderTile &tile)
+  {
+    /* Tiles queued for this server come first, then tiles of servers that disconnected. The
+     * tile mutex is not held while acquiring from the task, which allocates tile buffers. */
+    bool found = false;
+    {
+      thread_scoped_lock lock(tile_mutex);
+
+      if (!conn->queue.empty()) {
+        tile = conn->queue.front();
+        conn->queue.pop_front();
+        found = true;
+      }
+      else if (!retry_tiles.empty()) {
+        tile = retry_tiles.front();
+        retry_tiles.pop_front();
+        found = true;
+      }
+    }
+
+    if (!found && !the_task.acquire_tile(this, tile, the_task.tile_types)) {
+      thread_scoped_lock lock(tile_mutex);
+      if (!steal_tile(conn, tile)) {
+        return false;
+      }
+    }
+
+    /* Acquire tiles ahead for the time the server takes to ask for the next one, at least one
+     * so there is something to steal for servers that run out of work. */
+    int num_prefetch;
+    {
+      thread_scoped_lock lock(tile_mutex);
+      conn->tiles.push_back(tile);
+
+      const double throughput = conn->throughput();
+      const double work = max(tile_work(tile), 1.0);
+      const int depth = (throughput > 0.0) ? clamp((int)(throughput * 0.25 / work), 1, 8) : 1;
+      num_prefetch = depth - (int)conn->queue.size();
+    }
+
+    for (int i = 0; i < num_prefetch; i++) {
+      RenderTile next_tile;
+      if (!the_task.acquire_tile(this, next_tile, the_task.tile_types)) {
+        break;
+      }
+
+      thread_scoped_lock lock(tile_mutex);
+      if (conn->failed) {
+        retry_tiles.push_back(next_tile);
+      }
+      else {
+        conn->queue.push_back(next_tile);
+      }
+    }
+
+    return true;
+  }
+
+  /* Take the last queued tile from the server that would take longest to get to it, unless
+   * this server would not finish it any sooner. Must be called with the tile mutex held. */
+  bool steal_tile(NetworkConnection *thief, RenderTile &tile)
+  {
+    NetworkConnection *victim = NULL;
+    double victim_time = 0.0;
+
+    foreach (NetworkConnection *conn, connections) {
+      if (conn == thief || conn->failed || conn->queue.empty()) {
+        continue;
+      }
+
+      const double throughput = conn->throughput();
+      const double time = (throughput > 0.0) ? conn->queued_work() / throughput : FLT_MAX;
+
+      if (victim == NULL || time > victim_time) {
+        victim = conn;
+        victim_time = time;
+      }
+    }
+
+    if (victim == NULL) {
+      return false;
+    }
+
+    const double thief_throughput = thief->throughput();
+    if (thief_throughput > 0.0 &&
+        tile_work(victim->queue.back()) / thief_throughput >= victim_time) {
+      return false;
+    }
+
+    tile = victim->queue.back();
+    victim->queue.pop_back();
+    thief->num_stolen_tiles++;
+
+    return true;
+  }
+
+  void release_tile(NetworkConnection *conn, RenderTile &tile)
+  {
+    {
+      thread_scoped_lock lock(tile_mutex);
+
+      TileList::iterator it = tile_list_find(conn->tiles, tile);
+      if (it != conn->tiles.end()) {
+        tile.buffers = it->buffers;
+        conn->tiles.erase(it);
+      }
+
+      conn->completed_work += tile_work(tile);
+      conn->num_tiles++;
+
+      buffer_owners[tile.buffer].insert(conn);
+    }
+
+    assert(tile.buffers != NULL);
+
+    the_task.release_tile(tile);
   }
 
   void task_cancel()
   {
-    thread_scoped_lock lock(rpc_lock);
-    RPCSend snd(socket, &error_func, "task_cancel");
-    snd.write();
+    foreach (NetworkConnection *conn, live_connections()) {
+      thread_scoped_lock lock(conn->send_lock);
+      RPCSend snd(conn->socket, &conn->error_func, "task_cancel");
+      snd.write();
+    }
   }
 
   int get_split_task_count(DeviceTask &)
   {
     return 1;
   }
-
- private:
-  NetworkError error_func;
 };
 
 Device *device_network_create(DeviceInfo &info,
@@ -318,6 +954,64 @@ void device_network_info(vector<DeviceInfo> &devices)
   devices.push_back(info);
 }
 
+/* Compressed scene data of recent connections, kept by the server across connections. */
+
+class NetworkCache {
+ public:
+  explicit NetworkCache(size_t max_size) : size(0), max_size(max_size)
+  {
+  }
+
+  /* Decompress cached data into the buffer, returns false if it is not cached. */
+  bool lookup(const string &hash, void *data, size_t data_size)
+  {
+    thread_scoped_lock lock(mutex);
+
+    EntryMap::iterator it = entries.find(hash);
+    if (it == entries.end()) {
+      return false;
+    }
+
+    lru.splice(lru.begin(), lru, it->second.lru);
+    return network_data_decompress(it->second.data, data, data_size);
+  }
+
+  void insert(const string &hash, DataVector &compressed)
+  {
+    thread_scoped_lock lock(mutex);
+
+    if (compressed.size() > max_size || entries.find(hash) != entries.end()) {
+      return;
+    }
+
+    while (size + compressed.size() > max_size) {
+      EntryMap::iterator it = entries.find(lru.back());
+      size -= it->second.data.size();
+      entries.erase(it);
+      lru.pop_back();
+    }
+
+    lru.push_front(hash);
+    Entry &entry = entries[hash];
+    entry.data.swap(compressed);
+    entry.lru = lru.begin();
+    size += entry.data.size();
+  }
+
+ protected:
+  struct Entry {
+    DataVector data;
+    list<string>::iterator lru;
+  };
+  typedef map<string, Entry> EntryMap;
+
+  thread_mutex mutex;
+  EntryMap entries;
+  list<string> lru;
+  size_t size;
+  size_t max_size;
+};
+
 class DeviceServer {
  public:
   thread_mutex rpc_lock;
@@ -332,8 +1026,8 @@ class DeviceServer {
     return error_func.have_error();
   }
 
-  DeviceServer(Device *device_, tcp::socket &socket_)
-      : device(device_), socket(socket_), stop(false), blocked_waiting(false)
+  DeviceServer(Device *device_, tcp::socket &socket_, NetworkCache &cache_)
+      : device(device_), socket(socket_), cache(cache_), stop(false), blocked_waiting(false)
   {
     error_func = NetworkError();
   }
@@ -344,7 +1038,7 @@ class DeviceServer {
     for (;;) {
       listen_step();
 
-      if (stop)
+      if (stop || have_error())
         break;
     }
   }
@@ -355,7 +1049,7 @@ class DeviceServer {
     thread_scoped_lock lock(rpc_lock);
     RPCReceive rcv(socket, &error_func);
 
-    if (rcv.name == "stop")
+    if (have_error() || rcv.name == "stop")
       stop = true;
     else
       process(rcv, lock);
@@ -457,11 +1151,18 @@ class DeviceServer {
       /* Store a mapping to/from client_pointer and real device pointer. */
       pointer_mapping_insert(client_pointer, mem.device_pointer);
     }
-    else if (rcv.name == "mem_copy_to") {
-      string name;
+    else if (rcv.name == "mem_copy_to" || rcv.name == "mem_copy_to_cached") {
+      string name, hash;
       network_device_memory mem(device);
       rcv.read(mem, name);
-      lock.unlock();
+
+      const bool use_cache = (rcv.name == "mem_copy_to_cached");
+      if (use_cache) {
+        rcv.read(hash);
+      }
+      else {
+        lock.unlock();
+      }
 
       size_t data_size = mem.memory_size();
       device_ptr client_pointer = mem.device_pointer;
@@ -480,8 +1181,14 @@ class DeviceServer {
         mem.host_pointer = (data_size) ? (void *)&(data_v[0]) : 0;
       }
 
-      /* Copy data from network into memory buffer. */
-      rcv.read_buffer((uint8_t *)mem.host_pointer, data_size);
+      /* Copy data from network or cache into memory buffer. */
+      if (use_cache) {
+        receive_cached(hash, mem.host_pointer, data_size);
+        lock.unlock();
+      }
+      else {
+        rcv.read_buffer((uint8_t *)mem.host_pointer, data_size);
+      }
 
       /* Copy the data from the memory buffer to the device buffer. */
       device->mem_copy_to(mem);
@@ -507,7 +1214,7 @@ class DeviceServer {
 
       DataVector &data_v = data_vector_find(client_pointer);
 
-      mem.host_pointer = (device_ptr) & (data_v[0]);
+      mem.host_pointer = (void *)&(data_v[0]);
 
       device->mem_copy_from(mem, y, w, h, elem);
 
@@ -538,7 +1245,7 @@ class DeviceServer {
       else {
         /* Allocate host side data buffer. */
         DataVector &data_v = data_vector_insert(client_pointer, data_size);
-        mem.host_pointer = (void *) ? (device_ptr) & (data_v[0]) : 0;
+        mem.host_pointer = (data_size) ? (void *)&(data_v[0]) : 0;
       }
 
       /* Zero memory. */
@@ -578,7 +1285,6 @@ class DeviceServer {
     else if (rcv.name == "load_kernels") {
       DeviceRequestedFeatures requested_features;
       rcv.read(requested_features.experimental);
-      rcv.read(requested_features.max_closure);
       rcv.read(requested_features.max_nodes_group);
       rcv.read(requested_features.nodes_features);
 
@@ -610,7 +1316,7 @@ class DeviceServer {
       if (task.shader_output)
         task.shader_output = device_ptr_from_client_pointer(task.shader_output);
 
-      task.acquire_tile = function_bind(&DeviceServer::task_acquire_tile, this, _1, _2);
+      task.acquire_tile = function_bind(&DeviceServer::task_acquire_tile, this, _1, _2, _3);
       task.release_tile = function_bind(&DeviceServer::task_release_tile, this, _1);
       task.update_progress_sample = function_bind(&DeviceServer::task_update_progress_sample,
                                                   this);
@@ -660,7 +1366,41 @@ class DeviceServer {
     }
   }
 
-  bool task_acquire_tile(Device *, RenderTile &tile)
+  /* Receive data of a buffer the client sent the hash of, unless it is cached already. Must be
+   * called with the lock held. */
+  void receive_cached(const string &hash, void *data, size_t data_size)
+  {
+    const bool cached = cache.lookup(hash, data, data_size);
+
+    RPCSend snd(socket, &error_func, "mem_copy_to_cached");
+    snd.add(cached);
+    snd.write();
+
+    if (cached) {
+      return;
+    }
+
+    RPCReceive rcv(socket, &error_func);
+    if (error_func.have_error() || rcv.name != "mem_copy_to_data") {
+      network_error("Network receive error: expected buffer data");
+      return;
+    }
+
+    size_t compressed_size;
+    rcv.read(compressed_size);
+
+    DataVector compressed(compressed_size);
+    rcv.read_buffer(&compressed[0], compressed_size);
+
+    if (network_data_decompress(compressed, data, data_size)) {
+      cache.insert(hash, compressed);
+    }
+    else {
+      network_error("Network receive error: failed to decompress buffer data");
+    }
+  }
+
+  bool task_acquire_tile(Device *, RenderTile &tile, uint)
   {
     thread_scoped_lock acquire_lock(acquire_mutex);
 
@@ -756,6 +1496,7 @@ class DeviceServer {
   /* properties */
   Device *device;
   tcp::socket &socket;
+  NetworkCache &cache;
 
   /* mapping of remote to local pointer */
   PtrMap ptr_map;
@@ -779,16 +1520,33 @@ class DeviceServer {
   /* todo: free memory and device (osl) on network error */
 };
 
-void Device::server_run()
+void Device::server_run(int port)
 {
+  if (port == 0) {
+    port = SERVER_PORT;
+  }
+
+  /* Scene data is cached across connections, so a client rendering the same scene again only
+   * needs to send what changed. */
+  NetworkCache cache(SERVER_CACHE_SIZE);
+
   try {
-    /* starts thread that responds to discovery requests */
-    ServerDiscovery discovery;
+    /* starts thread that responds to discovery requests, clients discovering servers always
+     * connect to the default port */
+    unique_ptr<ServerDiscovery> discovery;
+    if (port == SERVER_PORT) {
+      try {
+        discovery.reset(new ServerDiscovery());
+      }
+      catch (exception &e) {
+        fprintf(stderr, "Network server discovery unavailable: %s\n", e.what());
+      }
+    }
 
     for (;;) {
       /* accept connection */
       boost::asio::io_service io_service;
-      tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), SERVER_PORT));
+      tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), port));
 
       tcp::socket socket(io_service);
       acceptor.accept(socket);
@@ -796,7 +1554,7 @@ void Device::server_run()
       string remote_address = socket.remote_endpoint().address().to_string();
       printf("Connected to remote client at: %s\n", remote_address.c_str());
 
-      DeviceServer server(this, socket);
+      DeviceServer server(this, socket, cache);
       server.listen();
 
       printf("Disconnected.\n");
@@ -33,10 +33,13 @@
 #  include <iostream>
 #  include <sstream>
 
+#  include "device/device_task.h"
+
 #  include "render/buffers.h"
 
 #  include "util/util_foreach.h"
 #  include "util/util_list.h"
+#  include "util/util_logging.h"
 #  include "util/util_map.h"
 #  include "util/util_param.h"
 #  include "util/util_string.h"
@@ -118,7 +121,7 @@ class RPCSend {
   {
     archive &name_;
     error_func = e;
-    fprintf(stderr, "rpc send %s\n", name.c_str());
+    VLOG(4) << "RPC send " << name;
   }
 
   ~RPCSend()
@@ -130,7 +133,6 @@ class RPCSend {
     archive &mem.data_type &mem.data_elements &mem.data_size;
     archive &mem.data_width &mem.data_height &mem.data_depth &mem.device_pointer;
     archive &mem.type &string(mem.name);
-    archive &mem.interpolation &mem.extension;
     archive &mem.device_pointer;
   }
 
@@ -147,11 +149,15 @@ class RPCSend {
     archive &task.offset &task.stride;
     archive &task.shader_input &task.shader_output &task.shader_eval_type;
     archive &task.shader_x &task.shader_w;
-    archive &task.need_finish_queue;
+    archive &task.need_finish_queue &task.tile_types &task.integrator_branched;
+    archive &task.adaptive_sampling.use &task.adaptive_sampling.adaptive_step;
+    archive &task.adaptive_sampling.min_samples;
   }
 
   void add(const RenderTile &tile)
   {
+    int type = (int)tile.task;
+    archive &type;
     archive &tile.x &tile.y &tile.w &tile.h;
     archive &tile.start_sample &tile.num_samples &tile.sample;
     archive &tile.resolution &tile.offset &tile.stride;
@@ -210,14 +216,26 @@ class RPCSend {
 
 class RPCReceive {
  public:
-  RPCReceive(tcp::socket &socket_, NetworkError *e)
-      : socket(socket_), archive_stream(NULL), archive(NULL)
+  /* Without an io_service reading blocks until the message arrived, with one reading fails
+   * with an error when it did not arrive after \a timeout seconds. The io_service must be the
+   * one of the socket. */
+  RPCReceive(tcp::socket &socket_,
+             NetworkError *e,
+             boost::asio::io_service *io_service_ = NULL,
+             double timeout = 0.0)
+      : socket(socket_), archive_stream(NULL), archive(NULL), io_service(io_service_)
   {
     error_func = e;
+    timed_out = false;
+    if (io_service) {
+      deadline = boost::posix_time::microsec_clock::universal_time() +
+                 boost::posix_time::milliseconds((long)(timeout * 1000.0));
+    }
+
     /* read head with fixed size */
     vector<char> header(8);
     boost::system::error_code error;
-    size_t len = boost::asio::read(socket, boost::asio::buffer(header), error);
+    size_t len = read_until_deadline(boost::asio::buffer(header), error);
 
     if (error.value()) {
       error_func->network_error(error.message());
@@ -234,7 +252,7 @@ class RPCReceive {
       if ((header_stream >> hex >> data_size)) {
 
         vector<char> data(data_size);
-        size_t len = boost::asio::read(socket, boost::asio::buffer(data), error);
+        size_t len = read_until_deadline(boost::asio::buffer(data), error);
 
         if (error.value())
           error_func->network_error(error.message());
@@ -246,7 +264,7 @@ class RPCReceive {
           archive = new i_archive(*archive_stream);
 
           *archive &name;
-          fprintf(stderr, "rpc receive %s\n", name.c_str());
+          VLOG(4) << "RPC receive " << name;
         }
         else {
           error_func->network_error("Network receive error: data size doesn't match header");
@@ -272,7 +290,6 @@ class RPCReceive {
     *archive &mem.data_type &mem.data_elements &mem.data_size;
     *archive &mem.data_width &mem.data_height &mem.data_depth &mem.device_pointer;
     *archive &mem.type &name;
-    *archive &mem.interpolation &mem.extension;
     *archive &mem.device_pointer;
 
     mem.name = name.c_str();
@@ -311,29 +328,73 @@ class RPCReceive {
     *archive &task.offset &task.stride;
     *archive &task.shader_input &task.shader_output &task.shader_eval_type;
     *archive &task.shader_x &task.shader_w;
-    *archive &task.need_finish_queue;
+    *archive &task.need_finish_queue &task.tile_types &task.integrator_branched;
+    *archive &task.adaptive_sampling.use &task.adaptive_sampling.adaptive_step;
+    *archive &task.adaptive_sampling.min_samples;
 
     task.type = (DeviceTask::Type)type;
   }
 
   void read(RenderTile &tile)
   {
+    int type;
+    *archive &type;
     *archive &tile.x &tile.y &tile.w &tile.h;
     *archive &tile.start_sample &tile.num_samples &tile.sample;
     *archive &tile.resolution &tile.offset &tile.stride;
     *archive &tile.buffer;
 
+    tile.task = (RenderTile::Task)type;
     tile.buffers = NULL;
   }
 
   string name;
+  bool timed_out;
 
  protected:
+  /* Read the whole buffer, or until the deadline when there is one. */
+  size_t read_until_deadline(const boost::asio::mutable_buffers_1 &buffer,
+                             boost::system::error_code &error)
+  {
+    if (io_service == NULL) {
+      return boost::asio::read(socket, buffer, error);
+    }
+
+    size_t len = 0;
+    bool read_done = false;
+    boost::asio::deadline_timer timer(*io_service, deadline);
+
+    boost::asio::async_read(
+        socket, buffer, [&](const boost::system::error_code &read_error, size_t read_len) {
+          error = read_error;
+          len = read_len;
+          read_done = true;
+          timer.cancel();
+        });
+    timer.async_wait([&](const boost::system::error_code &timer_error) {
+      if (timer_error != boost::asio::error::operation_aborted && !read_done) {
+        timed_out = true;
+        socket.cancel();
+      }
+    });
+
+    /* Returns once both are done, either one cancels the other. */
+    io_service->reset();
+    io_service->run();
+
+    if (timed_out) {
+      error = boost::asio::error::timed_out;
+    }
+    return len;
+  }
+
   tcp::socket &socket;
   string archive_str;
   istringstream *archive_stream;
   i_archive *archive;
   NetworkError *error_func;
+  boost::asio::io_service *io_service;
+  boost::posix_time::ptime deadline;
 };
 
 /* Server auto discovery */
@@ -0,0 +1,494 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "device/device_path_guiding.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_boundbox.h"
+#include "util/util_foreach.h"
+#include "util/util_logging.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Spatial leaves are split once they received more than this many vertices, scaled by the
+ * square root of the iteration length. */
+static const float SPATIAL_SPLIT_THRESHOLD = 12000.0f;
+static const int SPATIAL_MAX_DEPTH = 48;
+
+/* Directional quadrants are subdivided when they hold more than this fraction of the energy. */
+static const float DIRECTIONAL_SUBDIVISION_THRESHOLD = 0.01f;
+static const int DIRECTIONAL_MAX_DEPTH = 20;
+
+struct PathGuiding::Iteration {
+  /* Field as seen by the kernel, pointing into the vectors below. */
+  PathGuidingField field;
+  /* Same field without training, handed out once the iteration is complete. */
+  PathGuidingField sampling_field;
+
+  /* Number of the iteration, renders 2^index samples per pixel. */
+  int index;
+
+  vector<PathGuidingSpatialNode> spatial_nodes;
+  vector<PathGuidingDirectionalNode> sampling_nodes;
+  vector<PathGuidingDirectionalNode> training_nodes;
+  BoundBox spatial_bounds;
+  float bounds[6];
+
+  uint64_t num_paths;
+  uint64_t target_paths;
+  /* Threads using the iteration, and those of them recording into the training trees. */
+  int users;
+  int training_users;
+  /* Enough paths were recorded, the iteration is no longer handed out for training. */
+  bool complete;
+
+  explicit Iteration(int index) : index(index), spatial_bounds(BoundBox::empty), num_paths(0)
+  {
+    bounds[0] = bounds[1] = bounds[2] = FLT_MAX;
+    bounds[3] = bounds[4] = bounds[5] = -FLT_MAX;
+    target_paths = 0;
+    users = 0;
+    training_users = 0;
+    complete = false;
+  }
+
+  void update_field(bool use_training)
+  {
+    field.spatial_nodes = &spatial_nodes[0];
+    field.sampling_nodes = &sampling_nodes[0];
+    field.training_nodes = &training_nodes[0];
+    field.bounds = bounds;
+    field.use_sampling = (index > 0);
+    field.use_training = use_training;
+    field.use_bounds = !spatial_bounds.valid();
+
+    sampling_field = field;
+    sampling_field.use_training = false;
+  }
+};
+
+/* Directional Trees */
+
+static PathGuidingDirectionalNode directional_empty_node()
+{
+  PathGuidingDirectionalNode node;
+  for (int q = 0; q < 4; q++) {
+    node.energy[q] = 0.0f;
+    node.child[q] = 0;
+  }
+  return node;
+}
+
+/* Sum the energy recorded into the leaves up into the inner nodes. */
+static float directional_propagate(vector<PathGuidingDirectionalNode> &nodes, int index)
+{
+  float total = 0.0f;
+  for (int q = 0; q < 4; q++) {
+    const int child = nodes[index].child[q];
+    if (child != 0) {
+      nodes[index].energy[q] = directional_propagate(nodes, child);
+    }
+    total += nodes[index].energy[q];
+  }
+  return total;
+}
+
+static int directional_copy(const vector<PathGuidingDirectionalNode> &src,
+                            int src_index,
+                            vector<PathGuidingDirectionalNode> &dst)
+{
+  const int index = dst.size();
+  dst.push_back(src[src_index]);
+  for (int q = 0; q < 4; q++) {
+    if (src[src_index].child[q] != 0) {
+      const int child = directional_copy(src, src[src_index].child[q], dst);
+      dst[index].child[q] = child;
+    }
+  }
+  return index;
+}
+
+/* Build an empty tree that is subdivided wherever the source distribution holds enough
+ * energy. Quadrants that were leaves in the source tree are subdivided assuming their energy
+ * is spread uniformly, so the tree can grow several levels at once. */
+static int directional_refine(const vector<PathGuidingDirectionalNode> &src,
+                              int src_index,
+                              const float energy[4],
+                              float total,
+                              int depth,
+                              vector<PathGuidingDirectionalNode> &dst)
+{
+  const int index = dst.size();
+  dst.push_back(directional_empty_node());
+
+  if (depth >= DIRECTIONAL_MAX_DEPTH) {
+    return index;
+  }
+
+  for (int q = 0; q < 4; q++) {
+    if (!(energy[q] > total * DIRECTIONAL_SUBDIVISION_THRESHOLD)) {
+      continue;
+    }
+
+    float child_energy[4];
+    int child_src_index = -1;
+    if (src_index != -1 && src[src_index].child[q] != 0) {
+      child_src_index = src[src_index].child[q];
+      for (int i = 0; i < 4; i++) {
+        child_energy[i] = src[child_src_index].energy[i];
+      }
+    }
+    else {
+      for (int i = 0; i < 4; i++) {
+        child_energy[i] = energy[q] * 0.25f;
+      }
+    }
+
+    const int child = directional_refine(
+        src, child_src_index, child_energy, total, depth + 1, dst);
+    dst[index].child[q] = child;
+  }
+
+  return index;
+}
+
+static int directional_refine(const vector<PathGuidingDirectionalNode> &src,
+                              int src_index,
+                              vector<PathGuidingDirectionalNode> &dst)
+{
+  const PathGuidingDirectionalNode &root = src[src_index];
+  const float total = root.energy[0] + root.energy[1] + root.energy[2] + root.energy[3];
+  if (!(total > 0.0f)) {
+    dst.push_back(directional_empty_node());
+    return dst.size() - 1;
+  }
+  return directional_refine(src, src_index, root.energy, total, 0, dst);
+}
+
+/* Spatial Tree */
+
+struct SpatialBuildContext {
+  const vector<PathGuidingSpatialNode> *prev_spatial_nodes;
+  const vector<PathGuidingDirectionalNode> *prev_sampling_nodes;
+  vector<PathGuidingDirectionalNode> *prev_training_nodes;
+  bool prev_use_sampling;
+
+  vector<PathGuidingSpatialNode> *spatial_nodes;
+  vector<PathGuidingDirectionalNode> *sampling_nodes;
+  vector<PathGuidingDirectionalNode> *training_nodes;
+  bool use_training;
+
+  float split_threshold;
+  int num_leaves;
+};
+
+static void spatial_build_leaf(SpatialBuildContext &ctx,
+                               int index,
+                               const BoundBox &bounds,
+                               int depth,
+                               float num_samples,
+                               int sampling_root)
+{
+  if (num_samples > ctx.split_threshold && depth < SPATIAL_MAX_DEPTH) {
+    /* Split at the middle, cycling through the axes. */
+    const int axis = depth % 3;
+    const float split = 0.5f * (bounds.min[axis] + bounds.max[axis]);
+    const int child = ctx.spatial_nodes->size();
+    ctx.spatial_nodes->resize(child + 2);
+
+    PathGuidingSpatialNode &node = (*ctx.spatial_nodes)[index];
+    node.axis = axis;
+    node.child = child;
+    node.sampling_root = 0;
+    node.training_root = 0;
+    node.split = split;
+    node.num_samples = 0;
+
+    BoundBox lower = bounds, upper = bounds;
+    lower.max[axis] = split;
+    upper.min[axis] = split;
+
+    /* Both children start out with the parent distribution, assuming the recorded vertices
+     * were spread evenly between them. */
+    spatial_build_leaf(ctx, child, lower, depth + 1, num_samples * 0.5f, sampling_root);
+    spatial_build_leaf(ctx, child + 1, upper, depth + 1, num_samples * 0.5f, sampling_root);
+    return;
+  }
+
+  PathGuidingSpatialNode &node = (*ctx.spatial_nodes)[index];
+  node.axis = -1;
+  node.child = 0;
+  node.sampling_root = sampling_root;
+  node.split = 0.0f;
+  node.num_samples = 0;
+
+  int training_root;
+  if (ctx.use_training) {
+    training_root = directional_refine(*ctx.sampling_nodes, sampling_root, *ctx.training_nodes);
+  }
+  else {
+    training_root = 0;
+  }
+  (*ctx.spatial_nodes)[index].training_root = training_root;
+
+  ctx.num_leaves++;
+}
+
+static void spatial_build(SpatialBuildContext &ctx,
+                          int prev_index,
+                          int index,
+                          const BoundBox &bounds,
+                          int depth)
+{
+  const PathGuidingSpatialNode &prev_node = (*ctx.prev_spatial_nodes)[prev_index];
+
+  if (prev_node.axis != -1) {
+    const int axis = prev_node.axis;
+    const int child = ctx.spatial_nodes->size();
+    ctx.spatial_nodes->resize(child + 2);
+
+    PathGuidingSpatialNode &node = (*ctx.spatial_nodes)[index];
+    node = prev_node;
+    node.child = child;
+
+    BoundBox lower = bounds, upper = bounds;
+    lower.max[axis] = prev_node.split;
+    upper.min[axis] = prev_node.split;
+
+    spatial_build(ctx, prev_node.child, child, lower, depth + 1);
+    spatial_build(ctx, prev_node.child + 1, child + 1, upper, depth + 1);
+    return;
+  }
+
+  /* The distribution recorded during the previous iteration becomes the sampling distribution.
+   * Leaves that received no energy keep sampling what they did before. */
+  int sampling_root;
+  const float total = directional_propagate(*ctx.prev_training_nodes, prev_node.training_root);
+  if (total > 0.0f) {
+    sampling_root = directional_copy(
+        *ctx.prev_training_nodes, prev_node.training_root, *ctx.sampling_nodes);
+  }
+  else if (ctx.prev_use_sampling) {
+    sampling_root = directional_copy(
+        *ctx.prev_sampling_nodes, prev_node.sampling_root, *ctx.sampling_nodes);
+  }
+  else {
+    sampling_root = ctx.sampling_nodes->size();
+    ctx.sampling_nodes->push_back(directional_empty_node());
+  }
+
+  spatial_build_leaf(ctx, index, bounds, depth, (float)prev_node.num_samples, sampling_root);
+}
+
+/* Path Guiding */
+
+PathGuiding::PathGuiding() : current(NULL), building(false), num_pixels(0), training_samples(0)
+{
+}
+
+PathGuiding::~PathGuiding()
+{
+  foreach (Iteration *iteration, iterations) {
+    delete iteration;
+  }
+}
+
+void PathGuiding::reset(bool use, int num_pixels_, int training_samples_)
+{
+  thread_scoped_lock lock(mutex);
+
+  foreach (Iteration *iteration, iterations) {
+    assert(iteration->users == 0);
+    delete iteration;
+  }
+  iterations.clear();
+  current = NULL;
+
+  if (!use || num_pixels_ <= 0) {
+    return;
+  }
+
+  num_pixels = num_pixels_;
+  training_samples = training_samples_;
+
+  /* First iteration records into a single uniform tree to find the scene bounds. */
+  Iteration *iteration = new Iteration(0);
+  iteration->spatial_nodes.resize(1);
+  PathGuidingSpatialNode &root = iteration->spatial_nodes[0];
+  root.axis = -1;
+  root.child = 0;
+  root.sampling_root = 0;
+  root.training_root = 0;
+  root.split = 0.0f;
+  root.num_samples = 0;
+  iteration->sampling_nodes.push_back(directional_empty_node());
+  iteration->training_nodes.push_back(directional_empty_node());
+  iteration->target_paths = (uint64_t)num_pixels;
+  iteration->update_field(true);
+
+  iterations.push_back(iteration);
+  current = iteration;
+}
+
+PathGuidingField *PathGuiding::acquire()
+{
+  thread_scoped_lock lock(mutex);
+
+  if (current == NULL) {
+    return NULL;
+  }
+
+  current->users++;
+
+  if (current->complete) {
+    /* The training trees are about to be read for building the next iteration, keep
+     * sampling the current one without recording until it is ready. */
+    return &current->sampling_field;
+  }
+
+  current->training_users++;
+  return &current->field;
+}
+
+void PathGuiding::release(PathGuidingField *field, int num_paths)
+{
+  if (field == NULL) {
+    return;
+  }
+
+  thread_scoped_lock lock(mutex);
+
+  Iteration *iteration = NULL;
+  foreach (Iteration *it, iterations) {
+    if (&it->field == field || &it->sampling_field == field) {
+      iteration = it;
+      break;
+    }
+  }
+  assert(iteration != NULL);
+  iteration->users--;
+
+  const bool is_training = (field == &iteration->field);
+  if (is_training) {
+    iteration->training_users--;
+  }
+
+  if (iteration != current || !iteration->field.use_training) {
+    free_unused_iterations();
+    return;
+  }
+
+  if (is_training) {
+    iteration->num_paths += num_paths;
+    if (iteration->num_paths >= iteration->target_paths) {
+      iteration->complete = true;
+    }
+  }
+
+  /* Wait for all threads to stop recording before the training trees are read, other threads
+   * would still add into them otherwise. */
+  if (building || !iteration->complete || iteration->training_users > 0) {
+    return;
+  }
+
+  /* Nothing writes into the training trees anymore, so build without holding the lock. Other
+   * threads keep sampling the current iteration in the meantime. */
+  building = true;
+  iteration->users++;
+  lock.unlock();
+
+  Iteration *next = build_next_iteration(iteration);
+
+  lock.lock();
+  iteration->users--;
+  iterations.push_back(next);
+  current = next;
+  building = false;
+
+  free_unused_iterations();
+}
+
+PathGuiding::Iteration *PathGuiding::build_next_iteration(Iteration *prev)
+{
+  Iteration *next = new Iteration(prev->index + 1);
+
+  /* Iteration k renders 2^k samples, continue training while the next iteration still fits
+   * into the training samples. */
+  const int64_t trained_samples = ((int64_t)2 << prev->index) - 1;
+  const int64_t next_samples = (int64_t)1 << next->index;
+  const bool use_training = (trained_samples + next_samples <= training_samples);
+
+  next->target_paths = (uint64_t)num_pixels * next_samples;
+
+  if (prev->spatial_bounds.valid()) {
+    next->spatial_bounds = prev->spatial_bounds;
+  }
+  else if (prev->bounds[0] <= prev->bounds[3]) {
+    const float3 bounds_min = make_float3(prev->bounds[0], prev->bounds[1], prev->bounds[2]);
+    const float3 bounds_max = make_float3(prev->bounds[3], prev->bounds[4], prev->bounds[5]);
+    const float3 border = max(bounds_max - bounds_min, make_float3(1e-4f, 1e-4f, 1e-4f)) *
+                          0.01f;
+    next->spatial_bounds = BoundBox(bounds_min - border, bounds_max + border);
+  }
+
+  SpatialBuildContext ctx;
+  ctx.prev_spatial_nodes = &prev->spatial_nodes;
+  ctx.prev_sampling_nodes = &prev->sampling_nodes;
+  ctx.prev_training_nodes = &prev->training_nodes;
+  ctx.prev_use_sampling = prev->field.use_sampling;
+  ctx.spatial_nodes = &next->spatial_nodes;
+  ctx.sampling_nodes = &next->sampling_nodes;
+  ctx.training_nodes = &next->training_nodes;
+  ctx.use_training = use_training;
+  /* Without bounds the spatial tree can not be split yet. */
+  ctx.split_threshold = (next->spatial_bounds.valid()) ?
+                            SPATIAL_SPLIT_THRESHOLD * sqrtf((float)((int64_t)1 << prev->index)) :
+                            FLT_MAX;
+  ctx.num_leaves = 0;
+
+  next->spatial_nodes.resize(1);
+  spatial_build(ctx, 0, 0, next->spatial_bounds, 0);
+
+  if (next->training_nodes.empty()) {
+    next->training_nodes.push_back(directional_empty_node());
+  }
+
+  next->update_field(use_training);
+
+  VLOG(1) << "Path guiding iteration " << next->index << ": " << ctx.num_leaves
+          << " spatial leaves, " << next->sampling_nodes.size() << " sampling nodes, "
+          << next->training_nodes.size() << " training nodes"
+          << (use_training ? "." : ", training finished.");
+
+  return next;
+}
+
+void PathGuiding::free_unused_iterations()
+{
+  for (size_t i = 0; i < iterations.size();) {
+    Iteration *iteration = iterations[i];
+    if (iteration != current && iteration->users == 0) {
+      delete iteration;
+      iterations.erase(iterations.begin() + i);
+    }
+    else {
+      i++;
+    }
+  }
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __DEVICE_PATH_GUIDING_H__
+#define __DEVICE_PATH_GUIDING_H__
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_thread.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Path Guiding
+ *
+ * Learns the incident radiance field the CPU kernels guide with. Rendering is split into
+ * iterations that each take twice as many samples per pixel as the previous one. Every
+ * iteration records path vertices into its own training trees and samples directions from
+ * the distribution learned in the previous iteration, after which the spatial and directional
+ * trees are refined from the recorded data. Once the training samples are used up, the last
+ * distribution is kept for the rest of the render. */
+
+class PathGuiding {
+ public:
+  PathGuiding();
+  ~PathGuiding();
+
+  /* Discard the learned distribution, must be called while no tiles are being rendered. */
+  void reset(bool use, int num_pixels, int training_samples);
+
+  /* Field to render a pass over a tile with, or NULL if path guiding is disabled. The field
+   * remains valid until it is released along with the number of paths traced with it. The
+   * next iteration is built once the current one recorded enough paths and all fields that
+   * record into it have been released. */
+  PathGuidingField *acquire();
+  void release(PathGuidingField *field, int num_paths);
+
+ protected:
+  struct Iteration;
+
+  Iteration *build_next_iteration(Iteration *iteration);
+  void free_unused_iterations();
+
+  thread_mutex mutex;
+  vector<Iteration *> iterations;
+  Iteration *current;
+  bool building;
+
+  int num_pixels;
+  int training_samples;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __DEVICE_PATH_GUIDING_H__ */
@@ -98,6 +98,20 @@ ccl_device_noinline_cpu float3 direct_emissive_eval(KernelGlobals *kg,
   return eval;
 }
 
+ccl_device_inline void direct_emission_bsdf_eval(KernelGlobals *kg,
+                                                  ShaderData *sd,
+                                                  LightSample *ls,
+                                                  BsdfEval *eval)
+{
+#ifdef __PATH_GUIDING__
+  if (path_guiding_use_sampling(kg, sd)) {
+    path_guiding_bsdf_eval(kg, sd, ls->D, eval, ls->pdf, ls->shader & SHADER_USE_MIS);
+    return;
+  }
+#endif
+  shader_bsdf_eval(kg, sd, ls->D, eval, ls->pdf, ls->shader & SHADER_USE_MIS);
+}
+
 ccl_device_noinline_cpu bool direct_emission(KernelGlobals *kg,
                                              ShaderData *sd,
                                              ShaderData *emission_sd,
@@ -126,7 +140,7 @@ ccl_device_noinline_cpu bool direct_emission(KernelGlobals *kg,
 
 #ifdef __VOLUME__
   if (sd->prim != PRIM_NONE)
-    shader_bsdf_eval(kg, sd, ls->D, eval, ls->pdf, ls->shader & SHADER_USE_MIS);
+    direct_emission_bsdf_eval(kg, sd, ls, eval);
   else {
     float bsdf_pdf;
     shader_volume_phase_eval(kg, sd, ls->D, eval, &bsdf_pdf);
@@ -137,7 +151,7 @@ ccl_device_noinline_cpu bool direct_emission(KernelGlobals *kg,
     }
   }
 #else
-  shader_bsdf_eval(kg, sd, ls->D, eval, ls->pdf, ls->shader & SHADER_USE_MIS);
+  direct_emission_bsdf_eval(kg, sd, ls, eval);
 #endif
 
   bsdf_eval_mul3(eval, light_eval / ls->pdf);
@@ -85,6 +85,14 @@ typedef struct KernelGlobals {
   int2 global_size;
   int2 global_id;
 
+#  ifdef __PATH_GUIDING__
+  /* Learned incident radiance, NULL when path guiding is not used. */
+  PathGuidingField *path_guiding;
+  /* Vertices of the current path recorded for training. */
+  PathGuidingVertex path_guiding_vertices[PATH_GUIDING_MAX_VERTICES];
+  int path_guiding_num_vertices;
+#  endif
+
   ProfilingState profiler;
 } KernelGlobals;
 
@@ -45,6 +45,7 @@
 
 #include "kernel/kernel_path_state.h"
 #include "kernel/kernel_shadow.h"
+#include "kernel/kernel_path_guiding.h"
 #include "kernel/kernel_emission.h"
 #include "kernel/kernel_path_common.h"
 #include "kernel/kernel_path_surface.h"
@@ -621,9 +622,20 @@ ccl_device_forceinline void kernel_path_integrate(KernelGlobals *kg,
       }
 #  endif
 
+#  ifdef __PATH_GUIDING__
+      const int bounce = state->bounce;
+#  endif
+
       /* compute direct lighting and next bounce */
       if (!kernel_path_surface_bounce(kg, &sd, &throughput, state, &L->state, ray))
         break;
+
+#  ifdef __PATH_GUIDING__
+      /* Transparent bounces leave the bounce count unchanged and are not recorded. */
+      if (state->bounce != bounce) {
+        path_guiding_record_vertex(kg, &sd, state, ray, throughput, L);
+      }
+#  endif
     }
 
 #  ifdef __SUBSURFACE__
@@ -631,6 +643,11 @@ ccl_device_forceinline void kernel_path_integrate(KernelGlobals *kg,
      * stack memory than invoking kernel_path_indirect.
      */
     if (ss_indirect.num_rays) {
+#    ifdef __PATH_GUIDING__
+      /* Indirect rays share the radiance accumulator, so incident radiance at the vertices
+       * can no longer be told apart. */
+      path_guiding_discard_path(kg);
+#    endif
       kernel_path_subsurface_setup_indirect(kg, &ss_indirect, state, ray, L, &throughput);
     }
     else {
@@ -688,9 +705,17 @@ ccl_device void kernel_path_trace(
       reinterpret_cast<unsigned char *>(&L)[-pass_stride + i] = 0;
 #  endif
 
+#  ifdef __PATH_GUIDING__
+  path_guiding_begin_path(kg);
+#  endif
+
   /* Integrate. */
   kernel_path_integrate(kg, &state, throughput, &ray, &L, buffer, emission_sd);
 
+#  ifdef __PATH_GUIDING__
+  path_guiding_end_path(kg, &L);
+#  endif
+
   kernel_write_result(kg, buffer, sample, &L);
 }
 
@@ -0,0 +1,442 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_PATH_GUIDING_H__
+#define __KERNEL_PATH_GUIDING_H__
+
+#ifdef __PATH_GUIDING__
+
+#  include "util/util_atomic.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Path Guiding
+ *
+ * Practical path guiding as described in "Practical Path Guiding for Efficient
+ * Light-Transport Simulation", Mueller et al. 2017. The field is built on the host in
+ * iterations of doubling length, see PathGuiding. While an iteration renders, path vertices
+ * are recorded into its training trees, and directions at surface bounces are sampled from
+ * a one-sample mixture of the BSDF and the sampling trees learned in the previous iteration.
+ */
+
+/* Cylindrical equal-area mapping between directions and the unit square. */
+
+ccl_device_inline float2 path_guiding_direction_to_square(const float3 D)
+{
+  const float cos_theta = clamp(D.z, -1.0f, 1.0f);
+  float phi = atan2f(D.y, D.x);
+  if (phi < 0.0f) {
+    phi += M_2PI_F;
+  }
+  return make_float2(clamp((cos_theta + 1.0f) * 0.5f, 0.0f, 1.0f),
+                     clamp(phi * M_1_2PI_F, 0.0f, 1.0f));
+}
+
+ccl_device_inline float3 path_guiding_square_to_direction(const float2 p)
+{
+  const float cos_theta = 2.0f * p.x - 1.0f;
+  const float sin_theta = safe_sqrtf(1.0f - cos_theta * cos_theta);
+  const float phi = M_2PI_F * p.y;
+  return make_float3(sin_theta * cosf(phi), sin_theta * sinf(phi), cos_theta);
+}
+
+ccl_device_inline int path_guiding_quadrant(float2 *p)
+{
+  /* Quadrants are numbered x + 2 * y, the position is remapped into the quadrant. */
+  const int qx = (p->x >= 0.5f) ? 1 : 0;
+  const int qy = (p->y >= 0.5f) ? 1 : 0;
+  p->x = min(p->x * 2.0f - qx, 1.0f);
+  p->y = min(p->y * 2.0f - qy, 1.0f);
+  return qx + 2 * qy;
+}
+
+ccl_device_inline float path_guiding_energy(const PathGuidingDirectionalNode *node)
+{
+  return node->energy[0] + node->energy[1] + node->energy[2] + node->energy[3];
+}
+
+ccl_device_inline PathGuidingSpatialNode *path_guiding_find_leaf(
+    const PathGuidingField *field, const float3 P)
+{
+  PathGuidingSpatialNode *node = field->spatial_nodes;
+  while (node->axis != -1) {
+    const float p = (node->axis == 0) ? P.x : ((node->axis == 1) ? P.y : P.z);
+    node = &field->spatial_nodes[(p < node->split) ? node->child : node->child + 1];
+  }
+  return node;
+}
+
+/* Sample a direction from a directional tree, with pdf with respect to solid angle. */
+ccl_device float3 path_guiding_directional_sample(const PathGuidingDirectionalNode *nodes,
+                                                  int root,
+                                                  float randu,
+                                                  float randv,
+                                                  float *pdf)
+{
+  const PathGuidingDirectionalNode *node = &nodes[root];
+  float2 origin = make_float2(0.0f, 0.0f);
+  float size = 1.0f;
+  float density = 1.0f;
+
+  for (;;) {
+    const float total = path_guiding_energy(node);
+    if (!(total > 0.0f)) {
+      /* Nothing was recorded here, sample the cell uniformly. */
+      break;
+    }
+
+    /* Pick the column first and then the quadrant in it, reusing the random numbers. */
+    const float left = node->energy[0] + node->energy[2];
+    const float fx = left / total;
+    int qx;
+    if (randu < fx) {
+      randu = randu / fx;
+      qx = 0;
+    }
+    else {
+      randu = (randu - fx) / (1.0f - fx);
+      qx = 1;
+    }
+
+    const float column = (qx == 0) ? left : node->energy[1] + node->energy[3];
+    const float fy = node->energy[qx] / column;
+    int qy;
+    if (randv < fy) {
+      randv = randv / fy;
+      qy = 0;
+    }
+    else {
+      randv = (randv - fy) / (1.0f - fy);
+      qy = 1;
+    }
+
+    randu = clamp(randu, 0.0f, 1.0f);
+    randv = clamp(randv, 0.0f, 1.0f);
+
+    const int q = qx + 2 * qy;
+    density *= 4.0f * node->energy[q] / total;
+    size *= 0.5f;
+    origin.x += qx * size;
+    origin.y += qy * size;
+
+    if (node->child[q] == 0) {
+      break;
+    }
+    node = &nodes[node->child[q]];
+  }
+
+  *pdf = density * M_1_PI_F * 0.25f;
+  return path_guiding_square_to_direction(
+      make_float2(origin.x + randu * size, origin.y + randv * size));
+}
+
+ccl_device float path_guiding_directional_pdf(const PathGuidingDirectionalNode *nodes,
+                                              int root,
+                                              const float3 D)
+{
+  const PathGuidingDirectionalNode *node = &nodes[root];
+  float2 p = path_guiding_direction_to_square(D);
+  float density = 1.0f;
+
+  for (;;) {
+    const float total = path_guiding_energy(node);
+    if (!(total > 0.0f)) {
+      break;
+    }
+
+    const int q = path_guiding_quadrant(&p);
+    density *= 4.0f * node->energy[q] / total;
+
+    if (node->child[q] == 0) {
+      break;
+    }
+    node = &nodes[node->child[q]];
+  }
+
+  return density * M_1_PI_F * 0.25f;
+}
+
+ccl_device void path_guiding_directional_splat(PathGuidingDirectionalNode *nodes,
+                                               int root,
+                                               const float3 D,
+                                               float value)
+{
+  PathGuidingDirectionalNode *node = &nodes[root];
+  float2 p = path_guiding_direction_to_square(D);
+
+  for (;;) {
+    const int q = path_guiding_quadrant(&p);
+    if (node->child[q] == 0) {
+      atomic_add_and_fetch_float(&node->energy[q], value);
+      return;
+    }
+    node = &nodes[node->child[q]];
+  }
+}
+
+/* Sampling */
+
+ccl_device_inline bool path_guiding_use_sampling(KernelGlobals *kg, const ShaderData *sd)
+{
+  return (kg->path_guiding != NULL) && kg->path_guiding->use_sampling &&
+         (sd->flag & SD_BSDF_HAS_EVAL);
+}
+
+ccl_device_inline int path_guiding_label(const ShaderData *sd, const float3 omega_in)
+{
+  /* Directions sampled from the field do not come from a particular closure, label them
+   * like the closure that is most likely to be picked for BSDF sampling. */
+  ClosureType type = CLOSURE_BSDF_DIFFUSE_ID;
+  float max_weight = 0.0f;
+
+  for (int i = 0; i < sd->num_closure; i++) {
+    const ShaderClosure *sc = &sd->closure[i];
+
+    if (CLOSURE_IS_BSDF(sc->type) && !CLOSURE_IS_BSDF_TRANSPARENT(sc->type) &&
+        sc->sample_weight > max_weight) {
+      type = sc->type;
+      max_weight = sc->sample_weight;
+    }
+  }
+
+  int label = (dot(sd->Ng, omega_in) > 0.0f) ? LABEL_REFLECT : LABEL_TRANSMIT;
+  label |= CLOSURE_IS_BSDF_DIFFUSE(type) ? LABEL_DIFFUSE : LABEL_GLOSSY;
+  return label;
+}
+
+/* Sample a direction from the mixture of the BSDF and the learned incident radiance, with the
+ * balance heuristic applied through the combined pdf. Singular directions can only be
+ * generated by the BSDF and keep the BSDF pdf scaled by its selection probability. */
+ccl_device int path_guiding_bsdf_sample(KernelGlobals *kg,
+                                        ShaderData *sd,
+                                        float randu,
+                                        float randv,
+                                        BsdfEval *bsdf_eval,
+                                        float3 *omega_in,
+                                        differential3 *domega_in,
+                                        float *pdf)
+{
+  const PathGuidingField *field = kg->path_guiding;
+  const PathGuidingSpatialNode *leaf = path_guiding_find_leaf(field, sd->P);
+  const PathGuidingDirectionalNode *nodes = field->sampling_nodes;
+
+  if (!(path_guiding_energy(&nodes[leaf->sampling_root]) > 0.0f)) {
+    return shader_bsdf_sample(kg, sd, randu, randv, bsdf_eval, omega_in, domega_in, pdf);
+  }
+
+  const float fraction = kernel_data.integrator.path_guiding_fraction;
+  float guide_pdf, bsdf_pdf;
+  int label;
+
+  if (randu < fraction) {
+    PROFILING_INIT(kg, PROFILING_CLOSURE_SAMPLE);
+
+    *omega_in = path_guiding_directional_sample(
+        nodes, leaf->sampling_root, randu / fraction, randv, &guide_pdf);
+#  ifdef __RAY_DIFFERENTIALS__
+    *domega_in = differential3_zero();
+#  endif
+
+    bsdf_eval_init(bsdf_eval,
+                   NBUILTIN_CLOSURES,
+                   make_float3(0.0f, 0.0f, 0.0f),
+                   kernel_data.film.use_light_pass);
+    _shader_bsdf_multi_eval(kg, sd, *omega_in, &bsdf_pdf, NULL, bsdf_eval, 0.0f, 0.0f);
+
+    label = path_guiding_label(sd, *omega_in);
+  }
+  else {
+    randu = (randu - fraction) / (1.0f - fraction);
+    label = shader_bsdf_sample(kg, sd, randu, randv, bsdf_eval, omega_in, domega_in, &bsdf_pdf);
+
+    if (bsdf_pdf == 0.0f) {
+      *pdf = 0.0f;
+      return label;
+    }
+
+    if (label & (LABEL_SINGULAR | LABEL_TRANSPARENT)) {
+      *pdf = (1.0f - fraction) * bsdf_pdf;
+      return label;
+    }
+
+    guide_pdf = path_guiding_directional_pdf(nodes, leaf->sampling_root, *omega_in);
+  }
+
+  *pdf = fraction * guide_pdf + (1.0f - fraction) * bsdf_pdf;
+  return label;
+}
+
+/* Pdf of path_guiding_bsdf_sample() generating a non-singular direction. */
+ccl_device float path_guiding_bsdf_pdf(KernelGlobals *kg,
+                                       const ShaderData *sd,
+                                       const float3 omega_in,
+                                       const float bsdf_pdf)
+{
+  const PathGuidingField *field = kg->path_guiding;
+  const PathGuidingSpatialNode *leaf = path_guiding_find_leaf(field, sd->P);
+  const PathGuidingDirectionalNode *nodes = field->sampling_nodes;
+
+  if (!(path_guiding_energy(&nodes[leaf->sampling_root]) > 0.0f)) {
+    return bsdf_pdf;
+  }
+
+  const float fraction = kernel_data.integrator.path_guiding_fraction;
+  const float guide_pdf = path_guiding_directional_pdf(nodes, leaf->sampling_root, omega_in);
+  return fraction * guide_pdf + (1.0f - fraction) * bsdf_pdf;
+}
+
+/* Evaluate the BSDF for a light sample. Indirect hits of the light are weighted with the pdf
+ * of the guided mixture, so the same pdf is used for multiple importance sampling here. */
+ccl_device void path_guiding_bsdf_eval(KernelGlobals *kg,
+                                       ShaderData *sd,
+                                       const float3 omega_in,
+                                       BsdfEval *eval,
+                                       float light_pdf,
+                                       bool use_mis)
+{
+  PROFILING_INIT(kg, PROFILING_CLOSURE_EVAL);
+
+  bsdf_eval_init(
+      eval, NBUILTIN_CLOSURES, make_float3(0.0f, 0.0f, 0.0f), kernel_data.film.use_light_pass);
+
+  float bsdf_pdf;
+  _shader_bsdf_multi_eval(kg, sd, omega_in, &bsdf_pdf, NULL, eval, 0.0f, 0.0f);
+  if (use_mis) {
+    const float pdf = path_guiding_bsdf_pdf(kg, sd, omega_in, bsdf_pdf);
+    bsdf_eval_mis(eval, power_heuristic(light_pdf, pdf));
+  }
+}
+
+/* Training */
+
+ccl_device_inline float3 path_guiding_radiance_sum(const PathRadiance *L)
+{
+#  ifdef __PASSES__
+  if (L->use_light_pass) {
+    /* Contributions are only split into passes at the end of the path, sum the raw
+     * accumulators. */
+    return L->emission + L->background + L->direct_emission + L->indirect +
+           L->direct_diffuse + L->direct_glossy + L->direct_transmission + L->direct_volume;
+  }
+#  endif
+  return L->emission;
+}
+
+ccl_device_inline void path_guiding_begin_path(KernelGlobals *kg)
+{
+  const PathGuidingField *field = kg->path_guiding;
+  kg->path_guiding_num_vertices = (field != NULL && field->use_training) ? 0 : -1;
+}
+
+ccl_device_inline void path_guiding_discard_path(KernelGlobals *kg)
+{
+  kg->path_guiding_num_vertices = -1;
+}
+
+ccl_device_inline void path_guiding_record_vertex(KernelGlobals *kg,
+                                                  const ShaderData *sd,
+                                                  const PathState *state,
+                                                  const Ray *ray,
+                                                  const float3 throughput,
+                                                  const PathRadiance *L)
+{
+  const int num_vertices = kg->path_guiding_num_vertices;
+  if (num_vertices < 0 || num_vertices >= PATH_GUIDING_MAX_VERTICES) {
+    return;
+  }
+  /* Singular directions carry no information about the directional distribution. */
+  if (state->flag & PATH_RAY_SINGULAR) {
+    return;
+  }
+
+  PathGuidingVertex *vertex = &kg->path_guiding_vertices[num_vertices];
+  vertex->P = sd->P;
+  vertex->D = ray->D;
+  vertex->throughput = throughput;
+  vertex->radiance = path_guiding_radiance_sum(L);
+  vertex->pdf = state->ray_pdf;
+  kg->path_guiding_num_vertices = num_vertices + 1;
+}
+
+ccl_device_inline void path_guiding_atomic_min(float *dest, const float value)
+{
+  float old_value = *dest;
+  while (value < old_value) {
+    const float prev_value = atomic_compare_and_swap_float(dest, old_value, value);
+    if (prev_value == old_value) {
+      break;
+    }
+    old_value = prev_value;
+  }
+}
+
+ccl_device_inline void path_guiding_atomic_max(float *dest, const float value)
+{
+  float old_value = *dest;
+  while (value > old_value) {
+    const float prev_value = atomic_compare_and_swap_float(dest, old_value, value);
+    if (prev_value == old_value) {
+      break;
+    }
+    old_value = prev_value;
+  }
+}
+
+/* Splat the incident radiance estimated at every recorded vertex into the training trees,
+ * which is the radiance the path gathered after the vertex divided by its throughput. */
+ccl_device void path_guiding_end_path(KernelGlobals *kg, const PathRadiance *L)
+{
+  const int num_vertices = kg->path_guiding_num_vertices;
+  kg->path_guiding_num_vertices = -1;
+  if (num_vertices <= 0) {
+    return;
+  }
+
+  PathGuidingField *field = kg->path_guiding;
+  const float3 radiance = path_guiding_radiance_sum(L);
+  float3 bounds_min = make_float3(FLT_MAX, FLT_MAX, FLT_MAX);
+  float3 bounds_max = -bounds_min;
+
+  for (int i = 0; i < num_vertices; i++) {
+    const PathGuidingVertex *vertex = &kg->path_guiding_vertices[i];
+    bounds_min = min(bounds_min, vertex->P);
+    bounds_max = max(bounds_max, vertex->P);
+
+    PathGuidingSpatialNode *leaf = path_guiding_find_leaf(field, vertex->P);
+    atomic_fetch_and_add_uint32(&leaf->num_samples, 1);
+
+    const float3 incident = safe_divide_color(radiance - vertex->radiance, vertex->throughput);
+    const float value = average(incident) / vertex->pdf;
+    if (value > 0.0f && isfinite_safe(value)) {
+      path_guiding_directional_splat(field->training_nodes, leaf->training_root, vertex->D, value);
+    }
+  }
+
+  if (field->use_bounds) {
+    path_guiding_atomic_min(&field->bounds[0], bounds_min.x);
+    path_guiding_atomic_min(&field->bounds[1], bounds_min.y);
+    path_guiding_atomic_min(&field->bounds[2], bounds_min.z);
+    path_guiding_atomic_max(&field->bounds[3], bounds_max.x);
+    path_guiding_atomic_max(&field->bounds[4], bounds_max.y);
+    path_guiding_atomic_max(&field->bounds[5], bounds_max.z);
+  }
+}
+
+CCL_NAMESPACE_END
+
+#endif /* __PATH_GUIDING__ */
+
+#endif /* __KERNEL_PATH_GUIDING_H__ */
@@ -128,6 +128,7 @@ CCL_NAMESPACE_BEGIN
 #  endif
 #  define __VOLUME_DECOUPLED__
 #  define __VOLUME_RECORD_ALL__
+#  define __PATH_GUIDING__
 #endif /* __KERNEL_CPU__ */
 
 #ifdef __KERNEL_CUDA__
@@ -1109,6 +1110,64 @@ typedef struct SubsurfaceIndirectRays {
 } SubsurfaceIndirectRays;
 static_assert(BSSRDF_MAX_HITS <= LOCAL_MAX_HITS, "BSSRDF hits too high.");
 
+/* Path Guiding
+ *
+ * Incident radiance learned while rendering, stored as a binary tree over space with a
+ * quadtree over directions in every leaf. Directions are mapped to the unit square with
+ * the cylindrical equal-area mapping, so quadtree cells have equal solid angle. */
+
+#ifdef __PATH_GUIDING__
+
+/* Number of path vertices per path recorded for training, further vertices are skipped. */
+#  define PATH_GUIDING_MAX_VERTICES 32
+
+typedef struct PathGuidingSpatialNode {
+  /* Split axis, or -1 for leaf nodes. */
+  int axis;
+  /* Index of the first child, the second child is stored right after it. */
+  int child;
+  /* Roots of the directional trees used for sampling and recording, for leaf nodes. */
+  int sampling_root;
+  int training_root;
+  /* Position of the split plane along the axis. */
+  float split;
+  /* Number of vertices recorded into the leaf during the current iteration. */
+  uint num_samples;
+} PathGuidingSpatialNode;
+
+typedef struct PathGuidingDirectionalNode {
+  /* Radiance arriving through each quadrant. */
+  float energy[4];
+  /* Index of the node subdividing each quadrant, 0 for quadrants that are not subdivided. */
+  int child[4];
+} PathGuidingDirectionalNode;
+
+typedef struct PathGuidingField {
+  PathGuidingSpatialNode *spatial_nodes;
+  const PathGuidingDirectionalNode *sampling_nodes;
+  PathGuidingDirectionalNode *training_nodes;
+  /* Bounds of the recorded vertices, only gathered during the first iteration. */
+  float *bounds;
+  /* Whether the sampling trees contain a learned distribution. */
+  int use_sampling;
+  /* Whether path vertices are recorded into the training trees. */
+  int use_training;
+  int use_bounds;
+} PathGuidingField;
+
+typedef struct PathGuidingVertex {
+  float3 P;
+  float3 D;
+  /* Path throughput after scattering into D. */
+  float3 throughput;
+  /* Radiance gathered by the path before scattering into D. */
+  float3 radiance;
+  /* Probability density with which D was sampled. */
+  float pdf;
+} PathGuidingVertex;
+
+#endif /* __PATH_GUIDING__ */
+
 /* Constant Kernel Data
  *
  * These structs are passed from CPU to various devices, and the struct layout
@@ -1389,7 +1448,12 @@ typedef struct KernelIntegrator {
 
   int max_closures;
 
-  int pad1, pad2;
+  /* path guiding */
+  int use_path_guiding;
+  int path_guiding_training_samples;
+  float path_guiding_fraction;
+
+  int pad1, pad2, pad3;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
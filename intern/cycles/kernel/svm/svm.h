@@ -381,6 +381,9 @@ ccl_device_noinline void svm_eval_nodes(KernelGlobals *kg,
       case NODE_MATH:
         svm_node_math(kg, sd, stack, node.y, node.z, node.w, &offset);
         break;
+      case NODE_MATH_CHAIN:
+        svm_node_math_chain(kg, sd, stack, node.y, node.z, &offset);
+        break;
       case NODE_VECTOR_MATH:
         svm_node_vector_math(kg, sd, stack, node.y, node.z, node.w, &offset);
         break;
@@ -480,6 +483,9 @@ ccl_device_noinline void svm_eval_nodes(KernelGlobals *kg,
       case NODE_MIX:
         svm_node_mix(kg, sd, stack, node.y, node.z, node.w, &offset);
         break;
+      case NODE_MIX_CHAIN:
+        svm_node_mix_chain(kg, sd, stack, node.y, node.z, &offset);
+        break;
       case NODE_SEPARATE_VECTOR:
         svm_node_separate_vector(sd, stack, node.y, node.z, node.w);
         break;
@@ -35,6 +35,48 @@ ccl_device void svm_node_math(KernelGlobals *kg,
   stack_store_float(stack, result_stack_offset, result);
 }
 
+/* Evaluate a chain of math operations, where each step takes the result of the previous
+ * one as one of its inputs. Inputs that are not linked are embedded in the node. */
+ccl_device void svm_node_math_chain(KernelGlobals *kg,
+                                    ShaderData *sd,
+                                    float *stack,
+                                    uint num_steps,
+                                    uint result_stack_offset,
+                                    int *offset)
+{
+  float result = 0.0f;
+
+  for (uint i = 0; i < num_steps; i++) {
+    uint4 step = read_node(kg, offset);
+
+    uint type_chain_index, a_stack_offset, b_stack_offset, c_stack_offset;
+    svm_unpack_node_uchar4(
+        step.x, &type_chain_index, &a_stack_offset, &b_stack_offset, &c_stack_offset);
+
+    float a = stack_load_float_default(stack, a_stack_offset, step.y);
+    float b = stack_load_float_default(stack, b_stack_offset, step.z);
+    float c = stack_load_float_default(stack, c_stack_offset, step.w);
+
+    switch (type_chain_index >> 6) {
+      case 0:
+        a = result;
+        break;
+      case 1:
+        b = result;
+        break;
+      case 2:
+        c = result;
+        break;
+      default:
+        break;
+    }
+
+    result = svm_math((NodeMathType)(type_chain_index & 0x3F), a, b, c);
+  }
+
+  stack_store_float(stack, result_stack_offset, result);
+}
+
 ccl_device void svm_node_vector_math(KernelGlobals *kg,
                                      ShaderData *sd,
                                      float *stack,
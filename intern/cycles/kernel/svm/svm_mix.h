@@ -37,4 +37,36 @@ ccl_device void svm_node_mix(KernelGlobals *kg,
   stack_store_float3(stack, node1.z, result);
 }
 
+/* Evaluate a chain of mix operations, where each step takes the result of the previous one
+ * as one of its colors. Factors that are not linked are embedded in the node. */
+ccl_device void svm_node_mix_chain(KernelGlobals *kg,
+                                   ShaderData *sd,
+                                   float *stack,
+                                   uint num_steps,
+                                   uint result_stack_offset,
+                                   int *offset)
+{
+  float3 result = make_float3(0.0f, 0.0f, 0.0f);
+
+  for (uint i = 0; i < num_steps; i++) {
+    uint4 step = read_node(kg, offset);
+
+    uint type, chain_flags, fac_stack_offset, c1_stack_offset;
+    svm_unpack_node_uchar4(
+        step.x, &type, &chain_flags, &fac_stack_offset, &c1_stack_offset);
+
+    const uint chain_index = chain_flags & ~SVM_MIX_CHAIN_CLAMP;
+    float fac = stack_load_float_default(stack, fac_stack_offset, step.z);
+    float3 c1 = (chain_index == 1) ? result : stack_load_float3(stack, c1_stack_offset);
+    float3 c2 = (chain_index == 2) ? result : stack_load_float3(stack, step.y);
+
+    result = svm_mix((NodeMix)type, fac, c1, c2);
+    if (chain_flags & SVM_MIX_CHAIN_CLAMP) {
+      result = svm_mix_clamp(result);
+    }
+  }
+
+  stack_store_float3(stack, result_stack_offset, result);
+}
+
 CCL_NAMESPACE_END
@@ -26,6 +26,14 @@ CCL_NAMESPACE_BEGIN
 /* SVM stack offsets with this value indicate that it's not on the stack */
 #define SVM_STACK_INVALID 255
 
+/* Input index of a NODE_MATH_CHAIN step that does not read the result of the previous step. */
+#define SVM_MATH_CHAIN_NONE 3
+
+/* Input index of a NODE_MIX_CHAIN step that does not read the result of the previous step,
+ * and flag for clamping the result of a step. */
+#define SVM_MIX_CHAIN_NONE 3
+#define SVM_MIX_CHAIN_CLAMP 4
+
 #define SVM_BUMP_EVAL_STATE_SIZE 9
 
 /* Nodes */
@@ -105,6 +113,7 @@ typedef enum ShaderNodeType {
   NODE_CLOSURE_VOLUME,
   NODE_PRINCIPLED_VOLUME,
   NODE_MATH,
+  NODE_MATH_CHAIN,
   NODE_VECTOR_MATH,
   NODE_RGB_RAMP,
   NODE_GAMMA,
@@ -136,6 +145,7 @@ typedef enum ShaderNodeType {
   NODE_NORMAL_MAP,
   NODE_INVERT,
   NODE_MIX,
+  NODE_MIX_CHAIN,
   NODE_SEPARATE_VECTOR,
   NODE_COMBINE_VECTOR,
   NODE_SEPARATE_HSV,
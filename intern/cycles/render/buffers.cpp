@@ -105,6 +105,100 @@ int BufferParams::get_denoising_prefiltered_offset()
   return offset;
 }
 
+static PassStorage get_pass_component_storage(PassType type, int component)
+{
+  switch (type) {
+    case PASS_COMBINED:
+    case PASS_MIST:
+    case PASS_EMISSION:
+    case PASS_BACKGROUND:
+    case PASS_AO:
+    case PASS_SHADOW:
+    case PASS_DIFFUSE_DIRECT:
+    case PASS_DIFFUSE_INDIRECT:
+    case PASS_DIFFUSE_COLOR:
+    case PASS_GLOSSY_DIRECT:
+    case PASS_GLOSSY_INDIRECT:
+    case PASS_GLOSSY_COLOR:
+    case PASS_TRANSMISSION_DIRECT:
+    case PASS_TRANSMISSION_INDIRECT:
+    case PASS_TRANSMISSION_COLOR:
+    case PASS_VOLUME_DIRECT:
+    case PASS_VOLUME_INDIRECT:
+    case PASS_AOV_COLOR:
+    case PASS_AOV_VALUE:
+      return PASS_STORAGE_HALF;
+    case PASS_NORMAL:
+      return PASS_STORAGE_SNORM16;
+    case PASS_CRYPTOMATTE:
+      /* Packed as exact object IDs and half float weights. */
+      return (component % 2 == 0) ? PASS_STORAGE_FLOAT : PASS_STORAGE_HALF;
+    default:
+      return PASS_STORAGE_FLOAT;
+  }
+}
+
+static PassStorage get_denoising_component_storage(int component)
+{
+  if (component >= DENOISING_PASS_SIZE_BASE) {
+    /* Clean pass. */
+    return PASS_STORAGE_HALF;
+  }
+  /* Features and variances are the input of the denoiser. The variances are computed from the
+   * difference of accumulated squares which cancels badly at reduced precision, so all of them
+   * are kept as float. */
+  return PASS_STORAGE_FLOAT;
+}
+
+void BufferParams::get_pass_storage(vector<PassStorage> &storage)
+{
+  storage.clear();
+  storage.resize(get_passes_size(), PASS_STORAGE_NONE);
+
+  int offset = 0;
+
+  for (size_t i = 0; i < passes.size(); i++) {
+    for (int j = 0; j < passes[i].components; j++) {
+      storage[offset + j] = get_pass_component_storage(passes[i].type, j);
+    }
+    offset += passes[i].components;
+  }
+
+  if (denoising_data_pass) {
+    int size = DENOISING_PASS_SIZE_BASE;
+    if (denoising_clean_pass) {
+      size += DENOISING_PASS_SIZE_CLEAN;
+    }
+    for (int j = 0; j < size; j++) {
+      storage[offset + j] = get_denoising_component_storage(j);
+    }
+    offset += size;
+
+    /* Prefiltered passes are kept at full precision, they are the input of the
+     * reconstruction of neighboring tiles. */
+    if (denoising_prefiltered_pass) {
+      for (int j = 0; j < DENOISING_PASS_SIZE_PREFILTERED; j++) {
+        storage[offset + j] = PASS_STORAGE_FLOAT;
+      }
+    }
+  }
+}
+
+static size_t get_pass_storage_size(PassStorage storage)
+{
+  switch (storage) {
+    case PASS_STORAGE_FLOAT:
+      return sizeof(float);
+    case PASS_STORAGE_HALF:
+      return sizeof(half);
+    case PASS_STORAGE_SNORM16:
+      return sizeof(int16_t);
+    case PASS_STORAGE_NONE:
+      break;
+  }
+  return 0;
+}
+
 /* Render Buffer Task */
 
 RenderTile::RenderTile()
@@ -132,7 +226,10 @@ RenderTile::RenderTile()
 RenderBuffers::RenderBuffers(Device *device)
     : buffer(device, "RenderBuffers", MEM_READ_WRITE),
       map_neighbor_copied(false),
-      render_time(0.0f)
+      render_time(0.0f),
+      compact_pinned(false),
+      compact_requested(false),
+      map_users(0)
 {
 }
 
@@ -145,6 +242,10 @@ void RenderBuffers::reset(BufferParams &params_)
 {
   params = params_;
 
+  compact_data.free_memory();
+  compact_scale.free_memory();
+  compact_requested = false;
+
   /* re-allocate buffer */
   buffer.alloc(params.width * params.get_passes_size(), params.height);
   buffer.zero_to_device();
@@ -155,8 +256,203 @@ void RenderBuffers::zero()
   buffer.zero_to_device();
 }
 
+void RenderBuffers::request_compact()
+{
+  thread_scoped_lock lock(compact_mutex);
+  compact_requested = true;
+}
+
+void RenderBuffers::compact()
+{
+  thread_scoped_lock lock(compact_mutex);
+
+  if (!compact_requested || map_users > 0) {
+    return;
+  }
+  compact_requested = false;
+
+  if (is_compact() || !copy_from_device()) {
+    return;
+  }
+
+  vector<PassStorage> storage;
+  params.get_pass_storage(storage);
+
+  const int pass_stride = params.get_passes_size();
+  const size_t num_pixels = (size_t)params.width * params.height;
+
+  /* One plane per component, aligned so float planes can be accessed directly. */
+  size_t size = 0;
+  for (int c = 0; c < pass_stride; c++) {
+    size += align_up(num_pixels * get_pass_storage_size(storage[c]), sizeof(float));
+  }
+
+  compact_data.resize(size);
+  compact_scale.resize(pass_stride);
+
+  uchar *out = compact_data.data();
+
+  for (int c = 0; c < pass_stride; c++) {
+    const float *in = buffer.data() + c;
+
+    float max_abs = 0.0f;
+    if (storage[c] == PASS_STORAGE_HALF || storage[c] == PASS_STORAGE_SNORM16) {
+      for (size_t i = 0; i < num_pixels; i++) {
+        const float f = fabsf(in[i * pass_stride]);
+        if (isfinite_safe(f)) {
+          max_abs = max(max_abs, f);
+        }
+      }
+    }
+
+    switch (storage[c]) {
+      case PASS_STORAGE_NONE:
+        compact_scale[c] = 0.0f;
+        break;
+      case PASS_STORAGE_FLOAT: {
+        float *f = (float *)out;
+        for (size_t i = 0; i < num_pixels; i++) {
+          f[i] = in[i * pass_stride];
+        }
+        compact_scale[c] = 1.0f;
+        break;
+      }
+      case PASS_STORAGE_HALF: {
+        /* Accumulated values easily exceed the half float range, scale by a power of two
+         * so that the relative precision is not affected. */
+        const float scale = (max_abs > 0.0f) ? exp2f(ceilf(log2f(max_abs)) - 15.0f) : 1.0f;
+        const float inv_scale = 1.0f / scale;
+        half *h = (half *)out;
+        for (size_t i = 0; i < num_pixels; i++) {
+          h[i] = float_to_half(in[i * pass_stride] * inv_scale);
+        }
+        compact_scale[c] = scale;
+        break;
+      }
+      case PASS_STORAGE_SNORM16: {
+        const float scale = (max_abs > 0.0f) ? max_abs : 1.0f;
+        const float inv_scale = 32767.0f / scale;
+        int16_t *q = (int16_t *)out;
+        for (size_t i = 0; i < num_pixels; i++) {
+          const float f = clamp(in[i * pass_stride] * inv_scale, -32767.0f, 32767.0f);
+          q[i] = (int16_t)((f < 0.0f) ? f - 0.5f : f + 0.5f);
+        }
+        compact_scale[c] = scale / 32767.0f;
+        break;
+      }
+    }
+
+    out += align_up(num_pixels * get_pass_storage_size(storage[c]), sizeof(float));
+  }
+
+  buffer.free();
+}
+
+void RenderBuffers::decode_compact(float *data)
+{
+  vector<PassStorage> storage;
+  params.get_pass_storage(storage);
+
+  const int pass_stride = params.get_passes_size();
+  const size_t num_pixels = (size_t)params.width * params.height;
+
+  const uchar *in = compact_data.data();
+
+  for (int c = 0; c < pass_stride; c++) {
+    float *out = data + c;
+    const float scale = compact_scale[c];
+
+    switch (storage[c]) {
+      case PASS_STORAGE_NONE:
+        for (size_t i = 0; i < num_pixels; i++) {
+          out[i * pass_stride] = 0.0f;
+        }
+        break;
+      case PASS_STORAGE_FLOAT: {
+        const float *f = (const float *)in;
+        for (size_t i = 0; i < num_pixels; i++) {
+          out[i * pass_stride] = f[i];
+        }
+        break;
+      }
+      case PASS_STORAGE_HALF: {
+        const half *h = (const half *)in;
+        for (size_t i = 0; i < num_pixels; i++) {
+          half value = h[i];
+          /* half_to_float() does not handle zero. */
+          out[i * pass_stride] = (value & 0x7FFF) ? half_to_float(value) * scale : 0.0f;
+        }
+        break;
+      }
+      case PASS_STORAGE_SNORM16: {
+        const int16_t *q = (const int16_t *)in;
+        for (size_t i = 0; i < num_pixels; i++) {
+          out[i * pass_stride] = q[i] * scale;
+        }
+        break;
+      }
+    }
+
+    in += align_up(num_pixels * get_pass_storage_size(storage[c]), sizeof(float));
+  }
+}
+
+void RenderBuffers::expand()
+{
+  thread_scoped_lock lock(compact_mutex);
+  expand_locked();
+}
+
+void RenderBuffers::map_neighbor()
+{
+  thread_scoped_lock lock(compact_mutex);
+  map_users++;
+  expand_locked();
+}
+
+void RenderBuffers::unmap_neighbor()
+{
+  thread_scoped_lock lock(compact_mutex);
+  map_users--;
+}
+
+void RenderBuffers::expand_locked()
+{
+  compact_requested = false;
+
+  if (!is_compact()) {
+    return;
+  }
+
+  buffer.alloc(params.width * params.get_passes_size(), params.height);
+  decode_compact(buffer.data());
+  buffer.copy_to_device();
+
+  compact_data.free_memory();
+  compact_scale.free_memory();
+
+  map_neighbor_copied = false;
+}
+
+const float *RenderBuffers::get_float_data(vector<float> &decoded)
+{
+  if (!is_compact()) {
+    return buffer.data();
+  }
+
+  /* Conversion back to float only happens for reading the passes of a tile. */
+  decoded.resize((size_t)params.width * params.get_passes_size() * params.height);
+  decode_compact(decoded.data());
+  return decoded.data();
+}
+
 bool RenderBuffers::copy_from_device()
 {
+  if (is_compact()) {
+    /* Compact storage only exists on the host. */
+    return true;
+  }
+
   if (!buffer.device_pointer)
     return false;
 
@@ -168,7 +464,10 @@ bool RenderBuffers::copy_from_device()
 bool RenderBuffers::get_denoising_pass_rect(
     int type, float exposure, int sample, int components, float *pixels)
 {
-  if (buffer.data() == NULL) {
+  vector<float> decoded;
+  const float *data = get_float_data(decoded);
+
+  if (data == NULL) {
     return false;
   }
 
@@ -215,7 +514,7 @@ bool RenderBuffers::get_denoising_pass_rect(
   int pass_stride = params.get_passes_size();
   int size = params.width * params.height;
 
-  float *in = buffer.data() + offset;
+  const float *in = data + offset;
 
   if (components == 1) {
     for (int i = 0; i < size; i++, in += pass_stride, pixels++) {
@@ -232,7 +531,7 @@ bool RenderBuffers::get_denoising_pass_rect(
   else if (components == 4) {
     /* Since the alpha channel is not involved in denoising, output the Combined alpha channel. */
     assert(params.passes[0].type == PASS_COMBINED);
-    float *in_combined = buffer.data();
+    const float *in_combined = data;
 
     for (int i = 0; i < size; i++, in += pass_stride, in_combined += pass_stride, pixels += 4) {
       float3 val = make_float3(in[0], in[1], in[2]);
@@ -256,11 +555,14 @@ bool RenderBuffers::get_denoising_pass_rect(
 bool RenderBuffers::get_pass_rect(
     const string &name, float exposure, int sample, int components, float *pixels)
 {
-  if (buffer.data() == NULL) {
+  vector<float> decoded;
+  const float *data = get_float_data(decoded);
+
+  if (data == NULL) {
     return false;
   }
 
-  float *sample_count = NULL;
+  const float *sample_count = NULL;
   if (name == "Combined") {
     int sample_offset = 0;
     for (size_t j = 0; j < params.passes.size(); j++) {
@@ -270,7 +572,7 @@ bool RenderBuffers::get_pass_rect(
         continue;
       }
       else {
-        sample_count = buffer.data() + sample_offset;
+        sample_count = data + sample_offset;
         break;
       }
     }
@@ -290,7 +592,7 @@ bool RenderBuffers::get_pass_rect(
 
     PassType type = pass.type;
 
-    float *in = buffer.data() + pass_offset;
+    const float *in = data + pass_offset;
     int pass_stride = params.get_passes_size();
 
     float scale = (pass.filter) ? 1.0f / (float)sample : 1.0f;
@@ -361,7 +663,7 @@ bool RenderBuffers::get_pass_rect(
           pass_offset += color_pass.components;
         }
 
-        float *in_divide = buffer.data() + pass_offset;
+        const float *in_divide = data + pass_offset;
 
         for (int i = 0; i < size; i++, in += pass_stride, in_divide += pass_stride, pixels += 3) {
           float3 f = make_float3(in[0], in[1], in[2]);
@@ -410,7 +712,7 @@ bool RenderBuffers::get_pass_rect(
           pass_offset += color_pass.components;
         }
 
-        float *in_weight = buffer.data() + pass_offset;
+        const float *in_weight = data + pass_offset;
 
         for (int i = 0; i < size; i++, in += pass_stride, in_weight += pass_stride, pixels += 4) {
           float4 f = make_float4(in[0], in[1], in[2], in[3]);
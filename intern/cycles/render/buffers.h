@@ -34,6 +34,23 @@ class Device;
 struct DeviceDrawParams;
 struct float4;
 
+/* Pass Storage
+ *
+ * Precision used for a single buffer component while render buffers are kept
+ * around in compact form, e.g. for tiles waiting for their neighbors to be
+ * denoised. The kernels always accumulate into full float buffers. */
+
+typedef enum PassStorage {
+  /* Padding, not stored at all. */
+  PASS_STORAGE_NONE = 0,
+  /* Exact 32 bit float, for depth, IDs, motion and sample counts. */
+  PASS_STORAGE_FLOAT,
+  /* Half float scaled by a power of two per component, for colors. */
+  PASS_STORAGE_HALF,
+  /* 16 bit signed integer normalized by the component range, for normals. */
+  PASS_STORAGE_SNORM16,
+} PassStorage;
+
 /* Buffer Parameters
  * Size of render buffer and how it fits in the full image (border render). */
 
@@ -67,6 +84,9 @@ class BufferParams {
   int get_passes_size();
   int get_denoising_offset();
   int get_denoising_prefiltered_offset();
+
+  /* Storage precision of every component in a pixel, pass_stride entries. */
+  void get_pass_storage(vector<PassStorage> &storage);
 };
 
 /* Render Buffers */
@@ -81,18 +101,59 @@ class RenderBuffers {
   bool map_neighbor_copied;
   double render_time;
 
+  /* Set while the buffer is compacted outside of the tile mutex of the session, the buffer
+   * must not be freed until it is cleared again. Protected by the tile mutex of the session. */
+  bool compact_pinned;
+
   explicit RenderBuffers(Device *device);
   ~RenderBuffers();
 
   void reset(BufferParams &params);
   void zero();
 
+  /* Compact storage: copy the buffer to the host in the precision given by
+   * BufferParams::get_pass_storage() and free the float buffer. Expanding restores
+   * the float buffer on the device, reading passes works on either form.
+   *
+   * Compaction is expensive and runs without holding the tile mutex of the session, so it
+   * only happens when requested beforehand and the buffer was neither expanded nor mapped as
+   * a neighbor tile since. */
+  void request_compact();
+  void compact();
+  void expand();
+
+  /* Denoising tasks using the buffer as a neighbor tile, which keep it expanded. */
+  void map_neighbor();
+  void unmap_neighbor();
+  bool is_compact() const
+  {
+    return !compact_data.empty();
+  }
+  size_t compact_size() const
+  {
+    return compact_data.size();
+  }
+
   bool copy_from_device();
   bool get_pass_rect(
       const string &name, float exposure, int sample, int components, float *pixels);
   bool get_denoising_pass_rect(
       int offset, float exposure, int sample, int components, float *pixels);
   bool set_pass_rect(PassType type, int components, float *pixels, int samples);
+
+ protected:
+  /* Component planes of the compact storage, and per component scale factors. */
+  vector<uchar> compact_data;
+  vector<float> compact_scale;
+
+  /* Protects the compact storage, the request and the neighbor users. */
+  thread_mutex compact_mutex;
+  bool compact_requested;
+  int map_users;
+
+  void expand_locked();
+  void decode_compact(float *data);
+  const float *get_float_data(vector<float> &decoded);
 };
 
 /* Display Buffer
@@ -41,6 +41,7 @@
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -1265,6 +1266,16 @@ void GeometryManager::device_update(Device *device,
   }
 
   /* Tessellate meshes that are using subdivision */
+  SubdDiceCache *cache = NULL;
+  if (scene->params.use_dice_cache) {
+    dice_cache.set_memory_limit(scene->params.dice_cache_memory);
+    dice_cache.prune(scene->geometry);
+    cache = &dice_cache;
+  }
+  else {
+    dice_cache.clear();
+  }
+
   if (total_tess_needed) {
     Camera *dicing_camera = scene->dicing_camera;
     dicing_camera->update(scene);
@@ -1288,7 +1299,7 @@ void GeometryManager::device_update(Device *device,
         progress.set_status("Updating Mesh", msg);
 
         mesh->subd_params->camera = dicing_camera;
-        DiagSplit dsplit(*mesh->subd_params);
+        DiagSplit dsplit(*mesh->subd_params, cache);
         mesh->tessellate(&dsplit);
 
         i++;
@@ -1355,6 +1366,7 @@ void GeometryManager::device_update(Device *device,
       return;
   }
 
+  scoped_timer bvh_timer;
   TaskPool pool;
 
   size_t i = 0;
@@ -1371,6 +1383,7 @@ void GeometryManager::device_update(Device *device,
   TaskPool::Summary summary;
   pool.wait_work(&summary);
   VLOG(2) << "Objects BVH build pool statistics:\n" << summary.full_report();
+  scene->update_times.bvh += bvh_timer.get_time();
 
   foreach (Shader *shader, scene->shaders) {
     shader->need_update_geometry = false;
@@ -1388,7 +1401,11 @@ void GeometryManager::device_update(Device *device,
   if (progress.get_cancel())
     return;
 
-  device_update_bvh(device, dscene, scene, progress);
+  {
+    scoped_timer timer;
+    device_update_bvh(device, dscene, scene, progress);
+    scene->update_times.bvh += timer.get_time();
+  }
   if (progress.get_cancel())
     return;
 
@@ -23,6 +23,8 @@
 
 #include "render/attribute.h"
 
+#include "subd/subd_dice_cache.h"
+
 #include "util/util_boundbox.h"
 #include "util/util_set.h"
 #include "util/util_transform.h"
@@ -150,6 +152,9 @@ class GeometryManager {
   bool need_update;
   bool need_flags_update;
 
+  /* Diced geometry of adaptively subdivided meshes from previous updates. */
+  SubdDiceCache dice_cache;
+
   /* Constructor/Destructor */
   GeometryManager();
   ~GeometryManager();
@@ -78,6 +78,10 @@ NODE_DEFINE(Integrator)
   SOCKET_BOOLEAN(sample_all_lights_indirect, "Sample All Lights Indirect", true);
   SOCKET_FLOAT(light_sampling_threshold, "Light Sampling Threshold", 0.05f);
 
+  SOCKET_BOOLEAN(use_path_guiding, "Use Path Guiding", false);
+  SOCKET_INT(path_guiding_training_samples, "Path Guiding Training Samples", 128);
+  SOCKET_FLOAT(path_guiding_fraction, "Path Guiding Fraction", 0.5f);
+
   static NodeEnum method_enum;
   method_enum.insert("path", PATH);
   method_enum.insert("branched_path", BRANCHED_PATH);
@@ -214,6 +218,12 @@ void Integrator::device_update(Device *device, DeviceScene *dscene, Scene *scene
     kintegrator->light_inv_rr_threshold = 0.0f;
   }
 
+  /* Path guiding is only implemented for the path tracing integrator on the CPU, other
+   * devices ignore it. */
+  kintegrator->use_path_guiding = use_path_guiding && (method == PATH);
+  kintegrator->path_guiding_training_samples = max(path_guiding_training_samples, 1);
+  kintegrator->path_guiding_fraction = clamp(path_guiding_fraction, 0.0f, 1.0f);
+
   /* sobol directions table */
   int max_samples = 1;
 
@@ -78,6 +78,10 @@ class Integrator : public Node {
   int adaptive_min_samples;
   float adaptive_threshold;
 
+  bool use_path_guiding;
+  int path_guiding_training_samples;
+  float path_guiding_fraction;
+
   enum Method {
     BRANCHED_PATH = 0,
     PATH = 1,
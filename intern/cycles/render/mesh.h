@@ -164,6 +164,7 @@ class Mesh : public Geometry {
       vert_stitching_map; /* stitching index -> multiple real vert indices */
   friend class DiagSplit;
   friend class GeometryManager;
+  friend class SubdDiceCache;
 
  public:
   /* Functions */
@@ -372,12 +372,7 @@ void Mesh::tessellate(DiagSplit *split)
   OsdData osd_data;
   bool need_packed_patch_table = false;
 
-  if (subdivision_type == SUBDIVISION_CATMULL_CLARK) {
-    if (subd_faces.size()) {
-      osd_data.build_from_mesh(this);
-    }
-  }
-  else
+  if (subdivision_type != SUBDIVISION_CATMULL_CLARK)
 #endif
   {
     /* force linear subdivision if OpenSubdiv is unavailable to avoid
@@ -391,6 +386,26 @@ void Mesh::tessellate(DiagSplit *split)
     }
   }
 
+  /* Reuse geometry diced for an earlier update, OpenSubdiv data is then only needed for
+   * subdividing attributes. */
+  const bool is_cached = split->restore_cached();
+
+#ifdef WITH_OPENSUBDIV
+  if (subdivision_type == SUBDIVISION_CATMULL_CLARK && subd_faces.size()) {
+    bool need_osd_data = !is_cached;
+    foreach (Attribute &attr, subd_attributes.attributes) {
+      if (attr.flags & ATTR_SUBDIVIDED && attr.element != ATTR_ELEMENT_CORNER &&
+          attr.element != ATTR_ELEMENT_CORNER_BYTE) {
+        need_osd_data = true;
+      }
+    }
+
+    if (need_osd_data) {
+      osd_data.build_from_mesh(this);
+    }
+  }
+#endif
+
   int num_faces = subd_faces.size();
 
   Attribute *attr_vN = subd_attributes.find(ATTR_STD_VERTEX_NORMAL);
@@ -410,8 +425,11 @@ void Mesh::tessellate(DiagSplit *split)
   }
 
   /* build patches from faces */
+  if (is_cached) {
+    /* Diced geometry was restored, nothing to split. */
+  }
 #ifdef WITH_OPENSUBDIV
-  if (subdivision_type == SUBDIVISION_CATMULL_CLARK) {
+  else if (subdivision_type == SUBDIVISION_CATMULL_CLARK) {
     vector<OsdPatch> osd_patches(num_patches, &osd_data);
     OsdPatch *patch = osd_patches.data();
 
@@ -437,9 +455,8 @@ void Mesh::tessellate(DiagSplit *split)
     /* split patches */
     split->split_patches(osd_patches.data(), sizeof(OsdPatch));
   }
-  else
 #endif
-  {
+  else {
     vector<LinearQuadPatch> linear_patches(num_patches);
     LinearQuadPatch *patch = linear_patches.data();
 
@@ -4901,15 +4901,64 @@ void MixNode::compile(SVMCompiler &compiler)
   ShaderInput *color2_in = input("Color2");
   ShaderOutput *color_out = output("Color");
 
-  compiler.add_node(NODE_MIX,
-                    compiler.stack_assign(fac_in),
-                    compiler.stack_assign(color1_in),
-                    compiler.stack_assign(color2_in));
-  compiler.add_node(NODE_MIX, type, compiler.stack_assign(color_out));
+  /* Mix nodes fused into this one, from the last to the first in the chain. */
+  vector<MixNode *> chain;
+  chain.push_back(this);
+  for (ShaderNode *node = compiler.find_fused_input_node(this); node;
+       node = compiler.find_fused_input_node(node)) {
+    chain.push_back(static_cast<MixNode *>(node));
+  }
+
+  if (chain.size() == 1) {
+    compiler.add_node(NODE_MIX,
+                      compiler.stack_assign(fac_in),
+                      compiler.stack_assign(color1_in),
+                      compiler.stack_assign(color2_in));
+    compiler.add_node(NODE_MIX, type, compiler.stack_assign(color_out));
+
+    if (use_clamp) {
+      compiler.add_node(NODE_MIX, 0, compiler.stack_assign(color_out));
+      compiler.add_node(NODE_MIX, NODE_MIX_CLAMP, compiler.stack_assign(color_out));
+    }
+    return;
+  }
 
-  if (use_clamp) {
-    compiler.add_node(NODE_MIX, 0, compiler.stack_assign(color_out));
-    compiler.add_node(NODE_MIX, NODE_MIX_CLAMP, compiler.stack_assign(color_out));
+  /* Assign the stack for all steps first, loading unlinked colors adds nodes. */
+  const int num_steps = chain.size();
+  vector<uint> steps(num_steps * 2);
+
+  for (int i = num_steps - 1, step = 0; i >= 0; i--, step++) {
+    MixNode *node = chain[i];
+    ShaderInput *inputs[3] = {node->input("Fac"), node->input("Color1"), node->input("Color2")};
+    ShaderNode *chain_node = (i + 1 < num_steps) ? chain[i + 1] : NULL;
+
+    uint chain_index = SVM_MIX_CHAIN_NONE;
+    uint stack_offsets[3];
+    stack_offsets[0] = compiler.stack_assign_if_linked(inputs[0]);
+    for (int j = 1; j < 3; j++) {
+      if (chain_node && inputs[j]->link && inputs[j]->link->parent == chain_node) {
+        chain_index = j;
+        stack_offsets[j] = SVM_STACK_INVALID;
+      }
+      else {
+        stack_offsets[j] = compiler.stack_assign(inputs[j]);
+      }
+    }
+
+    if (node->use_clamp) {
+      chain_index |= SVM_MIX_CHAIN_CLAMP;
+    }
+
+    steps[step * 2 + 0] = compiler.encode_uchar4(
+        node->type, chain_index, stack_offsets[0], stack_offsets[1]);
+    steps[step * 2 + 1] = stack_offsets[2];
+  }
+
+  /* Evaluate the chain in a single node, intermediate colors are not stored on the stack. */
+  compiler.add_node(NODE_MIX_CHAIN, num_steps, compiler.stack_assign(color_out));
+
+  for (int i = num_steps - 1, step = 0; i >= 0; i--, step++) {
+    compiler.add_node(steps[step * 2 + 0], steps[step * 2 + 1], __float_as_int(chain[i]->fac));
   }
 }
 
@@ -6037,16 +6086,58 @@ void MathNode::compile(SVMCompiler &compiler)
   ShaderInput *value3_in = input("Value3");
   ShaderOutput *value_out = output("Value");
 
-  int value1_stack_offset = compiler.stack_assign(value1_in);
-  int value2_stack_offset = compiler.stack_assign(value2_in);
-  int value3_stack_offset = compiler.stack_assign(value3_in);
+  /* Math nodes fused into this one, from the last to the first in the chain. */
+  vector<MathNode *> chain;
+  chain.push_back(this);
+  for (ShaderNode *node = compiler.find_fused_input_node(this); node;
+       node = compiler.find_fused_input_node(node)) {
+    chain.push_back(static_cast<MathNode *>(node));
+  }
+
+  if (chain.size() == 1 && value1_in->link && value2_in->link && value3_in->link) {
+    int value1_stack_offset = compiler.stack_assign(value1_in);
+    int value2_stack_offset = compiler.stack_assign(value2_in);
+    int value3_stack_offset = compiler.stack_assign(value3_in);
+    int value_stack_offset = compiler.stack_assign(value_out);
+
+    compiler.add_node(
+        NODE_MATH,
+        type,
+        compiler.encode_uchar4(value1_stack_offset, value2_stack_offset, value3_stack_offset),
+        value_stack_offset);
+    return;
+  }
+
+  /* Evaluate the chain in a single node, with constant inputs embedded. */
   int value_stack_offset = compiler.stack_assign(value_out);
+  compiler.add_node(NODE_MATH_CHAIN, chain.size(), value_stack_offset);
+
+  for (int i = chain.size() - 1; i >= 0; i--) {
+    MathNode *node = chain[i];
+    ShaderInput *inputs[3] = {
+        node->input("Value1"), node->input("Value2"), node->input("Value3")};
+    ShaderNode *chain_node = (i + 1 < (int)chain.size()) ? chain[i + 1] : NULL;
+
+    uint chain_index = SVM_MATH_CHAIN_NONE;
+    uint stack_offsets[3];
+    for (int j = 0; j < 3; j++) {
+      if (chain_node && inputs[j]->link && inputs[j]->link->parent == chain_node) {
+        chain_index = j;
+        stack_offsets[j] = SVM_STACK_INVALID;
+      }
+      else {
+        stack_offsets[j] = compiler.stack_assign_if_linked(inputs[j]);
+      }
+    }
 
-  compiler.add_node(
-      NODE_MATH,
-      type,
-      compiler.encode_uchar4(value1_stack_offset, value2_stack_offset, value3_stack_offset),
-      value_stack_offset);
+    compiler.add_node(compiler.encode_uchar4(node->type | (chain_index << 6),
+                                             stack_offsets[0],
+                                             stack_offsets[1],
+                                             stack_offsets[2]),
+                      __float_as_int(node->value1),
+                      __float_as_int(node->value2),
+                      __float_as_int(node->value3));
+  }
 }
 
 void MathNode::compile(OSLCompiler &compiler)
@@ -31,6 +31,7 @@
 #include "render/scene.h"
 #include "render/session.h"
 #include "render/shader.h"
+#include "render/stats.h"
 #include "render/svm.h"
 #include "render/tables.h"
 #include "render/volume.h"
@@ -39,6 +40,7 @@
 #include "util/util_guarded_allocator.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -257,7 +259,11 @@ void Scene::device_update(Device *device_, Progress &progress)
     return;
 
   progress.set_status("Updating Images");
-  image_manager->device_update(device, this, progress);
+  {
+    scoped_timer timer;
+    image_manager->device_update(device, this, progress);
+    update_times.images += timer.get_time();
+  }
 
   if (progress.get_cancel() || device->have_error())
     return;
@@ -402,6 +408,10 @@ void Scene::collect_statistics(RenderStats *stats)
 {
   geometry_manager->collect_statistics(this, stats);
   image_manager->collect_statistics(stats);
+
+  stats->time.scene_update = update_times.total;
+  stats->time.bvh_build = update_times.bvh;
+  stats->time.image_load = update_times.images;
 }
 
 DeviceRequestedFeatures Scene::get_requested_device_features()
@@ -474,7 +484,9 @@ bool Scene::update(Progress &progress, bool &kernel_switch_needed)
     bool new_kernels_needed = load_kernels(progress, false);
 
     progress.set_status("Updating Scene");
+    scoped_timer timer;
     MEM_GUARDED_CALL(&progress, device_update, device, progress);
+    update_times.total += timer.get_time();
 
     DeviceKernelStatus kernel_switch_status = device->get_active_kernel_switch_state();
     kernel_switch_needed = kernel_switch_status == DEVICE_KERNEL_FEATURE_KERNEL_AVAILABLE ||
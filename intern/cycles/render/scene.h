@@ -176,6 +176,10 @@ class SceneParams {
   bool persistent_data;
   int texture_limit;
 
+  /* Reuse diced geometry of unchanged meshes across updates, up to a memory limit in bytes. */
+  bool use_dice_cache;
+  size_t dice_cache_memory;
+
   bool background;
 
   SceneParams()
@@ -190,6 +194,8 @@ class SceneParams {
     hair_shape = CURVE_RIBBON;
     persistent_data = false;
     texture_limit = 0;
+    use_dice_cache = false;
+    dice_cache_memory = 0;
     background = true;
   }
 
@@ -201,7 +207,9 @@ class SceneParams {
              use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes &&
              num_bvh_time_steps == params.num_bvh_time_steps &&
              hair_subdivisions == params.hair_subdivisions && hair_shape == params.hair_shape &&
-             persistent_data == params.persistent_data && texture_limit == params.texture_limit);
+             persistent_data == params.persistent_data && texture_limit == params.texture_limit &&
+             use_dice_cache == params.use_dice_cache &&
+             dice_cache_memory == params.dice_cache_memory);
   }
 
   int curve_subdivisions()
@@ -211,6 +219,25 @@ class SceneParams {
   }
 };
 
+/* Scene Update Times
+ *
+ * Wall clock time in seconds spent updating the scene on the device, accumulated over all
+ * updates since the scene was created. BVH building and image loading are part of the total. */
+
+class SceneUpdateTimes {
+ public:
+  double total;
+  double bvh;
+  double images;
+
+  SceneUpdateTimes()
+  {
+    total = 0.0;
+    bvh = 0.0;
+    images = 0.0;
+  }
+};
+
 /* Scene */
 
 class Scene : public NodeOwner {
@@ -257,6 +284,9 @@ class Scene : public NodeOwner {
   /* parameters */
   SceneParams params;
 
+  /* statistics */
+  SceneUpdateTimes update_times;
+
   /* mutex must be locked manually by callers */
   thread_mutex mutex;
 
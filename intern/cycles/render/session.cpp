@@ -82,6 +82,8 @@ Session::Session(const SessionParams &params_)
 
   reset_time = 0.0;
   last_update_time = 0.0;
+  denoise_time = 0.0;
+  denoise_start_time = 0.0;
 
   delayed_reset.do_reset = false;
   delayed_reset.samples = 0;
@@ -303,6 +305,7 @@ void Session::run_gpu()
       render(need_denoise);
 
       device->task_wait();
+      update_denoise_time();
 
       if (!device->error_message().empty())
         progress.set_cancel(device->error_message());
@@ -414,6 +417,11 @@ bool Session::acquire_tile(RenderTile &rtile, Device *tile_device, uint tile_typ
 
   if (tile->state == Tile::DENOISE) {
     rtile.task = RenderTile::DENOISE;
+
+    /* Restore the float buffer while the tile mutex is still locked. */
+    if (tile->buffers) {
+      tile->buffers->expand();
+    }
   }
   else if (read_bake_tile_cb) {
     rtile.task = RenderTile::BAKE;
@@ -502,34 +510,45 @@ void Session::update_tile_sample(RenderTile &rtile)
 
 void Session::release_tile(RenderTile &rtile, const bool need_denoise)
 {
-  thread_scoped_lock tile_lock(tile_mutex);
+  vector<int> compact_tiles;
 
-  progress.add_finished_tile(rtile.task == RenderTile::DENOISE);
+  {
+    thread_scoped_lock tile_lock(tile_mutex);
 
-  bool delete_tile;
+    progress.add_finished_tile(rtile.task == RenderTile::DENOISE);
 
-  if (tile_manager.finish_tile(rtile.tile_index, need_denoise, delete_tile)) {
-    /* Finished tile pixels write. */
-    if (write_render_tile_cb && params.progressive_refine == false) {
-      write_render_tile_cb(rtile);
-    }
+    bool delete_tile;
+
+    if (tile_manager.finish_tile(rtile.tile_index, need_denoise, delete_tile)) {
+      /* Finished tile pixels write. */
+      if (write_render_tile_cb && params.progressive_refine == false) {
+        write_render_tile_cb(rtile);
+      }
 
-    if (delete_tile) {
-      delete rtile.buffers;
-      tile_manager.state.tiles[rtile.tile_index].buffers = NULL;
+      /* Pinned buffers are freed once compaction is done. */
+      if (delete_tile && !(rtile.buffers && rtile.buffers->compact_pinned)) {
+        delete rtile.buffers;
+        tile_manager.state.tiles[rtile.tile_index].buffers = NULL;
+      }
     }
-  }
-  else {
-    /* In progress tile pixels update. */
-    if (update_render_tile_cb && params.progressive_refine == false) {
-      update_render_tile_cb(rtile, false);
+    else {
+      /* In progress tile pixels update. */
+      if (update_render_tile_cb && params.progressive_refine == false) {
+        update_render_tile_cb(rtile, false);
+      }
     }
-  }
 
-  update_status_time();
+    if (!delete_tile) {
+      pin_tile_buffers(rtile.tile_index, compact_tiles);
+    }
+
+    update_status_time();
+
+    /* Notify denoising thread that a tile was finished. */
+    denoising_cond.notify_all();
+  }
 
-  /* Notify denoising thread that a tile was finished. */
-  denoising_cond.notify_all();
+  compact_tile_buffers(compact_tiles);
 }
 
 void Session::map_neighbor_tiles(RenderTileNeighbors &neighbors, Device *tile_device)
@@ -572,6 +591,7 @@ void Session::map_neighbor_tiles(RenderTileNeighbors &neighbors, Device *tile_de
           rtile.y = image_region.y + tile->y;
           rtile.w = tile->w;
           rtile.h = tile->h;
+          rtile.tile_index = nindex;
 
           if (buffers) {
             tile_manager.state.buffer.get_offset_stride(rtile.offset, rtile.stride);
@@ -581,6 +601,7 @@ void Session::map_neighbor_tiles(RenderTileNeighbors &neighbors, Device *tile_de
           }
           else {
             assert(tile->buffers);
+            tile->buffers->map_neighbor();
             tile->buffers->params.get_offset_stride(rtile.offset, rtile.stride);
 
             rtile.buffer = tile->buffers->buffer.device_pointer;
@@ -611,8 +632,73 @@ void Session::map_neighbor_tiles(RenderTileNeighbors &neighbors, Device *tile_de
 
 void Session::unmap_neighbor_tiles(RenderTileNeighbors &neighbors, Device *tile_device)
 {
+  vector<int> compact_tiles;
+
+  {
+    thread_scoped_lock tile_lock(tile_mutex);
+    device->unmap_neighbor_tiles(tile_device, neighbors);
+
+    if (tile_manager.schedule_denoising && !buffers) {
+      for (int i = 0; i < RenderTileNeighbors::SIZE; i++) {
+        RenderTile &rtile = neighbors.tiles[i];
+        if (!rtile.buffers) {
+          continue;
+        }
+
+        rtile.buffers->unmap_neighbor();
+        pin_tile_buffers(rtile.tile_index, compact_tiles);
+      }
+    }
+  }
+
+  compact_tile_buffers(compact_tiles);
+}
+
+void Session::pin_tile_buffers(const int tile_index, vector<int> &compact_tiles)
+{
+  /* Tiles waiting for their neighbors to be rendered or denoised are kept in compact form,
+   * so only the tiles currently being rendered or denoised use full float buffers. */
+  if (!params.compact_tile_buffers || buffers) {
+    return;
+  }
+
+  Tile &tile = tile_manager.state.tiles[tile_index];
+  if (!tile.buffers || tile.buffers->compact_pinned) {
+    return;
+  }
+  if (tile.state != Tile::RENDERED && tile.state != Tile::DENOISED) {
+    return;
+  }
+
+  tile.buffers->compact_pinned = true;
+  tile.buffers->request_compact();
+  compact_tiles.push_back(tile_index);
+}
+
+void Session::compact_tile_buffers(const vector<int> &compact_tiles)
+{
+  if (compact_tiles.empty()) {
+    return;
+  }
+
+  /* Pinned buffers are not freed by other threads, and compaction is skipped when the tile
+   * got expanded or mapped for denoising in the meantime. */
+  for (int tile_index : compact_tiles) {
+    tile_manager.state.tiles[tile_index].buffers->compact();
+  }
+
   thread_scoped_lock tile_lock(tile_mutex);
-  device->unmap_neighbor_tiles(tile_device, neighbors);
+
+  for (int tile_index : compact_tiles) {
+    Tile &tile = tile_manager.state.tiles[tile_index];
+    tile.buffers->compact_pinned = false;
+
+    /* Free buffers of tiles that were finished while pinned. */
+    if (tile.state == Tile::DONE && !params.progressive) {
+      delete tile.buffers;
+      tile.buffers = NULL;
+    }
+  }
 }
 
 void Session::run_cpu()
@@ -733,6 +819,7 @@ void Session::run_cpu()
     }
 
     device->task_wait();
+    update_denoise_time();
 
     {
       thread_scoped_lock reset_lock(delayed_reset.mutex);
@@ -1114,12 +1201,23 @@ void Session::render(bool need_denoise)
       task.num_samples = tile_manager.state.num_samples;
       tile_manager.state.buffer.get_offset_stride(task.offset, task.stride);
       task.buffers = buffers;
+
+      /* Timed until the session waits for the task, it still runs asynchronously. */
+      denoise_start_time = time_dt();
     }
   }
 
   device->task_add(task);
 }
 
+void Session::update_denoise_time()
+{
+  if (denoise_start_time != 0.0) {
+    denoise_time += time_dt() - denoise_start_time;
+    denoise_start_time = 0.0;
+  }
+}
+
 void Session::copy_to_display_buffer(int sample)
 {
   /* add film conversion task */
@@ -1205,6 +1303,12 @@ void Session::device_free()
 void Session::collect_statistics(RenderStats *render_stats)
 {
   scene->collect_statistics(render_stats);
+
+  double total_time, render_time;
+  progress.get_time(total_time, render_time);
+  render_stats->time.render = max(render_time - denoise_time, 0.0);
+  render_stats->time.denoise = denoise_time;
+
   if (params.use_profiling && (params.device.type == DEVICE_CPU)) {
     render_stats->collect_profiling(scene, profiler);
   }
@@ -57,6 +57,7 @@ class SessionParams {
   int pixel_size;
   int threads;
   bool adaptive_sampling;
+  bool compact_tile_buffers;
 
   bool use_profiling;
 
@@ -87,6 +88,7 @@ class SessionParams {
     pixel_size = 1;
     threads = 0;
     adaptive_sampling = false;
+    compact_tile_buffers = false;
 
     use_profiling = false;
 
@@ -111,6 +113,7 @@ class SessionParams {
              tile_size == params.tile_size && start_resolution == params.start_resolution &&
              pixel_size == params.pixel_size && threads == params.threads &&
              adaptive_sampling == params.adaptive_sampling &&
+             compact_tile_buffers == params.compact_tile_buffers &&
              use_profiling == params.use_profiling &&
              display_buffer_linear == params.display_buffer_linear &&
              cancel_timeout == params.cancel_timeout && reset_timeout == params.reset_timeout &&
@@ -199,6 +202,8 @@ class Session {
 
   void map_neighbor_tiles(RenderTileNeighbors &neighbors, Device *tile_device);
   void unmap_neighbor_tiles(RenderTileNeighbors &neighbors, Device *tile_device);
+  void pin_tile_buffers(const int tile_index, vector<int> &compact_tiles);
+  void compact_tile_buffers(const vector<int> &compact_tiles);
 
   bool device_use_gl;
 
@@ -222,6 +227,11 @@ class Session {
   double last_update_time;
   double last_display_time;
 
+  /* Time spent denoising the full image after rendering. */
+  double denoise_time;
+  double denoise_start_time;
+  void update_denoise_time();
+
   /* progressive refine */
   bool update_progressive_refine(bool cancel);
 };
@@ -224,6 +224,29 @@ string ImageStats::full_report(int indent_level)
   return result;
 }
 
+/* Time statistics. */
+
+TimeStats::TimeStats()
+{
+  scene_update = 0.0;
+  bvh_build = 0.0;
+  image_load = 0.0;
+  render = 0.0;
+  denoise = 0.0;
+}
+
+string TimeStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  string result = "";
+  result += indent + string_printf("Scene update: %.2fs\n", scene_update);
+  result += indent + string_printf("  BVH build: %.2fs\n", bvh_build);
+  result += indent + string_printf("  Image load: %.2fs\n", image_load);
+  result += indent + string_printf("Render: %.2fs\n", render);
+  result += indent + string_printf("Denoise: %.2fs\n", denoise);
+  return result;
+}
+
 /* Overall statistics. */
 
 RenderStats::RenderStats()
@@ -306,6 +329,7 @@ string RenderStats::full_report()
   string result = "";
   result += "Mesh statistics:\n" + mesh.full_report(1);
   result += "Image statistics:\n" + image.full_report(1);
+  result += "Time statistics:\n" + time.full_report(1);
   if (has_profiling) {
     result += "Kernel statistics:\n" + kernel.full_report(1);
     result += "Shader statistics:\n" + shaders.full_report(1);
@@ -135,6 +135,25 @@ class ImageStats {
   NamedSizeStats textures;
 };
 
+/* Wall clock time spent in the stages of rendering, in seconds. */
+class TimeStats {
+ public:
+  TimeStats();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  /* Scene device update, including BVH building and image loading. */
+  double scene_update;
+  double bvh_build;
+  double image_load;
+
+  /* Path tracing, excluding scene updates. Denoising is only timed separately when it
+   * runs on the full image after rendering, per tile denoising is part of the render time. */
+  double render;
+  double denoise;
+};
+
 /* Render process statistics. */
 class RenderStats {
  public:
@@ -150,6 +169,7 @@ class RenderStats {
 
   MeshStats mesh;
   ImageStats image;
+  TimeStats time;
   NamedNestedSampleStats kernel;
   NamedSampleCountStats shaders;
   NamedSampleCountStats objects;
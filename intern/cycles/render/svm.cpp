@@ -176,6 +176,7 @@ SVMCompiler::SVMCompiler(Scene *scene) : scene(scene)
   background = false;
   mix_weight_offset = SVM_STACK_INVALID;
   compile_failed = false;
+  num_fused_nodes = 0;
 }
 
 int SVMCompiler::stack_size(SocketType::Type type)
@@ -432,8 +433,27 @@ void SVMCompiler::find_dependencies(ShaderNodeSet &dependencies,
 
 void SVMCompiler::generate_node(ShaderNode *node, ShaderNodeSet &done)
 {
+  if (is_fused_node(node)) {
+    /* Compiled as part of the node it is fused into. Its linked inputs stay on the
+     * stack until then, so it is not added to the done set yet. */
+    num_fused_nodes++;
+    return;
+  }
+
   node->compile(*this);
+
+  /* Nodes fused into this one are done now, which must happen before clearing users
+   * so that outputs read by both this node and a fused node are freed. */
+  for (ShaderNode *fused = find_fused_input_node(node); fused;
+       fused = find_fused_input_node(fused)) {
+    done.insert(fused);
+  }
+
   stack_clear_users(node, done);
+  for (ShaderNode *fused = find_fused_input_node(node); fused;
+       fused = find_fused_input_node(fused)) {
+    stack_clear_users(fused, done);
+  }
   stack_clear_temporary(node);
 
   if (current_type == SHADER_TYPE_SURFACE) {
@@ -472,7 +492,9 @@ void SVMCompiler::generate_svm_nodes(const ShaderNodeSet &nodes, CompilerState *
         }
         if (inputs_done) {
           generate_node(node, done);
-          done.insert(node);
+          if (!is_fused_node(node)) {
+            done.insert(node);
+          }
           done_flag[node->id] = true;
         }
         else {
@@ -686,6 +708,62 @@ void SVMCompiler::generate_multi_closure(ShaderNode *root_node,
   state->nodes_done_flag[node->id] = true;
 }
 
+/* Node Fusion
+ *
+ * A chain of math or mix nodes where each result is only used by the next node in the chain
+ * is evaluated as a single SVM node. Intermediate results are then kept in registers
+ * instead of the stack and constant inputs are embedded in the node, instead of being
+ * loaded onto the stack by separate value nodes. Nodes that are fused into another
+ * node do not generate any SVM nodes themselves.
+ *
+ * Other nodes are not fused. In texture coordinate, mapping and image texture chains the
+ * image lookup dominates, so the stack traffic saved by fusing them would not be noticeable. */
+
+void SVMCompiler::find_fused_nodes(ShaderGraph *graph)
+{
+  int max_id = 0;
+  foreach (ShaderNode *node, graph->nodes) {
+    max_id = max(node->id, max_id);
+  }
+
+  fused_nodes.clear();
+  fused_nodes.resize(max_id + 1, false);
+
+  foreach (ShaderNode *node, graph->nodes) {
+    if (node->type != MathNode::node_type && node->type != MixNode::node_type) {
+      continue;
+    }
+
+    /* Only a single input node can be fused, to keep the chain linear. Mix nodes are only
+     * chained through their colors. */
+    ShaderInput *fac_in = (node->type == MixNode::node_type) ? node->input("Fac") : NULL;
+    foreach (ShaderInput *input, node->inputs) {
+      ShaderOutput *link = input->link;
+      if (input != fac_in && link && link->parent->type == node->type &&
+          link->links.size() == 1) {
+        fused_nodes[link->parent->id] = true;
+        break;
+      }
+    }
+  }
+}
+
+bool SVMCompiler::is_fused_node(ShaderNode *node)
+{
+  return (size_t)node->id < fused_nodes.size() && fused_nodes[node->id];
+}
+
+ShaderNode *SVMCompiler::find_fused_input_node(ShaderNode *node)
+{
+  foreach (ShaderInput *input, node->inputs) {
+    if (input->link && is_fused_node(input->link->parent)) {
+      return input->link->parent;
+    }
+  }
+
+  return NULL;
+}
+
 void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType type)
 {
   /* Converting a shader graph into svm_nodes that can be executed
@@ -732,6 +810,7 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
   /* clear all compiler state */
   memset((void *)&active_stack, 0, sizeof(active_stack));
   current_svm_nodes.clear();
+  find_fused_nodes(graph);
 
   foreach (ShaderNode *node, graph->nodes) {
     foreach (ShaderInput *input, node->inputs)
@@ -900,6 +979,7 @@ void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Sum
   if (summary != NULL) {
     summary->time_total = time_dt() - time_start;
     summary->peak_stack_usage = max_stack_use;
+    summary->num_fused_nodes = num_fused_nodes;
     summary->num_svm_nodes = svm_nodes.size() - start_num_svm_nodes;
   }
 }
@@ -909,6 +989,7 @@ void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Sum
 SVMCompiler::Summary::Summary()
     : num_svm_nodes(0),
       peak_stack_usage(0),
+      num_fused_nodes(0),
       time_finalize(0.0),
       time_generate_surface(0.0),
       time_generate_bump(0.0),
@@ -923,6 +1004,7 @@ string SVMCompiler::Summary::full_report() const
   string report = "";
   report += string_printf("Number of SVM nodes: %d\n", num_svm_nodes);
   report += string_printf("Peak stack usage:    %d\n", peak_stack_usage);
+  report += string_printf("Fused nodes:         %d\n", num_fused_nodes);
 
   report += string_printf("Time (in seconds):\n");
   report += string_printf("Finalize:            %f\n", time_finalize);
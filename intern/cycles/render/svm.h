@@ -69,6 +69,9 @@ class SVMCompiler {
     /* Peak stack usage during shader evaluation. */
     int peak_stack_usage;
 
+    /* Number of nodes that were fused into other nodes. */
+    int num_fused_nodes;
+
     /* Time spent on surface graph finalization. */
     double time_finalize;
 
@@ -105,6 +108,9 @@ class SVMCompiler {
   void stack_clear_offset(SocketType::Type type, int offset);
   void stack_link(ShaderInput *input, ShaderOutput *output);
 
+  bool is_fused_node(ShaderNode *node);
+  ShaderNode *find_fused_input_node(ShaderNode *node);
+
   void add_node(ShaderNodeType type, int a = 0, int b = 0, int c = 0);
   void add_node(int a = 0, int b = 0, int c = 0, int d = 0);
   void add_node(ShaderNodeType type, const float3 &f);
@@ -208,6 +214,9 @@ class SVMCompiler {
                                       const ShaderNodeSet &shared);
   void generate_svm_nodes(const ShaderNodeSet &nodes, CompilerState *state);
 
+  /* node fusion */
+  void find_fused_nodes(ShaderGraph *graph);
+
   /* multi closure */
   void generate_multi_closure(ShaderNode *root_node, ShaderNode *node, CompilerState *state);
 
@@ -221,6 +230,8 @@ class SVMCompiler {
   int max_stack_use;
   uint mix_weight_offset;
   bool compile_failed;
+  vector<bool> fused_nodes;
+  int num_fused_nodes;
 };
 
 CCL_NAMESPACE_END
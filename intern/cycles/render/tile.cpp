@@ -480,7 +480,9 @@ bool TileManager::finish_tile(const int index, const bool need_denoise, bool &de
             if (neighbor == 4) {
               delete_tile = true;
             }
-            else {
+            else if (!(state.tiles[nindex].buffers &&
+                       state.tiles[nindex].buffers->compact_pinned)) {
+              /* Pinned buffers are freed by the session once compaction is done. */
               delete state.tiles[nindex].buffers;
               state.tiles[nindex].buffers = NULL;
             }
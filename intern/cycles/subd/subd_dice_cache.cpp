@@ -0,0 +1,323 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/camera.h"
+#include "render/mesh.h"
+
+#include "subd/subd_dice.h"
+#include "subd/subd_dice_cache.h"
+
+#include "util/util_foreach.h"
+#include "util/util_logging.h"
+#include "util/util_md5.h"
+#include "util/util_set.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Maximum number of control mesh vertices to compare the projected size at. */
+#define DICE_CACHE_MAX_SAMPLES 64
+
+template<typename T> static void md5_append_array(MD5Hash &md5, const array<T> &data)
+{
+  int size = data.size();
+  md5.append((const uint8_t *)&size, sizeof(size));
+  if (size) {
+    md5.append((const uint8_t *)data.data(), sizeof(T) * size);
+  }
+}
+
+template<typename T> static void md5_append_value(MD5Hash &md5, const T &value)
+{
+  md5.append((const uint8_t *)&value, sizeof(value));
+}
+
+/* Approximate memory of a hash map node, for estimating the size of the stitching maps. */
+#define DICE_CACHE_MAP_NODE_SIZE (4 * sizeof(void *) + 2 * sizeof(int))
+
+SubdDiceCache::SubdDiceCache() : memory_limit(0), memory_used(0), use_counter(0)
+{
+}
+
+SubdDiceCache::~SubdDiceCache()
+{
+}
+
+string SubdDiceCache::compute_key(const SubdParams &params)
+{
+  const Mesh *mesh = params.mesh;
+  MD5Hash md5;
+
+  /* Control mesh. */
+  md5_append_array(md5, mesh->verts);
+  md5_append_value(md5, mesh->num_triangles());
+  md5_append_value(md5, (int)mesh->subdivision_type);
+  md5_append_array(md5, mesh->subd_face_corners);
+  md5_append_array(md5, mesh->subd_creases);
+
+  /* Hash face members individually, the struct has padding. */
+  for (size_t i = 0; i < mesh->subd_faces.size(); i++) {
+    const Mesh::SubdFace &face = mesh->subd_faces[i];
+    md5_append_value(md5, face.start_corner);
+    md5_append_value(md5, face.num_corners);
+    md5_append_value(md5, face.shader);
+    md5_append_value(md5, face.smooth);
+    md5_append_value(md5, face.ptex_offset);
+  }
+
+  /* Normals used for linear patches. */
+  const Attribute *attr_vN = mesh->subd_attributes.find(ATTR_STD_VERTEX_NORMAL);
+  if (attr_vN) {
+    md5.append((const uint8_t *)attr_vN->data(), attr_vN->buffer.size());
+  }
+
+  /* Dicing parameters, the camera is compared separately. */
+  md5_append_value(md5, params.ptex);
+  md5_append_value(md5, params.test_steps);
+  md5_append_value(md5, params.split_threshold);
+  md5_append_value(md5, params.dicing_rate);
+  md5_append_value(md5, params.max_level);
+  md5_append_value(md5, params.camera != NULL);
+  if (params.camera) {
+    md5_append_value(md5, params.objecttoworld);
+  }
+
+  return md5.get_hex();
+}
+
+void SubdDiceCache::compute_samples(const SubdParams &params, size_t num_verts, Entry &entry)
+{
+  entry.sample_P.clear();
+  entry.sample_raster_size.clear();
+
+  if (!params.camera) {
+    return;
+  }
+
+  /* Projected size at evenly spaced control mesh vertices. */
+  const array<float3> &verts = params.mesh->verts;
+  const size_t step = (num_verts > DICE_CACHE_MAX_SAMPLES) ?
+                          num_verts / DICE_CACHE_MAX_SAMPLES :
+                          1;
+
+  for (size_t i = 0; i < num_verts; i += step) {
+    const float3 P = transform_point(&params.objecttoworld, verts[i]);
+    entry.sample_P.push_back(P);
+    entry.sample_raster_size.push_back(params.camera->world_to_raster_size(P));
+  }
+}
+
+bool SubdDiceCache::restore(const SubdParams &params, const string &key)
+{
+  Mesh *mesh = params.mesh;
+
+  thread_scoped_lock lock(mutex);
+
+  map<const Mesh *, Entry>::iterator it = entries.find(mesh);
+  if (it == entries.end() || it->second.key != key) {
+    return false;
+  }
+
+  Entry &entry = it->second;
+
+  if (!entry.has_geometry) {
+    return false;
+  }
+
+  if (params.camera) {
+    for (size_t i = 0; i < entry.sample_P.size(); i++) {
+      const float size = params.camera->world_to_raster_size(entry.sample_P[i]);
+      const float cached_size = entry.sample_raster_size[i];
+
+      if (fabsf(size - cached_size) > camera_tolerance * max(fabsf(cached_size), 1e-8f)) {
+        return false;
+      }
+    }
+  }
+
+  /* Same attributes as EdgeDice adds. */
+  mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
+  if (params.ptex) {
+    mesh->attributes.add(ATTR_STD_PTEX_UV);
+    mesh->attributes.add(ATTR_STD_PTEX_FACE_ID);
+  }
+
+  const size_t vert_offset = mesh->verts.size();
+  const size_t tri_offset = mesh->num_triangles();
+  const size_t num_verts = entry.verts.size();
+  const size_t num_triangles = entry.shader.size();
+
+  mesh->resize_mesh(vert_offset + num_verts, tri_offset + num_triangles);
+
+  float3 *vN = mesh->attributes.find(ATTR_STD_VERTEX_NORMAL)->data_float3();
+
+  std::copy_n(entry.verts.data(), num_verts, mesh->verts.data() + vert_offset);
+  std::copy_n(entry.normals.data(), num_verts, vN + vert_offset);
+  std::copy_n(entry.vert_patch_uv.data(), num_verts, mesh->vert_patch_uv.data() + vert_offset);
+  std::copy_n(entry.triangles.data(), num_triangles * 3, mesh->triangles.data() + tri_offset * 3);
+  std::copy_n(entry.shader.data(), num_triangles, mesh->shader.data() + tri_offset);
+  std::copy_n(entry.smooth.data(), num_triangles, mesh->smooth.data() + tri_offset);
+  std::copy_n(
+      entry.triangle_patch.data(), num_triangles, mesh->triangle_patch.data() + tri_offset);
+
+  mesh->vert_to_stitching_key_map = entry.vert_to_stitching_key_map;
+  mesh->vert_stitching_map = entry.vert_stitching_map;
+  mesh->num_subd_verts += num_verts;
+
+  entry.last_used = ++use_counter;
+
+  VLOG(1) << "Reused diced geometry for mesh " << mesh->name << ", " << num_triangles
+          << " triangles.";
+
+  return true;
+}
+
+void SubdDiceCache::store(const SubdParams &params,
+                          const string &key,
+                          size_t vert_offset,
+                          size_t tri_offset)
+{
+  Mesh *mesh = params.mesh;
+
+  Entry entry;
+  entry.key = key;
+
+  const size_t num_verts = mesh->verts.size() - vert_offset;
+  const size_t num_triangles = mesh->num_triangles() - tri_offset;
+  const size_t num_stitching = mesh->vert_to_stitching_key_map.size() +
+                               mesh->vert_stitching_map.size();
+
+  entry.memory = num_verts * (2 * sizeof(float3) + sizeof(float2)) +
+                 num_triangles * (5 * sizeof(int) + sizeof(bool)) +
+                 num_stitching * DICE_CACHE_MAP_NODE_SIZE;
+
+  {
+    thread_scoped_lock lock(mutex);
+
+    /* Only remember the key the first time a mesh is diced with it, the geometry is copied
+     * once it is diced again with the same key. Geometry larger than the whole cache is never
+     * stored. */
+    map<const Mesh *, Entry>::iterator it = entries.find(mesh);
+    const bool diced_before = (it != entries.end() && it->second.key == key);
+
+    if (!diced_before || entry.memory > memory_limit) {
+      if (it != entries.end()) {
+        memory_used -= (it->second.has_geometry) ? it->second.memory : 0;
+        entries.erase(it);
+      }
+
+      entry.memory = 0;
+      entries[mesh] = entry;
+      return;
+    }
+  }
+
+  compute_samples(params, vert_offset, entry);
+
+  /* Diced geometry. */
+  const float3 *vN = mesh->attributes.find(ATTR_STD_VERTEX_NORMAL)->data_float3();
+
+  entry.verts.resize(num_verts);
+  entry.normals.resize(num_verts);
+  entry.vert_patch_uv.resize(num_verts);
+  entry.triangles.resize(num_triangles * 3);
+  entry.shader.resize(num_triangles);
+  entry.smooth.resize(num_triangles);
+  entry.triangle_patch.resize(num_triangles);
+
+  std::copy_n(mesh->verts.data() + vert_offset, num_verts, entry.verts.data());
+  std::copy_n(vN + vert_offset, num_verts, entry.normals.data());
+  std::copy_n(mesh->vert_patch_uv.data() + vert_offset, num_verts, entry.vert_patch_uv.data());
+  std::copy_n(mesh->triangles.data() + tri_offset * 3, num_triangles * 3, entry.triangles.data());
+  std::copy_n(mesh->shader.data() + tri_offset, num_triangles, entry.shader.data());
+  std::copy_n(mesh->smooth.data() + tri_offset, num_triangles, entry.smooth.data());
+  std::copy_n(
+      mesh->triangle_patch.data() + tri_offset, num_triangles, entry.triangle_patch.data());
+
+  entry.vert_to_stitching_key_map = mesh->vert_to_stitching_key_map;
+  entry.vert_stitching_map = mesh->vert_stitching_map;
+  entry.has_geometry = true;
+
+  thread_scoped_lock lock(mutex);
+
+  Entry &cached = entries[mesh];
+  memory_used -= (cached.has_geometry) ? cached.memory : 0;
+  cached.has_geometry = false;
+
+  evict(memory_limit - entry.memory);
+
+  entry.last_used = ++use_counter;
+  memory_used += entry.memory;
+  std::swap(cached, entry);
+}
+
+void SubdDiceCache::evict(size_t target_memory)
+{
+  /* Drop geometry of least recently used entries, keeping their keys. */
+  while (memory_used > target_memory) {
+    Entry *oldest = NULL;
+
+    for (map<const Mesh *, Entry>::iterator it = entries.begin(); it != entries.end(); ++it) {
+      Entry &entry = it->second;
+      if (entry.has_geometry && (!oldest || entry.last_used < oldest->last_used)) {
+        oldest = &entry;
+      }
+    }
+
+    if (!oldest) {
+      break;
+    }
+
+    const string key = oldest->key;
+    memory_used -= oldest->memory;
+    *oldest = Entry();
+    oldest->key = key;
+  }
+}
+
+void SubdDiceCache::prune(const vector<Geometry *> &geometry)
+{
+  thread_scoped_lock lock(mutex);
+
+  set<const Geometry *> used(geometry.begin(), geometry.end());
+
+  for (map<const Mesh *, Entry>::iterator it = entries.begin(); it != entries.end();) {
+    if (used.find(it->first) == used.end()) {
+      memory_used -= (it->second.has_geometry) ? it->second.memory : 0;
+      entries.erase(it++);
+    }
+    else {
+      ++it;
+    }
+  }
+}
+
+void SubdDiceCache::clear()
+{
+  thread_scoped_lock lock(mutex);
+
+  entries.clear();
+  memory_used = 0;
+}
+
+void SubdDiceCache::set_memory_limit(size_t limit)
+{
+  thread_scoped_lock lock(mutex);
+
+  memory_limit = limit;
+  evict(memory_limit);
+}
+
+CCL_NAMESPACE_END
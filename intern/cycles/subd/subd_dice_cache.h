@@ -0,0 +1,103 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SUBD_DICE_CACHE_H__
+#define __SUBD_DICE_CACHE_H__
+
+/* Cache of diced geometry, so that meshes which are exported again without changes, for
+ * example on every frame of an animation, don't have to be split and diced again. Entries
+ * are reused when the control mesh and dicing parameters are identical, and the dicing camera
+ * moved so little that the projected size of the mesh changed less than a tolerance.
+ *
+ * Diced geometry is only copied into the cache once a mesh was diced twice with the same key,
+ * so deforming meshes only cost computing the key. The least recently used entries are
+ * removed when the cache grows beyond its memory limit. */
+
+#include "util/util_array.h"
+#include "util/util_map.h"
+#include "util/util_string.h"
+#include "util/util_thread.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class Geometry;
+class Mesh;
+struct SubdParams;
+
+class SubdDiceCache {
+ public:
+  /* Maximum relative change of the projected size of the mesh for reusing diced geometry. */
+  static constexpr float camera_tolerance = 0.01f;
+
+  SubdDiceCache();
+  ~SubdDiceCache();
+
+  /* Key of the control mesh and dicing parameters, computed before dicing. */
+  string compute_key(const SubdParams &params);
+
+  /* Append geometry diced for an earlier update to the mesh, returns false if there is none
+   * that can be reused. */
+  bool restore(const SubdParams &params, const string &key);
+
+  /* Store geometry that was just diced, starting at the given vertex and triangle offset. */
+  void store(const SubdParams &params, const string &key, size_t vert_offset, size_t tri_offset);
+
+  /* Remove entries of meshes that are no longer in the scene. */
+  void prune(const vector<Geometry *> &geometry);
+
+  /* Remove all entries. */
+  void clear();
+
+  /* Maximum memory in bytes used by diced geometry, evicting entries beyond it. */
+  void set_memory_limit(size_t limit);
+
+ protected:
+  struct Entry {
+    string key;
+    bool has_geometry = false;
+    size_t memory = 0;
+    uint64_t last_used = 0;
+
+    vector<float3> sample_P;
+    vector<float> sample_raster_size;
+
+    array<float3> verts;
+    array<float3> normals;
+    array<float2> vert_patch_uv;
+    array<int> triangles;
+    array<int> shader;
+    array<bool> smooth;
+    array<int> triangle_patch;
+
+    unordered_map<int, int> vert_to_stitching_key_map;
+    unordered_multimap<int, int> vert_stitching_map;
+  };
+
+  void compute_samples(const SubdParams &params, size_t num_verts, Entry &entry);
+  void evict(size_t target_memory);
+
+  thread_mutex mutex;
+  map<const Mesh *, Entry> entries;
+  size_t memory_limit;
+  size_t memory_used;
+  uint64_t use_counter;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __SUBD_DICE_CACHE_H__ */
@@ -18,6 +18,7 @@
 #include "render/mesh.h"
 
 #include "subd/subd_dice.h"
+#include "subd/subd_dice_cache.h"
 #include "subd/subd_patch.h"
 #include "subd/subd_split.h"
 
@@ -25,6 +26,7 @@
 #include "util/util_foreach.h"
 #include "util/util_hash.h"
 #include "util/util_math.h"
+#include "util/util_tbb.h"
 #include "util/util_types.h"
 
 CCL_NAMESPACE_BEGIN
@@ -35,7 +37,12 @@ CCL_NAMESPACE_BEGIN
 #define STITCH_NGON_CENTER_VERT_INDEX_OFFSET 0x60000000
 #define STITCH_NGON_SPLIT_EDGE_CENTER_VERT_TAG (0x60000000 - 1)
 
-DiagSplit::DiagSplit(const SubdParams &params_) : params(params_)
+/* Number of faces split by a single task, and number of subpatches diced by a single task. */
+#define DSPLIT_FACES_PER_TASK 32
+#define DICE_SUBPATCHES_PER_TASK 64
+
+DiagSplit::DiagSplit(const SubdParams &params_, SubdDiceCache *cache_)
+    : params(params_), cache(cache_)
 {
 }
 
@@ -337,11 +344,92 @@ Edge *DiagSplit::alloc_edge()
   return &edges.back();
 }
 
+bool DiagSplit::restore_cached()
+{
+  if (!cache) {
+    return false;
+  }
+
+  params.mesh->vert_to_stitching_key_map.clear();
+  params.mesh->vert_stitching_map.clear();
+
+  /* Reuse geometry diced for an earlier update if nothing relevant changed. */
+  cache_key = cache->compute_key(params);
+  return cache->restore(params, cache_key);
+}
+
 void DiagSplit::split_patches(Patch *patches, size_t patches_byte_stride)
 {
+  Mesh *mesh = params.mesh;
+
+  params.mesh->vert_to_stitching_key_map.clear();
+  params.mesh->vert_stitching_map.clear();
+
+  const size_t vert_offset = mesh->verts.size();
+  const size_t tri_offset = mesh->num_triangles();
+
+  /* Patch index of the first face of each chunk. */
+  const int num_faces = mesh->subd_faces.size();
+  const int num_chunks = divide_up(num_faces, DSPLIT_FACES_PER_TASK);
+  vector<int> chunk_patch_index(num_chunks);
+
   int patch_index = 0;
+  for (int f = 0; f < num_faces; f++) {
+    if (f % DSPLIT_FACES_PER_TASK == 0) {
+      chunk_patch_index[f / DSPLIT_FACES_PER_TASK] = patch_index;
+    }
+
+    Mesh::SubdFace &face = mesh->subd_faces[f];
+    patch_index += (face.is_quad()) ? 1 : face.num_corners;
+  }
 
-  for (int f = 0; f < params.mesh->subd_faces.size(); f++) {
+  /* Split chunks of faces in parallel. */
+  chunks.resize(num_chunks);
+
+  parallel_for(blocked_range<int>(0, num_chunks, 1), [&](const blocked_range<int> &r) {
+    for (int c = r.begin(); c != r.end(); c++) {
+      Patch *patch = (Patch *)(((char *)patches) + chunk_patch_index[c] * patches_byte_stride);
+
+      chunks[c].reset(new DiagSplit(params));
+      chunks[c]->split_faces(patch,
+                             patches_byte_stride,
+                             c * DSPLIT_FACES_PER_TASK,
+                             min((c + 1) * DSPLIT_FACES_PER_TASK, num_faces));
+    }
+  });
+
+  /* Merge in face order, so the result is the same as splitting all faces serially. */
+  foreach (unique_ptr<DiagSplit> &chunk, chunks) {
+    int v = alloc_verts(chunk->num_alloced_verts);
+
+    foreach (Edge &edge, chunk->edges) {
+      if (edge.start_vert_index >= 0) {
+        edge.start_vert_index += v;
+      }
+      if (edge.end_vert_index >= 0) {
+        edge.end_vert_index += v;
+      }
+    }
+
+    subpatches.insert(subpatches.end(), chunk->subpatches.begin(), chunk->subpatches.end());
+    chunk->subpatches.clear();
+  }
+
+  post_split();
+
+  if (cache && !cache_key.empty()) {
+    cache->store(params, cache_key, vert_offset, tri_offset);
+  }
+}
+
+void DiagSplit::split_faces(Patch *patches,
+                            size_t patches_byte_stride,
+                            int face_begin,
+                            int face_end)
+{
+  int patch_index = 0;
+
+  for (int f = face_begin; f < face_end; f++) {
     Mesh::SubdFace &face = params.mesh->subd_faces[f];
 
     Patch *patch = (Patch *)(((char *)patches) + patch_index * patches_byte_stride);
@@ -357,11 +445,6 @@ void DiagSplit::split_patches(Patch *patches, size_t patches_byte_stride)
       split_ngon(face, patch, patches_byte_stride);
     }
   }
-
-  params.mesh->vert_to_stitching_key_map.clear();
-  params.mesh->vert_stitching_map.clear();
-
-  post_split();
 }
 
 static Edge *create_edge_from_corner(DiagSplit *split,
@@ -605,9 +688,18 @@ void DiagSplit::post_split()
 {
   int num_stitch_verts = 0;
 
-  /* All patches are now split, and all T values known. */
+  /* All patches are now split, and all T values known. Edges are owned by the chunks they
+   * were created in. */
+  vector<Edge *> split_edges;
+  foreach (unique_ptr<DiagSplit> &chunk, chunks) {
+    foreach (Edge &edge, chunk->edges) {
+      split_edges.push_back(&edge);
+    }
+  }
+
+  foreach (Edge *edge_ptr, split_edges) {
+    Edge &edge = *edge_ptr;
 
-  foreach (Edge &edge, edges) {
     if (edge.second_vert_index < 0) {
       edge.second_vert_index = alloc_verts(edge.T - 1);
     }
@@ -630,7 +722,8 @@ void DiagSplit::post_split()
   typedef unordered_map<pair<int, int>, int, pair_hasher> edge_stitch_verts_map_t;
   edge_stitch_verts_map_t edge_stitch_verts_map;
 
-  foreach (Edge &edge, edges) {
+  foreach (Edge *edge_ptr, split_edges) {
+    Edge &edge = *edge_ptr;
     if (edge.is_stitch_edge) {
       if (edge.stitch_edge_T == 0) {
         edge.stitch_edge_T = edge.T;
@@ -644,7 +737,8 @@ void DiagSplit::post_split()
   }
 
   /* Set start and end indices for edges generated from a split. */
-  foreach (Edge &edge, edges) {
+  foreach (Edge *edge_ptr, split_edges) {
+    Edge &edge = *edge_ptr;
     if (edge.start_vert_index < 0) {
       /* Fixup offsets. */
       if (edge.top_indices_decrease) {
@@ -666,7 +760,8 @@ void DiagSplit::post_split()
   int vert_offset = params.mesh->verts.size();
 
   /* Add verts to stitching map. */
-  foreach (const Edge &edge, edges) {
+  foreach (const Edge *edge_ptr, split_edges) {
+    const Edge &edge = *edge_ptr;
     if (edge.is_stitch_edge) {
       int second_stitch_vert_index = edge_stitch_verts_map[edge.stitch_edge_key];
 
@@ -723,26 +818,31 @@ void DiagSplit::post_split()
 
   for (size_t i = 0; i < subpatches.size(); i++) {
     subpatches[i].inner_grid_vert_offset = num_verts;
+    subpatches[i].triangle_offset = num_triangles;
     num_verts += subpatches[i].calc_num_inner_verts();
     num_triangles += subpatches[i].calc_num_triangles();
   }
 
   dice.reserve(num_verts, num_triangles);
 
-  for (size_t i = 0; i < subpatches.size(); i++) {
-    Subpatch &sub = subpatches[i];
+  /* Subpatches write to their own range of verts and triangles, so can be diced in parallel. */
+  parallel_for(blocked_range<size_t>(0, subpatches.size(), DICE_SUBPATCHES_PER_TASK),
+               [&](const blocked_range<size_t> &r) {
+                 for (size_t i = r.begin(); i != r.end(); i++) {
+                   Subpatch &sub = subpatches[i];
 
-    sub.edge_u0.T = max(sub.edge_u0.T, 1);
-    sub.edge_u1.T = max(sub.edge_u1.T, 1);
-    sub.edge_v0.T = max(sub.edge_v0.T, 1);
-    sub.edge_v1.T = max(sub.edge_v1.T, 1);
+                   sub.edge_u0.T = max(sub.edge_u0.T, 1);
+                   sub.edge_u1.T = max(sub.edge_u1.T, 1);
+                   sub.edge_v0.T = max(sub.edge_v0.T, 1);
+                   sub.edge_v1.T = max(sub.edge_v1.T, 1);
 
-    dice.dice(sub);
-  }
+                   dice.dice(sub);
+                 }
+               });
 
   /* Cleanup */
   subpatches.clear();
-  edges.clear();
+  chunks.clear();
 }
 
 CCL_NAMESPACE_END
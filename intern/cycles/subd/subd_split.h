@@ -26,7 +26,9 @@
 #include "subd/subd_subpatch.h"
 
 #include "util/util_deque.h"
+#include "util/util_string.h"
 #include "util/util_types.h"
+#include "util/util_unique_ptr.h"
 #include "util/util_vector.h"
 
 #include <deque>
@@ -35,14 +37,20 @@ CCL_NAMESPACE_BEGIN
 
 class Mesh;
 class Patch;
+class SubdDiceCache;
 
 class DiagSplit {
   SubdParams params;
+  SubdDiceCache *cache;
+  string cache_key;
 
   vector<Subpatch> subpatches;
   /* deque is used so that element pointers remain vaild when size is changed. */
   deque<Edge> edges;
 
+  /* Faces are split in parallel in chunks, each with its own edges and vertex numbering. */
+  vector<unique_ptr<DiagSplit>> chunks;
+
   float3 to_world(Patch *patch, float2 uv);
   int T(Patch *patch, float2 Pstart, float2 Pend, bool recursive_resolve = false);
 
@@ -60,9 +68,14 @@ class DiagSplit {
  public:
   Edge *alloc_edge();
 
-  explicit DiagSplit(const SubdParams &params);
+  explicit DiagSplit(const SubdParams &params, SubdDiceCache *cache = NULL);
+
+  /* Append geometry diced for an earlier update from the cache, returns false if patches
+   * need to be split instead. */
+  bool restore_cached();
 
   void split_patches(Patch *patches, size_t patches_byte_stride);
+  void split_faces(Patch *patches, size_t patches_byte_stride, int face_begin, int face_end);
 
   void split_quad(const Mesh::SubdFace &face, Patch *patch);
   void split_ngon(const Mesh::SubdFace &face, Patch *patches, size_t patches_byte_stride);
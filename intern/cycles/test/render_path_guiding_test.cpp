@@ -0,0 +1,190 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "device/device.h"
+
+#include "render/buffers.h"
+#include "render/camera.h"
+#include "render/graph.h"
+#include "render/integrator.h"
+#include "render/mesh.h"
+#include "render/nodes.h"
+#include "render/object.h"
+#include "render/scene.h"
+#include "render/session.h"
+#include "render/shader.h"
+
+#include "util/util_transform.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+const int WIDTH = 32;
+const int HEIGHT = 32;
+const int SAMPLES = 512;
+
+void add_quad(Scene *scene, Shader *shader, const float3 P[4])
+{
+  Mesh *mesh = new Mesh();
+  mesh->used_shaders.push_back(shader);
+  mesh->reserve_mesh(4, 2);
+  for (int i = 0; i < 4; i++) {
+    mesh->add_vertex(P[i]);
+  }
+  mesh->add_triangle(0, 1, 2, 0, false);
+  mesh->add_triangle(0, 2, 3, 0, false);
+  scene->geometry.push_back(mesh);
+
+  Object *object = new Object();
+  object->geometry = mesh;
+  object->tfm = transform_identity();
+  scene->objects.push_back(object);
+}
+
+Shader *add_emission_shader(Scene *scene, float strength)
+{
+  ShaderGraph *graph = new ShaderGraph();
+  EmissionNode *emission = new EmissionNode();
+  emission->color = make_float3(1.0f, 0.9f, 0.8f);
+  emission->strength = strength;
+  graph->add(emission);
+  graph->connect(emission->output("Emission"), graph->output()->input("Surface"));
+
+  Shader *shader = new Shader();
+  shader->name = "light";
+  shader->set_graph(graph);
+  shader->tag_update(scene);
+  scene->shaders.push_back(shader);
+  return shader;
+}
+
+/* A diffuse box open towards the camera, lit by a small mesh light below the ceiling. Most of
+ * the image is lit by light that is both sampled directly and hit by BSDF samples, so the
+ * multiple importance sampling weights of both must add up. */
+void create_scene(Scene *scene)
+{
+  Camera *camera = scene->camera;
+  camera->width = camera->full_width = WIDTH;
+  camera->height = camera->full_height = HEIGHT;
+  camera->matrix = transform_identity();
+  camera->compute_auto_viewplane();
+  camera->need_update = true;
+
+  Shader *diffuse = scene->default_surface;
+  const float3 floor[4] = {make_float3(-1.0f, -1.0f, 1.0f),
+                           make_float3(1.0f, -1.0f, 1.0f),
+                           make_float3(1.0f, -1.0f, 3.0f),
+                           make_float3(-1.0f, -1.0f, 3.0f)};
+  const float3 ceiling[4] = {make_float3(-1.0f, 1.0f, 1.0f),
+                             make_float3(-1.0f, 1.0f, 3.0f),
+                             make_float3(1.0f, 1.0f, 3.0f),
+                             make_float3(1.0f, 1.0f, 1.0f)};
+  const float3 back[4] = {make_float3(-1.0f, -1.0f, 3.0f),
+                          make_float3(1.0f, -1.0f, 3.0f),
+                          make_float3(1.0f, 1.0f, 3.0f),
+                          make_float3(-1.0f, 1.0f, 3.0f)};
+  const float3 left[4] = {make_float3(-1.0f, -1.0f, 1.0f),
+                          make_float3(-1.0f, -1.0f, 3.0f),
+                          make_float3(-1.0f, 1.0f, 3.0f),
+                          make_float3(-1.0f, 1.0f, 1.0f)};
+  add_quad(scene, diffuse, floor);
+  add_quad(scene, diffuse, ceiling);
+  add_quad(scene, diffuse, back);
+  add_quad(scene, diffuse, left);
+
+  Shader *light = add_emission_shader(scene, 20.0f);
+  const float3 lamp[4] = {make_float3(0.3f, 0.95f, 2.2f),
+                          make_float3(0.7f, 0.95f, 2.2f),
+                          make_float3(0.7f, 0.95f, 2.6f),
+                          make_float3(0.3f, 0.95f, 2.6f)};
+  add_quad(scene, light, lamp);
+}
+
+/* Render the scene and return the average of the combined pass over the image. */
+float3 render_average(bool use_path_guiding)
+{
+  vector<DeviceInfo> devices = Device::available_devices(DEVICE_MASK_CPU);
+  EXPECT_FALSE(devices.empty());
+  if (devices.empty()) {
+    return make_float3(0.0f, 0.0f, 0.0f);
+  }
+
+  SessionParams session_params;
+  session_params.device = devices[0];
+  session_params.background = true;
+  session_params.samples = SAMPLES;
+  session_params.tile_size = make_int2(16, 16);
+
+  Session *session = new Session(session_params);
+
+  SceneParams scene_params;
+  Scene *scene = new Scene(scene_params, session->device);
+  session->scene = scene;
+  create_scene(scene);
+
+  Integrator *integrator = scene->integrator;
+  integrator->method = Integrator::PATH;
+  integrator->max_bounce = 4;
+  integrator->use_path_guiding = use_path_guiding;
+  integrator->tag_update(scene);
+
+  double sum[3] = {0.0, 0.0, 0.0};
+  session->write_render_tile_cb = [&](RenderTile &rtile) {
+    vector<float> pixels(rtile.w * rtile.h * 4);
+    if (rtile.buffers->get_pass_rect("Combined", 1.0f, rtile.sample, 4, &pixels[0])) {
+      for (int i = 0; i < rtile.w * rtile.h; i++) {
+        sum[0] += pixels[i * 4 + 0];
+        sum[1] += pixels[i * 4 + 1];
+        sum[2] += pixels[i * 4 + 2];
+      }
+    }
+  };
+
+  BufferParams buffer_params;
+  buffer_params.width = buffer_params.full_width = WIDTH;
+  buffer_params.height = buffer_params.full_height = HEIGHT;
+
+  session->reset(buffer_params, SAMPLES);
+  session->start();
+  session->wait();
+
+  EXPECT_FALSE(session->progress.get_error());
+  delete session;
+
+  const double num_pixels = WIDTH * HEIGHT;
+  return make_float3(sum[0] / num_pixels, sum[1] / num_pixels, sum[2] / num_pixels);
+}
+
+}  // namespace
+
+/* Guiding only changes how directions are sampled, the rendered image must converge to the
+ * same result as without it. */
+TEST(render_path_guiding, converges_to_unguided)
+{
+  const float3 unguided = render_average(false);
+  const float3 guided = render_average(true);
+
+  EXPECT_GT(average(unguided), 0.01f);
+  EXPECT_NEAR(guided.x, unguided.x, unguided.x * 0.02f);
+  EXPECT_NEAR(guided.y, unguided.y, unguided.y * 0.02f);
+  EXPECT_NEAR(guided.z, unguided.z, unguided.z * 0.02f);
+}
+
+CCL_NAMESPACE_END
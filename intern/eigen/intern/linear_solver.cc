@@ -37,6 +37,7 @@
 typedef Eigen::SparseMatrix<double, Eigen::ColMajor> EigenSparseMatrix;
 typedef Eigen::SparseLU<EigenSparseMatrix> EigenSparseLU;
 typedef Eigen::VectorXd EigenVectorX;
+typedef Eigen::MatrixXd EigenMatrixX;
 typedef Eigen::Triplet<double> EigenTriplet;
 
 /* Linear Solver data structure */
@@ -303,7 +304,10 @@ bool EIG_linear_solver_solve(LinearSolver *solver)
   }
 
   if (result) {
-    /* solve for each right hand side */
+    /* gather all right hand sides, to solve them with a single back-substitution
+     * reusing the factorization */
+    EigenMatrixX B(solver->m, solver->num_rhs);
+
     for (int rhs = 0; rhs < solver->num_rhs; rhs++) {
       /* modify for locked variables */
       EigenVectorX &b = solver->b[rhs];
@@ -319,22 +323,28 @@ bool EIG_linear_solver_solve(LinearSolver *solver)
         }
       }
 
-      /* solve */
-      if (solver->least_squares) {
-        EigenVectorX Mtb = solver->M.transpose() * b;
-        solver->x[rhs] = solver->sparseLU->solve(Mtb);
-      }
-      else {
-        EigenVectorX &b = solver->b[rhs];
-        solver->x[rhs] = solver->sparseLU->solve(b);
-      }
+      B.col(rhs) = b;
+    }
 
-      if (solver->sparseLU->info() != Eigen::Success)
-        result = false;
+    /* solve */
+    EigenMatrixX X;
+    if (solver->least_squares) {
+      EigenMatrixX MtB = solver->M.transpose() * B;
+      X = solver->sparseLU->solve(MtB);
     }
+    else {
+      X = solver->sparseLU->solve(B);
+    }
+
+    if (solver->sparseLU->info() != Eigen::Success)
+      result = false;
+
+    if (result) {
+      for (int rhs = 0; rhs < solver->num_rhs; rhs++)
+        solver->x[rhs] = X.col(rhs);
 
-    if (result)
       linear_solver_vector_to_variables(solver);
+    }
   }
 
   /* clear for next solve */
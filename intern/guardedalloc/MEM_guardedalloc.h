@@ -220,9 +220,30 @@ void MEM_init_memleak_detection(void);
  * tests. */
 void MEM_enable_fail_on_memleak(void);
 
+/**
+ * Start the sampling allocation profiler, which estimates the memory in use per allocation
+ * name and allocating thread. About one allocation per \a sample_interval bytes is sampled,
+ * so its overhead is low enough to keep it running.
+ * Only the lockfree and thread cached allocators are profiled, not aligned allocations.
+ */
+void MEM_profile_start(size_t sample_interval);
+/** Stop sampling, the statistics are kept. */
+void MEM_profile_stop(void);
+bool MEM_profile_is_running(void);
+/** Profile statistics as a JSON string, to be freed with #MEM_freeN. */
+char *MEM_profile_json(void);
+/** Write the profile statistics as JSON, returns false when the file could not be written. */
+bool MEM_profile_write_json(const char *filepath);
+/** Write the profile statistics as JSON when the program exits. */
+void MEM_profile_write_json_at_exit(const char *filepath);
+
 /* Switch allocator to slower but fully guarded mode. */
 void MEM_use_guarded_allocator(void);
 
+/* Switch allocator to caching small blocks per thread, for less contention between threads.
+ * Blocks allocated before the switch can still be freed. */
+void MEM_use_thread_cached_allocator(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,496 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup MEM
+ *
+ * Memory allocation with per-thread caches of small blocks.
+ *
+ * Small blocks are taken from and returned to a cache owned by the calling thread,
+ * avoiding both the system allocator and atomic operations on shared counters.
+ * Every block is a separate system allocation, so a block freed by another thread than
+ * the one that allocated it is simply cached by the freeing thread.
+ *
+ * Memory counters are kept per thread and added to the global counters in batches.
+ * Large and aligned blocks are passed on to the lockfree allocator,
+ * which also shares the block header layout so its blocks can be freed here.
+ */
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h> /* memcpy */
+#include <sys/types.h>
+
+#include "MEM_guardedalloc.h"
+
+/* to ensure strict conversions */
+#include "../../source/blender/blenlib/BLI_strict_flags.h"
+
+#include "atomic_ops.h"
+#include "mallocn_intern.h"
+
+/* Must match the lockfree allocator's MemHead. */
+typedef struct MemHead {
+  /* Length of allocated memory block, with #MEMHEAD_CACHED_FLAG set. */
+  size_t len;
+} MemHead;
+
+#define MEMHEAD_FROM_PTR(ptr) (((MemHead *)ptr) - 1)
+#define PTR_FROM_MEMHEAD(memhead) (memhead + 1)
+#define MEMHEAD_IS_CACHED(memhead) (MEMHEAD_TYPE(memhead) == MEMHEAD_CACHED_FLAG)
+
+/* Blocks up to #MEM_CACHE_LEN_MAX are rounded up to a multiple of #MEM_CACHE_CLASS_LEN
+ * and cached, each size class in its own list. */
+#define MEM_CACHE_CLASS_LEN 16
+#define MEM_CACHE_CLASS_NUM 16
+#define MEM_CACHE_LEN_MAX (MEM_CACHE_CLASS_LEN * MEM_CACHE_CLASS_NUM)
+
+/* Maximum memory kept in the cache of one size class per thread,
+ * further blocks are returned to the system. */
+#define MEM_CACHE_CLASS_LEN_CACHED_MAX (16 * 1024)
+
+/* Per-thread counters are added to the global counters once they reach this. */
+#define MEM_CACHE_COUNTERS_FLUSH (256 * 1024)
+
+typedef struct MemThreadCache {
+  /* Free blocks of each size class, linked through their first bytes. */
+  MemHead *free_list[MEM_CACHE_CLASS_NUM];
+  unsigned int free_list_len[MEM_CACHE_CLASS_NUM];
+
+  /* Counters not yet added to the global counters. Only changed by the owning thread,
+   * they can be negative when it frees blocks allocated by other threads. */
+  int64_t mem_in_use;
+  int64_t totblock;
+
+  struct MemThreadCache *next, *prev;
+} MemThreadCache;
+
+static pthread_key_t cache_key;
+static pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+
+/* All thread caches, to sum up their counters. Also locked when flushing counters. */
+static pthread_mutex_t caches_lock = PTHREAD_MUTEX_INITIALIZER;
+static MemThreadCache *caches = NULL;
+
+/* Counters of cached blocks, the lockfree allocator counts its own blocks. */
+static int64_t mem_in_use = 0, totblock = 0;
+static size_t peak_mem = 0;
+static bool malloc_debug_memset = false;
+
+static void (*error_callback)(const char *) = NULL;
+
+#ifdef __GNUC__
+__attribute__((format(printf, 1, 2)))
+#endif
+static void
+print_error(const char *str, ...)
+{
+  char buf[512];
+  va_list ap;
+
+  va_start(ap, str);
+  vsnprintf(buf, sizeof(buf), str, ap);
+  va_end(ap);
+  buf[sizeof(buf) - 1] = '\0';
+
+  if (error_callback) {
+    error_callback(buf);
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Thread Caches
+ * \{ */
+
+MEM_INLINE unsigned int cache_class_from_len(size_t len)
+{
+  return len ? (unsigned int)((len - 1) / MEM_CACHE_CLASS_LEN) : 0;
+}
+
+MEM_INLINE size_t cache_class_len(unsigned int cache_class)
+{
+  return (size_t)(cache_class + 1) * MEM_CACHE_CLASS_LEN;
+}
+
+static size_t cache_mem_in_use_total(void)
+{
+  int64_t total = atomic_add_and_fetch_int64(&mem_in_use, 0);
+  for (MemThreadCache *cache = caches; cache; cache = cache->next) {
+    total += atomic_add_and_fetch_int64(&cache->mem_in_use, 0);
+  }
+  return (size_t)total + MEM_lockfree_get_memory_in_use();
+}
+
+static void cache_counters_flush(MemThreadCache *cache)
+{
+  pthread_mutex_lock(&caches_lock);
+  const int64_t cache_mem_in_use = atomic_add_and_fetch_int64(&cache->mem_in_use, 0);
+  const int64_t cache_totblock = atomic_add_and_fetch_int64(&cache->totblock, 0);
+  atomic_sub_and_fetch_int64(&cache->mem_in_use, cache_mem_in_use);
+  atomic_sub_and_fetch_int64(&cache->totblock, cache_totblock);
+  atomic_add_and_fetch_int64(&mem_in_use, cache_mem_in_use);
+  atomic_add_and_fetch_int64(&totblock, cache_totblock);
+  /* The peak is only updated when flushing, so it may be off by the flush size per thread. */
+  atomic_fetch_and_update_max_z(&peak_mem, cache_mem_in_use_total());
+  pthread_mutex_unlock(&caches_lock);
+}
+
+MEM_INLINE void cache_counters_update(MemThreadCache *cache, int64_t len, int64_t blocks)
+{
+  /* Atomic so other threads can read the counters, there is no contention. */
+  const int64_t cache_mem_in_use = atomic_add_and_fetch_int64(&cache->mem_in_use, len);
+  atomic_add_and_fetch_int64(&cache->totblock, blocks);
+  if (UNLIKELY(cache_mem_in_use >= MEM_CACHE_COUNTERS_FLUSH ||
+               cache_mem_in_use <= -MEM_CACHE_COUNTERS_FLUSH)) {
+    cache_counters_flush(cache);
+  }
+}
+
+/* Called on thread exit. */
+static void cache_free(void *cache_v)
+{
+  MemThreadCache *cache = cache_v;
+
+  for (unsigned int i = 0; i < MEM_CACHE_CLASS_NUM; i++) {
+    MemHead *memh = cache->free_list[i];
+    while (memh) {
+      MemHead *memh_next = *(MemHead **)PTR_FROM_MEMHEAD(memh);
+      free(memh);
+      memh = memh_next;
+    }
+  }
+
+  pthread_mutex_lock(&caches_lock);
+  atomic_add_and_fetch_int64(&mem_in_use, cache->mem_in_use);
+  atomic_add_and_fetch_int64(&totblock, cache->totblock);
+  if (cache->prev) {
+    cache->prev->next = cache->next;
+  }
+  else {
+    caches = cache->next;
+  }
+  if (cache->next) {
+    cache->next->prev = cache->prev;
+  }
+  pthread_mutex_unlock(&caches_lock);
+
+  free(cache);
+}
+
+static void cache_key_create(void)
+{
+  pthread_key_create(&cache_key, cache_free);
+}
+
+/* Returns NULL when the cache could not be allocated, the caller must fall back. */
+static MemThreadCache *cache_get(void)
+{
+  MemThreadCache *cache = pthread_getspecific(cache_key);
+  if (UNLIKELY(cache == NULL)) {
+    cache = calloc(1, sizeof(MemThreadCache));
+    if (UNLIKELY(cache == NULL)) {
+      return NULL;
+    }
+    pthread_setspecific(cache_key, cache);
+
+    pthread_mutex_lock(&caches_lock);
+    cache->next = caches;
+    if (caches) {
+      caches->prev = cache;
+    }
+    caches = cache;
+    pthread_mutex_unlock(&caches_lock);
+  }
+  return cache;
+}
+
+/* Returns NULL when the system is out of memory, the caller must fall back. */
+static MemHead *cache_block_alloc(MemThreadCache *cache, size_t len)
+{
+  const unsigned int cache_class = cache_class_from_len(len);
+  MemHead *memh = cache->free_list[cache_class];
+
+  if (memh) {
+    cache->free_list[cache_class] = *(MemHead **)PTR_FROM_MEMHEAD(memh);
+    cache->free_list_len[cache_class]--;
+  }
+  else {
+    memh = (MemHead *)malloc(cache_class_len(cache_class) + sizeof(MemHead));
+    if (UNLIKELY(memh == NULL)) {
+      return NULL;
+    }
+  }
+
+  memh->len = len | (size_t)MEMHEAD_CACHED_FLAG;
+  cache_counters_update(cache, (int64_t)len, 1);
+
+  return memh;
+}
+
+static void cache_block_free(MemThreadCache *cache, MemHead *memh, size_t len)
+{
+  const unsigned int cache_class = cache_class_from_len(len);
+
+  if (cache->free_list_len[cache_class] * cache_class_len(cache_class) <
+      MEM_CACHE_CLASS_LEN_CACHED_MAX) {
+    *(MemHead **)PTR_FROM_MEMHEAD(memh) = cache->free_list[cache_class];
+    cache->free_list[cache_class] = memh;
+    cache->free_list_len[cache_class]++;
+  }
+  else {
+    free(memh);
+  }
+
+  cache_counters_update(cache, -(int64_t)len, -1);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Allocator API
+ * \{ */
+
+void MEM_cached_freeN(void *vmemh)
+{
+  if (vmemh == NULL || !MEMHEAD_IS_CACHED(MEMHEAD_FROM_PTR(vmemh))) {
+    MEM_lockfree_freeN(vmemh);
+    return;
+  }
+
+  if (leak_detector_has_run) {
+    print_error("%s\n", free_after_leak_detection_message);
+  }
+
+  MemHead *memh = MEMHEAD_FROM_PTR(vmemh);
+  size_t len = MEM_lockfree_allocN_len(vmemh);
+
+  if (UNLIKELY(malloc_debug_memset && len)) {
+    memset(memh + 1, 255, len);
+  }
+
+  MemThreadCache *cache = cache_get();
+  if (LIKELY(cache)) {
+    cache_block_free(cache, memh, len);
+  }
+  else {
+    atomic_sub_and_fetch_int64(&mem_in_use, (int64_t)len);
+    atomic_sub_and_fetch_int64(&totblock, 1);
+    free(memh);
+  }
+}
+
+void *MEM_cached_dupallocN(const void *vmemh)
+{
+  void *newp = NULL;
+  if (vmemh) {
+    if (!MEMHEAD_IS_CACHED(MEMHEAD_FROM_PTR(vmemh))) {
+      return MEM_lockfree_dupallocN(vmemh);
+    }
+    const size_t prev_size = MEM_lockfree_allocN_len(vmemh);
+    newp = MEM_cached_mallocN(prev_size, "dupli_malloc");
+    if (newp) {
+      memcpy(newp, vmemh, prev_size);
+    }
+  }
+  return newp;
+}
+
+/**
+ * Realloc of a block that isn't aligned, which may be moved between the caches and the lockfree
+ * allocator depending on its new size.
+ */
+static void *cached_realloc(void *vmemh, size_t len, const bool use_calloc)
+{
+  const size_t old_len = MEM_lockfree_allocN_len(vmemh);
+  void *newp = MEM_cached_mallocN(len, "realloc");
+
+  if (newp) {
+    if (len < old_len) {
+      /* shrink */
+      memcpy(newp, vmemh, len);
+    }
+    else {
+      memcpy(newp, vmemh, old_len);
+
+      if (use_calloc && len > old_len) {
+        /* grow */
+        /* zero new bytes */
+        memset(((char *)newp) + old_len, 0, len - old_len);
+      }
+    }
+  }
+
+  MEM_cached_freeN(vmemh);
+
+  return newp;
+}
+
+void *MEM_cached_reallocN_id(void *vmemh, size_t len, const char *str)
+{
+  if (vmemh == NULL) {
+    return MEM_cached_mallocN(len, str);
+  }
+  if (MEMHEAD_TYPE(MEMHEAD_FROM_PTR(vmemh)) == MEMHEAD_ALIGN_FLAG) {
+    return MEM_lockfree_reallocN_id(vmemh, len, str);
+  }
+  return cached_realloc(vmemh, len, false);
+}
+
+void *MEM_cached_recallocN_id(void *vmemh, size_t len, const char *str)
+{
+  if (vmemh == NULL) {
+    return MEM_cached_callocN(len, str);
+  }
+  if (MEMHEAD_TYPE(MEMHEAD_FROM_PTR(vmemh)) == MEMHEAD_ALIGN_FLAG) {
+    return MEM_lockfree_recallocN_id(vmemh, len, str);
+  }
+  return cached_realloc(vmemh, len, true);
+}
+
+void *MEM_cached_callocN(size_t len, const char *str)
+{
+  len = SIZET_ALIGN_4(len);
+
+  if (len <= MEM_CACHE_LEN_MAX) {
+    /* Blocks sampled by the profiler are allocated by the lockfree allocator. */
+    if (UNLIKELY(mem_profile_is_running) && mem_profile_sample_test(len)) {
+      return MEM_lockfree_sampled_allocN(len, str, true);
+    }
+
+    MemThreadCache *cache = cache_get();
+    MemHead *memh = cache ? cache_block_alloc(cache, len) : NULL;
+    if (LIKELY(memh)) {
+      memset(memh + 1, 0, len);
+      return PTR_FROM_MEMHEAD(memh);
+    }
+  }
+
+  return MEM_lockfree_callocN(len, str);
+}
+
+void *MEM_cached_calloc_arrayN(size_t len, size_t size, const char *str)
+{
+  size_t total_size;
+  if (UNLIKELY(!MEM_size_safe_multiply(len, size, &total_size))) {
+    /* Reports the overflow. */
+    return MEM_lockfree_calloc_arrayN(len, size, str);
+  }
+
+  return MEM_cached_callocN(total_size, str);
+}
+
+void *MEM_cached_mallocN(size_t len, const char *str)
+{
+  len = SIZET_ALIGN_4(len);
+
+  if (len <= MEM_CACHE_LEN_MAX) {
+    /* Blocks sampled by the profiler are allocated by the lockfree allocator. */
+    if (UNLIKELY(mem_profile_is_running) && mem_profile_sample_test(len)) {
+      return MEM_lockfree_sampled_allocN(len, str, false);
+    }
+
+    MemThreadCache *cache = cache_get();
+    MemHead *memh = cache ? cache_block_alloc(cache, len) : NULL;
+    if (LIKELY(memh)) {
+      if (UNLIKELY(malloc_debug_memset && len)) {
+        memset(memh + 1, 255, len);
+      }
+      return PTR_FROM_MEMHEAD(memh);
+    }
+  }
+
+  return MEM_lockfree_mallocN(len, str);
+}
+
+void *MEM_cached_malloc_arrayN(size_t len, size_t size, const char *str)
+{
+  size_t total_size;
+  if (UNLIKELY(!MEM_size_safe_multiply(len, size, &total_size))) {
+    /* Reports the overflow. */
+    return MEM_lockfree_malloc_arrayN(len, size, str);
+  }
+
+  return MEM_cached_mallocN(total_size, str);
+}
+
+void MEM_cached_printmemlist_stats(void)
+{
+  printf("\ntotal memory len: %.3f MB\n",
+         (double)MEM_cached_get_memory_in_use() / (double)(1024 * 1024));
+  printf("peak memory len: %.3f MB\n",
+         (double)MEM_cached_get_peak_memory() / (double)(1024 * 1024));
+  printf(
+      "\nFor more detailed per-block statistics run Blender with memory debugging command line "
+      "argument.\n");
+
+#ifdef HAVE_MALLOC_STATS
+  printf("System Statistics:\n");
+  malloc_stats();
+#endif
+}
+
+void MEM_cached_set_error_callback(void (*func)(const char *))
+{
+  error_callback = func;
+  MEM_lockfree_set_error_callback(func);
+}
+
+void MEM_cached_set_memory_debug(void)
+{
+  malloc_debug_memset = true;
+  MEM_lockfree_set_memory_debug();
+}
+
+size_t MEM_cached_get_memory_in_use(void)
+{
+  pthread_mutex_lock(&caches_lock);
+  const size_t total = cache_mem_in_use_total();
+  pthread_mutex_unlock(&caches_lock);
+  return total;
+}
+
+unsigned int MEM_cached_get_memory_blocks_in_use(void)
+{
+  pthread_mutex_lock(&caches_lock);
+  int64_t total = atomic_add_and_fetch_int64(&totblock, 0);
+  for (MemThreadCache *cache = caches; cache; cache = cache->next) {
+    total += atomic_add_and_fetch_int64(&cache->totblock, 0);
+  }
+  pthread_mutex_unlock(&caches_lock);
+  return (unsigned int)total + MEM_lockfree_get_memory_blocks_in_use();
+}
+
+void MEM_cached_reset_peak_memory(void)
+{
+  pthread_mutex_lock(&caches_lock);
+  peak_mem = cache_mem_in_use_total();
+  pthread_mutex_unlock(&caches_lock);
+}
+
+size_t MEM_cached_get_peak_memory(void)
+{
+  const size_t total = MEM_cached_get_memory_in_use();
+  return total > peak_mem ? total : peak_mem;
+}
+
+/** \} */
+
+void MEM_cached_init(void)
+{
+  pthread_once(&cache_key_once, cache_key_create);
+}
@@ -95,6 +95,15 @@ size_t malloc_usable_size(void *ptr);
 #define MEMHEAD_ALIGN_PADDING(alignment) \
   ((size_t)alignment - (sizeof(MemHeadAligned) % (size_t)alignment))
 
+/* Type of block stored in the lowest bits of the length of blocks from the lockfree and
+ * cached allocators, which is always a multiple of 4. */
+#define MEMHEAD_TYPE_MASK 3
+#define MEMHEAD_ALIGN_FLAG 1
+#define MEMHEAD_CACHED_FLAG 2
+/* Sampled by the allocation profiler, with a #MemProfileSample before its header. */
+#define MEMHEAD_SAMPLED_FLAG 3
+#define MEMHEAD_TYPE(memh) ((memh)->len & (size_t)MEMHEAD_TYPE_MASK)
+
 /* Real pointer returned by the malloc or aligned_alloc. */
 #define MEMHEAD_REAL_PTR(memh) ((char *)memh - MEMHEAD_ALIGN_PADDING(memh->alignment))
 
@@ -112,6 +121,20 @@ void aligned_free(void *ptr);
 extern bool leak_detector_has_run;
 extern char free_after_leak_detection_message[];
 
+/* Allocation profiler, see mallocn_profile.c */
+typedef struct MemProfileRecord MemProfileRecord;
+typedef struct MemProfileSample {
+  MemProfileRecord *record;
+  /* Estimate of the allocations this sample stands in for. */
+  size_t weight_len;
+  size_t weight_count;
+} MemProfileSample;
+
+extern bool mem_profile_is_running;
+bool mem_profile_sample_test(size_t len);
+void mem_profile_sample_alloc(MemProfileSample *sample, size_t len, const char *str);
+void mem_profile_sample_free(const MemProfileSample *sample);
+
 /* Prototypes for counted allocator functions */
 size_t MEM_lockfree_allocN_len(const void *vmemh) ATTR_WARN_UNUSED_RESULT;
 void MEM_lockfree_freeN(void *vmemh);
@@ -140,6 +163,7 @@ void *MEM_lockfree_mallocN_aligned(size_t len,
                                    size_t alignment,
                                    const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
     ATTR_ALLOC_SIZE(1) ATTR_NONNULL(3);
+void *MEM_lockfree_sampled_allocN(size_t len, const char *str, bool use_calloc);
 void MEM_lockfree_printmemlist_pydict(void);
 void MEM_lockfree_printmemlist(void);
 void MEM_lockfree_callbackmemlist(void (*func)(void *));
@@ -155,6 +179,39 @@ size_t MEM_lockfree_get_peak_memory(void) ATTR_WARN_UNUSED_RESULT;
 const char *MEM_lockfree_name_ptr(void *vmemh);
 #endif
 
+/* Prototypes for thread cached allocator functions,
+ * functions not listed here are shared with the lockfree allocator. */
+void MEM_cached_init(void);
+void MEM_cached_freeN(void *vmemh);
+void *MEM_cached_dupallocN(const void *vmemh) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+void *MEM_cached_reallocN_id(void *vmemh,
+                             size_t len,
+                             const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_ALLOC_SIZE(2);
+void *MEM_cached_recallocN_id(void *vmemh,
+                              size_t len,
+                              const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_ALLOC_SIZE(2);
+void *MEM_cached_callocN(size_t len, const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_ALLOC_SIZE(1) ATTR_NONNULL(2);
+void *MEM_cached_calloc_arrayN(size_t len,
+                               size_t size,
+                               const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_ALLOC_SIZE(1, 2) ATTR_NONNULL(3);
+void *MEM_cached_mallocN(size_t len, const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_ALLOC_SIZE(1) ATTR_NONNULL(2);
+void *MEM_cached_malloc_arrayN(size_t len,
+                               size_t size,
+                               const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_ALLOC_SIZE(1, 2) ATTR_NONNULL(3);
+void MEM_cached_printmemlist_stats(void);
+void MEM_cached_set_error_callback(void (*func)(const char *));
+void MEM_cached_set_memory_debug(void);
+size_t MEM_cached_get_memory_in_use(void);
+unsigned int MEM_cached_get_memory_blocks_in_use(void);
+void MEM_cached_reset_peak_memory(void);
+size_t MEM_cached_get_peak_memory(void) ATTR_WARN_UNUSED_RESULT;
+
 /* Prototypes for fully guarded allocator functions */
 size_t MEM_guarded_allocN_len(const void *vmemh) ATTR_WARN_UNUSED_RESULT;
 void MEM_guarded_freeN(void *vmemh);
@@ -49,14 +49,12 @@ static bool malloc_debug_memset = false;
 
 static void (*error_callback)(const char *) = NULL;
 
-enum {
-  MEMHEAD_ALIGN_FLAG = 1,
-};
-
 #define MEMHEAD_FROM_PTR(ptr) (((MemHead *)ptr) - 1)
 #define PTR_FROM_MEMHEAD(memhead) (memhead + 1)
 #define MEMHEAD_ALIGNED_FROM_PTR(ptr) (((MemHeadAligned *)ptr) - 1)
-#define MEMHEAD_IS_ALIGNED(memhead) ((memhead)->len & (size_t)MEMHEAD_ALIGN_FLAG)
+#define MEMHEAD_IS_ALIGNED(memhead) (MEMHEAD_TYPE(memhead) == MEMHEAD_ALIGN_FLAG)
+#define MEMHEAD_IS_SAMPLED(memhead) (MEMHEAD_TYPE(memhead) == MEMHEAD_SAMPLED_FLAG)
+#define SAMPLE_FROM_MEMHEAD(memhead) (((MemProfileSample *)memhead) - 1)
 
 /* Uncomment this to have proper peak counter. */
 #define USE_ATOMIC_MAX
@@ -92,7 +90,7 @@ print_error(const char *str, ...)
 size_t MEM_lockfree_allocN_len(const void *vmemh)
 {
   if (vmemh) {
-    return MEMHEAD_FROM_PTR(vmemh)->len & ~((size_t)(MEMHEAD_ALIGN_FLAG));
+    return MEMHEAD_FROM_PTR(vmemh)->len & ~((size_t)MEMHEAD_TYPE_MASK);
   }
 
   return 0;
@@ -125,6 +123,11 @@ void MEM_lockfree_freeN(void *vmemh)
     MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
     aligned_free(MEMHEAD_REAL_PTR(memh_aligned));
   }
+  else if (UNLIKELY(MEMHEAD_IS_SAMPLED(memh))) {
+    MemProfileSample *sample = SAMPLE_FROM_MEMHEAD(memh);
+    mem_profile_sample_free(sample);
+    free(sample);
+  }
   else {
     free(memh);
   }
@@ -232,6 +235,10 @@ void *MEM_lockfree_callocN(size_t len, const char *str)
 
   len = SIZET_ALIGN_4(len);
 
+  if (UNLIKELY(mem_profile_is_running) && mem_profile_sample_test(len)) {
+    return MEM_lockfree_sampled_allocN(len, str, true);
+  }
+
   memh = (MemHead *)calloc(1, len + sizeof(MemHead));
 
   if (LIKELY(memh)) {
@@ -273,6 +280,10 @@ void *MEM_lockfree_mallocN(size_t len, const char *str)
 
   len = SIZET_ALIGN_4(len);
 
+  if (UNLIKELY(mem_profile_is_running) && mem_profile_sample_test(len)) {
+    return MEM_lockfree_sampled_allocN(len, str, false);
+  }
+
   memh = (MemHead *)malloc(len + sizeof(MemHead));
 
   if (LIKELY(memh)) {
@@ -294,6 +305,39 @@ void *MEM_lockfree_mallocN(size_t len, const char *str)
   return NULL;
 }
 
+/**
+ * Allocate a block sampled by the allocation profiler, with the sample stored before its header.
+ * \param len: Must already be aligned to 4.
+ */
+void *MEM_lockfree_sampled_allocN(size_t len, const char *str, bool use_calloc)
+{
+  const size_t len_alloc = len + sizeof(MemProfileSample) + sizeof(MemHead);
+  MemProfileSample *sample = (MemProfileSample *)(use_calloc ? calloc(1, len_alloc) :
+                                                               malloc(len_alloc));
+
+  if (LIKELY(sample)) {
+    MemHead *memh = (MemHead *)(sample + 1);
+
+    if (UNLIKELY(!use_calloc && malloc_debug_memset && len)) {
+      memset(memh + 1, 255, len);
+    }
+
+    memh->len = len | (size_t)MEMHEAD_SAMPLED_FLAG;
+    atomic_add_and_fetch_u(&totblock, 1);
+    atomic_add_and_fetch_z(&mem_in_use, len);
+    update_maximum(&peak_mem, mem_in_use);
+
+    mem_profile_sample_alloc(sample, len, str);
+
+    return PTR_FROM_MEMHEAD(memh);
+  }
+  print_error("Malloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
+              SIZET_ARG(len),
+              str,
+              (unsigned int)mem_in_use);
+  return NULL;
+}
+
 void *MEM_lockfree_malloc_arrayN(size_t len, size_t size, const char *str)
 {
   size_t total_size;
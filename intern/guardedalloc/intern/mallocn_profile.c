@@ -0,0 +1,450 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup MEM
+ *
+ * Sampling allocation profiler for the lockfree and thread cached allocators.
+ *
+ * Every thread counts down the bytes it allocates, and samples the allocation that reaches
+ * zero, after which the count down restarts from a randomized sample interval. A sampled
+ * block gets a #MemProfileSample header which points to the statistics of its name and
+ * allocating thread, and stands in for the sample interval worth of allocations.
+ * This is unbiased on average, while the rest of the allocations only pay for the count down.
+ */
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+/* to ensure strict conversions */
+#include "../../source/blender/blenlib/BLI_strict_flags.h"
+
+#include "atomic_ops.h"
+#include "mallocn_intern.h"
+
+#ifdef _MSC_VER
+#  define MEM_THREAD_LOCAL __declspec(thread)
+#else
+#  define MEM_THREAD_LOCAL __thread
+#endif
+
+#define MEM_PROFILE_HASH_SIZE 4096
+
+typedef struct MemProfileStats {
+  /* Estimated from the samples. */
+  size_t live_len;
+  size_t live_count;
+  size_t peak_len;
+  size_t total_len;
+  size_t total_count;
+} MemProfileStats;
+
+struct MemProfileRecord {
+  struct MemProfileRecord *hash_next;
+  /* Name passed to the allocation, also compared by pointer first
+   * since most names are string literals. */
+  const char *str;
+  char *name;
+  unsigned int hash;
+  /* Index of the allocating thread, -1 for the totals of all threads. */
+  int thread;
+  MemProfileStats stats;
+  /* Totals over all threads, NULL when this is the totals. */
+  struct MemProfileRecord *totals;
+};
+
+bool mem_profile_is_running = false;
+static size_t sample_interval = 0;
+
+/* Records are never freed, as sampled blocks point to them. */
+static pthread_mutex_t records_lock = PTHREAD_MUTEX_INITIALIZER;
+static MemProfileRecord *records_hash[MEM_PROFILE_HASH_SIZE];
+static unsigned int records_len = 0;
+
+static unsigned int thread_num = 0;
+static char *exit_filepath = NULL;
+
+static MEM_THREAD_LOCAL int64_t thread_len_until_sample = 0;
+static MEM_THREAD_LOCAL unsigned int thread_index = 0; /* Zero until assigned. */
+static MEM_THREAD_LOCAL uint32_t thread_rng_state = 0;
+
+/* -------------------------------------------------------------------- */
+/** \name Sampling
+ * \{ */
+
+static uint32_t thread_rng_next(void)
+{
+  /* Xorshift, seeded per thread. */
+  uint32_t x = thread_rng_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  thread_rng_state = x;
+  return x;
+}
+
+static void thread_ensure_index(void)
+{
+  if (UNLIKELY(thread_index == 0)) {
+    thread_index = atomic_add_and_fetch_u(&thread_num, 1);
+    thread_rng_state = 0x9E3779B9u * thread_index;
+  }
+}
+
+static int64_t sample_interval_random(void)
+{
+  /* Randomize the interval in [0.5, 1.5) times the sample interval,
+   * so regular allocation patterns don't alias with it. */
+  const int64_t interval = (int64_t)sample_interval;
+  return interval / 2 + (int64_t)(thread_rng_next() % (uint32_t)interval);
+}
+
+bool mem_profile_sample_test(size_t len)
+{
+  thread_len_until_sample -= (int64_t)len;
+  if (LIKELY(thread_len_until_sample > 0)) {
+    return false;
+  }
+
+  if (UNLIKELY(thread_index == 0)) {
+    /* The countdown of a new thread starts at zero, seed it with a random interval
+     * instead of always sampling the first allocation of every thread. */
+    thread_ensure_index();
+    thread_len_until_sample = sample_interval_random() - (int64_t)len;
+    if (thread_len_until_sample > 0) {
+      return false;
+    }
+  }
+
+  thread_len_until_sample = sample_interval_random();
+  return true;
+}
+
+static unsigned int str_hash(const char *str)
+{
+  /* DJB2. */
+  unsigned int hash = 5381;
+  for (const char *p = str; *p; p++) {
+    hash = (hash << 5) + hash + (unsigned int)(unsigned char)*p;
+  }
+  return hash;
+}
+
+static MemProfileRecord *record_ensure(const char *str, unsigned int hash, int thread)
+{
+  const unsigned int bucket = (hash + (unsigned int)(thread + 1) * 31u) % MEM_PROFILE_HASH_SIZE;
+  for (MemProfileRecord *record = records_hash[bucket]; record; record = record->hash_next) {
+    if (record->thread == thread && record->hash == hash &&
+        (record->str == str || strcmp(record->name, str) == 0)) {
+      return record;
+    }
+  }
+
+  /* Allocated from the system, to not recurse into the allocator. */
+  MemProfileRecord *record = calloc(1, sizeof(MemProfileRecord));
+  char *name = strdup(str);
+  if (UNLIKELY(record == NULL || name == NULL)) {
+    free(record);
+    free(name);
+    return NULL;
+  }
+  record->str = str;
+  record->name = name;
+  record->hash = hash;
+  record->thread = thread;
+  record->hash_next = records_hash[bucket];
+  records_hash[bucket] = record;
+  records_len++;
+  return record;
+}
+
+static void stats_add(MemProfileStats *stats, size_t len, size_t count)
+{
+  const size_t live_len = atomic_add_and_fetch_z(&stats->live_len, len);
+  atomic_add_and_fetch_z(&stats->live_count, count);
+  atomic_fetch_and_update_max_z(&stats->peak_len, live_len);
+  atomic_add_and_fetch_z(&stats->total_len, len);
+  atomic_add_and_fetch_z(&stats->total_count, count);
+}
+
+static void stats_sub(MemProfileStats *stats, size_t len, size_t count)
+{
+  atomic_sub_and_fetch_z(&stats->live_len, len);
+  atomic_sub_and_fetch_z(&stats->live_count, count);
+}
+
+void mem_profile_sample_alloc(MemProfileSample *sample, size_t len, const char *str)
+{
+  /* Each sample stands in for the sample interval worth of allocations. */
+  sample->weight_len = len > sample_interval ? len : sample_interval;
+  sample->weight_count = len ? sample->weight_len / len : 1;
+
+  const unsigned int hash = str_hash(str);
+  pthread_mutex_lock(&records_lock);
+  MemProfileRecord *record = record_ensure(str, hash, (int)thread_index - 1);
+  if (record && record->totals == NULL) {
+    record->totals = record_ensure(str, hash, -1);
+  }
+  pthread_mutex_unlock(&records_lock);
+
+  if (UNLIKELY(record == NULL || record->totals == NULL)) {
+    sample->record = NULL;
+    return;
+  }
+
+  sample->record = record;
+  stats_add(&record->stats, sample->weight_len, sample->weight_count);
+  stats_add(&record->totals->stats, sample->weight_len, sample->weight_count);
+}
+
+void mem_profile_sample_free(const MemProfileSample *sample)
+{
+  MemProfileRecord *record = sample->record;
+  if (record) {
+    stats_sub(&record->stats, sample->weight_len, sample->weight_count);
+    stats_sub(&record->totals->stats, sample->weight_len, sample->weight_count);
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name JSON Output
+ * \{ */
+
+typedef struct JSONBuffer {
+  char *data;
+  size_t len, len_alloc;
+  bool failed;
+} JSONBuffer;
+
+#ifdef __GNUC__
+__attribute__((format(printf, 2, 3)))
+#endif
+static void
+json_append(JSONBuffer *buf, const char *format, ...)
+{
+  while (!buf->failed) {
+    va_list args;
+    va_start(args, format);
+    const int len = vsnprintf(buf->data + buf->len, buf->len_alloc - buf->len, format, args);
+    va_end(args);
+
+    if (len < 0) {
+      buf->failed = true;
+    }
+    else if (buf->len + (size_t)len < buf->len_alloc) {
+      buf->len += (size_t)len;
+      return;
+    }
+    else {
+      /* Grow and try again. */
+      const size_t len_alloc = (buf->len_alloc + (size_t)len) * 2;
+      char *data = realloc(buf->data, len_alloc);
+      if (data == NULL) {
+        buf->failed = true;
+      }
+      else {
+        buf->data = data;
+        buf->len_alloc = len_alloc;
+      }
+    }
+  }
+}
+
+static void json_append_string(JSONBuffer *buf, const char *str)
+{
+  json_append(buf, "\"");
+  for (const char *p = str; *p; p++) {
+    const unsigned char c = (unsigned char)*p;
+    if (c == '"' || c == '\\') {
+      json_append(buf, "\\%c", c);
+    }
+    else if (c < 0x20) {
+      json_append(buf, "\\u%04x", c);
+    }
+    else {
+      json_append(buf, "%c", c);
+    }
+  }
+  json_append(buf, "\"");
+}
+
+static int record_cmp_live_len(const void *a_v, const void *b_v)
+{
+  const MemProfileRecord *a = *(const MemProfileRecord **)a_v;
+  const MemProfileRecord *b = *(const MemProfileRecord **)b_v;
+  if (a->stats.live_len != b->stats.live_len) {
+    return a->stats.live_len > b->stats.live_len ? -1 : 1;
+  }
+  return strcmp(a->name, b->name);
+}
+
+static void json_append_records(JSONBuffer *buf,
+                                MemProfileRecord **records,
+                                unsigned int records_num,
+                                const bool use_totals)
+{
+  bool is_first = true;
+  for (unsigned int i = 0; i < records_num; i++) {
+    const MemProfileRecord *record = records[i];
+    if ((record->thread == -1) != use_totals) {
+      continue;
+    }
+    json_append(buf, is_first ? "\n    {\"name\": " : ",\n    {\"name\": ");
+    json_append_string(buf, record->name);
+    if (!use_totals) {
+      json_append(buf, ", \"thread\": %d", record->thread);
+    }
+    json_append(buf,
+                ", \"live_bytes\": " SIZET_FORMAT ", \"live_count\": " SIZET_FORMAT
+                ", \"peak_bytes\": " SIZET_FORMAT ", \"total_bytes\": " SIZET_FORMAT
+                ", \"total_count\": " SIZET_FORMAT "}",
+                SIZET_ARG(record->stats.live_len),
+                SIZET_ARG(record->stats.live_count),
+                SIZET_ARG(record->stats.peak_len),
+                SIZET_ARG(record->stats.total_len),
+                SIZET_ARG(record->stats.total_count));
+    is_first = false;
+  }
+}
+
+/* Returns a string allocated with malloc(), or NULL on failure. */
+static char *profile_json(void)
+{
+  JSONBuffer buf = {NULL, 0, 0, false};
+
+  json_append(&buf,
+              "{\n  \"sample_interval\": " SIZET_FORMAT ",\n  \"memory_in_use\": " SIZET_FORMAT
+              ",\n  \"peak_memory\": " SIZET_FORMAT ",\n  \"threads\": %u,",
+              SIZET_ARG(sample_interval),
+              SIZET_ARG(MEM_get_memory_in_use()),
+              SIZET_ARG(MEM_get_peak_memory()),
+              thread_num);
+
+  pthread_mutex_lock(&records_lock);
+
+  MemProfileRecord **records = malloc(sizeof(*records) * (records_len ? records_len : 1));
+  unsigned int records_num = 0;
+  if (records) {
+    for (unsigned int i = 0; i < MEM_PROFILE_HASH_SIZE; i++) {
+      for (MemProfileRecord *record = records_hash[i]; record; record = record->hash_next) {
+        records[records_num++] = record;
+      }
+    }
+    qsort(records, records_num, sizeof(*records), record_cmp_live_len);
+  }
+  else {
+    buf.failed = true;
+  }
+
+  /* Totals per name first, then per name and allocating thread. */
+  json_append(&buf, "\n  \"names\": [");
+  json_append_records(&buf, records, records_num, true);
+  json_append(&buf, "\n  ],\n  \"threads_names\": [");
+  json_append_records(&buf, records, records_num, false);
+  json_append(&buf, "\n  ]\n}\n");
+
+  pthread_mutex_unlock(&records_lock);
+
+  free(records);
+
+  if (buf.failed) {
+    free(buf.data);
+    return NULL;
+  }
+  return buf.data;
+}
+
+static void profile_exit_write(void)
+{
+  if (exit_filepath) {
+    if (!MEM_profile_write_json(exit_filepath)) {
+      fprintf(stderr, "Error: could not write memory profile to \"%s\"\n", exit_filepath);
+    }
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Public API
+ * \{ */
+
+void MEM_profile_start(size_t interval)
+{
+  /* Also limited by the random number range. */
+  sample_interval = interval < 1 ? 1 : (interval > UINT32_MAX ? UINT32_MAX : interval);
+  mem_profile_is_running = true;
+}
+
+void MEM_profile_stop(void)
+{
+  mem_profile_is_running = false;
+}
+
+bool MEM_profile_is_running(void)
+{
+  return mem_profile_is_running;
+}
+
+char *MEM_profile_json(void)
+{
+  char *json = profile_json();
+  if (json == NULL) {
+    return NULL;
+  }
+  /* Copy after the records are unlocked, the allocation may be sampled. */
+  const size_t len = strlen(json) + 1;
+  char *result = MEM_mallocN(len, __func__);
+  memcpy(result, json, len);
+  free(json);
+  return result;
+}
+
+bool MEM_profile_write_json(const char *filepath)
+{
+  char *json = profile_json();
+  if (json == NULL) {
+    return false;
+  }
+
+  FILE *file = fopen(filepath, "w");
+  bool ok = false;
+  if (file) {
+    ok = fputs(json, file) >= 0;
+    ok = (fclose(file) == 0) && ok;
+  }
+  free(json);
+  return ok;
+}
+
+void MEM_profile_write_json_at_exit(const char *filepath)
+{
+  if (exit_filepath == NULL) {
+    atexit(profile_exit_write);
+  }
+  free(exit_filepath);
+  exit_filepath = strdup(filepath);
+}
+
+/** \} */
@@ -0,0 +1,68 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <string>
+#include <thread>
+
+#include "MEM_guardedalloc.h"
+
+#include "../intern/mallocn_intern.h"
+
+/* The lockfree allocator functions are called directly, as other tests may have switched
+ * to the guarded allocator which isn't profiled. */
+
+namespace {
+
+std::string profile_json()
+{
+  char *json = MEM_profile_json();
+  EXPECT_NE(json, nullptr);
+  std::string result;
+  if (json) {
+    result = json;
+    MEM_freeN(json);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(guardedalloc, ProfileSampleAll)
+{
+  /* Sampling every byte makes the statistics exact. */
+  MEM_profile_start(1);
+  EXPECT_TRUE(MEM_profile_is_running());
+
+  void *blocks[10];
+  for (int i = 0; i < 10; i++) {
+    blocks[i] = MEM_lockfree_mallocN(100, "ProfileSampleAll \"block\"");
+  }
+  void *block_thread = nullptr;
+  std::thread thread(
+      [&]() { block_thread = MEM_lockfree_callocN(1000, "ProfileSampleAll \"block\""); });
+  thread.join();
+
+  std::string json = profile_json();
+  EXPECT_NE(json.find("{\"name\": \"ProfileSampleAll \\\"block\\\"\", \"live_bytes\": 2000, "
+                      "\"live_count\": 11, \"peak_bytes\": 2000, \"total_bytes\": 2000, "
+                      "\"total_count\": 11}"),
+            std::string::npos);
+  /* The block allocated by the other thread is counted separately. */
+  EXPECT_NE(json.find("\"live_bytes\": 1000, \"live_count\": 1"), std::string::npos);
+  EXPECT_NE(json.find("\"live_bytes\": 1000, \"live_count\": 10"), std::string::npos);
+
+  for (int i = 0; i < 10; i++) {
+    MEM_lockfree_freeN(blocks[i]);
+  }
+  MEM_lockfree_freeN(block_thread);
+
+  json = profile_json();
+  EXPECT_NE(json.find("{\"name\": \"ProfileSampleAll \\\"block\\\"\", \"live_bytes\": 0, "
+                      "\"live_count\": 0, \"peak_bytes\": 2000, \"total_bytes\": 2000, "
+                      "\"total_count\": 11}"),
+            std::string::npos);
+
+  MEM_profile_stop();
+  EXPECT_FALSE(MEM_profile_is_running());
+}
@@ -0,0 +1,174 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+#include "../intern/mallocn_intern.h"
+
+/* The allocator functions are called directly rather than switching the allocator,
+ * so other tests are not affected. */
+
+namespace {
+
+struct Allocator {
+  const char *name;
+  void *(*mallocN)(size_t len, const char *str);
+  void (*freeN)(void *vmemh);
+  size_t (*get_memory_in_use)(void);
+  unsigned int (*get_memory_blocks_in_use)(void);
+};
+
+const Allocator lockfree_allocator = {"lockfree",
+                                      MEM_lockfree_mallocN,
+                                      MEM_lockfree_freeN,
+                                      MEM_lockfree_get_memory_in_use,
+                                      MEM_lockfree_get_memory_blocks_in_use};
+
+const Allocator cached_allocator = {"thread cached",
+                                    MEM_cached_mallocN,
+                                    MEM_cached_freeN,
+                                    MEM_cached_get_memory_in_use,
+                                    MEM_cached_get_memory_blocks_in_use};
+
+/* Sizes of a mix of small and large blocks. */
+size_t block_size(int i)
+{
+  return (i % 7 == 6) ? size_t(1000 + i) : size_t(1 + (i * 37) % 256);
+}
+
+/* Allocate and free blocks in batches, like typical temporary allocations. */
+void alloc_free_loop(const Allocator &allocator, int batches, int batch_len)
+{
+  std::vector<void *> blocks(batch_len);
+  for (int batch = 0; batch < batches; batch++) {
+    for (int i = 0; i < batch_len; i++) {
+      blocks[i] = allocator.mallocN(block_size(batch + i), __func__);
+      memset(blocks[i], i, block_size(batch + i));
+    }
+    for (int i = 0; i < batch_len; i++) {
+      allocator.freeN(blocks[i]);
+    }
+  }
+}
+
+double alloc_free_threaded(const Allocator &allocator, int threads_num, int batches)
+{
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < threads_num; i++) {
+    threads.emplace_back(alloc_free_loop, std::cref(allocator), batches, 64);
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+TEST(guardedalloc, ThreadCachedAllocFree)
+{
+  MEM_cached_init();
+
+  const size_t mem_in_use = MEM_cached_get_memory_in_use();
+  const unsigned int blocks_in_use = MEM_cached_get_memory_blocks_in_use();
+
+  std::vector<void *> blocks;
+  size_t len_total = 0;
+  for (int i = 0; i < 1000; i++) {
+    const size_t len = block_size(i);
+    void *block = (i % 2) ? MEM_cached_mallocN(len, __func__) : MEM_cached_callocN(len, __func__);
+    EXPECT_EQ(MEM_lockfree_allocN_len(block), SIZET_ALIGN_4(len));
+    if (i % 2 == 0) {
+      for (size_t j = 0; j < len; j++) {
+        EXPECT_EQ(((char *)block)[j], 0);
+      }
+    }
+    memset(block, 1, len);
+    blocks.push_back(block);
+    len_total += SIZET_ALIGN_4(len);
+  }
+  EXPECT_EQ(MEM_cached_get_memory_in_use(), mem_in_use + len_total);
+  EXPECT_EQ(MEM_cached_get_memory_blocks_in_use(), blocks_in_use + blocks.size());
+
+  /* Grow and shrink across the size classes and the lockfree allocator. */
+  for (void *&block : blocks) {
+    block = MEM_cached_reallocN_id(block, 2000, __func__);
+    EXPECT_EQ(((char *)block)[0], 1);
+    block = MEM_cached_recallocN_id(block, 8, __func__);
+    EXPECT_EQ(((char *)block)[0], 1);
+    block = MEM_cached_recallocN_id(block, 100, __func__);
+    EXPECT_EQ(((char *)block)[99], 0);
+    void *block_dup = MEM_cached_dupallocN(block);
+    EXPECT_EQ(memcmp(block, block_dup, 100), 0);
+    MEM_cached_freeN(block_dup);
+  }
+  for (void *block : blocks) {
+    MEM_cached_freeN(block);
+  }
+
+  /* Blocks from the lockfree allocator can be freed too. */
+  MEM_cached_freeN(MEM_lockfree_mallocN(10, __func__));
+
+  EXPECT_EQ(MEM_cached_get_memory_in_use(), mem_in_use);
+  EXPECT_EQ(MEM_cached_get_memory_blocks_in_use(), blocks_in_use);
+}
+
+TEST(guardedalloc, ThreadCachedCrossThreadFree)
+{
+  MEM_cached_init();
+
+  const size_t mem_in_use = MEM_cached_get_memory_in_use();
+  const unsigned int blocks_in_use = MEM_cached_get_memory_blocks_in_use();
+
+  /* Allocate on one thread and free on another, more than fits in the caches. */
+  std::vector<void *> blocks(100000);
+  std::thread producer([&]() {
+    for (size_t i = 0; i < blocks.size(); i++) {
+      blocks[i] = MEM_cached_mallocN(block_size(int(i)), __func__);
+    }
+  });
+  producer.join();
+  std::thread consumer([&]() {
+    for (void *block : blocks) {
+      MEM_cached_freeN(block);
+    }
+  });
+  consumer.join();
+
+  /* The counters of both threads must be kept when they exit. */
+  EXPECT_EQ(MEM_cached_get_memory_in_use(), mem_in_use);
+  EXPECT_EQ(MEM_cached_get_memory_blocks_in_use(), blocks_in_use);
+}
+
+/* Not a pass or fail test, prints the throughput of both allocators for comparison. */
+TEST(guardedalloc, ThreadCachedThroughput)
+{
+  MEM_cached_init();
+
+  const int threads_max = std::max(int(std::thread::hardware_concurrency()), 1);
+  const int batches = 2000;
+
+  for (const Allocator *allocator : {&lockfree_allocator, &cached_allocator}) {
+    const size_t mem_in_use = allocator->get_memory_in_use();
+    for (int threads_num = 1;; threads_num = std::min(threads_num * 2, threads_max)) {
+      const double time = alloc_free_threaded(*allocator, threads_num, batches);
+      const double ops = 2.0 * 64.0 * batches * threads_num;
+      printf("%s allocator, %d threads: %.2f M alloc & free per second\n",
+             allocator->name,
+             threads_num,
+             ops / time * 1e-6);
+      if (threads_num == threads_max) {
+        break;
+      }
+    }
+    EXPECT_EQ(allocator->get_memory_in_use(), mem_in_use);
+  }
+}
@@ -51,6 +51,10 @@ int openSubdiv_getAvailableEvaluators(void)
     flags |= OPENSUBDIV_EVALUATOR_OPENMP;
   }
 
+#ifdef OPENSUBDIV_HAS_TBB
+  flags |= OPENSUBDIV_EVALUATOR_TBB;
+#endif
+
   if (OpenCLDeviceContext::isSupported()) {
     flags |= OPENSUBDIV_EVALUATOR_OPENCL;
   }
@@ -32,6 +32,9 @@
 #include <opensubdiv/osd/cpuPatchTable.h>
 #include <opensubdiv/osd/cpuVertexBuffer.h>
 #include <opensubdiv/osd/mesh.h>
+#ifdef OPENSUBDIV_HAS_TBB
+#  include <opensubdiv/osd/tbbEvaluator.h>
+#endif
 #include <opensubdiv/osd/types.h>
 #include <opensubdiv/version.h>
 
@@ -52,10 +55,48 @@ using OpenSubdiv::Osd::CpuEvaluator;
 using OpenSubdiv::Osd::CpuPatchTable;
 using OpenSubdiv::Osd::CpuVertexBuffer;
 using OpenSubdiv::Osd::PatchCoord;
+#ifdef OPENSUBDIV_HAS_TBB
+using OpenSubdiv::Osd::TbbEvaluator;
+#endif
 
 namespace blender {
 namespace opensubdiv {
 
+// Interface of the evaluator implementations, allows to choose the OpenSubdiv evaluator used for
+// refinement and patch evaluation at runtime.
+class EvalOutput {
+ public:
+  virtual ~EvalOutput() = default;
+
+  virtual void updateData(const float *src, int start_vertex, int num_vertices) = 0;
+  virtual void updateVaryingData(const float *src, int start_vertex, int num_vertices) = 0;
+  virtual void updateFaceVaryingData(const int face_varying_channel,
+                                     const float *src,
+                                     int start_vertex,
+                                     int num_vertices) = 0;
+
+  virtual void refine() = 0;
+
+  // NOTE: P must point to a memory of at least float[3]*num_patch_coords.
+  virtual void evalPatches(const PatchCoord *patch_coord,
+                           const int num_patch_coords,
+                           float *P) = 0;
+  // NOTE: P, dPdu, dPdv must point to a memory of at least float[3]*num_patch_coords.
+  virtual void evalPatchesWithDerivatives(const PatchCoord *patch_coord,
+                                          const int num_patch_coords,
+                                          float *P,
+                                          float *dPdu,
+                                          float *dPdv) = 0;
+  // NOTE: varying must point to a memory of at least float[3]*num_patch_coords.
+  virtual void evalPatchesVarying(const PatchCoord *patch_coord,
+                                  const int num_patch_coords,
+                                  float *varying) = 0;
+  virtual void evalPatchesFaceVarying(const int face_varying_channel,
+                                      const PatchCoord *patch_coord,
+                                      const int num_patch_coords,
+                                      float face_varying[2]) = 0;
+};
+
 namespace {
 
 // Array implementation which stores small data on stack (or, rather, in the class itself).
@@ -289,7 +330,7 @@ template<typename SRC_VERTEX_BUFFER,
          typename PATCH_TABLE,
          typename EVALUATOR,
          typename DEVICE_CONTEXT = void>
-class VolatileEvalOutput {
+class VolatileEvalOutput : public EvalOutput {
  public:
   typedef OpenSubdiv::Osd::EvaluatorCacheT<EVALUATOR> EvaluatorCache;
   typedef FaceVaryingVolatileEval<EVAL_VERTEX_BUFFER,
@@ -338,7 +379,7 @@ class VolatileEvalOutput {
     }
   }
 
-  ~VolatileEvalOutput()
+  ~VolatileEvalOutput() override
   {
     delete src_data_;
     delete src_varying_data_;
@@ -352,12 +393,12 @@ class VolatileEvalOutput {
 
   // TODO(sergey): Implement binding API.
 
-  void updateData(const float *src, int start_vertex, int num_vertices)
+  void updateData(const float *src, int start_vertex, int num_vertices) override
   {
     src_data_->UpdateData(src, start_vertex, num_vertices, device_context_);
   }
 
-  void updateVaryingData(const float *src, int start_vertex, int num_vertices)
+  void updateVaryingData(const float *src, int start_vertex, int num_vertices) override
   {
     src_varying_data_->UpdateData(src, start_vertex, num_vertices, device_context_);
   }
@@ -365,7 +406,7 @@ class VolatileEvalOutput {
   void updateFaceVaryingData(const int face_varying_channel,
                              const float *src,
                              int start_vertex,
-                             int num_vertices)
+                             int num_vertices) override
   {
     assert(face_varying_channel >= 0);
     assert(face_varying_channel < face_varying_evaluators.size());
@@ -384,7 +425,7 @@ class VolatileEvalOutput {
     return face_varying_evaluators.size() != 0;
   }
 
-  void refine()
+  void refine() override
   {
     // Evaluate vertex positions.
     BufferDescriptor dst_desc = src_desc_;
@@ -420,8 +461,7 @@ class VolatileEvalOutput {
     }
   }
 
-  // NOTE: P must point to a memory of at least float[3]*num_patch_coords.
-  void evalPatches(const PatchCoord *patch_coord, const int num_patch_coords, float *P)
+  void evalPatches(const PatchCoord *patch_coord, const int num_patch_coords, float *P) override
   {
     RawDataWrapperBuffer<float> P_data(P);
     // TODO(sergey): Support interleaved vertex-varying data.
@@ -440,12 +480,11 @@ class VolatileEvalOutput {
                            device_context_);
   }
 
-  // NOTE: P, dPdu, dPdv must point to a memory of at least float[3]*num_patch_coords.
   void evalPatchesWithDerivatives(const PatchCoord *patch_coord,
                                   const int num_patch_coords,
                                   float *P,
                                   float *dPdu,
-                                  float *dPdv)
+                                  float *dPdv) override
   {
     assert(dPdu);
     assert(dPdv);
@@ -472,10 +511,9 @@ class VolatileEvalOutput {
                            device_context_);
   }
 
-  // NOTE: varying must point to a memory of at least float[3]*num_patch_coords.
   void evalPatchesVarying(const PatchCoord *patch_coord,
                           const int num_patch_coords,
-                          float *varying)
+                          float *varying) override
   {
     RawDataWrapperBuffer<float> varying_data(varying);
     BufferDescriptor varying_desc(3, 3, 6);
@@ -496,7 +534,7 @@ class VolatileEvalOutput {
   void evalPatchesFaceVarying(const int face_varying_channel,
                               const PatchCoord *patch_coord,
                               const int num_patch_coords,
-                              float face_varying[2])
+                              float face_varying[2]) override
   {
     assert(face_varying_channel >= 0);
     assert(face_varying_channel < face_varying_evaluators.size());
@@ -566,10 +604,39 @@ class CpuEvalOutput : public VolatileEvalOutput<CpuVertexBuffer,
   }
 };
 
+#ifdef OPENSUBDIV_HAS_TBB
+// Same as above, but refinement and patch evaluation are done from multiple threads.
+class TbbEvalOutput : public VolatileEvalOutput<CpuVertexBuffer,
+                                                CpuVertexBuffer,
+                                                StencilTable,
+                                                CpuPatchTable,
+                                                TbbEvaluator> {
+ public:
+  TbbEvalOutput(const StencilTable *vertex_stencils,
+                const StencilTable *varying_stencils,
+                const vector<const StencilTable *> &all_face_varying_stencils,
+                const int face_varying_width,
+                const PatchTable *patch_table,
+                EvaluatorCache *evaluator_cache = NULL)
+      : VolatileEvalOutput<CpuVertexBuffer,
+                           CpuVertexBuffer,
+                           StencilTable,
+                           CpuPatchTable,
+                           TbbEvaluator>(vertex_stencils,
+                                         varying_stencils,
+                                         all_face_varying_stencils,
+                                         face_varying_width,
+                                         patch_table,
+                                         evaluator_cache)
+  {
+  }
+};
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // Evaluator wrapper for anonymous API.
 
-CpuEvalOutputAPI::CpuEvalOutputAPI(CpuEvalOutput *implementation,
+CpuEvalOutputAPI::CpuEvalOutputAPI(EvalOutput *implementation,
                                    OpenSubdiv::Far::PatchMap *patch_map)
     : implementation_(implementation), patch_map_(patch_map)
 {
@@ -748,7 +815,7 @@ OpenSubdiv_EvaluatorImpl::~OpenSubdiv_EvaluatorImpl()
 }
 
 OpenSubdiv_EvaluatorImpl *openSubdiv_createEvaluatorInternal(
-    OpenSubdiv_TopologyRefiner *topology_refiner)
+    OpenSubdiv_TopologyRefiner *topology_refiner, eOpenSubdivEvaluator evaluator_type)
 {
   using blender::opensubdiv::vector;
   TopologyRefiner *refiner = topology_refiner->impl->topology_refiner;
@@ -852,9 +919,18 @@ OpenSubdiv_EvaluatorImpl *openSubdiv_createEvaluatorInternal(
     }
   }
   // Create OpenSubdiv's CPU side evaluator.
-  // TODO(sergey): Make it possible to use different evaluators.
-  blender::opensubdiv::CpuEvalOutput *eval_output = new blender::opensubdiv::CpuEvalOutput(
-      vertex_stencils, varying_stencils, all_face_varying_stencils, 2, patch_table);
+  blender::opensubdiv::EvalOutput *eval_output = NULL;
+  if (evaluator_type == OPENSUBDIV_EVALUATOR_TBB) {
+#ifdef OPENSUBDIV_HAS_TBB
+    eval_output = new blender::opensubdiv::TbbEvalOutput(
+        vertex_stencils, varying_stencils, all_face_varying_stencils, 2, patch_table);
+#endif
+  }
+  // Fall back to the single threaded evaluator.
+  if (eval_output == NULL) {
+    eval_output = new blender::opensubdiv::CpuEvalOutput(
+        vertex_stencils, varying_stencils, all_face_varying_stencils, 2, patch_table);
+  }
   OpenSubdiv::Far::PatchMap *patch_map = new PatchMap(*patch_table);
   // Wrap everything we need into an object which we control from our side.
   OpenSubdiv_EvaluatorImpl *evaluator_descr;
@@ -27,6 +27,7 @@
 #include <opensubdiv/far/patchTable.h>
 
 #include "internal/base/memory.h"
+#include "opensubdiv_capi_type.h"
 
 struct OpenSubdiv_PatchCoord;
 struct OpenSubdiv_TopologyRefiner;
@@ -35,7 +36,7 @@ namespace blender {
 namespace opensubdiv {
 
 // Anonymous forward declaration of actual evaluator implementation.
-class CpuEvalOutput;
+class EvalOutput;
 
 // Wrapper around implementaiton, which defines API which we are capable to
 // provide over the implementation.
@@ -46,7 +47,7 @@ class CpuEvalOutput;
 class CpuEvalOutputAPI {
  public:
   // NOTE: API object becomes an owner of evaluator. Patch we are referencing.
-  CpuEvalOutputAPI(CpuEvalOutput *implementation, OpenSubdiv::Far::PatchMap *patch_map);
+  CpuEvalOutputAPI(EvalOutput *implementation, OpenSubdiv::Far::PatchMap *patch_map);
   ~CpuEvalOutputAPI();
 
   // Set coarse positions from a continuous array of coordinates.
@@ -131,7 +132,7 @@ class CpuEvalOutputAPI {
                             float *dPdv);
 
  protected:
-  CpuEvalOutput *implementation_;
+  EvalOutput *implementation_;
   OpenSubdiv::Far::PatchMap *patch_map_;
 };
 
@@ -151,7 +152,7 @@ struct OpenSubdiv_EvaluatorImpl {
 };
 
 OpenSubdiv_EvaluatorImpl *openSubdiv_createEvaluatorInternal(
-    struct OpenSubdiv_TopologyRefiner *topology_refiner);
+    struct OpenSubdiv_TopologyRefiner *topology_refiner, eOpenSubdivEvaluator evaluator_type);
 
 void openSubdiv_deleteEvaluatorInternal(OpenSubdiv_EvaluatorImpl *evaluator);
 
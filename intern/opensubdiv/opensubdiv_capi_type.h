@@ -32,6 +32,7 @@ typedef enum eOpenSubdivEvaluator {
   OPENSUBDIV_EVALUATOR_CUDA = (1 << 3),
   OPENSUBDIV_EVALUATOR_GLSL_TRANSFORM_FEEDBACK = (1 << 4),
   OPENSUBDIV_EVALUATOR_GLSL_COMPUTE = (1 << 5),
+  OPENSUBDIV_EVALUATOR_TBB = (1 << 6),
 } eOpenSubdivEvaluator;
 
 typedef enum OpenSubdiv_SchemeType {
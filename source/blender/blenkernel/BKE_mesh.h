@@ -52,6 +52,7 @@ struct MVert;
 struct Main;
 struct MemArena;
 struct Mesh;
+struct MeshElemMap;
 struct ModifierData;
 struct Object;
 struct Scene;
@@ -124,6 +125,7 @@ void BKE_mesh_eval_delete(struct Mesh *me_eval);
 /* Performs copy for use during evaluation,
  * optional referencing original arrays to reduce memory. */
 struct Mesh *BKE_mesh_copy_for_eval(struct Mesh *source, bool reference);
+void BKE_mesh_duplicate_borrowed_layers(struct Mesh *mesh);
 
 /* These functions construct a new Mesh,
  * contrary to BKE_mesh_from_nurbs which modifies ob itself. */
@@ -293,6 +295,16 @@ void BKE_mesh_calc_normals_poly(struct MVert *mverts,
                                 int numPolys,
                                 float (*r_polyNors)[3],
                                 const bool only_face_normals);
+void BKE_mesh_calc_normals_poly_ex(struct MVert *mverts,
+                                   float (*r_vertnors)[3],
+                                   int numVerts,
+                                   const struct MLoop *mloop,
+                                   const struct MPoly *mpolys,
+                                   int numLoops,
+                                   int numPolys,
+                                   float (*r_polyNors)[3],
+                                   const bool only_face_normals,
+                                   const struct MeshElemMap *vert_to_loop);
 void BKE_mesh_calc_normals(struct Mesh *me);
 void BKE_mesh_ensure_normals(struct Mesh *me);
 void BKE_mesh_ensure_normals_for_display(struct Mesh *mesh);
@@ -414,6 +426,27 @@ void BKE_mesh_normals_loop_split(const struct MVert *mverts,
                                  short (*clnors_data)[2],
                                  int *r_loop_to_poly);
 
+/** Smooth fans cached between evaluations, see #BKE_mesh_normals_loop_split_ex. */
+typedef struct MeshSmoothFans MeshSmoothFans;
+
+void BKE_mesh_normals_loop_split_ex(const struct MVert *mverts,
+                                    const int numVerts,
+                                    struct MEdge *medges,
+                                    const int numEdges,
+                                    struct MLoop *mloops,
+                                    float (*r_loopnors)[3],
+                                    const int numLoops,
+                                    struct MPoly *mpolys,
+                                    const float (*polynors)[3],
+                                    const int numPolys,
+                                    const bool use_split_normals,
+                                    const float split_angle,
+                                    MLoopNorSpaceArray *r_lnors_spacearr,
+                                    short (*clnors_data)[2],
+                                    int *r_loop_to_poly,
+                                    MeshSmoothFans **smooth_fans_cache);
+void BKE_mesh_smooth_fans_free(MeshSmoothFans *smooth_fans);
+
 void BKE_mesh_normals_loop_custom_set(const struct MVert *mverts,
                                       const int numVerts,
                                       struct MEdge *medges,
@@ -447,6 +480,7 @@ void BKE_mesh_normals_loop_to_vertex(const int numVerts,
 bool BKE_mesh_has_custom_loop_normals(struct Mesh *me);
 
 void BKE_mesh_calc_normals_split(struct Mesh *mesh);
+void BKE_mesh_calc_normals_split_cached(struct Mesh *mesh, struct Mesh *mesh_cache);
 void BKE_mesh_calc_normals_split_ex(struct Mesh *mesh,
                                     struct MLoopNorSpaceArray *r_lnors_spacearr);
 
@@ -34,8 +34,11 @@ struct CustomData;
 struct CustomData_MeshMasks;
 struct Depsgraph;
 struct KeyBlock;
+struct MDeformVert;
+struct MDeformWeight;
 struct MLoop;
 struct MLoopTri;
+struct MeshElemMap;
 struct MVertTri;
 struct Mesh;
 struct Object;
@@ -52,6 +55,45 @@ bool BKE_mesh_runtime_reset_edit_data(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_geometry(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_cache(struct Mesh *mesh);
 
+const struct MeshElemMap *BKE_mesh_runtime_vert_poly_map_ensure(struct Mesh *mesh);
+const struct MeshElemMap *BKE_mesh_runtime_vert_loop_map_ensure(struct Mesh *mesh);
+const struct MeshElemMap *BKE_mesh_runtime_vert_edge_map_ensure(struct Mesh *mesh);
+const struct MeshElemMap *BKE_mesh_runtime_edge_poly_map_ensure(struct Mesh *mesh);
+
+/**
+ * Vertex group weights of all vertices packed in a single array, which is faster to iterate over
+ * than #MDeformVert, where the weights of each vertex are a separate allocation.
+ *
+ * Only weights of groups with a bone are kept, along with the index of the bone instead of the
+ * group, so deforming doesn't need to look up the bone of every weight.
+ */
+typedef struct MeshDeformWeights {
+  struct MeshDeformWeights *next;
+
+  /** Bone index of each vertex group or -1, the weights are cached for each mapping. */
+  int *bone_from_defbase;
+  int defbase_len;
+  /** Group of #armature_weights, or -1. */
+  int armature_def_nr;
+
+  /** The weights of vertex `i` start at `weights[vert_offsets[i]]` and end before
+   * `weights[vert_offsets[i + 1]]`, in the same order as in #MDeformVert.dw. */
+  int *vert_offsets;
+  int *bone_indices;
+  float *weights;
+  /** Weight of each vertex in #armature_def_nr, NULL when there is no such group. */
+  float *armature_weights;
+
+  /** The layer the weights were copied from, used to detect changes of the layer. */
+  const struct MDeformVert *dvert;
+  int totvert;
+} MeshDeformWeights;
+
+const MeshDeformWeights *BKE_mesh_runtime_deform_weights_ensure(struct Mesh *mesh,
+                                                                const int *bone_from_defbase,
+                                                                const int defbase_len,
+                                                                const int armature_def_nr);
+
 void BKE_mesh_runtime_verttri_from_looptri(struct MVertTri *r_verttri,
                                            const struct MLoop *mloop,
                                            const struct MLoopTri *looptri,
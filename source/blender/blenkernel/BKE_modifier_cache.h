@@ -0,0 +1,77 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/** \file
+ * \ingroup bke
+ *
+ * Results of constructive modifiers of the mesh modifier stack, kept in the runtime of evaluated
+ * objects. When a modifier changes, evaluation starts from the cached result of the last
+ * modifier before it that didn't change.
+ */
+
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct CDMaskLink;
+struct CustomData_MeshMasks;
+struct Mesh;
+struct ModifierData;
+struct ModifierStackCache;
+struct Object;
+struct Scene;
+
+typedef struct ModifierCacheStats {
+  /** Modifier stack evaluations starting from a cached result. */
+  uint64_t hits;
+  /** Modifier stack evaluations without a usable cached result. */
+  uint64_t misses;
+  /** Modifiers that didn't need to be evaluated thanks to hits. */
+  uint64_t modifiers_skipped;
+  /** Results that weren't cached because it would exceed #UserDef.modifier_cache_limit. */
+  uint64_t over_limit;
+  /** Memory used by the cached results of all objects. */
+  size_t memory_used;
+} ModifierCacheStats;
+
+bool BKE_modifier_cache_is_enabled(void);
+
+struct ModifierStackCache *BKE_modifier_cache_eval_begin(
+    struct Object *ob,
+    const struct Scene *scene,
+    struct ModifierData *firstmd,
+    const struct CDMaskLink *datamasks,
+    const struct CustomData_MeshMasks *final_datamask,
+    const int required_mode,
+    const bool need_mapping);
+struct ModifierData *BKE_modifier_cache_eval_hit(struct ModifierStackCache *cache,
+                                                 const struct Mesh **r_mesh);
+void BKE_modifier_cache_eval_store(struct ModifierStackCache *cache,
+                                   const struct ModifierData *md,
+                                   struct Mesh **mesh);
+
+void BKE_modifier_cache_free(struct Object *ob);
+
+void BKE_modifier_cache_stats_get(ModifierCacheStats *r_stats);
+void BKE_modifier_cache_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
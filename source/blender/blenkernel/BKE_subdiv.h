@@ -55,6 +55,14 @@ typedef enum eSubdivFVarLinearInterpolation {
   SUBDIV_FVAR_LINEAR_INTERPOLATION_ALL,
 } eSubdivFVarLinearInterpolation;
 
+typedef enum eSubdivEvaluatorType {
+  /* Refinement and limit surface evaluation happen on the calling thread. */
+  SUBDIV_EVALUATOR_TYPE_CPU,
+  /* Refinement and batched limit surface evaluation are split across threads.
+   * Falls back to SUBDIV_EVALUATOR_TYPE_CPU when OpenSubdiv is built without TBB. */
+  SUBDIV_EVALUATOR_TYPE_THREADED,
+} eSubdivEvaluatorType;
+
 typedef struct SubdivSettings {
   /* Simple subdivision corresponds to "Simple" option in the interface. When its enabled the
    * subdivided mesh is not "smoothed": new vertices are added uniformly on the existing surface.
@@ -85,6 +93,9 @@ typedef struct SubdivSettings {
 
   eSubdivVtxBoundaryInterpolation vtx_boundary_interpolation;
   eSubdivFVarLinearInterpolation fvar_linear_interpolation;
+
+  /* OpenSubdiv evaluator used for the refinement of the control cage and limit surface queries. */
+  eSubdivEvaluatorType evaluator_type;
 } SubdivSettings;
 
 /* NOTE: Order of enumerators MUST match order of values in SubdivStats. */
@@ -204,6 +215,9 @@ void BKE_subdiv_exit(void);
 /* NOTE: uv_smooth is eSubsurfUVSmooth. */
 eSubdivFVarLinearInterpolation BKE_subdiv_fvar_interpolation_from_uv_smooth(int uv_smooth);
 
+/* Evaluator chosen in the user preferences (UserDef.opensubdiv_compute_type). */
+eSubdivEvaluatorType BKE_subdiv_evaluator_type_from_userdef(void);
+
 /* =============================== STATISTICS =============================== */
 
 void BKE_subdiv_stats_init(SubdivStats *stats);
@@ -59,6 +59,7 @@
 #include "BKE_mesh_tangent.h"
 #include "BKE_mesh_wrapper.h"
 #include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_multires.h"
 #include "BKE_object.h"
 #include "BKE_object_deform.h"
@@ -779,10 +780,32 @@ static void add_orco_mesh(Object *ob, BMEditMesh *em, Mesh *mesh, Mesh *mesh_orc
   }
 }
 
+/**
+ * Get the mesh to cache topology data used for the normals of \a mesh_final in.
+ *
+ * The mesh of the object is kept between evaluations unless its geometry changes. When the
+ * modifiers only deformed it, \a mesh_final references its topology, so the cached data is
+ * created once for all frames of an animation.
+ */
+static Mesh *mesh_calc_modifier_final_normals_cache_get(const Mesh *mesh_input,
+                                                        const Mesh *mesh_final)
+{
+  /* Original meshes can have their topology edited in place. */
+  if (!DEG_is_evaluated_id(&mesh_input->id)) {
+    return NULL;
+  }
+  if (mesh_final->mloop != mesh_input->mloop || mesh_final->medge != mesh_input->medge ||
+      mesh_final->mpoly != mesh_input->mpoly || mesh_final->totvert != mesh_input->totvert) {
+    return NULL;
+  }
+  return (Mesh *)mesh_input;
+}
+
 static void mesh_calc_modifier_final_normals(const Mesh *mesh_input,
                                              const CustomData_MeshMasks *final_datamask,
                                              const bool sculpt_dyntopo,
-                                             Mesh *mesh_final)
+                                             Mesh *mesh_final,
+                                             Mesh *mesh_cache)
 {
   /* Compute normals. */
   const bool do_loop_normals = ((mesh_input->flag & ME_AUTOSMOOTH) != 0 ||
@@ -813,7 +836,12 @@ static void mesh_calc_modifier_final_normals(const Mesh *mesh_input,
 
   if (do_loop_normals) {
     /* Compute loop normals (note: will compute poly and vert normals as well, if needed!) */
-    BKE_mesh_calc_normals_split(mesh_final);
+    if (mesh_cache) {
+      BKE_mesh_calc_normals_split_cached(mesh_final, mesh_cache);
+    }
+    else {
+      BKE_mesh_calc_normals_split(mesh_final);
+    }
     BKE_mesh_tessface_clear(mesh_final);
   }
 
@@ -954,8 +982,24 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
   /* Clear errors before evaluation. */
   BKE_modifiers_clear_errors(ob);
 
-  /* Apply all leading deform modifiers. */
-  if (useDeform) {
+  /* Results of modifiers that didn't change since the previous evaluation. */
+  struct ModifierStackCache *modifier_cache = NULL;
+  ModifierData *modifier_cache_md = NULL;
+  const Mesh *modifier_cache_mesh = NULL;
+  if (use_cache && useDeform > 0 && index == -1 && !sculpt_mode) {
+    modifier_cache = BKE_modifier_cache_eval_begin(
+        ob, scene, firstmd, datamasks, &final_datamask, required_mode, need_mapping);
+  }
+  else if (use_cache) {
+    BKE_modifier_cache_free(ob);
+  }
+  if (modifier_cache) {
+    modifier_cache_md = BKE_modifier_cache_eval_hit(modifier_cache, &modifier_cache_mesh);
+  }
+
+  /* Apply all leading deform modifiers. A cached result already includes them, they are only
+   * needed for the deformed mesh then. */
+  if (useDeform && (modifier_cache_md == NULL || r_deform)) {
     for (; md; md = md->next, md_datamask = md_datamask->next) {
       const ModifierTypeInfo *mti = BKE_modifier_get_info(md->type);
 
@@ -1011,6 +1055,22 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
   for (; md; md = md->next, md_datamask = md_datamask->next) {
     const ModifierTypeInfo *mti = BKE_modifier_get_info(md->type);
 
+    /* Continue from the cached result, skipping all modifiers up to it. */
+    if (modifier_cache_md) {
+      if (md == modifier_cache_md) {
+        if (mesh_final) {
+          BKE_id_free(NULL, mesh_final);
+        }
+        MEM_SAFE_FREE(deformed_verts);
+        mesh_final = BKE_mesh_copy_for_eval((Mesh *)modifier_cache_mesh, true);
+        mesh_final->runtime.deformed_only = false;
+        have_non_onlydeform_modifiers_appled = true;
+        isPrevDeform = false;
+        modifier_cache_md = NULL;
+      }
+      continue;
+    }
+
     if (!BKE_modifier_is_enabled(scene, md, required_mode)) {
       continue;
     }
@@ -1196,6 +1256,10 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
           MEM_freeN(deformed_verts);
           deformed_verts = NULL;
         }
+
+        if (modifier_cache) {
+          BKE_modifier_cache_eval_store(modifier_cache, md, &mesh_final);
+        }
       }
 
       /* create an orco mesh in parallel */
@@ -1332,7 +1396,9 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
 
   /* Compute normals. */
   if (is_own_mesh) {
-    mesh_calc_modifier_final_normals(mesh_input, &final_datamask, sculpt_dyntopo, mesh_final);
+    Mesh *mesh_cache = mesh_calc_modifier_final_normals_cache_get(mesh_input, mesh_final);
+    mesh_calc_modifier_final_normals(
+        mesh_input, &final_datamask, sculpt_dyntopo, mesh_final, mesh_cache);
   }
   else {
     Mesh_Runtime *runtime = &mesh_input->runtime;
@@ -1341,7 +1407,8 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
       BLI_mutex_lock(runtime->eval_mutex);
       if (runtime->mesh_eval == NULL) {
         mesh_final = BKE_mesh_copy_for_eval(mesh_input, true);
-        mesh_calc_modifier_final_normals(mesh_input, &final_datamask, sculpt_dyntopo, mesh_final);
+        mesh_calc_modifier_final_normals(
+            mesh_input, &final_datamask, sculpt_dyntopo, mesh_final, NULL);
         mesh_calc_finalize(mesh_input, mesh_final);
         runtime->mesh_eval = mesh_final;
       }
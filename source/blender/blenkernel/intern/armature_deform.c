@@ -50,11 +50,17 @@
 #include "BKE_deform.h"
 #include "BKE_editmesh.h"
 #include "BKE_lattice.h"
+#include "BKE_mesh_runtime.h"
 
 #include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_query.h"
 
 #include "CLG_log.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 static CLG_LogRef LOG = {"bke.armature_deform"};
 
 /* -------------------------------------------------------------------- */
@@ -229,6 +235,34 @@ static void pchan_bone_deform(bPoseChannel *pchan,
   (*contrib) += weight;
 }
 
+#ifdef __SSE2__
+/* Same as #add_weighted_dq_dq. */
+static void add_weighted_dq_dq_sse2(DualQuat *dqsum, const DualQuat *dq, float weight)
+{
+  /* Make sure we interpolate quats in the right direction. */
+  const float weight_signed = (dot_qtqt(dq->quat, dqsum->quat) < 0) ? -weight : weight;
+  const __m128 weight_r = _mm_set1_ps(weight_signed);
+
+  _mm_storeu_ps(
+      dqsum->quat,
+      _mm_add_ps(_mm_loadu_ps(dqsum->quat), _mm_mul_ps(_mm_loadu_ps(dq->quat), weight_r)));
+  _mm_storeu_ps(
+      dqsum->trans,
+      _mm_add_ps(_mm_loadu_ps(dqsum->trans), _mm_mul_ps(_mm_loadu_ps(dq->trans), weight_r)));
+
+  if (dq->scale_weight) {
+    /* No negative weights for scaling. */
+    const __m128 weight_scale_r = _mm_set1_ps(weight);
+    for (int i = 0; i < 4; i++) {
+      _mm_storeu_ps(dqsum->scale[i],
+                    _mm_add_ps(_mm_loadu_ps(dqsum->scale[i]),
+                               _mm_mul_ps(_mm_loadu_ps(dq->scale[i]), weight_scale_r)));
+    }
+    dqsum->scale_weight += weight;
+  }
+}
+#endif
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -255,6 +289,13 @@ typedef struct ArmatureUserdata {
   const MDeformVert *dverts;
   int dverts_len;
 
+  /** Packed weights of the target mesh, used instead of its #MDeformVert when set. */
+  const MeshDeformWeights *deform_weights;
+  /** Pose channels of the bone indices in #deform_weights. */
+  bPoseChannel **pchan_from_bone;
+  /** Bones without B-Bone segments or envelope multiplication, which use a SIMD code path. */
+  const bool *bone_is_simple;
+
   bPoseChannel **pchan_from_defbase;
   int defbase_len;
 
@@ -267,6 +308,104 @@ typedef struct ArmatureUserdata {
   } bmesh;
 } ArmatureUserdata;
 
+static float armature_vert_deform_envelopes(const ArmatureUserdata *data,
+                                            float vec[3],
+                                            DualQuat *dq,
+                                            float mat[3][3],
+                                            const float co[3])
+{
+  float contrib = 0.0f;
+  for (bPoseChannel *pchan = data->ob_arm->pose->chanbase.first; pchan; pchan = pchan->next) {
+    if (!(pchan->bone->flag & BONE_NO_DEFORM)) {
+      contrib += dist_bone_deform(pchan, vec, dq, mat, co);
+    }
+  }
+  return contrib;
+}
+
+/**
+ * Deform by the packed weights of vertex \a i.
+ * \return False when the vertex isn't in any group of a bone.
+ */
+static bool armature_vert_deform_packed(const ArmatureUserdata *data,
+                                        const int i,
+                                        float vec[3],
+                                        DualQuat *dq,
+                                        float mat[3][3],
+                                        const float co[3],
+                                        float *contrib)
+{
+  const MeshDeformWeights *deform_weights = data->deform_weights;
+  const int weights_start = deform_weights->vert_offsets[i];
+  const int weights_end = deform_weights->vert_offsets[i + 1];
+  if (weights_start == weights_end) {
+    return false;
+  }
+
+#ifdef __SSE2__
+  /* Linear blending sums the weighted matrices of simple bones, applied to the coordinate once.
+   * Dual quaternions are added directly, the sign of each depends on the sum so far. */
+  __m128 summat_r[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+  float summat_weight = 0.0f;
+#endif
+
+  for (int j = weights_start; j < weights_end; j++) {
+    const int bone_index = deform_weights->bone_indices[j];
+    bPoseChannel *pchan = data->pchan_from_bone[bone_index];
+    float weight = deform_weights->weights[j];
+
+#ifdef __SSE2__
+    if (data->bone_is_simple[bone_index]) {
+      if (weight == 0.0f) {
+        continue;
+      }
+      if (dq) {
+        add_weighted_dq_dq_sse2(dq, &pchan->runtime.deform_dual_quat, weight);
+      }
+      else {
+        const __m128 weight_r = _mm_set1_ps(weight);
+        for (int k = 0; k < 4; k++) {
+          summat_r[k] = _mm_add_ps(summat_r[k],
+                                   _mm_mul_ps(_mm_loadu_ps(pchan->chan_mat[k]), weight_r));
+        }
+        summat_weight += weight;
+      }
+      *contrib += weight;
+      continue;
+    }
+#endif
+
+    Bone *bone = pchan->bone;
+    if (bone->flag & BONE_MULT_VG_ENV) {
+      weight *= distfactor_to_bone(
+          co, bone->arm_head, bone->arm_tail, bone->rad_head, bone->rad_tail, bone->dist);
+    }
+    pchan_bone_deform(pchan, weight, vec, dq, mat, co, contrib);
+  }
+
+#ifdef __SSE2__
+  if (summat_weight != 0.0f) {
+    float tmp[4];
+    __m128 co_r = _mm_add_ps(_mm_mul_ps(summat_r[0], _mm_set1_ps(co[0])),
+                             _mm_mul_ps(summat_r[1], _mm_set1_ps(co[1])));
+    co_r = _mm_add_ps(co_r, _mm_mul_ps(summat_r[2], _mm_set1_ps(co[2])));
+    co_r = _mm_add_ps(co_r, summat_r[3]);
+    _mm_storeu_ps(tmp, co_r);
+    madd_v3_v3fl(tmp, co, -summat_weight);
+    add_v3_v3(vec, tmp);
+
+    if (mat) {
+      for (int k = 0; k < 3; k++) {
+        _mm_storeu_ps(tmp, summat_r[k]);
+        add_v3_v3(mat[k], tmp);
+      }
+    }
+  }
+#endif
+
+  return true;
+}
+
 static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
                                           const int i,
                                           const MDeformVert *dvert)
@@ -302,8 +441,9 @@ static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
     }
   }
 
-  if (armature_def_nr != -1 && dvert) {
-    armature_weight = BKE_defvert_find_weight(dvert, armature_def_nr);
+  if (armature_def_nr != -1 && (dvert || data->deform_weights)) {
+    armature_weight = data->deform_weights ? data->deform_weights->armature_weights[i] :
+                                             BKE_defvert_find_weight(dvert, armature_def_nr);
 
     if (data->invert_vgroup) {
       armature_weight = 1.0f - armature_weight;
@@ -327,7 +467,12 @@ static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
   /* Apply the object's matrix */
   mul_m4_v3(data->premat, co);
 
-  if (use_dverts && dvert && dvert->totweight) { /* use weight groups ? */
+  if (use_dverts && data->deform_weights) {
+    if (!armature_vert_deform_packed(data, i, vec, dq, smat, co, &contrib) && use_envelope) {
+      contrib += armature_vert_deform_envelopes(data, vec, dq, smat, co);
+    }
+  }
+  else if (use_dverts && dvert && dvert->totweight) { /* use weight groups ? */
     const MDeformWeight *dw = dvert->dw;
     int deformed = 0;
     unsigned int j;
@@ -349,19 +494,11 @@ static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
     }
     /* If there are vertex-groups but not groups with bones (like for soft-body groups). */
     if (deformed == 0 && use_envelope) {
-      for (pchan = data->ob_arm->pose->chanbase.first; pchan; pchan = pchan->next) {
-        if (!(pchan->bone->flag & BONE_NO_DEFORM)) {
-          contrib += dist_bone_deform(pchan, vec, dq, smat, co);
-        }
-      }
+      contrib += armature_vert_deform_envelopes(data, vec, dq, smat, co);
     }
   }
   else if (use_envelope) {
-    for (pchan = data->ob_arm->pose->chanbase.first; pchan; pchan = pchan->next) {
-      if (!(pchan->bone->flag & BONE_NO_DEFORM)) {
-        contrib += dist_bone_deform(pchan, vec, dq, smat, co);
-      }
-    }
+    contrib += armature_vert_deform_envelopes(data, vec, dq, smat, co);
   }
 
   /* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
@@ -421,7 +558,11 @@ static void armature_vert_task(void *__restrict userdata,
   const ArmatureUserdata *data = userdata;
   const MDeformVert *dvert;
   if (data->use_dverts || data->armature_def_nr != -1) {
-    if (data->me_target) {
+    if (data->deform_weights) {
+      /* The packed weights are used instead. */
+      dvert = NULL;
+    }
+    else if (data->me_target) {
       BLI_assert(i < data->me_target->totvert);
       if (data->me_target->dvert != NULL) {
         dvert = data->me_target->dvert + i;
@@ -459,6 +600,35 @@ static void armature_vert_task_editmesh_no_dvert(void *__restrict userdata, Memp
   armature_vert_task_with_dvert(data, BM_elem_index_get(v), NULL);
 }
 
+/**
+ * Get the packed weights of the mesh to deform, when they can be cached in the evaluated mesh.
+ *
+ * The mesh of the object is kept between evaluations unless its geometry changes, so the packed
+ * weights are created once for all frames of an animation. The modifier stack may pass a copy of
+ * that mesh, which references its weights.
+ */
+static const MeshDeformWeights *armature_deform_weights_get(const Object *ob_target,
+                                                            const Mesh *me_target,
+                                                            const int vert_coords_len,
+                                                            const int *bone_from_defbase,
+                                                            const int defbase_len,
+                                                            const int armature_def_nr)
+{
+  Mesh *me_object = ob_target->data;
+  Mesh *mesh = (me_target == NULL || me_target->dvert == me_object->dvert) ? me_object :
+                                                                              (Mesh *)me_target;
+  /* Original meshes can have their weights edited in place. */
+  if (mesh->dvert == NULL || !DEG_is_evaluated_id(&mesh->id)) {
+    return NULL;
+  }
+  if ((me_target != NULL && me_target->totvert != mesh->totvert) ||
+      vert_coords_len > mesh->totvert) {
+    return NULL;
+  }
+  return BKE_mesh_runtime_deform_weights_ensure(
+      mesh, bone_from_defbase, defbase_len, armature_def_nr);
+}
+
 static void armature_deform_coords_impl(const Object *ob_arm,
                                         const Object *ob_target,
                                         float (*vert_coords)[3],
@@ -560,6 +730,40 @@ static void armature_deform_coords_impl(const Object *ob_arm,
     }
   }
 
+  /* Deforming bones are numbered in the order of their vertex groups, for the packed weights. */
+  int *bone_from_defbase = NULL;
+  bPoseChannel **pchan_from_bone = NULL;
+  bool *bone_is_simple = NULL;
+  const MeshDeformWeights *deform_weights = NULL;
+  if (ob_target->type == OB_MESH && em_target == NULL && (use_dverts || armature_def_nr != -1)) {
+    int bones_len = 0;
+    if (use_dverts) {
+      bone_from_defbase = MEM_malloc_arrayN(defbase_len, sizeof(*bone_from_defbase), __func__);
+      pchan_from_bone = MEM_malloc_arrayN(defbase_len, sizeof(*pchan_from_bone), __func__);
+      bone_is_simple = MEM_malloc_arrayN(defbase_len, sizeof(*bone_is_simple), __func__);
+      for (i = 0; i < defbase_len; i++) {
+        bPoseChannel *pchan = pchan_from_defbase[i];
+        if (pchan == NULL) {
+          bone_from_defbase[i] = -1;
+          continue;
+        }
+        const Bone *bone = pchan->bone;
+        const bool is_bbone = bone->segments > 1 &&
+                              pchan->runtime.bbone_segments == bone->segments;
+        bone_from_defbase[i] = bones_len;
+        pchan_from_bone[bones_len] = pchan;
+        bone_is_simple[bones_len] = !is_bbone && !(bone->flag & BONE_MULT_VG_ENV);
+        bones_len++;
+      }
+    }
+    deform_weights = armature_deform_weights_get(ob_target,
+                                                 me_target,
+                                                 vert_coords_len,
+                                                 bone_from_defbase,
+                                                 use_dverts ? defbase_len : 0,
+                                                 armature_def_nr);
+  }
+
   ArmatureUserdata data = {
       .ob_arm = ob_arm,
       .ob_target = ob_target,
@@ -574,6 +778,9 @@ static void armature_deform_coords_impl(const Object *ob_arm,
       .armature_def_nr = armature_def_nr,
       .dverts = dverts,
       .dverts_len = dverts_len,
+      .deform_weights = deform_weights,
+      .pchan_from_bone = pchan_from_bone,
+      .bone_is_simple = bone_is_simple,
       .pchan_from_defbase = pchan_from_defbase,
       .defbase_len = defbase_len,
       .bmesh =
@@ -611,6 +818,9 @@ static void armature_deform_coords_impl(const Object *ob_arm,
   if (pchan_from_defbase) {
     MEM_freeN(pchan_from_defbase);
   }
+  MEM_SAFE_FREE(bone_from_defbase);
+  MEM_SAFE_FREE(pchan_from_bone);
+  MEM_SAFE_FREE(bone_is_simple);
 }
 
 void BKE_armature_deform_coords_with_gpencil_stroke(const Object *ob_arm,
@@ -17,11 +17,26 @@
  * All rights reserved.
  */
 
+#include "testing/testing.h"
+
 #include "BKE_armature.h"
+#include "BKE_customdata.h"
+#include "BKE_deform.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
 
+#include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_rand.hh"
+#include "BLI_string.h"
+#include "BLI_threads.h"
 
-#include "testing/testing.h"
+#include "DNA_action_types.h"
+#include "DNA_armature_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
 
 namespace blender::bke::tests {
 
@@ -90,4 +105,196 @@ TEST(mat3_vec_to_roll, Rotationmatrix)
   }
 }
 
+/* Deforming an evaluated mesh uses packed weights, with SIMD where available. Original meshes
+ * use their #MDeformVert with the scalar code, which must give the same result. */
+class ArmatureDeformTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+    BKE_idtype_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BLI_threadapi_exit();
+  }
+
+ protected:
+  static const int BONES_NUM = 3;
+  static const int VERTS_NUM = 256;
+
+  bArmature arm;
+  bPose pose;
+  Bone bones[BONES_NUM];
+  bPoseChannel pchans[BONES_NUM];
+  Object ob_arm;
+
+  /* Groups of bones, a group without a bone and a group scaling the whole deformation. */
+  bDeformGroup groups[BONES_NUM + 2];
+  Object ob_target;
+  Mesh *mesh_orig;
+  Mesh *mesh_eval;
+
+  float coords_orig[VERTS_NUM][3];
+
+  void SetUp() override
+  {
+    memset(&arm, 0, sizeof(arm));
+    memset(&pose, 0, sizeof(pose));
+    memset(bones, 0, sizeof(bones));
+    memset(pchans, 0, sizeof(pchans));
+    memset(&ob_arm, 0, sizeof(ob_arm));
+    memset(groups, 0, sizeof(groups));
+    memset(&ob_target, 0, sizeof(ob_target));
+
+    for (int i = 0; i < BONES_NUM; i++) {
+      Bone *bone = &bones[i];
+      bPoseChannel *pchan = &pchans[i];
+      BLI_snprintf(bone->name, sizeof(bone->name), "Bone%d", i);
+      BLI_strncpy(pchan->name, bone->name, sizeof(pchan->name));
+      unit_m4(bone->arm_mat);
+      copy_v3_fl3(bone->arm_head, i, 0.0f, 0.0f);
+      copy_v3_fl3(bone->arm_tail, i, 1.0f, 0.0f);
+      bone->rad_head = bone->rad_tail = 0.5f;
+      bone->dist = 1.0f;
+      bone->weight = 1.0f;
+      bone->length = 1.0f;
+      bone->segments = 1;
+
+      float rot[3] = {0.3f * i, 0.2f, -0.5f * i};
+      float loc[3] = {0.1f, -0.2f * i, 0.5f};
+      float size[3] = {1.0f, 1.0f, 1.0f};
+      if (i == 1) {
+        /* Scale, which dual quaternions handle separately. */
+        copy_v3_fl3(size, 1.5f, 0.8f, 1.2f);
+      }
+      loc_eul_size_to_mat4(pchan->chan_mat, loc, rot, size);
+      mat4_to_dquat(&pchan->runtime.deform_dual_quat, bone->arm_mat, pchan->chan_mat);
+      pchan->bone = bone;
+      BLI_addtail(&pose.chanbase, pchan);
+    }
+    /* Uses the scalar code with packed weights too. */
+    bones[2].flag |= BONE_MULT_VG_ENV;
+
+    ob_arm.type = OB_ARMATURE;
+    ob_arm.data = &arm;
+    ob_arm.pose = &pose;
+    unit_m4(ob_arm.obmat);
+
+    STRNCPY(groups[0].name, "Bone0");
+    STRNCPY(groups[1].name, "Other");
+    STRNCPY(groups[2].name, "Bone1");
+    STRNCPY(groups[3].name, "Bone2");
+    STRNCPY(groups[4].name, "Armature");
+    for (int i = 0; i < BONES_NUM + 2; i++) {
+      BLI_addtail(&ob_target.defbase, &groups[i]);
+    }
+
+    RandomNumberGenerator rng(1);
+    for (int i = 0; i < VERTS_NUM; i++) {
+      for (int j = 0; j < 3; j++) {
+        coords_orig[i][j] = rng.get_float() * 4.0f - 2.0f;
+      }
+    }
+    mesh_orig = mesh_create();
+    mesh_eval = mesh_create();
+    mesh_eval->id.tag |= LIB_TAG_COPIED_ON_WRITE;
+
+    ob_target.type = OB_MESH;
+    ob_target.data = mesh_orig;
+    unit_m4(ob_target.obmat);
+  }
+
+  void TearDown() override
+  {
+    BKE_id_free(nullptr, mesh_orig);
+    BKE_id_free(nullptr, mesh_eval);
+  }
+
+  /* The same weights every time. */
+  Mesh *mesh_create()
+  {
+    Mesh *mesh = BKE_mesh_new_nomain(VERTS_NUM, 0, 0, 0, 0);
+    MDeformVert *dvert = static_cast<MDeformVert *>(
+        CustomData_add_layer(&mesh->vdata, CD_MDEFORMVERT, CD_CALLOC, nullptr, VERTS_NUM));
+    BKE_mesh_update_customdata_pointers(mesh, false);
+
+    RandomNumberGenerator rng(2);
+    for (int i = 0; i < VERTS_NUM; i++) {
+      copy_v3_v3(mesh->mvert[i].co, coords_orig[i]);
+      /* Some vertices aren't in any group, or only in the group without a bone. */
+      for (int group = 0; group < BONES_NUM + 2; group++) {
+        if (rng.get_int32(3) != 0) {
+          BKE_defvert_add_index_notest(&dvert[i], group, rng.get_float());
+        }
+      }
+    }
+    return mesh;
+  }
+
+  void deform(const Mesh *me_target,
+              const int deformflag,
+              const char *defgrp_name,
+              float (*r_coords)[3],
+              float (*r_deform_mats)[3][3])
+  {
+    memcpy(r_coords, coords_orig, sizeof(coords_orig));
+    for (int i = 0; i < VERTS_NUM; i++) {
+      unit_m3(r_deform_mats[i]);
+    }
+    BKE_armature_deform_coords_with_mesh(&ob_arm,
+                                         &ob_target,
+                                         r_coords,
+                                         r_deform_mats,
+                                         VERTS_NUM,
+                                         deformflag,
+                                         nullptr,
+                                         defgrp_name,
+                                         me_target);
+  }
+
+  void expect_packed_matches_scalar(const int deformflag, const char *defgrp_name)
+  {
+    float coords_scalar[VERTS_NUM][3], coords_packed[VERTS_NUM][3];
+    float deform_mats_scalar[VERTS_NUM][3][3], deform_mats_packed[VERTS_NUM][3][3];
+    deform(mesh_orig, deformflag, defgrp_name, coords_scalar, deform_mats_scalar);
+    EXPECT_EQ(mesh_orig->runtime.deform_weights, nullptr);
+    deform(mesh_eval, deformflag, defgrp_name, coords_packed, deform_mats_packed);
+    EXPECT_NE(mesh_eval->runtime.deform_weights, nullptr);
+
+    int num_deformed = 0;
+    for (int i = 0; i < VERTS_NUM; i++) {
+      EXPECT_V3_NEAR(coords_packed[i], coords_scalar[i], 1e-5f);
+      for (int j = 0; j < 3; j++) {
+        EXPECT_V3_NEAR(deform_mats_packed[i][j], deform_mats_scalar[i][j], 1e-5f);
+      }
+      num_deformed += !equals_v3v3(coords_scalar[i], coords_orig[i]);
+    }
+    EXPECT_GT(num_deformed, VERTS_NUM / 2);
+  }
+};
+
+TEST_F(ArmatureDeformTest, PackedLinear)
+{
+  expect_packed_matches_scalar(ARM_DEF_VGROUP, "");
+}
+
+TEST_F(ArmatureDeformTest, PackedDualQuaternion)
+{
+  expect_packed_matches_scalar(ARM_DEF_VGROUP | ARM_DEF_QUATERNION, "");
+}
+
+TEST_F(ArmatureDeformTest, PackedEnvelopeFallback)
+{
+  expect_packed_matches_scalar(ARM_DEF_VGROUP | ARM_DEF_ENVELOPE, "");
+}
+
+TEST_F(ArmatureDeformTest, PackedArmatureGroup)
+{
+  expect_packed_matches_scalar(ARM_DEF_VGROUP, "Armature");
+  expect_packed_matches_scalar(ARM_DEF_VGROUP | ARM_DEF_QUATERNION | ARM_DEF_INVERT_VGROUP,
+                               "Armature");
+}
+
 }  // namespace blender::bke::tests
@@ -26,6 +26,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 /* Since we have versioning code here (CustomData_verify_versions()). */
 #define DNA_DEPRECATED_ALLOW
 
@@ -2170,6 +2172,62 @@ static bool customdata_typemap_is_valid(const CustomData *data)
 }
 #endif
 
+/* -------------------------------------------------------------------- */
+/** \name Implicit Sharing
+ *
+ * Referencing the data of a layer (#CD_REFERENCE) shares its ownership, the data is freed once
+ * all layers using it are freed. Layers referencing the data are flagged with #CD_FLAG_NOFREE and
+ * have to be duplicated before writing to them, which only copies the data when it's still used
+ * by other layers. Layers referencing data that isn't owned by a layer (added with
+ * #CD_REFERENCE) don't share it, that data has to outlive them.
+ * \{ */
+
+typedef struct CustomDataLayerSharing {
+  /** Number of layers using the data. */
+  int32_t users;
+} CustomDataLayerSharing;
+
+static CustomDataLayerSharing *customData_layer_share(CustomDataLayer *layer)
+{
+  CustomDataLayerSharing *sharing = layer->sharing_info;
+  if (sharing == NULL) {
+    CustomDataLayerSharing *sharing_new = MEM_mallocN(sizeof(*sharing_new), __func__);
+    sharing_new->users = 1;
+    /* The same layer may be referenced from multiple threads. */
+    sharing = atomic_cas_ptr((void **)&layer->sharing_info, NULL, sharing_new);
+    if (sharing == NULL) {
+      sharing = sharing_new;
+    }
+    else {
+      MEM_freeN(sharing_new);
+    }
+  }
+  atomic_add_and_fetch_int32(&sharing->users, 1);
+  return sharing;
+}
+
+/**
+ * Stop sharing the data of the layer.
+ * \return True when the layer was the last user, the data is then owned by the layer again.
+ */
+static bool customData_layer_sharing_release(CustomDataLayer *layer)
+{
+  CustomDataLayerSharing *sharing = layer->sharing_info;
+  layer->sharing_info = NULL;
+  if (atomic_sub_and_fetch_int32(&sharing->users, 1) == 0) {
+    MEM_freeN(sharing);
+    return true;
+  }
+  return false;
+}
+
+static bool customData_layer_sharing_is_mutable(const CustomDataLayer *layer)
+{
+  return layer->sharing_info == NULL || layer->sharing_info->users == 1;
+}
+
+/** \} */
+
 bool CustomData_merge(const struct CustomData *source,
                       struct CustomData *dest,
                       CustomDataMask mask,
@@ -2236,6 +2294,16 @@ bool CustomData_merge(const struct CustomData *source,
       newlayer = customData_add_layer__internal(dest, type, alloctype, data, totelem, layer->name);
     }
 
+    if (newlayer && data) {
+      if (alloctype == CD_ASSIGN) {
+        /* The data moves to the new layer, along with the users sharing it. */
+        newlayer->sharing_info = layer->sharing_info;
+      }
+      else if (alloctype == CD_REFERENCE && (layer->sharing_info || !(flag & CD_FLAG_NOFREE))) {
+        newlayer->sharing_info = customData_layer_share(layer);
+      }
+    }
+
     if (newlayer) {
       newlayer->uid = layer->uid;
 
@@ -2263,6 +2331,22 @@ void CustomData_realloc(CustomData *data, int totelem)
       continue;
     }
     typeInfo = layerType_getInfo(layer->type);
+    if (layer->sharing_info) {
+      /* Other layers keep using the shared data. */
+      if (!customData_layer_sharing_release(layer)) {
+        const size_t totelem_old = MEM_allocN_len(layer->data) / typeInfo->size;
+        const size_t totelem_copy = MIN2(totelem_old, (size_t)totelem);
+        void *data_new = MEM_calloc_arrayN((size_t)totelem, typeInfo->size, __func__);
+        if (typeInfo->copy) {
+          typeInfo->copy(layer->data, data_new, (int)totelem_copy);
+        }
+        else {
+          memcpy(data_new, layer->data, totelem_copy * typeInfo->size);
+        }
+        layer->data = data_new;
+        continue;
+      }
+    }
     layer->data = MEM_reallocN(layer->data, (size_t)totelem * typeInfo->size);
   }
 }
@@ -2286,6 +2370,13 @@ static void customData_free_layer__internal(CustomDataLayer *layer, int totelem)
 {
   const LayerTypeInfo *typeInfo;
 
+  if (layer->sharing_info) {
+    if (!customData_layer_sharing_release(layer)) {
+      return;
+    }
+    layer->flag &= ~CD_FLAG_NOFREE;
+  }
+
   if (!(layer->flag & CD_FLAG_NOFREE) && layer->data) {
     typeInfo = layerType_getInfo(layer->type);
 
@@ -2686,6 +2777,7 @@ static CustomDataLayer *customData_add_layer__internal(CustomData *data,
   data->layers[index].type = type;
   data->layers[index].flag = flag;
   data->layers[index].data = newlayerdata;
+  data->layers[index].sharing_info = NULL;
 
   /* Set default name if none exists. Note we only call DATA_()  once
    * we know there is a default name, to avoid overhead of locale lookups
@@ -2871,21 +2963,35 @@ static void *customData_duplicate_referenced_layer_index(CustomData *data,
 
   layer = &data->layers[layer_index];
 
-  if (layer->flag & CD_FLAG_NOFREE) {
+  if (layer->sharing_info && customData_layer_sharing_is_mutable(layer)) {
+    /* All other users are gone, take back ownership without copying. */
+    customData_layer_sharing_release(layer);
+    layer->flag &= ~CD_FLAG_NOFREE;
+  }
+  else if ((layer->flag & CD_FLAG_NOFREE) || layer->sharing_info) {
     /* MEM_dupallocN won't work in case of complex layers, like e.g.
      * CD_MDEFORMVERT, which has pointers to allocated data...
      * So in case a custom copy function is defined, use it!
      */
     const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
+    void *src_data = layer->data;
 
     if (typeInfo->copy) {
       void *dst_data = MEM_malloc_arrayN(
           (size_t)totelem, typeInfo->size, "CD duplicate ref layer");
-      typeInfo->copy(layer->data, dst_data, totelem);
+      typeInfo->copy(src_data, dst_data, totelem);
       layer->data = dst_data;
     }
     else {
-      layer->data = MEM_dupallocN(layer->data);
+      layer->data = MEM_dupallocN(src_data);
+    }
+
+    /* Other users may have been freed meanwhile, then the shared data has to be freed here. */
+    if (layer->sharing_info && customData_layer_sharing_release(layer)) {
+      CustomDataLayer src_layer = *layer;
+      src_layer.data = src_data;
+      src_layer.flag &= ~CD_FLAG_NOFREE;
+      customData_free_layer__internal(&src_layer, totelem);
     }
 
     layer->flag &= ~CD_FLAG_NOFREE;
@@ -2930,6 +3036,20 @@ void *CustomData_duplicate_referenced_layer_named(CustomData *data,
   return customData_duplicate_referenced_layer_index(data, layer_index, totelem);
 }
 
+/**
+ * Duplicate referenced layers that don't share the ownership of their data, so all layers stay
+ * valid as long as \a data, whatever happens to the data they were copied from.
+ */
+void CustomData_duplicate_borrowed_layers(CustomData *data, const int totelem)
+{
+  for (int i = 0; i < data->totlayer; i++) {
+    CustomDataLayer *layer = &data->layers[i];
+    if ((layer->flag & CD_FLAG_NOFREE) && layer->sharing_info == NULL) {
+      customData_duplicate_referenced_layer_index(data, i, totelem);
+    }
+  }
+}
+
 bool CustomData_is_referenced_layer(struct CustomData *data, int type)
 {
   CustomDataLayer *layer;
@@ -3368,6 +3488,29 @@ const char *CustomData_get_layer_name(const CustomData *data, int type, int n)
   return (layer_index == -1) ? NULL : data->layers[layer_index].name;
 }
 
+/**
+ * The previous data is the callers responsibility, unless it's still used by other layers.
+ * A referencing layer that was the last user of shared data frees it, the caller doesn't own it.
+ */
+static void customData_set_layer_data(CustomDataLayer *layer, void *ptr)
+{
+  if (layer->sharing_info && customData_layer_sharing_release(layer) &&
+      (layer->flag & CD_FLAG_NOFREE)) {
+    if (layer->data == ptr) {
+      /* Setting the same data again, keep it as owned by the layer. */
+      layer->flag &= ~CD_FLAG_NOFREE;
+    }
+    else {
+      const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
+      CustomDataLayer src_layer = *layer;
+      src_layer.flag &= ~CD_FLAG_NOFREE;
+      customData_free_layer__internal(&src_layer,
+                                      (int)(MEM_allocN_len(layer->data) / typeInfo->size));
+    }
+  }
+  layer->data = ptr;
+}
+
 void *CustomData_set_layer(const CustomData *data, int type, void *ptr)
 {
   /* get the layer index of the first layer of type */
@@ -3377,7 +3520,7 @@ void *CustomData_set_layer(const CustomData *data, int type, void *ptr)
     return NULL;
   }
 
-  data->layers[layer_index].data = ptr;
+  customData_set_layer_data(&data->layers[layer_index], ptr);
 
   return ptr;
 }
@@ -3390,7 +3533,7 @@ void *CustomData_set_layer_n(const struct CustomData *data, int type, int n, voi
     return NULL;
   }
 
-  data->layers[layer_index].data = ptr;
+  customData_set_layer_data(&data->layers[layer_index], ptr);
 
   return ptr;
 }
@@ -5324,6 +5467,7 @@ void CustomData_blend_read(BlendDataReader *reader, CustomData *data, int count)
     }
 
     layer->flag &= ~CD_FLAG_NOFREE;
+    layer->sharing_info = NULL;
 
     if (CustomData_verify_versions(data, i)) {
       BLO_read_data_address(reader, &layer->data);
@@ -0,0 +1,103 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_customdata_types.h"
+
+#include "BKE_customdata.h"
+
+namespace blender::bke::tests {
+
+static const int ELEM_NUM = 16;
+
+static float *add_float_layer(CustomData *data)
+{
+  CustomData_reset(data);
+  float *values = static_cast<float *>(
+      CustomData_add_layer(data, CD_PROP_FLOAT, CD_CALLOC, nullptr, ELEM_NUM));
+  for (int i = 0; i < ELEM_NUM; i++) {
+    values[i] = static_cast<float>(i);
+  }
+  return values;
+}
+
+TEST(customdata, ReferenceOutlivesSource)
+{
+  CustomData source, dest;
+  const float *values = add_float_layer(&source);
+  CustomData_copy(&source, &dest, CD_MASK_PROP_FLOAT, CD_REFERENCE, ELEM_NUM);
+  EXPECT_EQ(CustomData_get_layer(&dest, CD_PROP_FLOAT), values);
+  EXPECT_TRUE(CustomData_is_referenced_layer(&dest, CD_PROP_FLOAT));
+
+  /* The shared data is kept alive by the reference. */
+  CustomData_free(&source, ELEM_NUM);
+  EXPECT_EQ(values[ELEM_NUM - 1], static_cast<float>(ELEM_NUM - 1));
+
+  /* The last user takes ownership without a copy. */
+  EXPECT_EQ(CustomData_duplicate_referenced_layer(&dest, CD_PROP_FLOAT, ELEM_NUM), values);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&dest, CD_PROP_FLOAT));
+  CustomData_free(&dest, ELEM_NUM);
+}
+
+TEST(customdata, CopyOnWrite)
+{
+  CustomData source, dest_a, dest_b;
+  const float *values = add_float_layer(&source);
+  CustomData_copy(&source, &dest_a, CD_MASK_PROP_FLOAT, CD_REFERENCE, ELEM_NUM);
+  CustomData_copy(&dest_a, &dest_b, CD_MASK_PROP_FLOAT, CD_REFERENCE, ELEM_NUM);
+  EXPECT_EQ(CustomData_get_layer(&dest_b, CD_PROP_FLOAT), values);
+
+  /* Writing to a layer that is still shared copies it. */
+  float *values_a = static_cast<float *>(
+      CustomData_duplicate_referenced_layer(&dest_a, CD_PROP_FLOAT, ELEM_NUM));
+  EXPECT_NE(values_a, values);
+  values_a[0] = -1.0f;
+  EXPECT_EQ(values[0], 0.0f);
+  EXPECT_EQ(values_a[1], 1.0f);
+
+  CustomData_free(&source, ELEM_NUM);
+  CustomData_free(&dest_a, ELEM_NUM);
+  EXPECT_EQ(CustomData_duplicate_referenced_layer(&dest_b, CD_PROP_FLOAT, ELEM_NUM), values);
+  CustomData_free(&dest_b, ELEM_NUM);
+}
+
+TEST(customdata, SetLayerFreesLastReference)
+{
+  CustomData source, dest;
+  add_float_layer(&source);
+  CustomData_copy(&source, &dest, CD_MASK_PROP_FLOAT, CD_REFERENCE, ELEM_NUM);
+  CustomData_free(&source, ELEM_NUM);
+  float *values_new = static_cast<float *>(
+      MEM_calloc_arrayN(ELEM_NUM, sizeof(float), __func__));
+  const unsigned int blocks_in_use = MEM_get_memory_blocks_in_use();
+
+  /* The referencing layer was the last user, replacing its data frees the shared data along
+   * with its sharing info. */
+  CustomData_set_layer(&dest, CD_PROP_FLOAT, values_new);
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_in_use - 2);
+
+  CustomData_free(&dest, ELEM_NUM);
+  MEM_freeN(values_new);
+}
+
+TEST(customdata, DuplicateBorrowedLayers)
+{
+  float values[ELEM_NUM] = {0.0f};
+  CustomData borrowed, dest;
+  CustomData_reset(&borrowed);
+  CustomData_add_layer(&borrowed, CD_PROP_FLOAT, CD_REFERENCE, values, ELEM_NUM);
+  CustomData_copy(&borrowed, &dest, CD_MASK_PROP_FLOAT, CD_REFERENCE, ELEM_NUM);
+  EXPECT_EQ(CustomData_get_layer(&dest, CD_PROP_FLOAT), values);
+
+  /* Data not owned by a layer can't be shared, it's copied. */
+  CustomData_duplicate_borrowed_layers(&dest, ELEM_NUM);
+  EXPECT_NE(CustomData_get_layer(&dest, CD_PROP_FLOAT), values);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&dest, CD_PROP_FLOAT));
+
+  CustomData_free(&borrowed, ELEM_NUM);
+  CustomData_free(&dest, ELEM_NUM);
+}
+
+}  // namespace blender::bke::tests
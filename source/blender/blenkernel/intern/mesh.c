@@ -42,6 +42,7 @@
 #include "BLI_math.h"
 #include "BLI_memarena.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -983,6 +984,20 @@ Mesh *BKE_mesh_copy_for_eval(struct Mesh *source, bool reference)
   return result;
 }
 
+/**
+ * Copy the layers referencing data that isn't shared, like data referenced with #CD_REFERENCE
+ * from outside of a mesh. Afterwards the mesh can outlive the mesh it was copied from.
+ */
+void BKE_mesh_duplicate_borrowed_layers(Mesh *mesh)
+{
+  CustomData_duplicate_borrowed_layers(&mesh->vdata, mesh->totvert);
+  CustomData_duplicate_borrowed_layers(&mesh->edata, mesh->totedge);
+  CustomData_duplicate_borrowed_layers(&mesh->fdata, mesh->totface);
+  CustomData_duplicate_borrowed_layers(&mesh->ldata, mesh->totloop);
+  CustomData_duplicate_borrowed_layers(&mesh->pdata, mesh->totpoly);
+  BKE_mesh_update_customdata_pointers(mesh, false);
+}
+
 Mesh *BKE_mesh_copy(Main *bmain, const Mesh *me)
 {
   Mesh *me_copy;
@@ -1791,14 +1806,9 @@ void BKE_mesh_vert_normals_apply(Mesh *mesh, const short (*vert_normals)[3])
   mesh->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
 }
 
-/**
- * Compute 'split' (aka loop, or per face corner's) normals.
- *
- * \param r_lnors_spacearr: Allows to get computed loop normal space array.
- * That data, among other things, contains 'smooth fan' info, useful e.g.
- * to split geometry along sharp edges...
- */
-void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spacearr)
+static void mesh_calc_normals_split(Mesh *mesh,
+                                    MLoopNorSpaceArray *r_lnors_spacearr,
+                                    Mesh *mesh_cache)
 {
   float(*r_loopnors)[3];
   float(*polynors)[3];
@@ -1831,33 +1841,59 @@ void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spac
   }
   else {
     polynors = MEM_malloc_arrayN(mesh->totpoly, sizeof(float[3]), __func__);
-    BKE_mesh_calc_normals_poly(mesh->mvert,
-                               NULL,
-                               mesh->totvert,
-                               mesh->mloop,
-                               mesh->mpoly,
-                               mesh->totloop,
-                               mesh->totpoly,
-                               polynors,
-                               false);
+    BKE_mesh_calc_normals_poly_ex(
+        mesh->mvert,
+        NULL,
+        mesh->totvert,
+        mesh->mloop,
+        mesh->mpoly,
+        mesh->totloop,
+        mesh->totpoly,
+        polynors,
+        false,
+        mesh_cache ? BKE_mesh_runtime_vert_loop_map_ensure(mesh_cache) : NULL);
     free_polynors = true;
   }
 
-  BKE_mesh_normals_loop_split(mesh->mvert,
-                              mesh->totvert,
-                              mesh->medge,
-                              mesh->totedge,
-                              mesh->mloop,
-                              r_loopnors,
-                              mesh->totloop,
-                              mesh->mpoly,
-                              (const float(*)[3])polynors,
-                              mesh->totpoly,
-                              use_split_normals,
-                              split_angle,
-                              r_lnors_spacearr,
-                              clnors,
-                              NULL);
+  /* The cached fans are taken out of the mesh while they are used, so other threads computing
+   * normals of the same mesh aren't blocked, they start from an empty cache instead. */
+  ThreadMutex *mesh_cache_mutex = mesh_cache ? mesh_cache->runtime.eval_mutex : NULL;
+  MeshSmoothFans *smooth_fans = NULL;
+  if (mesh_cache_mutex) {
+    BLI_mutex_lock(mesh_cache_mutex);
+    smooth_fans = mesh_cache->runtime.smooth_fans;
+    mesh_cache->runtime.smooth_fans = NULL;
+    BLI_mutex_unlock(mesh_cache_mutex);
+  }
+
+  BKE_mesh_normals_loop_split_ex(mesh->mvert,
+                                 mesh->totvert,
+                                 mesh->medge,
+                                 mesh->totedge,
+                                 mesh->mloop,
+                                 r_loopnors,
+                                 mesh->totloop,
+                                 mesh->mpoly,
+                                 (const float(*)[3])polynors,
+                                 mesh->totpoly,
+                                 use_split_normals,
+                                 split_angle,
+                                 r_lnors_spacearr,
+                                 clnors,
+                                 NULL,
+                                 mesh_cache_mutex ? &smooth_fans : NULL);
+
+  if (mesh_cache_mutex) {
+    BLI_mutex_lock(mesh_cache_mutex);
+    if (mesh_cache->runtime.smooth_fans == NULL) {
+      mesh_cache->runtime.smooth_fans = smooth_fans;
+      smooth_fans = NULL;
+    }
+    BLI_mutex_unlock(mesh_cache_mutex);
+    if (smooth_fans != NULL) {
+      BKE_mesh_smooth_fans_free(smooth_fans);
+    }
+  }
 
   if (free_polynors) {
     MEM_freeN(polynors);
@@ -1866,9 +1902,35 @@ void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spac
   mesh->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
 }
 
+/**
+ * Compute 'split' (aka loop, or per face corner's) normals.
+ *
+ * \param r_lnors_spacearr: Allows to get computed loop normal space array.
+ * That data, among other things, contains 'smooth fan' info, useful e.g.
+ * to split geometry along sharp edges...
+ */
+void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spacearr)
+{
+  mesh_calc_normals_split(mesh, r_lnors_spacearr, NULL);
+}
+
 void BKE_mesh_calc_normals_split(Mesh *mesh)
 {
-  BKE_mesh_calc_normals_split_ex(mesh, NULL);
+  mesh_calc_normals_split(mesh, NULL, NULL);
+}
+
+/**
+ * Same as #BKE_mesh_calc_normals_split, caching the smooth fans and the vertex to loop map in the
+ * runtime of \a mesh_cache, so they are reused as long as only the positions change.
+ *
+ * \param mesh_cache: A mesh using the same topology arrays as \a mesh,
+ * usually the one it was copied from and which is kept between evaluations.
+ */
+void BKE_mesh_calc_normals_split_cached(Mesh *mesh, Mesh *mesh_cache)
+{
+  BLI_assert(mesh_cache->mloop == mesh->mloop && mesh_cache->medge == mesh->medge &&
+             mesh_cache->mpoly == mesh->mpoly);
+  mesh_calc_normals_split(mesh, NULL, mesh_cache);
 }
 
 /* Split faces helper functions. */
@@ -0,0 +1,258 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bke
+ *
+ * Calculate the edges of a mesh from its polygons.
+ *
+ * Edges are found with a concurrent hash map in parallel over all polygons. Every edge remembers
+ * the first loop that uses it, new edges are ordered by that loop so the result does not depend on
+ * the order in which threads added them.
+ *
+ * The order is the same as when edges were added one polygon after the other, starting with the
+ * closing edge from the last to the first vertex of a polygon. The edge from the last loop is
+ * ranked at the first loop, the edge from every other loop is ranked at the loop after it.
+ */
+
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array.hh"
+#include "BLI_concurrent_map.hh"
+#include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_mesh.h"
+
+using blender::Array;
+using blender::ConcurrentMap;
+
+namespace {
+
+struct OrderedEdge {
+  uint v_low, v_high;
+
+  OrderedEdge(const uint v1, const uint v2)
+  {
+    if (v1 < v2) {
+      v_low = v1;
+      v_high = v2;
+    }
+    else {
+      v_low = v2;
+      v_high = v1;
+    }
+  }
+
+  uint64_t hash() const
+  {
+    return (static_cast<uint64_t>(v_low) << 8) ^ v_high;
+  }
+
+  friend bool operator==(const OrderedEdge &a, const OrderedEdge &b)
+  {
+    BLI_assert(a.v_low < a.v_high);
+    BLI_assert(b.v_low < b.v_high);
+    return a.v_low == b.v_low && a.v_high == b.v_high;
+  }
+};
+
+/**
+ * The value stored for every edge: the index of an existing edge when it is below the number of
+ * existing edges, otherwise the number of existing edges plus the lowest rank of the loops using
+ * the edge.
+ */
+using EdgeMap = ConcurrentMap<OrderedEdge, int>;
+
+struct CalcEdgesData {
+  const MPoly *mpoly;
+  MLoop *mloop;
+  MEdge *medge;
+  EdgeMap *edge_map;
+  /** Number of existing edges that are kept. */
+  int totedge_prev;
+  /** The value of the edge map for every loop, -1 for invalid edges. */
+  int *loop_edge_values;
+  /** The index of the new edge, at the rank of the loop that is the first to use it. */
+  int *loop_first_edges;
+  short ed_flag;
+};
+
+static void calc_edges_add_cb(void *__restrict userdata,
+                              const int poly_index,
+                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const CalcEdgesData *data = static_cast<const CalcEdgesData *>(userdata);
+  const MPoly *mp = &data->mpoly[poly_index];
+  const MLoop *mloop = data->mloop;
+
+  int loop_prev = mp->loopstart + mp->totloop - 1;
+  for (int loop = mp->loopstart; loop < mp->loopstart + mp->totloop; loop++) {
+    if (mloop[loop_prev].v != mloop[loop].v) {
+      const int value = data->totedge_prev + loop;
+      data->edge_map->add_or_modify(
+          OrderedEdge(mloop[loop_prev].v, mloop[loop].v),
+          [&](int *r_value) { *r_value = value; },
+          [&](int *r_value) { *r_value = min_ii(*r_value, value); });
+    }
+    loop_prev = loop;
+  }
+}
+
+static void calc_edges_lookup_cb(void *__restrict userdata,
+                                 const int poly_index,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const CalcEdgesData *data = static_cast<const CalcEdgesData *>(userdata);
+  const MPoly *mp = &data->mpoly[poly_index];
+  const MLoop *mloop = data->mloop;
+
+  int loop_prev = mp->loopstart + mp->totloop - 1;
+  for (int loop = mp->loopstart; loop < mp->loopstart + mp->totloop; loop++) {
+    if (mloop[loop_prev].v != mloop[loop].v) {
+      data->loop_edge_values[loop_prev] = data->edge_map->lookup_default(
+          OrderedEdge(mloop[loop_prev].v, mloop[loop].v), -1);
+    }
+    else {
+      /* This is an invalid edge; normally this does not happen in Blender, but it can be part
+       * of an imported mesh with invalid geometry. See T76514. */
+      data->loop_edge_values[loop_prev] = -1;
+    }
+    loop_prev = loop;
+  }
+}
+
+static void calc_edges_assign_cb(void *__restrict userdata,
+                                 const int poly_index,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const CalcEdgesData *data = static_cast<const CalcEdgesData *>(userdata);
+  const MPoly *mp = &data->mpoly[poly_index];
+  MLoop *mloop = data->mloop;
+
+  int loop_prev = mp->loopstart + mp->totloop - 1;
+  for (int loop = mp->loopstart; loop < mp->loopstart + mp->totloop; loop++) {
+    const int value = data->loop_edge_values[loop_prev];
+    int edge_index = 0;
+    if (value >= data->totedge_prev) {
+      edge_index = data->loop_first_edges[value - data->totedge_prev];
+      if (value - data->totedge_prev == loop) {
+        MEdge *med = &data->medge[edge_index];
+        const OrderedEdge edge(mloop[loop_prev].v, mloop[loop].v);
+        med->v1 = edge.v_low;
+        med->v2 = edge.v_high;
+        med->flag = data->ed_flag;
+      }
+    }
+    else if (value >= 0) {
+      edge_index = value;
+    }
+    mloop[loop_prev].e = static_cast<uint>(edge_index);
+    loop_prev = loop;
+  }
+}
+
+}  // namespace
+
+/**
+ * Calculate edges from polygons
+ *
+ * \param mesh: The mesh to add edges into
+ * \param update: When true create new edges co-exist
+ */
+void BKE_mesh_calc_edges(Mesh *mesh, bool update, const bool select)
+{
+  /* select for newly created meshes which are selected [#25595] */
+  const short ed_flag = (ME_EDGEDRAW | ME_EDGERENDER) | (select ? SELECT : 0);
+
+  if (mesh->totedge == 0) {
+    update = false;
+  }
+  const int totedge_prev = update ? mesh->totedge : 0;
+
+  /* Most meshes are manifold, using every edge from two loops. */
+  EdgeMap edge_map;
+  edge_map.reserve(max_ii(totedge_prev, mesh->totloop / 2));
+
+  if (update) {
+    /* assume existing edges are valid
+     * useful when adding more faces and generating edges from them */
+    const MEdge *med = mesh->medge;
+    for (int i = 0; i < mesh->totedge; i++, med++) {
+      edge_map.add(OrderedEdge(med->v1, med->v2), i);
+    }
+  }
+
+  Array<int> loop_edge_values(mesh->totloop);
+  Array<int> loop_first_edges(mesh->totloop);
+
+  CalcEdgesData data;
+  data.mpoly = mesh->mpoly;
+  data.mloop = mesh->mloop;
+  data.medge = nullptr;
+  data.edge_map = &edge_map;
+  data.totedge_prev = totedge_prev;
+  data.loop_edge_values = loop_edge_values.data();
+  data.loop_first_edges = loop_first_edges.data();
+  data.ed_flag = ed_flag;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+
+  BLI_task_parallel_range(0, mesh->totpoly, &data, calc_edges_add_cb, &settings);
+  BLI_task_parallel_range(0, mesh->totpoly, &data, calc_edges_lookup_cb, &settings);
+
+  /* Number the new edges in the order of the first loop using them. */
+  int totedge = totedge_prev;
+  for (int poly_index = 0; poly_index < mesh->totpoly; poly_index++) {
+    const MPoly *mp = &mesh->mpoly[poly_index];
+    int loop_prev = mp->loopstart + mp->totloop - 1;
+    for (int loop = mp->loopstart; loop < mp->loopstart + mp->totloop; loop++) {
+      if (loop_edge_values[loop_prev] == totedge_prev + loop) {
+        loop_first_edges[loop] = totedge++;
+      }
+      loop_prev = loop;
+    }
+  }
+
+  /* write new edges into a temporary CustomData */
+  CustomData edata;
+  CustomData_reset(&edata);
+  data.medge = static_cast<MEdge *>(
+      CustomData_add_layer(&edata, CD_MEDGE, CD_CALLOC, nullptr, totedge));
+  if (totedge_prev) {
+    /* copy from the original */
+    memcpy(data.medge, mesh->medge, sizeof(MEdge) * static_cast<size_t>(totedge_prev));
+  }
+
+  BLI_task_parallel_range(0, mesh->totpoly, &data, calc_edges_assign_cb, &settings);
+
+  /* free old CustomData and assign new one */
+  CustomData_free(&mesh->edata, mesh->totedge);
+  mesh->edata = edata;
+  mesh->totedge = totedge;
+
+  mesh->medge = static_cast<MEdge *>(CustomData_get_layer(&mesh->edata, CD_MEDGE));
+}
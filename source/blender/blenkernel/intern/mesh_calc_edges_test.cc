@@ -0,0 +1,145 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BLI_edgehash.h"
+#include "BLI_vector.hh"
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+namespace blender::bke::tests {
+
+/* Quads and triangles sharing edges, in no particular order. */
+static Mesh *polys_mesh_create()
+{
+  const Vector<Vector<int>> polys = {{0, 1, 5, 4},
+                                     {5, 6, 10, 9},
+                                     {1, 2, 6, 5},
+                                     {4, 5, 9, 8},
+                                     {2, 3, 7},
+                                     {2, 7, 6},
+                                     {10, 11, 7, 6},
+                                     {3, 11, 7}};
+  int totloop = 0;
+  for (const Vector<int> &poly : polys) {
+    totloop += poly.size();
+  }
+
+  Mesh *mesh = BKE_mesh_new_nomain(12, 0, 0, totloop, polys.size());
+  int loop = 0;
+  for (const int i : polys.index_range()) {
+    mesh->mpoly[i].loopstart = loop;
+    mesh->mpoly[i].totloop = polys[i].size();
+    for (const int v : polys[i]) {
+      mesh->mloop[loop++].v = v;
+    }
+  }
+  return mesh;
+}
+
+struct EdgesResult {
+  Vector<std::pair<uint, uint>> edges;
+  Vector<uint> loop_edges;
+};
+
+/* The edges as they were calculated with an #EdgeHash, in the order of insertion. */
+static EdgesResult edges_calc_edgehash(const Mesh *mesh, const int totedge_prev)
+{
+  EdgeHash *eh = BLI_edgehash_new(__func__);
+  EdgesResult result;
+  auto add_edge = [&](const uint v1, const uint v2) {
+    void **val_p;
+    if (!BLI_edgehash_ensure_p(eh, v1, v2, &val_p)) {
+      *val_p = POINTER_FROM_INT(result.edges.size());
+      result.edges.append({std::min(v1, v2), std::max(v1, v2)});
+    }
+  };
+  for (int i = 0; i < totedge_prev; i++) {
+    add_edge(mesh->medge[i].v1, mesh->medge[i].v2);
+  }
+  for (int i = 0; i < mesh->totpoly; i++) {
+    const MPoly *mp = &mesh->mpoly[i];
+    uint v_prev = mesh->mloop[mp->loopstart + mp->totloop - 1].v;
+    for (int loop = mp->loopstart; loop < mp->loopstart + mp->totloop; loop++) {
+      add_edge(v_prev, mesh->mloop[loop].v);
+      v_prev = mesh->mloop[loop].v;
+    }
+  }
+  for (int i = 0; i < mesh->totpoly; i++) {
+    const MPoly *mp = &mesh->mpoly[i];
+    int loop_prev = mp->loopstart + mp->totloop - 1;
+    for (int loop = mp->loopstart; loop < mp->loopstart + mp->totloop; loop++) {
+      result.loop_edges.append(0);
+    }
+    for (int loop = mp->loopstart; loop < mp->loopstart + mp->totloop; loop++) {
+      result.loop_edges[loop_prev] = POINTER_AS_INT(
+          BLI_edgehash_lookup(eh, mesh->mloop[loop_prev].v, mesh->mloop[loop].v));
+      loop_prev = loop;
+    }
+  }
+  BLI_edgehash_free(eh, nullptr);
+  return result;
+}
+
+static void expect_edges_eq(const Mesh *mesh, const EdgesResult &expected)
+{
+  ASSERT_EQ(mesh->totedge, expected.edges.size());
+  for (int i = 0; i < mesh->totedge; i++) {
+    EXPECT_EQ(std::min(mesh->medge[i].v1, mesh->medge[i].v2), expected.edges[i].first);
+    EXPECT_EQ(std::max(mesh->medge[i].v1, mesh->medge[i].v2), expected.edges[i].second);
+  }
+  for (int i = 0; i < mesh->totloop; i++) {
+    EXPECT_EQ(mesh->mloop[i].e, expected.loop_edges[i]);
+  }
+}
+
+class MeshCalcEdgesTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+};
+
+TEST_F(MeshCalcEdgesTest, OrderMatchesEdgeHash)
+{
+  Mesh *mesh = polys_mesh_create();
+  const EdgesResult expected = edges_calc_edgehash(mesh, 0);
+  BKE_mesh_calc_edges(mesh, false, false);
+  expect_edges_eq(mesh, expected);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshCalcEdgesTest, UpdateOrderMatchesEdgeHash)
+{
+  Mesh *mesh = polys_mesh_create();
+  BKE_mesh_calc_edges(mesh, false, false);
+
+  /* Keep some of the edges, in reverse order. */
+  const int totedge_prev = 5;
+  Mesh *mesh_update = BKE_mesh_new_nomain(
+      mesh->totvert, totedge_prev, 0, mesh->totloop, mesh->totpoly);
+  for (int i = 0; i < totedge_prev; i++) {
+    mesh_update->medge[i] = mesh->medge[mesh->totedge - 1 - i];
+  }
+  memcpy(mesh_update->mloop, mesh->mloop, sizeof(MLoop) * mesh->totloop);
+  memcpy(mesh_update->mpoly, mesh->mpoly, sizeof(MPoly) * mesh->totpoly);
+
+  const EdgesResult expected = edges_calc_edgehash(mesh_update, totedge_prev);
+  BKE_mesh_calc_edges(mesh_update, true, false);
+  expect_edges_eq(mesh_update, expected);
+
+  BKE_id_free(nullptr, mesh);
+  BKE_id_free(nullptr, mesh_update);
+}
+
+}  // namespace blender::bke::tests
@@ -49,6 +49,7 @@
 #include "BKE_editmesh_cache.h"
 #include "BKE_global.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
 #include "BKE_multires.h"
 #include "BKE_report.h"
 
@@ -217,6 +218,7 @@ typedef struct MeshCalcNormalsData {
   float (*pnors)[3];
   float (*lnors_weighted)[3];
   float (*vnors)[3];
+  const MeshElemMap *vert_to_loop;
 } MeshCalcNormalsData;
 
 static void mesh_calc_normals_poly_cb(void *__restrict userdata,
@@ -310,6 +312,22 @@ static void mesh_calc_normals_poly_finalize_cb(void *__restrict userdata,
   normal_float_to_short_v3(mv->no, no);
 }
 
+static void mesh_calc_normals_poly_gather_cb(void *__restrict userdata,
+                                             const int vidx,
+                                             const TaskParallelTLS *__restrict tls)
+{
+  MeshCalcNormalsData *data = userdata;
+  const MeshElemMap *vert_loops = &data->vert_to_loop[vidx];
+  float *no = data->vnors[vidx];
+
+  zero_v3(no);
+  for (int i = 0; i < vert_loops->count; i++) {
+    add_v3_v3(no, data->lnors_weighted[vert_loops->indices[i]]);
+  }
+
+  mesh_calc_normals_poly_finalize_cb(userdata, vidx, tls);
+}
+
 void BKE_mesh_calc_normals_poly(MVert *mverts,
                                 float (*r_vertnors)[3],
                                 int numVerts,
@@ -319,6 +337,34 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
                                 int numPolys,
                                 float (*r_polynors)[3],
                                 const bool only_face_normals)
+{
+  BKE_mesh_calc_normals_poly_ex(mverts,
+                                r_vertnors,
+                                numVerts,
+                                mloop,
+                                mpolys,
+                                numLoops,
+                                numPolys,
+                                r_polynors,
+                                only_face_normals,
+                                NULL);
+}
+
+/**
+ * \param vert_to_loop: Optional map from vertices to their loops
+ * (see #BKE_mesh_runtime_vert_loop_map_ensure), when given the weighted loop normals are
+ * gathered into the vertex normals in parallel.
+ */
+void BKE_mesh_calc_normals_poly_ex(MVert *mverts,
+                                   float (*r_vertnors)[3],
+                                   int numVerts,
+                                   const MLoop *mloop,
+                                   const MPoly *mpolys,
+                                   int numLoops,
+                                   int numPolys,
+                                   float (*r_polynors)[3],
+                                   const bool only_face_normals,
+                                   const MeshElemMap *vert_to_loop)
 {
   float(*pnors)[3] = r_polynors;
 
@@ -351,7 +397,7 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
     vnors = MEM_calloc_arrayN((size_t)numVerts, sizeof(*vnors), __func__);
     free_vnors = true;
   }
-  else {
+  else if (vert_to_loop == NULL) {
     memset(vnors, 0, sizeof(*vnors) * (size_t)numVerts);
   }
 
@@ -362,21 +408,28 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
       .pnors = pnors,
       .lnors_weighted = lnors_weighted,
       .vnors = vnors,
+      .vert_to_loop = vert_to_loop,
   };
 
   /* Compute poly normals, and prepare weighted loop normals. */
   BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_prepare_cb, &settings);
 
-  /* Actually accumulate weighted loop normals into vertex ones. */
-  /* Unfortunately, not possible to thread that
-   * (not in a reasonable, totally lock- and barrier-free fashion),
-   * since several loops will point to the same vertex... */
-  for (int lidx = 0; lidx < numLoops; lidx++) {
-    add_v3_v3(vnors[mloop[lidx].v], data.lnors_weighted[lidx]);
+  if (vert_to_loop) {
+    /* Each vertex sums the weighted normals of its own loops, so this can be threaded. */
+    BLI_task_parallel_range(0, numVerts, &data, mesh_calc_normals_poly_gather_cb, &settings);
   }
+  else {
+    /* Actually accumulate weighted loop normals into vertex ones. */
+    /* Unfortunately, not possible to thread that without a map from vertices to loops
+     * (not in a reasonable, totally lock- and barrier-free fashion),
+     * since several loops will point to the same vertex... */
+    for (int lidx = 0; lidx < numLoops; lidx++) {
+      add_v3_v3(vnors[mloop[lidx].v], data.lnors_weighted[lidx]);
+    }
 
-  /* Normalize and validate computed vertex normals. */
-  BLI_task_parallel_range(0, numVerts, &data, mesh_calc_normals_poly_finalize_cb, &settings);
+    /* Normalize and validate computed vertex normals. */
+    BLI_task_parallel_range(0, numVerts, &data, mesh_calc_normals_poly_finalize_cb, &settings);
+  }
 
   if (free_vnors) {
     MEM_freeN(vnors);
@@ -774,6 +827,7 @@ void BKE_lnor_space_custom_normal_to_data(MLoopNorSpace *lnor_space,
   }
 }
 
+/* Minimum number of fans computed by a thread. */
 #define LOOP_SPLIT_TASK_BLOCK_SIZE 1024
 
 typedef struct LoopSplitTaskData {
@@ -819,6 +873,15 @@ typedef struct LoopSplitTaskDataCommon {
   int numPolys;
 } LoopSplitTaskDataCommon;
 
+/** A smooth fan, given by the loop it is computed from. */
+typedef struct LoopSplitFan {
+  int ml_curr_index;
+  int ml_prev_index;
+  int mp_index;
+  /** Both edges of the loop are sharp, so it is the only loop of its fan. */
+  bool is_single;
+} LoopSplitFan;
+
 #define INDEX_UNSET INT_MIN
 #define INDEX_INVALID -1
 /* See comment about edge_to_loops below. */
@@ -1316,38 +1379,6 @@ static void loop_split_worker_do(LoopSplitTaskDataCommon *common_data,
   }
 }
 
-static void loop_split_worker(TaskPool *__restrict pool, void *taskdata)
-{
-  LoopSplitTaskDataCommon *common_data = BLI_task_pool_user_data(pool);
-  LoopSplitTaskData *data = taskdata;
-
-  /* Temp edge vectors stack, only used when computing lnor spacearr. */
-  BLI_Stack *edge_vectors = common_data->lnors_spacearr ?
-                                BLI_stack_new(sizeof(float[3]), __func__) :
-                                NULL;
-
-#ifdef DEBUG_TIME
-  TIMEIT_START_AVERAGED(loop_split_worker);
-#endif
-
-  for (int i = 0; i < LOOP_SPLIT_TASK_BLOCK_SIZE; i++, data++) {
-    /* A NULL ml_curr is used to tag ended data! */
-    if (data->ml_curr == NULL) {
-      break;
-    }
-
-    loop_split_worker_do(common_data, data, edge_vectors);
-  }
-
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
-  }
-
-#ifdef DEBUG_TIME
-  TIMEIT_END_AVERAGED(loop_split_worker);
-#endif
-}
-
 /**
  * Check whether given loop is part of an unknown-so-far cyclic smooth fan, or not.
  * Needed because cyclic smooth fans have no obvious 'entry point',
@@ -1423,11 +1454,13 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
   }
 }
 
-static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common_data)
+/**
+ * Find the smooth fans of the mesh (a single loop when both its edges are sharp),
+ * each one given by the loop it is computed from.
+ */
+static LoopSplitFan *loop_split_fans_find(const LoopSplitTaskDataCommon *common_data,
+                                          int *r_fans_len)
 {
-  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
-  float(*loopnors)[3] = common_data->loopnors;
-
   const MLoop *mloops = common_data->mloops;
   const MPoly *mpolys = common_data->mpolys;
   const int *loop_to_poly = common_data->loop_to_poly;
@@ -1445,49 +1478,29 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
 
   BLI_bitmap *skip_loops = BLI_BITMAP_NEW(numLoops, __func__);
 
-  LoopSplitTaskData *data_buff = NULL;
-  int data_idx = 0;
-
-  /* Temp edge vectors stack, only used when computing lnor spacearr
-   * (and we are not multi-threading). */
-  BLI_Stack *edge_vectors = NULL;
+  /* There is at most one fan per loop. */
+  LoopSplitFan *fans = MEM_malloc_arrayN((size_t)numLoops, sizeof(*fans), __func__);
+  int fans_len = 0;
 
 #ifdef DEBUG_TIME
-  TIMEIT_START_AVERAGED(loop_split_generator);
+  TIMEIT_START_AVERAGED(loop_split_fans_find);
 #endif
 
-  if (!pool) {
-    if (lnors_spacearr) {
-      edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
-    }
-  }
-
   /* We now know edges that can be smoothed (with their vector, and their two loops),
-   * and edges that will be hard! Now, time to generate the normals.
+   * and edges that will be hard! Now, time to find the fans.
    */
   for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-    float(*lnors)[3];
     const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
     ml_curr_index = mp->loopstart;
     ml_prev_index = ml_last_index;
 
     ml_curr = &mloops[ml_curr_index];
     ml_prev = &mloops[ml_prev_index];
-    lnors = &loopnors[ml_curr_index];
 
-    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++, lnors++) {
+    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
       const int *e2l_curr = edge_to_loops[ml_curr->e];
       const int *e2l_prev = edge_to_loops[ml_prev->e];
 
-#if 0
-      printf("Checking loop %d / edge %u / vert %u (sharp edge: %d, skiploop: %d)...",
-             ml_curr_index,
-             ml_curr->e,
-             ml_curr->v,
-             IS_EDGE_SHARP(e2l_curr),
-             BLI_BITMAP_TEST_BOOL(skip_loops, ml_curr_index));
-#endif
-
       /* A smooth edge, we have to check for cyclic smooth fan case.
        * If we find a new, never-processed cyclic smooth fan, we can do it now using that loop/edge
        * as 'entry point', otherwise we can skip it. */
@@ -1510,39 +1523,9 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
                                                                                      ml_curr_index,
                                                                                      ml_prev_index,
                                                                                      mp_index))) {
-        //              printf("SKIPPING!\n");
+        /* Skipped. */
       }
       else {
-        LoopSplitTaskData *data, data_local;
-
-        //              printf("PROCESSING!\n");
-
-        if (pool) {
-          if (data_idx == 0) {
-            data_buff = MEM_calloc_arrayN(
-                LOOP_SPLIT_TASK_BLOCK_SIZE, sizeof(*data_buff), __func__);
-          }
-          data = &data_buff[data_idx];
-        }
-        else {
-          data = &data_local;
-          memset(data, 0, sizeof(*data));
-        }
-
-        if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
-          data->lnor = lnors;
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-#if 0 /* Not needed for 'single' loop. */
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = NULL; /* Tag as 'single' task. */
-#endif
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
-        }
         /* We *do not need* to check/tag loops as already computed!
          * Due to the fact a loop only links to one of its two edges,
          * a same fan *will never be walked more than once!*
@@ -1552,31 +1535,11 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
          * and not the alternative (smooth curr_edge, sharp prev_edge).
          * All this due/thanks to link between normals and loop ordering (i.e. winding).
          */
-        else {
-#if 0 /* Not needed for 'fan' loops. */
-          data->lnor = lnors;
-#endif
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
-        }
-
-        if (pool) {
-          data_idx++;
-          if (data_idx == LOOP_SPLIT_TASK_BLOCK_SIZE) {
-            BLI_task_pool_push(pool, loop_split_worker, data_buff, true, NULL);
-            data_idx = 0;
-          }
-        }
-        else {
-          loop_split_worker_do(common_data, data, edge_vectors);
-        }
+        LoopSplitFan *fan = &fans[fans_len++];
+        fan->ml_curr_index = ml_curr_index;
+        fan->ml_prev_index = ml_prev_index;
+        fan->mp_index = mp_index;
+        fan->is_single = IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev);
       }
 
       ml_prev = ml_curr;
@@ -1584,20 +1547,252 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
     }
   }
 
-  /* Last block of data... Since it is calloc'ed and we use first NULL item as stopper,
-   * everything is fine. */
-  if (pool && data_idx) {
-    BLI_task_pool_push(pool, loop_split_worker, data_buff, true, NULL);
-  }
+  MEM_freeN(skip_loops);
 
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
+  if (fans_len == 0) {
+    MEM_SAFE_FREE(fans);
+  }
+  else if (fans_len < numLoops) {
+    fans = MEM_reallocN(fans, sizeof(*fans) * (size_t)fans_len);
   }
-  MEM_freeN(skip_loops);
 
 #ifdef DEBUG_TIME
-  TIMEIT_END_AVERAGED(loop_split_generator);
+  TIMEIT_END_AVERAGED(loop_split_fans_find);
 #endif
+
+  *r_fans_len = fans_len;
+  return fans;
+}
+
+typedef struct LoopSplitFansData {
+  LoopSplitTaskDataCommon *common_data;
+  const LoopSplitFan *fans;
+  /** One space per fan, only used when computing lnor spacearr. */
+  MLoopNorSpace *lnor_spaces;
+} LoopSplitFansData;
+
+typedef struct LoopSplitFansTLS {
+  /** Temp edge vectors stack, only used when computing lnor spacearr. */
+  BLI_Stack *edge_vectors;
+} LoopSplitFansTLS;
+
+static void loop_split_fan_cb(void *__restrict userdata,
+                              const int fan_index,
+                              const TaskParallelTLS *__restrict tls)
+{
+  LoopSplitFansData *data = userdata;
+  LoopSplitTaskDataCommon *common_data = data->common_data;
+  LoopSplitFansTLS *tls_data = tls->userdata_chunk;
+  const LoopSplitFan *fan = &data->fans[fan_index];
+
+  LoopSplitTaskData task_data = {
+      .lnor_space = data->lnor_spaces ? &data->lnor_spaces[fan_index] : NULL,
+      .ml_curr = &common_data->mloops[fan->ml_curr_index],
+      .ml_prev = &common_data->mloops[fan->ml_prev_index],
+      .ml_curr_index = fan->ml_curr_index,
+      .ml_prev_index = fan->ml_prev_index,
+      .mp_index = fan->mp_index,
+  };
+
+  if (fan->is_single) {
+    task_data.lnor = &common_data->loopnors[fan->ml_curr_index];
+  }
+  else {
+    /* Also tags as 'fan' task. */
+    task_data.e2l_prev = common_data->edge_to_loops[task_data.ml_prev->e];
+    if (common_data->lnors_spacearr && tls_data->edge_vectors == NULL) {
+      tls_data->edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
+    }
+  }
+
+  loop_split_worker_do(common_data, &task_data, tls_data->edge_vectors);
+}
+
+static void loop_split_fan_free(const void *__restrict UNUSED(userdata), void *__restrict chunk)
+{
+  LoopSplitFansTLS *tls_data = chunk;
+  if (tls_data->edge_vectors) {
+    BLI_stack_free(tls_data->edge_vectors);
+  }
+}
+
+/**
+ * Compute the normals (and spaces) of all fans. Fans never share loops,
+ * so they are computed in parallel.
+ */
+static void loop_split_fans_compute(LoopSplitTaskDataCommon *common_data,
+                                    const LoopSplitFan *fans,
+                                    const int fans_len)
+{
+  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
+
+  LoopSplitFansData data = {
+      .common_data = common_data,
+      .fans = fans,
+  };
+
+  /* We have to create those outside of tasks, since memarena is not threadsafe. */
+  if (lnors_spacearr && fans_len != 0) {
+    data.lnor_spaces = BLI_memarena_calloc(lnors_spacearr->mem,
+                                           sizeof(*data.lnor_spaces) * (size_t)fans_len);
+    lnors_spacearr->num_spaces += fans_len;
+  }
+
+  LoopSplitFansTLS tls_data = {NULL};
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  /* Not enough loops to be worth the whole threading overhead... */
+  settings.use_threading = (common_data->numLoops >= LOOP_SPLIT_TASK_BLOCK_SIZE * 8);
+  settings.min_iter_per_thread = LOOP_SPLIT_TASK_BLOCK_SIZE;
+  settings.userdata_chunk = &tls_data;
+  settings.userdata_chunk_size = sizeof(tls_data);
+  settings.func_free = loop_split_fan_free;
+
+  BLI_task_parallel_range(0, fans_len, &data, loop_split_fan_cb, &settings);
+}
+
+/**
+ * Cache of the smooth fans of a mesh, see #BKE_mesh_normals_loop_split_ex.
+ *
+ * Which edges are sharp only depends on the positions through the split angle, and the smooth
+ * fans only depend on the sharp edges. When only the positions of a mesh change,
+ * the topology part is reused and the fans are only searched again if the angle test gives
+ * other sharp edges.
+ */
+struct MeshSmoothFans {
+  /** Topology the cache was created for. */
+  const MEdge *medges;
+  const MLoop *mloops;
+  const MPoly *mpolys;
+  int numEdges;
+  int numLoops;
+  int numPolys;
+
+  /** Edge to loops map without edges only sharp because of the split angle. */
+  int (*edge_to_loops_topology)[2];
+  int *loop_to_poly;
+
+  /** Edge to loops map the fans were found with, NULL until they are. */
+  int (*edge_to_loops)[2];
+  LoopSplitFan *fans;
+  int fans_len;
+};
+
+void BKE_mesh_smooth_fans_free(MeshSmoothFans *smooth_fans)
+{
+  MEM_SAFE_FREE(smooth_fans->edge_to_loops_topology);
+  MEM_SAFE_FREE(smooth_fans->loop_to_poly);
+  MEM_SAFE_FREE(smooth_fans->edge_to_loops);
+  MEM_SAFE_FREE(smooth_fans->fans);
+  MEM_freeN(smooth_fans);
+}
+
+static MeshSmoothFans *mesh_smooth_fans_ensure(MeshSmoothFans **smooth_fans_p,
+                                               const LoopSplitTaskDataCommon *common_data)
+{
+  MeshSmoothFans *smooth_fans = *smooth_fans_p;
+  if (smooth_fans != NULL &&
+      (smooth_fans->medges != common_data->medges || smooth_fans->mloops != common_data->mloops ||
+       smooth_fans->mpolys != common_data->mpolys ||
+       smooth_fans->numEdges != common_data->numEdges ||
+       smooth_fans->numLoops != common_data->numLoops ||
+       smooth_fans->numPolys != common_data->numPolys)) {
+    BKE_mesh_smooth_fans_free(smooth_fans);
+    smooth_fans = NULL;
+  }
+
+  if (smooth_fans == NULL) {
+    smooth_fans = MEM_callocN(sizeof(*smooth_fans), __func__);
+    smooth_fans->medges = common_data->medges;
+    smooth_fans->mloops = common_data->mloops;
+    smooth_fans->mpolys = common_data->mpolys;
+    smooth_fans->numEdges = common_data->numEdges;
+    smooth_fans->numLoops = common_data->numLoops;
+    smooth_fans->numPolys = common_data->numPolys;
+    smooth_fans->edge_to_loops_topology = MEM_calloc_arrayN(
+        (size_t)common_data->numEdges, sizeof(*smooth_fans->edge_to_loops_topology), __func__);
+    smooth_fans->loop_to_poly = MEM_malloc_arrayN(
+        (size_t)common_data->numLoops, sizeof(*smooth_fans->loop_to_poly), __func__);
+
+    LoopSplitTaskDataCommon topology_data = *common_data;
+    topology_data.loopnors = NULL;
+    topology_data.edge_to_loops = smooth_fans->edge_to_loops_topology;
+    topology_data.loop_to_poly = smooth_fans->loop_to_poly;
+    mesh_edges_sharp_tag(&topology_data, false, (float)M_PI, false);
+
+    *smooth_fans_p = smooth_fans;
+  }
+
+  return smooth_fans;
+}
+
+typedef struct MeshEdgesSharpFromTopologyData {
+  LoopSplitTaskDataCommon *common_data;
+  const int (*edge_to_loops_topology)[2];
+  bool check_angle;
+  float split_angle_cos;
+} MeshEdgesSharpFromTopologyData;
+
+static void mesh_edges_sharp_from_topology_cb(void *__restrict userdata,
+                                              const int me_index,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshEdgesSharpFromTopologyData *data = userdata;
+  const LoopSplitTaskDataCommon *common_data = data->common_data;
+  int *e2l = common_data->edge_to_loops[me_index];
+
+  copy_v2_v2_int(e2l, data->edge_to_loops_topology[me_index]);
+
+  /* Loose edges have both loops set to 0. */
+  if (data->check_angle && !IS_EDGE_SHARP(e2l) && e2l[0] != e2l[1]) {
+    const float(*polynors)[3] = common_data->polynors;
+    const int *loop_to_poly = common_data->loop_to_poly;
+    if (dot_v3v3(polynors[loop_to_poly[e2l[0]]], polynors[loop_to_poly[e2l[1]]]) <
+        data->split_angle_cos) {
+      e2l[1] = INDEX_INVALID;
+    }
+  }
+}
+
+static void mesh_loops_normal_from_vert_cb(void *__restrict userdata,
+                                           const int ml_index,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshEdgesSharpFromTopologyData *data = userdata;
+  const LoopSplitTaskDataCommon *common_data = data->common_data;
+
+  normal_short_to_float_v3(common_data->loopnors[ml_index],
+                           common_data->mverts[common_data->mloops[ml_index].v].no);
+}
+
+/**
+ * Same as #mesh_edges_sharp_tag, using the cached edge to loops map of the topology,
+ * so only the split angle has to be checked.
+ */
+static void mesh_edges_sharp_tag_from_topology(LoopSplitTaskDataCommon *common_data,
+                                               const MeshSmoothFans *smooth_fans,
+                                               const bool check_angle,
+                                               const float split_angle)
+{
+  MeshEdgesSharpFromTopologyData data = {
+      .common_data = common_data,
+      .edge_to_loops_topology = (const int(*)[2])smooth_fans->edge_to_loops_topology,
+      .check_angle = check_angle,
+      .split_angle_cos = check_angle ? cosf(split_angle) : -1.0f,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+
+  BLI_task_parallel_range(
+      0, common_data->numEdges, &data, mesh_edges_sharp_from_topology_cb, &settings);
+
+  /* Pre-populate all loop normals as if their verts were all-smooth,
+   * this way we don't have to compute those later! */
+  BLI_task_parallel_range(
+      0, common_data->numLoops, &data, mesh_loops_normal_from_vert_cb, &settings);
 }
 
 /**
@@ -1606,7 +1801,7 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
  * (splitting edges).
  */
 void BKE_mesh_normals_loop_split(const MVert *mverts,
-                                 const int UNUSED(numVerts),
+                                 const int numVerts,
                                  MEdge *medges,
                                  const int numEdges,
                                  MLoop *mloops,
@@ -1620,6 +1815,47 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
                                  MLoopNorSpaceArray *r_lnors_spacearr,
                                  short (*clnors_data)[2],
                                  int *r_loop_to_poly)
+{
+  BKE_mesh_normals_loop_split_ex(mverts,
+                                 numVerts,
+                                 medges,
+                                 numEdges,
+                                 mloops,
+                                 r_loopnors,
+                                 numLoops,
+                                 mpolys,
+                                 polynors,
+                                 numPolys,
+                                 use_split_normals,
+                                 split_angle,
+                                 r_lnors_spacearr,
+                                 clnors_data,
+                                 r_loop_to_poly,
+                                 NULL);
+}
+
+/**
+ * \param smooth_fans_cache: Optional cache of the smooth fans, created or updated as needed.
+ * Only the part depending on the positions is computed again when it matches the topology.
+ * It must not be used by other threads at the same time, free it with
+ * #BKE_mesh_smooth_fans_free.
+ */
+void BKE_mesh_normals_loop_split_ex(const MVert *mverts,
+                                    const int UNUSED(numVerts),
+                                    MEdge *medges,
+                                    const int numEdges,
+                                    MLoop *mloops,
+                                    float (*r_loopnors)[3],
+                                    const int numLoops,
+                                    MPoly *mpolys,
+                                    const float (*polynors)[3],
+                                    const int numPolys,
+                                    const bool use_split_normals,
+                                    const float split_angle,
+                                    MLoopNorSpaceArray *r_lnors_spacearr,
+                                    short (*clnors_data)[2],
+                                    int *r_loop_to_poly,
+                                    MeshSmoothFans **smooth_fans_cache)
 {
   /* For now this is not supported.
    * If we do not use split normals, we do not generate anything fancy! */
@@ -1670,12 +1906,19 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
    * However, if needed, we can store the negated value of loop index instead of INDEX_INVALID
    * to retrieve the real value later in code).
    * Note also that lose edges always have both values set to 0! */
-  int(*edge_to_loops)[2] = MEM_calloc_arrayN((size_t)numEdges, sizeof(*edge_to_loops), __func__);
+  int(*edge_to_loops)[2] = smooth_fans_cache ?
+                               MEM_malloc_arrayN(
+                                   (size_t)numEdges, sizeof(*edge_to_loops), __func__) :
+                               MEM_calloc_arrayN(
+                                   (size_t)numEdges, sizeof(*edge_to_loops), __func__);
 
   /* Simple mapping from a loop to its polygon index. */
-  int *loop_to_poly = r_loop_to_poly ?
-                          r_loop_to_poly :
-                          MEM_malloc_arrayN((size_t)numLoops, sizeof(*loop_to_poly), __func__);
+  int *loop_to_poly = NULL;
+  if (smooth_fans_cache == NULL) {
+    loop_to_poly = r_loop_to_poly ?
+                       r_loop_to_poly :
+                       MEM_malloc_arrayN((size_t)numLoops, sizeof(*loop_to_poly), __func__);
+  }
 
   /* When using custom loop normals, disable the angle feature! */
   const bool check_angle = (split_angle < (float)M_PI) && (clnors_data == NULL);
@@ -1711,25 +1954,51 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
       .numPolys = numPolys,
   };
 
-  /* This first loop check which edges are actually smooth, and compute edge vectors. */
-  mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
+  const LoopSplitFan *fans;
+  int fans_len;
+  LoopSplitFan *fans_local = NULL;
 
-  if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
-    /* Not enough loops to be worth the whole threading overhead... */
-    loop_split_generator(NULL, &common_data);
-  }
-  else {
-    TaskPool *task_pool = BLI_task_pool_create(&common_data, TASK_PRIORITY_HIGH);
+  if (smooth_fans_cache) {
+    MeshSmoothFans *smooth_fans = mesh_smooth_fans_ensure(smooth_fans_cache, &common_data);
+    common_data.loop_to_poly = smooth_fans->loop_to_poly;
+    if (r_loop_to_poly) {
+      memcpy(r_loop_to_poly, smooth_fans->loop_to_poly, sizeof(int) * (size_t)numLoops);
+    }
 
-    loop_split_generator(task_pool, &common_data);
+    /* Only check the split angle of edges which are smooth in the topology. */
+    mesh_edges_sharp_tag_from_topology(&common_data, smooth_fans, check_angle, split_angle);
 
-    BLI_task_pool_work_and_wait(task_pool);
+    const size_t edge_to_loops_size = sizeof(*edge_to_loops) * (size_t)numEdges;
+    if (smooth_fans->edge_to_loops != NULL &&
+        memcmp(smooth_fans->edge_to_loops, edge_to_loops, edge_to_loops_size) == 0) {
+      /* Same sharp edges as when the fans were found. */
+      MEM_freeN(edge_to_loops);
+    }
+    else {
+      MEM_SAFE_FREE(smooth_fans->edge_to_loops);
+      MEM_SAFE_FREE(smooth_fans->fans);
+      smooth_fans->edge_to_loops = edge_to_loops;
+      smooth_fans->fans = loop_split_fans_find(&common_data, &smooth_fans->fans_len);
+    }
+    edge_to_loops = NULL;
+    common_data.edge_to_loops = smooth_fans->edge_to_loops;
 
-    BLI_task_pool_free(task_pool);
+    fans = smooth_fans->fans;
+    fans_len = smooth_fans->fans_len;
   }
+  else {
+    /* This first loop check which edges are actually smooth, and compute edge vectors. */
+    mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
 
-  MEM_freeN(edge_to_loops);
-  if (!r_loop_to_poly) {
+    fans_local = loop_split_fans_find(&common_data, &fans_len);
+    fans = fans_local;
+  }
+
+  loop_split_fans_compute(&common_data, fans, fans_len);
+
+  MEM_SAFE_FREE(fans_local);
+  MEM_SAFE_FREE(edge_to_loops);
+  if (loop_to_poly && !r_loop_to_poly) {
     MEM_freeN(loop_to_poly);
   }
 
@@ -0,0 +1,145 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BLI_array.hh"
+#include "BLI_float3.hh"
+#include "BLI_math_base.h"
+#include "BLI_math_vector.h"
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+namespace blender::bke::tests {
+
+/* Enough loops for the smooth fans to be computed in parallel. */
+static const int GRID_SIZE = 64;
+
+/* A grid of smooth quads folded along its middle column. */
+static Mesh *folded_grid_create()
+{
+  const int verts_len = (GRID_SIZE + 1) * (GRID_SIZE + 1);
+  const int polys_len = GRID_SIZE * GRID_SIZE;
+  Mesh *mesh = BKE_mesh_new_nomain(verts_len, 0, 0, polys_len * 4, polys_len);
+  for (int y = 0; y <= GRID_SIZE; y++) {
+    for (int x = 0; x <= GRID_SIZE; x++) {
+      MVert *mv = &mesh->mvert[y * (GRID_SIZE + 1) + x];
+      mv->co[0] = (float)x;
+      mv->co[1] = (float)y;
+    }
+  }
+  for (int y = 0; y < GRID_SIZE; y++) {
+    for (int x = 0; x < GRID_SIZE; x++) {
+      const int poly_index = y * GRID_SIZE + x;
+      MPoly *mp = &mesh->mpoly[poly_index];
+      mp->loopstart = poly_index * 4;
+      mp->totloop = 4;
+      mp->flag = ME_SMOOTH;
+      MLoop *ml = &mesh->mloop[mp->loopstart];
+      ml[0].v = y * (GRID_SIZE + 1) + x;
+      ml[1].v = y * (GRID_SIZE + 1) + x + 1;
+      ml[2].v = (y + 1) * (GRID_SIZE + 1) + x + 1;
+      ml[3].v = (y + 1) * (GRID_SIZE + 1) + x;
+    }
+  }
+  BKE_mesh_calc_edges(mesh, false, false);
+  return mesh;
+}
+
+/* Fold the grid so neighboring faces at the middle column are \a angle apart. */
+static void folded_grid_set_angle(Mesh *mesh, const float angle)
+{
+  const float slope = tanf(angle * 0.5f);
+  for (int i = 0; i < mesh->totvert; i++) {
+    MVert *mv = &mesh->mvert[i];
+    mv->co[2] = fabsf(mv->co[0] - GRID_SIZE / 2) * slope;
+  }
+}
+
+static void loop_normals_calc(Mesh *mesh,
+                              const float split_angle,
+                              MeshSmoothFans **smooth_fans_cache,
+                              MutableSpan<float3> r_loop_normals)
+{
+  Array<float3> poly_normals(mesh->totpoly);
+  BKE_mesh_calc_normals_poly(mesh->mvert,
+                             nullptr,
+                             mesh->totvert,
+                             mesh->mloop,
+                             mesh->mpoly,
+                             mesh->totloop,
+                             mesh->totpoly,
+                             (float(*)[3])poly_normals.data(),
+                             false);
+  BKE_mesh_normals_loop_split_ex(mesh->mvert,
+                                 mesh->totvert,
+                                 mesh->medge,
+                                 mesh->totedge,
+                                 mesh->mloop,
+                                 (float(*)[3])r_loop_normals.data(),
+                                 mesh->totloop,
+                                 mesh->mpoly,
+                                 (const float(*)[3])poly_normals.data(),
+                                 mesh->totpoly,
+                                 true,
+                                 split_angle,
+                                 nullptr,
+                                 nullptr,
+                                 nullptr,
+                                 smooth_fans_cache);
+}
+
+class MeshEvaluateTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+};
+
+TEST_F(MeshEvaluateTest, LoopSplitSmoothFansCache)
+{
+  Mesh *mesh = folded_grid_create();
+  const float split_angle = DEG2RADF(30.0f);
+  MeshSmoothFans *smooth_fans = nullptr;
+  Array<float3> loop_normals(mesh->totloop);
+  Array<float3> loop_normals_cached(mesh->totloop);
+
+  /* Below the split angle, then across it both ways, then moving without crossing it. */
+  const float angles[] = {
+      DEG2RADF(20.0f), DEG2RADF(40.0f), DEG2RADF(45.0f), DEG2RADF(20.0f), DEG2RADF(10.0f)};
+  for (const float angle : angles) {
+    folded_grid_set_angle(mesh, angle);
+    loop_normals_calc(mesh, split_angle, nullptr, loop_normals);
+    loop_normals_calc(mesh, split_angle, &smooth_fans, loop_normals_cached);
+    EXPECT_NE(smooth_fans, nullptr);
+    for (int i = 0; i < mesh->totloop; i++) {
+      EXPECT_V3_NEAR(loop_normals[i], loop_normals_cached[i], 1e-6f);
+    }
+
+    /* The faces of the fold share the normal of their vertex unless it is sharp. */
+    const int poly_left = GRID_SIZE / 2 - 1;
+    const MPoly *mp = &mesh->mpoly[poly_left];
+    const float3 normal_left = loop_normals_cached[mp->loopstart + 1];
+    const float3 normal_right = loop_normals_cached[mesh->mpoly[poly_left + 1].loopstart];
+    EXPECT_EQ(mesh->mloop[mp->loopstart + 1].v,
+              mesh->mloop[mesh->mpoly[poly_left + 1].loopstart].v);
+    if (angle < split_angle) {
+      EXPECT_V3_NEAR(normal_left, normal_right, 1e-6f);
+    }
+    else {
+      EXPECT_GT(len_v3v3(normal_left, normal_right), 0.1f);
+    }
+  }
+
+  BKE_mesh_smooth_fans_free(smooth_fans);
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::bke::tests
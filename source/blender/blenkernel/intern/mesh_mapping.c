@@ -23,12 +23,16 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "DNA_meshdata_types.h"
 #include "DNA_vec_types.h"
 
 #include "BLI_bitmap.h"
 #include "BLI_buffer.h"
 #include "BLI_math.h"
+#include "BLI_sort_utils.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_customdata.h"
@@ -194,6 +198,202 @@ void BKE_mesh_uv_vert_map_free(UvVertMap *vmap)
   }
 }
 
+/* Parallel map creation.
+ *
+ * Maps are created with a counting sort: the users of every element are counted,
+ * a prefix sum of the counts gives the start of the list of every element,
+ * then the users are written into their lists.
+ *
+ * For large meshes every step runs in parallel over blocks of items. Counting and writing the
+ * users then use atomics, writing the lists in any order, so the lists are sorted afterwards
+ * to give the same result as a single thread. */
+
+/* Only use multiple threads for more users than this. */
+#define MESH_MAP_PARALLEL_THRESHOLD 10000
+/* Number of items (polys, edges or map elements) handled by one task. */
+#define MESH_MAP_BLOCK_LEN 4096
+
+typedef struct MeshElemMapCreateData {
+  MeshElemMap *map;
+  int *indices;
+  int map_len;
+
+  const MPoly *mpoly;
+  const MLoop *mloop;
+  const MEdge *medge;
+  int items_len;
+  /** Map from loops to their edges instead of their vertices. */
+  bool use_loop_edge;
+  /** Store loop indices instead of poly indices. */
+  bool use_loop_index;
+  /** False while counting the users, true while writing them into the lists. */
+  bool do_fill;
+  bool use_threading;
+
+  /** Start of every block of the map, for the prefix sum. */
+  int *block_offsets;
+} MeshElemMapCreateData;
+
+BLI_INLINE void mesh_elem_map_user_add(const MeshElemMapCreateData *data,
+                                       MeshElemMap *map_ele,
+                                       const int index)
+{
+  if (data->use_threading) {
+    if (data->do_fill) {
+      map_ele->indices[atomic_fetch_and_add_int32(&map_ele->count, 1)] = index;
+    }
+    else {
+      atomic_add_and_fetch_int32(&map_ele->count, 1);
+    }
+  }
+  else {
+    if (data->do_fill) {
+      map_ele->indices[map_ele->count] = index;
+    }
+    map_ele->count++;
+  }
+}
+
+static void mesh_elem_map_poly_cb(void *__restrict userdata,
+                                  const int block,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const MeshElemMapCreateData *data = userdata;
+  const int start = block * MESH_MAP_BLOCK_LEN;
+  const int end = min_ii(start + MESH_MAP_BLOCK_LEN, data->items_len);
+  for (int i = start; i < end; i++) {
+    const MPoly *mp = &data->mpoly[i];
+    const int loopend = mp->loopstart + mp->totloop;
+    for (int j = mp->loopstart; j < loopend; j++) {
+      const MLoop *ml = &data->mloop[j];
+      MeshElemMap *map_ele = &data->map[data->use_loop_edge ? ml->e : ml->v];
+      mesh_elem_map_user_add(data, map_ele, data->use_loop_index ? j : i);
+    }
+  }
+}
+
+static void mesh_elem_map_edge_cb(void *__restrict userdata,
+                                  const int block,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const MeshElemMapCreateData *data = userdata;
+  const int start = block * MESH_MAP_BLOCK_LEN;
+  const int end = min_ii(start + MESH_MAP_BLOCK_LEN, data->items_len);
+  for (int i = start; i < end; i++) {
+    const MEdge *med = &data->medge[i];
+    mesh_elem_map_user_add(data, &data->map[med->v1], i);
+    mesh_elem_map_user_add(data, &data->map[med->v2], i);
+  }
+}
+
+static void mesh_elem_map_offsets_sum_cb(void *__restrict userdata,
+                                         const int block,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const MeshElemMapCreateData *data = userdata;
+  const int start = block * MESH_MAP_BLOCK_LEN;
+  const int end = min_ii(start + MESH_MAP_BLOCK_LEN, data->map_len);
+  int sum = 0;
+  for (int i = start; i < end; i++) {
+    sum += data->map[i].count;
+  }
+  data->block_offsets[block] = sum;
+}
+
+static void mesh_elem_map_offsets_assign_cb(void *__restrict userdata,
+                                            const int block,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const MeshElemMapCreateData *data = userdata;
+  const int start = block * MESH_MAP_BLOCK_LEN;
+  const int end = min_ii(start + MESH_MAP_BLOCK_LEN, data->map_len);
+  int *index_iter = &data->indices[data->block_offsets[block]];
+  for (int i = start; i < end; i++) {
+    data->map[i].indices = index_iter;
+    index_iter += data->map[i].count;
+
+    /* Reset 'count' for use as index when writing the users. */
+    data->map[i].count = 0;
+  }
+}
+
+static void mesh_elem_map_sort_cb(void *__restrict userdata,
+                                  const int block,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const MeshElemMapCreateData *data = userdata;
+  const int start = block * MESH_MAP_BLOCK_LEN;
+  const int end = min_ii(start + MESH_MAP_BLOCK_LEN, data->map_len);
+  for (int i = start; i < end; i++) {
+    int *indices = data->map[i].indices;
+    const int count = data->map[i].count;
+    if (count > 32) {
+      qsort(indices, (size_t)count, sizeof(*indices), BLI_sortutil_cmp_int);
+      continue;
+    }
+    /* Insertion sort, lists are short and often sorted already. */
+    for (int j = 1; j < count; j++) {
+      const int index = indices[j];
+      int k = j;
+      for (; k > 0 && indices[k - 1] > index; k--) {
+        indices[k] = indices[k - 1];
+      }
+      indices[k] = index;
+    }
+  }
+}
+
+/**
+ * Count the users, assign the lists from the prefix sum of the counts and write the users.
+ *
+ * \param items_len: The number of items passed to \a func (polys or edges).
+ * \param users_len: The total number of users, used to decide on threading.
+ */
+static void mesh_elem_map_create_parallel(MeshElemMapCreateData *data,
+                                          const int items_len,
+                                          const int users_len,
+                                          TaskParallelRangeFunc func)
+{
+  data->items_len = items_len;
+  data->use_threading = (users_len > MESH_MAP_PARALLEL_THRESHOLD) &&
+                        (BLI_task_scheduler_num_threads() > 1);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = data->use_threading;
+  settings.min_iter_per_thread = 1;
+
+  const int item_blocks_len = (items_len + MESH_MAP_BLOCK_LEN - 1) / MESH_MAP_BLOCK_LEN;
+  const int map_blocks_len = (data->map_len + MESH_MAP_BLOCK_LEN - 1) / MESH_MAP_BLOCK_LEN;
+
+  /* Count the users of every element. */
+  data->do_fill = false;
+  BLI_task_parallel_range(0, item_blocks_len, data, func, &settings);
+
+  /* Prefix sum of the counts, in blocks. */
+  data->block_offsets = MEM_mallocN(sizeof(*data->block_offsets) * (size_t)(map_blocks_len + 1),
+                                    __func__);
+  BLI_task_parallel_range(0, map_blocks_len, data, mesh_elem_map_offsets_sum_cb, &settings);
+  int offset = 0;
+  for (int block = 0; block < map_blocks_len; block++) {
+    const int block_sum = data->block_offsets[block];
+    data->block_offsets[block] = offset;
+    offset += block_sum;
+  }
+  BLI_task_parallel_range(0, map_blocks_len, data, mesh_elem_map_offsets_assign_cb, &settings);
+  MEM_freeN(data->block_offsets);
+  data->block_offsets = NULL;
+
+  /* Write the users into their lists. */
+  data->do_fill = true;
+  BLI_task_parallel_range(0, item_blocks_len, data, func, &settings);
+
+  /* A single thread writes the users in order already. */
+  if (data->use_threading) {
+    BLI_task_parallel_range(0, map_blocks_len, data, mesh_elem_map_sort_cb, &settings);
+  }
+}
+
 /**
  * Generates a map where the key is the vertex and the value is a list
  * of polys or loops that use that vertex as a corner. The lists are allocated
@@ -210,44 +410,19 @@ static void mesh_vert_poly_or_loop_map_create(MeshElemMap **r_map,
                                               int totloop,
                                               const bool do_loops)
 {
-  MeshElemMap *map = MEM_callocN(sizeof(MeshElemMap) * (size_t)totvert, __func__);
-  int *indices, *index_iter;
-  int i, j;
-
-  indices = index_iter = MEM_mallocN(sizeof(int) * (size_t)totloop, __func__);
-
-  /* Count number of polys for each vertex */
-  for (i = 0; i < totpoly; i++) {
-    const MPoly *p = &mpoly[i];
-
-    for (j = 0; j < p->totloop; j++) {
-      map[mloop[p->loopstart + j].v].count++;
-    }
-  }
-
-  /* Assign indices mem */
-  for (i = 0; i < totvert; i++) {
-    map[i].indices = index_iter;
-    index_iter += map[i].count;
-
-    /* Reset 'count' for use as index in last loop */
-    map[i].count = 0;
-  }
-
-  /* Find the users */
-  for (i = 0; i < totpoly; i++) {
-    const MPoly *p = &mpoly[i];
-
-    for (j = 0; j < p->totloop; j++) {
-      unsigned int v = mloop[p->loopstart + j].v;
-
-      map[v].indices[map[v].count] = do_loops ? p->loopstart + j : i;
-      map[v].count++;
-    }
-  }
-
-  *r_map = map;
-  *r_mem = indices;
+  MeshElemMapCreateData data = {
+      .map = MEM_callocN(sizeof(MeshElemMap) * (size_t)totvert, __func__),
+      .indices = MEM_mallocN(sizeof(int) * (size_t)totloop, __func__),
+      .map_len = totvert,
+      .mpoly = mpoly,
+      .mloop = mloop,
+      .use_loop_index = do_loops,
+  };
+
+  mesh_elem_map_create_parallel(&data, totpoly, totloop, mesh_elem_map_poly_cb);
+
+  *r_map = data.map;
+  *r_mem = data.indices;
 }
 
 /**
@@ -339,40 +514,17 @@ void BKE_mesh_vert_looptri_map_create(MeshElemMap **r_map,
 void BKE_mesh_vert_edge_map_create(
     MeshElemMap **r_map, int **r_mem, const MEdge *medge, int totvert, int totedge)
 {
-  MeshElemMap *map = MEM_callocN(sizeof(MeshElemMap) * (size_t)totvert, "vert-edge map");
-  int *indices = MEM_mallocN(sizeof(int[2]) * (size_t)totedge, "vert-edge map mem");
-  int *i_pt = indices;
+  MeshElemMapCreateData data = {
+      .map = MEM_callocN(sizeof(MeshElemMap) * (size_t)totvert, "vert-edge map"),
+      .indices = MEM_mallocN(sizeof(int[2]) * (size_t)totedge, "vert-edge map mem"),
+      .map_len = totvert,
+      .medge = medge,
+  };
 
-  int i;
-
-  /* Count number of edges for each vertex */
-  for (i = 0; i < totedge; i++) {
-    map[medge[i].v1].count++;
-    map[medge[i].v2].count++;
-  }
-
-  /* Assign indices mem */
-  for (i = 0; i < totvert; i++) {
-    map[i].indices = i_pt;
-    i_pt += map[i].count;
+  mesh_elem_map_create_parallel(&data, totedge, totedge * 2, mesh_elem_map_edge_cb);
 
-    /* Reset 'count' for use as index in last loop */
-    map[i].count = 0;
-  }
-
-  /* Find the users */
-  for (i = 0; i < totedge; i++) {
-    const unsigned int v[2] = {medge[i].v1, medge[i].v2};
-
-    map[v[0]].indices[map[v[0]].count] = i;
-    map[v[1]].indices[map[v[1]].count] = i;
-
-    map[v[0]].count++;
-    map[v[1]].count++;
-  }
-
-  *r_map = map;
-  *r_mem = indices;
+  *r_map = data.map;
+  *r_mem = data.indices;
 }
 
 /**
@@ -490,43 +642,19 @@ void BKE_mesh_edge_poly_map_create(MeshElemMap **r_map,
                                    const MLoop *mloop,
                                    const int totloop)
 {
-  MeshElemMap *map = MEM_callocN(sizeof(MeshElemMap) * (size_t)totedge, "edge-poly map");
-  int *indices = MEM_mallocN(sizeof(int) * (size_t)totloop, "edge-poly map mem");
-  int *index_step;
-  const MPoly *mp;
-  int i;
-
-  /* count face users */
-  for (i = 0, mp = mpoly; i < totpoly; mp++, i++) {
-    const MLoop *ml;
-    int j = mp->totloop;
-    for (ml = &mloop[mp->loopstart]; j--; ml++) {
-      map[ml->e].count++;
-    }
-  }
-
-  /* create offsets */
-  index_step = indices;
-  for (i = 0; i < totedge; i++) {
-    map[i].indices = index_step;
-    index_step += map[i].count;
-
-    /* re-count, using this as an index below */
-    map[i].count = 0;
-  }
-
-  /* assign poly-edge users */
-  for (i = 0, mp = mpoly; i < totpoly; mp++, i++) {
-    const MLoop *ml;
-    int j = mp->totloop;
-    for (ml = &mloop[mp->loopstart]; j--; ml++) {
-      MeshElemMap *map_ele = &map[ml->e];
-      map_ele->indices[map_ele->count++] = i;
-    }
-  }
-
-  *r_map = map;
-  *r_mem = indices;
+  MeshElemMapCreateData data = {
+      .map = MEM_callocN(sizeof(MeshElemMap) * (size_t)totedge, "edge-poly map"),
+      .indices = MEM_mallocN(sizeof(int) * (size_t)totloop, "edge-poly map mem"),
+      .map_len = totedge,
+      .mpoly = mpoly,
+      .mloop = mloop,
+      .use_loop_edge = true,
+  };
+
+  mesh_elem_map_create_parallel(&data, totpoly, totloop, mesh_elem_map_poly_cb);
+
+  *r_map = data.map;
+  *r_mem = data.indices;
 }
 
 /**
@@ -0,0 +1,265 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BLI_timeit.hh"
+
+#include "BKE_mesh_mapping.h"
+#include "BKE_mesh_runtime.h"
+
+namespace blender::bke::tests {
+
+/* A grid of quads, with edges shared between the quads. */
+struct GridMesh {
+  int totvert;
+  std::vector<MEdge> edges;
+  std::vector<MPoly> polys;
+  std::vector<MLoop> loops;
+
+  explicit GridMesh(const int size)
+  {
+    const int verts_x = size + 1;
+    totvert = verts_x * verts_x;
+
+    auto vert_index = [&](int x, int y) { return y * verts_x + x; };
+    auto add_edge = [&](int v1, int v2) {
+      MEdge edge = {};
+      edge.v1 = (uint)v1;
+      edge.v2 = (uint)v2;
+      edges.push_back(edge);
+      return (int)edges.size() - 1;
+    };
+
+    /* Edges along x then along y. */
+    std::vector<int> edges_x(size * verts_x), edges_y(verts_x * size);
+    for (int y = 0; y < verts_x; y++) {
+      for (int x = 0; x < size; x++) {
+        edges_x[y * size + x] = add_edge(vert_index(x, y), vert_index(x + 1, y));
+      }
+    }
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < verts_x; x++) {
+        edges_y[y * verts_x + x] = add_edge(vert_index(x, y), vert_index(x, y + 1));
+      }
+    }
+
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        MPoly poly = {};
+        poly.loopstart = (int)loops.size();
+        poly.totloop = 4;
+        polys.push_back(poly);
+
+        const int corners[4][2] = {
+            {vert_index(x, y), edges_x[y * size + x]},
+            {vert_index(x + 1, y), edges_y[y * verts_x + x + 1]},
+            {vert_index(x + 1, y + 1), edges_x[(y + 1) * size + x]},
+            {vert_index(x, y + 1), edges_y[y * verts_x + x]},
+        };
+        for (const auto &corner : corners) {
+          MLoop loop;
+          loop.v = (uint)corner[0];
+          loop.e = (uint)corner[1];
+          loops.push_back(loop);
+        }
+      }
+    }
+  }
+
+  int totedge() const
+  {
+    return (int)edges.size();
+  }
+  int totpoly() const
+  {
+    return (int)polys.size();
+  }
+  int totloop() const
+  {
+    return (int)loops.size();
+  }
+};
+
+using ExpectedMap = std::vector<std::vector<int>>;
+
+static void expect_map_eq(const MeshElemMap *map, const ExpectedMap &expected)
+{
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(map[i].count, (int)expected[i].size());
+    for (int j = 0; j < map[i].count; j++) {
+      EXPECT_EQ(map[i].indices[j], expected[i][j]);
+    }
+  }
+}
+
+static ExpectedMap expected_vert_poly_or_loop_map(const GridMesh &grid, const bool use_loops)
+{
+  ExpectedMap expected(grid.totvert);
+  for (int i = 0; i < grid.totpoly(); i++) {
+    const MPoly &poly = grid.polys[i];
+    for (int j = poly.loopstart; j < poly.loopstart + poly.totloop; j++) {
+      expected[grid.loops[j].v].push_back(use_loops ? j : i);
+    }
+  }
+  return expected;
+}
+
+static ExpectedMap expected_vert_edge_map(const GridMesh &grid)
+{
+  ExpectedMap expected(grid.totvert);
+  for (int i = 0; i < grid.totedge(); i++) {
+    expected[grid.edges[i].v1].push_back(i);
+    expected[grid.edges[i].v2].push_back(i);
+  }
+  return expected;
+}
+
+static ExpectedMap expected_edge_poly_map(const GridMesh &grid)
+{
+  ExpectedMap expected(grid.totedge());
+  for (int i = 0; i < grid.totpoly(); i++) {
+    const MPoly &poly = grid.polys[i];
+    for (int j = poly.loopstart; j < poly.loopstart + poly.totloop; j++) {
+      expected[grid.loops[j].e].push_back(i);
+    }
+  }
+  return expected;
+}
+
+/* Test a small grid created by a single thread and a large grid created by multiple threads,
+ * which must give the same order as a single thread. */
+static void test_mesh_maps(const int size)
+{
+  const GridMesh grid(size);
+  MeshElemMap *map;
+  int *mem;
+
+  BKE_mesh_vert_poly_map_create(&map,
+                                &mem,
+                                grid.polys.data(),
+                                grid.loops.data(),
+                                grid.totvert,
+                                grid.totpoly(),
+                                grid.totloop());
+  expect_map_eq(map, expected_vert_poly_or_loop_map(grid, false));
+  MEM_freeN(map);
+  MEM_freeN(mem);
+
+  BKE_mesh_vert_loop_map_create(&map,
+                                &mem,
+                                grid.polys.data(),
+                                grid.loops.data(),
+                                grid.totvert,
+                                grid.totpoly(),
+                                grid.totloop());
+  expect_map_eq(map, expected_vert_poly_or_loop_map(grid, true));
+  MEM_freeN(map);
+  MEM_freeN(mem);
+
+  BKE_mesh_vert_edge_map_create(&map, &mem, grid.edges.data(), grid.totvert, grid.totedge());
+  expect_map_eq(map, expected_vert_edge_map(grid));
+  MEM_freeN(map);
+  MEM_freeN(mem);
+
+  BKE_mesh_edge_poly_map_create(&map,
+                                &mem,
+                                grid.edges.data(),
+                                grid.totedge(),
+                                grid.polys.data(),
+                                grid.totpoly(),
+                                grid.loops.data(),
+                                grid.totloop());
+  expect_map_eq(map, expected_edge_poly_map(grid));
+  MEM_freeN(map);
+  MEM_freeN(mem);
+}
+
+TEST(mesh_mapping, MapsSmall)
+{
+  test_mesh_maps(8);
+}
+
+TEST(mesh_mapping, MapsLarge)
+{
+  test_mesh_maps(300);
+}
+
+TEST(mesh_mapping, RuntimeMapsCache)
+{
+  GridMesh grid(16);
+  Mesh mesh = {};
+  BKE_mesh_runtime_reset(&mesh);
+  mesh.mvert = nullptr;
+  mesh.medge = grid.edges.data();
+  mesh.mpoly = grid.polys.data();
+  mesh.mloop = grid.loops.data();
+  mesh.totvert = grid.totvert;
+  mesh.totedge = grid.totedge();
+  mesh.totpoly = grid.totpoly();
+  mesh.totloop = grid.totloop();
+
+  const MeshElemMap *vert_poly_map = BKE_mesh_runtime_vert_poly_map_ensure(&mesh);
+  expect_map_eq(vert_poly_map, expected_vert_poly_or_loop_map(grid, false));
+  expect_map_eq(BKE_mesh_runtime_vert_loop_map_ensure(&mesh),
+                expected_vert_poly_or_loop_map(grid, true));
+  expect_map_eq(BKE_mesh_runtime_vert_edge_map_ensure(&mesh), expected_vert_edge_map(grid));
+  expect_map_eq(BKE_mesh_runtime_edge_poly_map_ensure(&mesh), expected_edge_poly_map(grid));
+
+  /* Maps are only created once. */
+  EXPECT_EQ(BKE_mesh_runtime_vert_poly_map_ensure(&mesh), vert_poly_map);
+
+  BKE_mesh_runtime_clear_cache(&mesh);
+}
+
+/* Performance of the maps of a mesh with 10 million loops. */
+#if 0
+TEST(mesh_mapping, MapsPerformance)
+{
+  const GridMesh grid(1582);
+  MeshElemMap *map;
+  int *mem;
+
+  for (int i = 0; i < 3; i++) {
+    {
+      SCOPED_TIMER("vert poly map");
+      BKE_mesh_vert_poly_map_create(&map,
+                                    &mem,
+                                    grid.polys.data(),
+                                    grid.loops.data(),
+                                    grid.totvert,
+                                    grid.totpoly(),
+                                    grid.totloop());
+    }
+    MEM_freeN(map);
+    MEM_freeN(mem);
+    {
+      SCOPED_TIMER("vert edge map");
+      BKE_mesh_vert_edge_map_create(&map, &mem, grid.edges.data(), grid.totvert, grid.totedge());
+    }
+    MEM_freeN(map);
+    MEM_freeN(mem);
+    {
+      SCOPED_TIMER("edge poly map");
+      BKE_mesh_edge_poly_map_create(&map,
+                                    &mem,
+                                    grid.edges.data(),
+                                    grid.totedge(),
+                                    grid.polys.data(),
+                                    grid.totpoly(),
+                                    grid.loops.data(),
+                                    grid.totloop());
+    }
+    MEM_freeN(map);
+    MEM_freeN(mem);
+  }
+}
+#endif
+
+}  // namespace blender::bke::tests
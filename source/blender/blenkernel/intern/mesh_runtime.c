@@ -33,12 +33,289 @@
 #include "BLI_threads.h"
 
 #include "BKE_bvhutils.h"
+#include "BKE_deform.h"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
 #include "BKE_mesh_runtime.h"
 #include "BKE_shrinkwrap.h"
 #include "BKE_subdiv_ccg.h"
 
+/* -------------------------------------------------------------------- */
+/** \name Mesh Topology Maps
+ *
+ * Maps are cached until the geometry is cleared,
+ * so evaluated meshes only need to create them once.
+ * \{ */
+
+typedef enum eMeshTopologyMapType {
+  MESH_TOPOLOGY_MAP_VERT_POLY = 0,
+  MESH_TOPOLOGY_MAP_VERT_LOOP,
+  MESH_TOPOLOGY_MAP_VERT_EDGE,
+  MESH_TOPOLOGY_MAP_EDGE_POLY,
+} eMeshTopologyMapType;
+#define MESH_TOPOLOGY_MAP_TOT (MESH_TOPOLOGY_MAP_EDGE_POLY + 1)
+
+typedef struct MeshTopologyMaps {
+  MeshElemMap *maps[MESH_TOPOLOGY_MAP_TOT];
+  int *maps_mem[MESH_TOPOLOGY_MAP_TOT];
+} MeshTopologyMaps;
+
+static void mesh_topology_maps_free(Mesh *mesh)
+{
+  MeshTopologyMaps *topology_maps = mesh->runtime.topology_maps;
+  if (topology_maps == NULL) {
+    return;
+  }
+  for (int i = 0; i < MESH_TOPOLOGY_MAP_TOT; i++) {
+    MEM_SAFE_FREE(topology_maps->maps[i]);
+    MEM_SAFE_FREE(topology_maps->maps_mem[i]);
+  }
+  MEM_freeN(topology_maps);
+  mesh->runtime.topology_maps = NULL;
+}
+
+static const MeshElemMap *mesh_topology_map_ensure(Mesh *mesh, const eMeshTopologyMapType type)
+{
+  ThreadMutex *mesh_eval_mutex = (ThreadMutex *)mesh->runtime.eval_mutex;
+  BLI_mutex_lock(mesh_eval_mutex);
+
+  if (mesh->runtime.topology_maps == NULL) {
+    mesh->runtime.topology_maps = MEM_callocN(sizeof(MeshTopologyMaps), __func__);
+  }
+  MeshTopologyMaps *topology_maps = mesh->runtime.topology_maps;
+
+  if (topology_maps->maps[type] == NULL) {
+    MeshElemMap **r_map = &topology_maps->maps[type];
+    int **r_mem = &topology_maps->maps_mem[type];
+    switch (type) {
+      case MESH_TOPOLOGY_MAP_VERT_POLY:
+        BKE_mesh_vert_poly_map_create(r_map,
+                                      r_mem,
+                                      mesh->mpoly,
+                                      mesh->mloop,
+                                      mesh->totvert,
+                                      mesh->totpoly,
+                                      mesh->totloop);
+        break;
+      case MESH_TOPOLOGY_MAP_VERT_LOOP:
+        BKE_mesh_vert_loop_map_create(r_map,
+                                      r_mem,
+                                      mesh->mpoly,
+                                      mesh->mloop,
+                                      mesh->totvert,
+                                      mesh->totpoly,
+                                      mesh->totloop);
+        break;
+      case MESH_TOPOLOGY_MAP_VERT_EDGE:
+        BKE_mesh_vert_edge_map_create(r_map, r_mem, mesh->medge, mesh->totvert, mesh->totedge);
+        break;
+      case MESH_TOPOLOGY_MAP_EDGE_POLY:
+        BKE_mesh_edge_poly_map_create(r_map,
+                                      r_mem,
+                                      mesh->medge,
+                                      mesh->totedge,
+                                      mesh->mpoly,
+                                      mesh->totpoly,
+                                      mesh->mloop,
+                                      mesh->totloop);
+        break;
+    }
+  }
+
+  const MeshElemMap *map = topology_maps->maps[type];
+
+  BLI_mutex_unlock(mesh_eval_mutex);
+
+  return map;
+}
+
+/**
+ * Get a map from every vertex to the polygons using it, see #BKE_mesh_vert_poly_map_create.
+ * The map is owned by the mesh.
+ */
+const MeshElemMap *BKE_mesh_runtime_vert_poly_map_ensure(Mesh *mesh)
+{
+  return mesh_topology_map_ensure(mesh, MESH_TOPOLOGY_MAP_VERT_POLY);
+}
+
+/**
+ * Get a map from every vertex to the loops using it, see #BKE_mesh_vert_loop_map_create.
+ * The map is owned by the mesh.
+ */
+const MeshElemMap *BKE_mesh_runtime_vert_loop_map_ensure(Mesh *mesh)
+{
+  return mesh_topology_map_ensure(mesh, MESH_TOPOLOGY_MAP_VERT_LOOP);
+}
+
+/**
+ * Get a map from every vertex to the edges using it, see #BKE_mesh_vert_edge_map_create.
+ * The map is owned by the mesh.
+ */
+const MeshElemMap *BKE_mesh_runtime_vert_edge_map_ensure(Mesh *mesh)
+{
+  return mesh_topology_map_ensure(mesh, MESH_TOPOLOGY_MAP_VERT_EDGE);
+}
+
+/**
+ * Get a map from every edge to the polygons using it, see #BKE_mesh_edge_poly_map_create.
+ * The map is owned by the mesh.
+ */
+const MeshElemMap *BKE_mesh_runtime_edge_poly_map_ensure(Mesh *mesh)
+{
+  return mesh_topology_map_ensure(mesh, MESH_TOPOLOGY_MAP_EDGE_POLY);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Mesh Deform Weights
+ *
+ * Like the topology maps, the packed weights are cached until the geometry is cleared, so they
+ * are shared by all evaluations of an evaluated mesh, for example on every frame of an armature
+ * animation.
+ * \{ */
+
+static void mesh_deform_weights_free(Mesh *mesh)
+{
+  MeshDeformWeights *deform_weights = mesh->runtime.deform_weights;
+  while (deform_weights) {
+    MeshDeformWeights *next = deform_weights->next;
+    MEM_SAFE_FREE(deform_weights->bone_from_defbase);
+    MEM_SAFE_FREE(deform_weights->vert_offsets);
+    MEM_SAFE_FREE(deform_weights->bone_indices);
+    MEM_SAFE_FREE(deform_weights->weights);
+    MEM_SAFE_FREE(deform_weights->armature_weights);
+    MEM_freeN(deform_weights);
+    deform_weights = next;
+  }
+  mesh->runtime.deform_weights = NULL;
+}
+
+static int mesh_deform_weights_bone_index(const MeshDeformWeights *deform_weights,
+                                          const MDeformWeight *dw)
+{
+  return (dw->def_nr < (uint)deform_weights->defbase_len) ?
+             deform_weights->bone_from_defbase[dw->def_nr] :
+             -1;
+}
+
+static MeshDeformWeights *mesh_deform_weights_create(const MDeformVert *dvert,
+                                                     const int totvert,
+                                                     const int *bone_from_defbase,
+                                                     const int defbase_len,
+                                                     const int armature_def_nr)
+{
+  MeshDeformWeights *deform_weights = MEM_callocN(sizeof(MeshDeformWeights), __func__);
+  deform_weights->defbase_len = defbase_len;
+  if (defbase_len != 0) {
+    deform_weights->bone_from_defbase = MEM_malloc_arrayN(
+        (size_t)defbase_len, sizeof(int), __func__);
+    memcpy(deform_weights->bone_from_defbase, bone_from_defbase, sizeof(int) * defbase_len);
+  }
+  deform_weights->armature_def_nr = armature_def_nr;
+
+  int *vert_offsets = MEM_mallocN(sizeof(int) * (size_t)(totvert + 1), __func__);
+  int totweight = 0;
+  for (int i = 0; i < totvert; i++) {
+    vert_offsets[i] = totweight;
+    for (int j = 0; j < dvert[i].totweight; j++) {
+      totweight += (mesh_deform_weights_bone_index(deform_weights, &dvert[i].dw[j]) != -1);
+    }
+  }
+  vert_offsets[totvert] = totweight;
+
+  int *bone_indices = MEM_malloc_arrayN((size_t)totweight, sizeof(int), __func__);
+  float *weights = MEM_malloc_arrayN((size_t)totweight, sizeof(float), __func__);
+  for (int i = 0; i < totvert; i++) {
+    int offset = vert_offsets[i];
+    for (int j = 0; j < dvert[i].totweight; j++) {
+      const int bone_index = mesh_deform_weights_bone_index(deform_weights, &dvert[i].dw[j]);
+      if (bone_index != -1) {
+        bone_indices[offset] = bone_index;
+        weights[offset] = dvert[i].dw[j].weight;
+        offset++;
+      }
+    }
+  }
+
+  if (armature_def_nr != -1) {
+    float *armature_weights = MEM_malloc_arrayN((size_t)totvert, sizeof(float), __func__);
+    for (int i = 0; i < totvert; i++) {
+      armature_weights[i] = BKE_defvert_find_weight(&dvert[i], armature_def_nr);
+    }
+    deform_weights->armature_weights = armature_weights;
+  }
+
+  deform_weights->vert_offsets = vert_offsets;
+  deform_weights->bone_indices = bone_indices;
+  deform_weights->weights = weights;
+  deform_weights->dvert = dvert;
+  deform_weights->totvert = totvert;
+  return deform_weights;
+}
+
+static bool mesh_deform_weights_matches(const MeshDeformWeights *deform_weights,
+                                        const int *bone_from_defbase,
+                                        const int defbase_len,
+                                        const int armature_def_nr)
+{
+  return deform_weights->defbase_len == defbase_len &&
+         deform_weights->armature_def_nr == armature_def_nr &&
+         (defbase_len == 0 || memcmp(deform_weights->bone_from_defbase,
+                                     bone_from_defbase,
+                                     sizeof(int) * defbase_len) == 0);
+}
+
+/**
+ * Get the vertex group weights of the mesh packed in a single array, or NULL when the mesh has
+ * no vertex groups. The weights are owned by the mesh.
+ *
+ * \param bone_from_defbase: The index of the bone of each vertex group, or -1 for groups that
+ * don't deform. Weights are stored with these indices.
+ * \param armature_def_nr: Group of which the weight of each vertex is stored separately, or -1.
+ *
+ * \note The weights are only updated when the vertex group layer or the number of vertices
+ * changes, only use this for evaluated meshes which weights aren't edited in place.
+ */
+const MeshDeformWeights *BKE_mesh_runtime_deform_weights_ensure(Mesh *mesh,
+                                                                const int *bone_from_defbase,
+                                                                const int defbase_len,
+                                                                const int armature_def_nr)
+{
+  if (mesh->dvert == NULL) {
+    return NULL;
+  }
+
+  ThreadMutex *mesh_eval_mutex = (ThreadMutex *)mesh->runtime.eval_mutex;
+  BLI_mutex_lock(mesh_eval_mutex);
+
+  MeshDeformWeights *deform_weights = mesh->runtime.deform_weights;
+  if (deform_weights != NULL &&
+      (deform_weights->dvert != mesh->dvert || deform_weights->totvert != mesh->totvert)) {
+    mesh_deform_weights_free(mesh);
+    deform_weights = NULL;
+  }
+  /* Typically there is only one, unless several armatures deform the mesh. */
+  while (deform_weights != NULL &&
+         !mesh_deform_weights_matches(
+             deform_weights, bone_from_defbase, defbase_len, armature_def_nr)) {
+    deform_weights = deform_weights->next;
+  }
+  if (deform_weights == NULL) {
+    deform_weights = mesh_deform_weights_create(
+        mesh->dvert, mesh->totvert, bone_from_defbase, defbase_len, armature_def_nr);
+    deform_weights->next = mesh->runtime.deform_weights;
+    mesh->runtime.deform_weights = deform_weights;
+  }
+
+  BLI_mutex_unlock(mesh_eval_mutex);
+
+  return deform_weights;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Mesh Runtime Struct Utils
  * \{ */
@@ -68,6 +345,9 @@ void BKE_mesh_runtime_reset_on_copy(Mesh *mesh, const int UNUSED(flag))
   memset(&runtime->looptris, 0, sizeof(runtime->looptris));
   runtime->bvh_cache = NULL;
   runtime->shrinkwrap_data = NULL;
+  runtime->topology_maps = NULL;
+  runtime->deform_weights = NULL;
+  runtime->smooth_fans = NULL;
 
   mesh->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime eval_mutex");
   BLI_mutex_init(mesh->runtime.eval_mutex);
@@ -240,6 +520,12 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
     mesh->runtime.subdiv_ccg = NULL;
   }
   BKE_shrinkwrap_discard_boundary_data(mesh);
+  mesh_topology_maps_free(mesh);
+  mesh_deform_weights_free(mesh);
+  if (mesh->runtime.smooth_fans != NULL) {
+    BKE_mesh_smooth_fans_free(mesh->runtime.smooth_fans);
+    mesh->runtime.smooth_fans = NULL;
+  }
 }
 
 /** \} */
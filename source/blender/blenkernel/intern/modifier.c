@@ -44,6 +44,7 @@
 #include "BLI_session_uuid.h"
 #include "BLI_string.h"
 #include "BLI_string_utils.h"
+#include "BLI_trace.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -1004,7 +1005,11 @@ struct Mesh *BKE_modifier_modify_mesh(ModifierData *md,
   if (mti->dependsOnNormals && mti->dependsOnNormals(md)) {
     modwrap_dependsOnNormals(me);
   }
-  return mti->modifyMesh(md, ctx, me);
+
+  BLI_TRACE_ZONE_BEGIN(trace_zone, "Modifier", md->name);
+  Mesh *result = mti->modifyMesh(md, ctx, me);
+  BLI_TRACE_ZONE_END(trace_zone);
+  return result;
 }
 
 void BKE_modifier_deform_verts(ModifierData *md,
@@ -1019,7 +1024,10 @@ void BKE_modifier_deform_verts(ModifierData *md,
   if (me && mti->dependsOnNormals && mti->dependsOnNormals(md)) {
     modwrap_dependsOnNormals(me);
   }
+
+  BLI_TRACE_ZONE_BEGIN(trace_zone, "Modifier", md->name);
   mti->deformVerts(md, ctx, me, vertexCos, numVerts);
+  BLI_TRACE_ZONE_END(trace_zone);
 }
 
 void BKE_modifier_deform_vertsEM(ModifierData *md,
@@ -1035,7 +1043,10 @@ void BKE_modifier_deform_vertsEM(ModifierData *md,
   if (me && mti->dependsOnNormals && mti->dependsOnNormals(md)) {
     BKE_mesh_calc_normals(me);
   }
+
+  BLI_TRACE_ZONE_BEGIN(trace_zone, "Modifier", md->name);
   mti->deformVertsEM(md, ctx, em, me, vertexCos, numVerts);
+  BLI_TRACE_ZONE_END(trace_zone);
 }
 
 /* end modifier callback wrappers */
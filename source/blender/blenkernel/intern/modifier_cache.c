@@ -0,0 +1,540 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bke
+ *
+ * The cache stores one entry per modifier of the stack (including virtual modifiers). An entry
+ * remembers the settings the modifier was last evaluated with, and optionally the resulting mesh.
+ * A result can be used when neither the input of the stack nor any modifier up to and including
+ * its own changed since it was stored.
+ *
+ * Cached meshes share their layers with the meshes they were created from and with the copy given
+ * to the following modifier, so storing and using a result doesn't copy any geometry.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "atomic_ops.h"
+
+#include "DNA_customdata_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BLI_hash.h"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_string.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_customdata.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
+
+#include "RNA_access.h"
+
+#include "CLG_log.h"
+
+static CLG_LogRef LOG = {"bke.modifier_cache"};
+
+/* -------------------------------------------------------------------- */
+/** \name Cache Data
+ * \{ */
+
+/** Everything outside of the modifiers that affects the result of the stack. */
+typedef struct ModifierCacheInput {
+  const Mesh *mesh;
+  const Scene *scene;
+  CustomData_MeshMasks final_datamask;
+  int required_mode;
+  int need_mapping;
+  int scene_mode;
+  int simplify_subsurf;
+  int simplify_subsurf_render;
+  int ob_mode;
+  int ob_totcol;
+  int shapenr;
+  int shapeflag;
+  /** Vertex group names are referenced by name in the modifier settings. */
+  uint defbase_hash;
+} ModifierCacheInput;
+
+typedef struct ModifierCacheEntry {
+  /** Copy of the modifier as it was last evaluated. */
+  ModifierData *settings;
+  CustomData_MeshMasks mask;
+  CustomData_MeshMasks next_mask;
+
+  /** Evaluated modifier for the current evaluation. */
+  const ModifierData *md;
+  /** The result can be stored during the current evaluation. */
+  bool is_storable;
+
+  /** Result of the modifier, may be null. */
+  Mesh *mesh;
+  size_t mesh_memory;
+
+  /** Error of the modifier when a result at or after it was stored, may be null. */
+  char *error;
+} ModifierCacheEntry;
+
+typedef struct ModifierStackCache {
+  ModifierCacheInput input;
+  bool has_input;
+
+  ModifierCacheEntry *entries;
+  int entries_len;
+
+  /** Entry with the last usable result for the current evaluation, -1 when there is none. */
+  int hit_index;
+} ModifierStackCache;
+
+static struct {
+  ModifierCacheStats stats;
+} g_modifier_cache = {{0}};
+
+static size_t modifier_cache_limit(void)
+{
+  return (size_t)max_ii(U.modifier_cache_limit, 0) * 1024 * 1024;
+}
+
+bool BKE_modifier_cache_is_enabled(void)
+{
+  return U.modifier_cache_limit > 0;
+}
+
+/* Layers shared with other meshes are not accounted for. */
+static size_t mesh_memory_estimate(const Mesh *mesh)
+{
+  const CustomData *cdata[] = {&mesh->vdata, &mesh->edata, &mesh->ldata, &mesh->pdata};
+  const int elem_num[] = {mesh->totvert, mesh->totedge, mesh->totloop, mesh->totpoly};
+  size_t memory = sizeof(*mesh);
+  for (int i = 0; i < ARRAY_SIZE(cdata); i++) {
+    for (int j = 0; j < cdata[i]->totlayer; j++) {
+      const CustomDataLayer *layer = &cdata[i]->layers[j];
+      if (layer->sharing_info == NULL) {
+        memory += (size_t)CustomData_sizeof(layer->type) * (size_t)elem_num[i];
+      }
+    }
+  }
+  return memory;
+}
+
+static void entry_mesh_free(ModifierCacheEntry *entry)
+{
+  if (entry->mesh) {
+    BKE_id_free(NULL, entry->mesh);
+    entry->mesh = NULL;
+    atomic_sub_and_fetch_z(&g_modifier_cache.stats.memory_used, entry->mesh_memory);
+    entry->mesh_memory = 0;
+  }
+}
+
+static void entry_error_set(ModifierCacheEntry *entry, const char *error)
+{
+  MEM_SAFE_FREE(entry->error);
+  if (error) {
+    entry->error = BLI_strdup(error);
+  }
+}
+
+static void entry_settings_free(ModifierCacheEntry *entry)
+{
+  if (entry->settings) {
+    BKE_modifier_free_ex(entry->settings, LIB_ID_CREATE_NO_MAIN | LIB_ID_CREATE_NO_USER_REFCOUNT);
+    entry->settings = NULL;
+  }
+}
+
+void BKE_modifier_cache_free(Object *ob)
+{
+  ModifierStackCache *cache = ob->runtime.modifier_cache;
+  if (cache == NULL) {
+    return;
+  }
+  for (int i = 0; i < cache->entries_len; i++) {
+    entry_mesh_free(&cache->entries[i]);
+    entry_settings_free(&cache->entries[i]);
+    entry_error_set(&cache->entries[i], NULL);
+  }
+  MEM_SAFE_FREE(cache->entries);
+  MEM_freeN(cache);
+  ob->runtime.modifier_cache = NULL;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Change Detection
+ * \{ */
+
+static void modifier_cache_input_init(ModifierCacheInput *input,
+                                      const Object *ob,
+                                      const Scene *scene,
+                                      const CustomData_MeshMasks *final_datamask,
+                                      const int required_mode,
+                                      const bool need_mapping)
+{
+  /* Compared with #memcmp, clear the padding. */
+  memset(input, 0, sizeof(*input));
+  input->mesh = ob->data;
+  input->scene = scene;
+  input->final_datamask = *final_datamask;
+  input->required_mode = required_mode;
+  input->need_mapping = need_mapping;
+  input->scene_mode = scene->r.mode;
+  input->simplify_subsurf = scene->r.simplify_subsurf;
+  input->simplify_subsurf_render = scene->r.simplify_subsurf_render;
+  input->ob_mode = ob->mode;
+  input->ob_totcol = ob->totcol;
+  input->shapenr = ob->shapenr;
+  input->shapeflag = ob->shapeflag;
+  input->defbase_hash = 0;
+  LISTBASE_FOREACH (const bDeformGroup *, dg, &ob->defbase) {
+    input->defbase_hash = BLI_hash_int_2d(input->defbase_hash, BLI_hash_string(dg->name));
+  }
+}
+
+typedef struct ModifierCacheIDState {
+  /** Any data-block is referenced. */
+  bool has_ids;
+  /** A referenced data-block was changed in the current depsgraph update. */
+  bool is_changed;
+  /** A referenced data-block can't be checked for changes. */
+  bool is_unsupported;
+} ModifierCacheIDState;
+
+static void modifier_cache_id_state_cb(void *user_data,
+                                       Object *UNUSED(ob),
+                                       ID **idpoin,
+                                       int UNUSED(cb_flag))
+{
+  ModifierCacheIDState *state = user_data;
+  const ID *id = *idpoin;
+  if (id == NULL) {
+    return;
+  }
+  state->has_ids = true;
+  /* Changes of the objects in a collection don't tag the collection itself. */
+  if (GS(id->name) == ID_GR) {
+    state->is_unsupported = true;
+  }
+  if (id->recalc & ID_RECALC_ALL) {
+    state->is_changed = true;
+  }
+}
+
+static ModifierCacheIDState modifier_cache_id_state(ModifierData *md, Object *ob)
+{
+  const ModifierTypeInfo *mti = BKE_modifier_get_info(md->type);
+  ModifierCacheIDState state = {false};
+  if (mti->foreachIDLink) {
+    mti->foreachIDLink(md, ob, modifier_cache_id_state_cb, &state);
+  }
+  else if (mti->foreachObjectLink) {
+    /* Each Object can masquerade as an ID, so this should be OK. */
+    mti->foreachObjectLink(md, ob, (ObjectWalkFunc)modifier_cache_id_state_cb, &state);
+  }
+  return state;
+}
+
+/**
+ * Modifiers that depend on more than their settings, input mesh and referenced data-blocks.
+ * Later modifiers can't be cached either, as their input can change at any time.
+ */
+static bool modifier_cache_supports(ModifierData *md)
+{
+  if (ELEM(md->type,
+           eModifierType_Multires,
+           eModifierType_ParticleSystem,
+           eModifierType_Explode,
+           eModifierType_Simulation)) {
+    return false;
+  }
+  const ModifierTypeInfo *mti = BKE_modifier_get_info(md->type);
+  if (mti->dependsOnTime && mti->dependsOnTime(md)) {
+    return false;
+  }
+  return true;
+}
+
+static bool modifier_cache_masks_use_orco(const CDMaskLink *datamasks,
+                                          const CustomData_MeshMasks *final_datamask)
+{
+  /* Orco meshes are evaluated alongside the stack, they aren't cached. */
+  const uint64_t orco_mask = CD_MASK_ORCO | CD_MASK_CLOTH_ORCO;
+  if (final_datamask->vmask & orco_mask) {
+    return true;
+  }
+  for (const CDMaskLink *link = datamasks; link; link = link->next) {
+    if (link->mask.vmask & orco_mask) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool entry_settings_equal(const ModifierCacheEntry *entry,
+                                 Object *ob,
+                                 ModifierData *md,
+                                 const CustomData_MeshMasks *mask,
+                                 const CustomData_MeshMasks *next_mask)
+{
+  if (entry->settings == NULL || entry->settings->type != md->type ||
+      memcmp(&entry->mask, mask, sizeof(*mask)) != 0 ||
+      memcmp(&entry->next_mask, next_mask, sizeof(*next_mask)) != 0) {
+    return false;
+  }
+  /* Compare through RNA rather than the bytes of the modifier, pointers to data owned by the
+   * modifier change whenever the evaluated object is copied again. */
+  PointerRNA ptr_a, ptr_b;
+  RNA_pointer_create(&ob->id, &RNA_Modifier, entry->settings, &ptr_a);
+  RNA_pointer_create(&ob->id, &RNA_Modifier, md, &ptr_b);
+  return RNA_struct_equals(NULL, &ptr_a, &ptr_b, RNA_EQ_STRICT);
+}
+
+static void entry_settings_set(ModifierCacheEntry *entry,
+                               ModifierData *md,
+                               const CustomData_MeshMasks *mask,
+                               const CustomData_MeshMasks *next_mask)
+{
+  const int flag = LIB_ID_CREATE_NO_MAIN | LIB_ID_CREATE_NO_USER_REFCOUNT;
+  entry_settings_free(entry);
+  const ModifierTypeInfo *mti = BKE_modifier_get_info(md->type);
+  entry->settings = MEM_callocN(mti->structSize, mti->structName);
+  entry->settings->type = md->type;
+  BLI_strncpy(entry->settings->name, md->name, sizeof(entry->settings->name));
+  BKE_modifier_copydata_ex(md, entry->settings, flag);
+  entry->mask = *mask;
+  entry->next_mask = *next_mask;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Evaluation
+ * \{ */
+
+/**
+ * Find the last cached result that is still valid, and free all others.
+ *
+ * \param datamasks: The masks of each modifier starting at \a firstmd.
+ * \return The cache for #BKE_modifier_cache_eval_hit and #BKE_modifier_cache_eval_store,
+ * NULL when the stack can't be cached.
+ */
+ModifierStackCache *BKE_modifier_cache_eval_begin(Object *ob,
+                                                  const Scene *scene,
+                                                  ModifierData *firstmd,
+                                                  const CDMaskLink *datamasks,
+                                                  const CustomData_MeshMasks *final_datamask,
+                                                  const int required_mode,
+                                                  const bool need_mapping)
+{
+  if (!BKE_modifier_cache_is_enabled() ||
+      modifier_cache_masks_use_orco(datamasks, final_datamask)) {
+    BKE_modifier_cache_free(ob);
+    return NULL;
+  }
+
+  int entries_len = 0;
+  for (ModifierData *md = firstmd; md; md = md->next) {
+    entries_len++;
+  }
+
+  ModifierStackCache *cache = ob->runtime.modifier_cache;
+  if (cache && cache->entries_len != entries_len) {
+    BKE_modifier_cache_free(ob);
+    cache = NULL;
+  }
+  if (cache == NULL) {
+    cache = MEM_callocN(sizeof(*cache), __func__);
+    cache->entries = MEM_calloc_arrayN(entries_len, sizeof(*cache->entries), __func__);
+    cache->entries_len = entries_len;
+    ob->runtime.modifier_cache = cache;
+  }
+
+  /* Check the input of the stack. */
+  ModifierCacheInput input;
+  modifier_cache_input_init(&input, ob, scene, final_datamask, required_mode, need_mapping);
+  const Mesh *mesh_input = ob->data;
+  bool is_valid = cache->has_input && (memcmp(&input, &cache->input, sizeof(input)) == 0) &&
+                  (mesh_input->id.recalc & ID_RECALC_ALL) == 0;
+  cache->input = input;
+  cache->has_input = true;
+
+  /* Modifiers referencing other objects typically use the transform relative to them. */
+  const bool is_transform_changed = (ob->id.recalc & ID_RECALC_TRANSFORM) != 0;
+  bool is_storable = true;
+  int skipped_len = 0;
+  cache->hit_index = -1;
+
+  const CDMaskLink *md_datamask = datamasks;
+  int i = 0;
+  for (ModifierData *md = firstmd; md; md = md->next, md_datamask = md_datamask->next, i++) {
+    ModifierCacheEntry *entry = &cache->entries[i];
+    const CustomData_MeshMasks *next_mask = md_datamask->next ? &md_datamask->next->mask :
+                                                                final_datamask;
+    const ModifierCacheIDState id_state = modifier_cache_id_state(md, ob);
+
+    is_storable = is_storable && !id_state.is_unsupported && modifier_cache_supports(md);
+    if (is_storable) {
+      const bool is_settings_equal = entry_settings_equal(
+          entry, ob, md, &md_datamask->mask, next_mask);
+      is_valid = is_valid && is_settings_equal && !id_state.is_changed &&
+                 !(id_state.has_ids && is_transform_changed);
+      if (!is_settings_equal) {
+        entry_settings_set(entry, md, &md_datamask->mask, next_mask);
+      }
+    }
+    else {
+      is_valid = false;
+      entry_settings_free(entry);
+    }
+    entry->md = md;
+    entry->is_storable = is_storable;
+
+    if (!is_valid) {
+      entry_mesh_free(entry);
+    }
+    else if (entry->mesh) {
+      cache->hit_index = i;
+    }
+  }
+
+  if (cache->hit_index != -1) {
+    for (ModifierData *md = firstmd; md; md = md->next) {
+      if (BKE_modifier_is_enabled(scene, md, required_mode)) {
+        skipped_len++;
+      }
+      if (md == cache->entries[cache->hit_index].md) {
+        break;
+      }
+    }
+    atomic_add_and_fetch_uint64(&g_modifier_cache.stats.hits, 1);
+    atomic_add_and_fetch_uint64(&g_modifier_cache.stats.modifiers_skipped, (uint64_t)skipped_len);
+    CLOG_INFO(&LOG,
+              1,
+              "%s: starting after modifier \"%s\", skipping %d modifiers",
+              ob->id.name + 2,
+              cache->entries[cache->hit_index].md->name,
+              skipped_len);
+  }
+  else {
+    atomic_add_and_fetch_uint64(&g_modifier_cache.stats.misses, 1);
+  }
+
+  return cache;
+}
+
+/**
+ * \return The modifier to continue the evaluation after, and its cached result in \a r_mesh.
+ * The result must not be modified, only used through a copy referencing its data.
+ *
+ * Errors of the modifiers up to the returned one are restored, as they are cleared before the
+ * evaluation but the modifiers aren't evaluated again.
+ */
+ModifierData *BKE_modifier_cache_eval_hit(ModifierStackCache *cache, const Mesh **r_mesh)
+{
+  if (cache->hit_index == -1) {
+    *r_mesh = NULL;
+    return NULL;
+  }
+  for (int i = 0; i <= cache->hit_index; i++) {
+    const ModifierCacheEntry *entry = &cache->entries[i];
+    if (entry->error) {
+      ModifierData *md = (ModifierData *)entry->md;
+      MEM_SAFE_FREE(md->error);
+      md->error = BLI_strdup(entry->error);
+    }
+  }
+  const ModifierCacheEntry *entry = &cache->entries[cache->hit_index];
+  *r_mesh = entry->mesh;
+  return (ModifierData *)entry->md;
+}
+
+/**
+ * Store the result of a constructive modifier, when it fits in the memory limit.
+ * The cache takes ownership of \a *mesh and replaces it by a copy referencing its data.
+ */
+void BKE_modifier_cache_eval_store(ModifierStackCache *cache,
+                                   const ModifierData *md,
+                                   Mesh **mesh)
+{
+  ModifierCacheEntry *entry = NULL;
+  int entry_index;
+  for (entry_index = 0; entry_index < cache->entries_len; entry_index++) {
+    if (cache->entries[entry_index].md == md) {
+      entry = &cache->entries[entry_index];
+      break;
+    }
+  }
+  /* Keep evaluating modifiers with errors, so the error is reported again. */
+  if (entry == NULL || !entry->is_storable || md->error) {
+    return;
+  }
+  BLI_assert(entry->mesh == NULL);
+
+  const size_t memory = mesh_memory_estimate(*mesh);
+  if (atomic_add_and_fetch_z(&g_modifier_cache.stats.memory_used, memory) >
+      modifier_cache_limit()) {
+    atomic_sub_and_fetch_z(&g_modifier_cache.stats.memory_used, memory);
+    atomic_add_and_fetch_uint64(&g_modifier_cache.stats.over_limit, 1);
+    return;
+  }
+  /* Shared layers stay valid, only data owned outside of meshes has to be copied. */
+  BKE_mesh_duplicate_borrowed_layers(*mesh);
+
+  entry->mesh = *mesh;
+  entry->mesh_memory = memory;
+  *mesh = BKE_mesh_copy_for_eval(entry->mesh, true);
+
+  /* Earlier modifiers may have reported warnings, which have to be shown when using the result. */
+  for (int i = 0; i <= entry_index; i++) {
+    entry_error_set(&cache->entries[i], cache->entries[i].md->error);
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Statistics
+ * \{ */
+
+void BKE_modifier_cache_stats_get(ModifierCacheStats *r_stats)
+{
+  *r_stats = g_modifier_cache.stats;
+}
+
+/**
+ * Reset the counters, the memory in use is kept.
+ */
+void BKE_modifier_cache_stats_reset(void)
+{
+  g_modifier_cache.stats.hits = 0;
+  g_modifier_cache.stats.misses = 0;
+  g_modifier_cache.stats.modifiers_skipped = 0;
+  g_modifier_cache.stats.over_limit = 0;
+}
+
+/** \} */
@@ -0,0 +1,197 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_customdata_types.h"
+#include "DNA_genfile.h"
+#include "DNA_mesh_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BLI_linklist.h"
+#include "BLI_listbase.h"
+#include "BLI_threads.h"
+
+#include "BKE_blender.h"
+#include "BKE_customdata.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
+
+#include "RNA_define.h"
+
+namespace blender::bke::tests {
+
+class ModifierCacheTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+    DNA_sdna_current_init();
+    BKE_blender_globals_init();
+    BKE_idtype_init();
+    BKE_modifier_init();
+    RNA_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BKE_blender_free();
+    RNA_exit();
+    DNA_sdna_current_free();
+    BLI_threadapi_exit();
+  }
+
+ protected:
+  Scene *scene;
+  Object *ob;
+  Mesh *mesh;
+  /* A deform modifier followed by a constructive one. */
+  ModifierData *deform_md;
+  ModifierData *subsurf_md;
+  ModifierStackCache *cache;
+  int limit_prev;
+
+  void SetUp() override
+  {
+    limit_prev = U.modifier_cache_limit;
+    U.modifier_cache_limit = 16;
+    BKE_modifier_cache_stats_reset();
+
+    scene = static_cast<Scene *>(BKE_id_new_nomain(ID_SCE, "Scene"));
+    mesh = BKE_mesh_new_nomain(8, 0, 0, 0, 0);
+    ob = static_cast<Object *>(BKE_id_new_nomain(ID_OB, "Object"));
+    ob->type = OB_MESH;
+    ob->data = mesh;
+
+    deform_md = BKE_modifier_new(eModifierType_Smooth);
+    subsurf_md = BKE_modifier_new(eModifierType_Subsurf);
+    BLI_addtail(&ob->modifiers, deform_md);
+    BLI_addtail(&ob->modifiers, subsurf_md);
+    cache = nullptr;
+  }
+
+  void TearDown() override
+  {
+    BKE_modifier_cache_free(ob);
+    BKE_id_free(nullptr, ob);
+    BKE_id_free(nullptr, mesh);
+    BKE_id_free(nullptr, scene);
+    U.modifier_cache_limit = limit_prev;
+  }
+
+  /* Start an evaluation the way #mesh_calc_modifiers does, returning the modifier to continue
+   * after and its cached result. */
+  ModifierData *eval_begin(const Mesh **r_mesh)
+  {
+    CustomData_MeshMasks final_datamask = CD_MASK_BAREMESH;
+    ModifierData *firstmd = static_cast<ModifierData *>(ob->modifiers.first);
+    CDMaskLink *datamasks = BKE_modifier_calc_data_masks(
+        scene, ob, firstmd, &final_datamask, eModifierMode_Realtime, nullptr, nullptr);
+
+    BKE_modifiers_clear_errors(ob);
+    cache = BKE_modifier_cache_eval_begin(
+        ob, scene, firstmd, datamasks, &final_datamask, eModifierMode_Realtime, false);
+    BLI_linklist_free((LinkNode *)datamasks, nullptr);
+
+    EXPECT_NE(cache, nullptr);
+    return BKE_modifier_cache_eval_hit(cache, r_mesh);
+  }
+
+  /* Store a result for the subdivision modifier of the current evaluation. */
+  void eval_store(const int totvert)
+  {
+    Mesh *result = BKE_mesh_new_nomain(totvert, 0, 0, 0, 0);
+    BKE_modifier_cache_eval_store(cache, subsurf_md, &result);
+    BKE_id_free(nullptr, result);
+  }
+
+  /* Evaluate without a hit and store a result. */
+  void eval_miss_and_store(const int totvert)
+  {
+    const Mesh *cached_mesh;
+    EXPECT_EQ(eval_begin(&cached_mesh), nullptr);
+    eval_store(totvert);
+  }
+};
+
+TEST_F(ModifierCacheTest, HitAfterStore)
+{
+  eval_miss_and_store(32);
+
+  const Mesh *cached_mesh;
+  EXPECT_EQ(eval_begin(&cached_mesh), subsurf_md);
+  ASSERT_NE(cached_mesh, nullptr);
+  EXPECT_EQ(cached_mesh->totvert, 32);
+
+  ModifierCacheStats stats;
+  BKE_modifier_cache_stats_get(&stats);
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+  /* Both the deform and the subdivision modifier are skipped. */
+  EXPECT_EQ(stats.modifiers_skipped, 2);
+  EXPECT_GT(stats.memory_used, 0);
+}
+
+TEST_F(ModifierCacheTest, InvalidateSettings)
+{
+  eval_miss_and_store(32);
+
+  /* Changing an earlier modifier invalidates later results. */
+  ((SmoothModifierData *)deform_md)->repeat += 1;
+  eval_miss_and_store(32);
+
+  ((SubsurfModifierData *)subsurf_md)->levels += 1;
+  const Mesh *cached_mesh;
+  EXPECT_EQ(eval_begin(&cached_mesh), nullptr);
+  EXPECT_EQ(cached_mesh, nullptr);
+}
+
+TEST_F(ModifierCacheTest, InvalidateInput)
+{
+  eval_miss_and_store(32);
+
+  const Mesh *cached_mesh;
+  mesh->id.recalc |= ID_RECALC_GEOMETRY;
+  EXPECT_EQ(eval_begin(&cached_mesh), nullptr);
+
+  /* The invalid result was freed, not only skipped once. */
+  mesh->id.recalc = 0;
+  EXPECT_EQ(eval_begin(&cached_mesh), nullptr);
+  eval_store(32);
+  EXPECT_EQ(eval_begin(&cached_mesh), subsurf_md);
+}
+
+TEST_F(ModifierCacheTest, ErrorsRestoredOnHit)
+{
+  const Mesh *cached_mesh;
+  EXPECT_EQ(eval_begin(&cached_mesh), nullptr);
+  BKE_modifier_set_error(deform_md, "Test warning");
+  eval_store(32);
+
+  /* Errors are cleared when starting the evaluation, the skipped modifier reports it again. */
+  EXPECT_EQ(eval_begin(&cached_mesh), subsurf_md);
+  ASSERT_NE(deform_md->error, nullptr);
+  EXPECT_STREQ(deform_md->error, "Test warning");
+  EXPECT_EQ(subsurf_md->error, nullptr);
+}
+
+TEST_F(ModifierCacheTest, ModifierWithErrorNotStored)
+{
+  const Mesh *cached_mesh;
+  EXPECT_EQ(eval_begin(&cached_mesh), nullptr);
+  BKE_modifier_set_error(subsurf_md, "Test error");
+  eval_store(32);
+
+  EXPECT_EQ(eval_begin(&cached_mesh), nullptr);
+}
+
+}  // namespace blender::bke::tests
@@ -43,6 +43,7 @@ void BKE_multires_subdiv_settings_init(SubdivSettings *settings, const MultiresM
   settings->vtx_boundary_interpolation = SUBDIV_VTX_BOUNDARY_EDGE_ONLY;
   settings->fvar_linear_interpolation = BKE_subdiv_fvar_interpolation_from_uv_smooth(
       mmd->uv_smooth);
+  settings->evaluator_type = BKE_subdiv_evaluator_type_from_userdef();
 }
 
 void BKE_multires_subdiv_mesh_settings_init(SubdivToMeshSettings *mesh_settings,
@@ -110,6 +110,7 @@
 #include "BKE_mesh.h"
 #include "BKE_mesh_wrapper.h"
 #include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_multires.h"
 #include "BKE_node.h"
 #include "BKE_object.h"
@@ -593,6 +594,7 @@ void BKE_object_free_modifiers(Object *ob, const int flag)
 
   /* modifiers may have stored data in the DM cache */
   BKE_object_free_derived_caches(ob);
+  BKE_modifier_cache_free(ob);
 }
 
 void BKE_object_free_shaderfx(Object *ob, const int flag)
@@ -4160,6 +4162,7 @@ void BKE_object_runtime_reset_on_copy(Object *object, const int UNUSED(flag))
   runtime->data_eval = NULL;
   runtime->mesh_deform_eval = NULL;
   runtime->curve_cache = NULL;
+  runtime->modifier_cache = NULL;
 }
 
 /*
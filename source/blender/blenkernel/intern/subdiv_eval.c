@@ -35,9 +35,22 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "opensubdiv_capi_type.h"
 #include "opensubdiv_evaluator_capi.h"
 #include "opensubdiv_topology_refiner_capi.h"
 
+static eOpenSubdivEvaluator opensubdiv_evaluator_from_type(const eSubdivEvaluatorType type)
+{
+  switch (type) {
+    case SUBDIV_EVALUATOR_TYPE_CPU:
+      return OPENSUBDIV_EVALUATOR_CPU;
+    case SUBDIV_EVALUATOR_TYPE_THREADED:
+      return OPENSUBDIV_EVALUATOR_TBB;
+  }
+  BLI_assert(!"Unknown evaluator type");
+  return OPENSUBDIV_EVALUATOR_CPU;
+}
+
 bool BKE_subdiv_eval_begin(Subdiv *subdiv)
 {
   BKE_subdiv_stats_reset(&subdiv->stats, SUBDIV_STATS_EVALUATOR_CREATE);
@@ -48,7 +61,8 @@ bool BKE_subdiv_eval_begin(Subdiv *subdiv)
   }
   if (subdiv->evaluator == NULL) {
     BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_EVALUATOR_CREATE);
-    subdiv->evaluator = openSubdiv_createEvaluatorFromTopologyRefiner(subdiv->topology_refiner);
+    subdiv->evaluator = openSubdiv_createEvaluatorFromTopologyRefiner(
+        subdiv->topology_refiner, opensubdiv_evaluator_from_type(subdiv->settings.evaluator_type));
     BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_EVALUATOR_CREATE);
     if (subdiv->evaluator == NULL) {
       return false;
@@ -273,6 +287,39 @@ void BKE_subdiv_eval_final_point(
   }
 }
 
+/* ============================ Batched queries ============================= */
+
+void BKE_subdiv_eval_limit_points_and_derivatives(Subdiv *subdiv,
+                                                  const OpenSubdiv_PatchCoord *patch_coords,
+                                                  const int num_patch_coords,
+                                                  float (*r_P)[3],
+                                                  float (*r_dPdu)[3],
+                                                  float (*r_dPdv)[3])
+{
+  subdiv->evaluator->evaluatePatchesLimit(subdiv->evaluator,
+                                          patch_coords,
+                                          num_patch_coords,
+                                          (float *)r_P,
+                                          (float *)r_dPdu,
+                                          (float *)r_dPdv);
+  if (r_dPdu != NULL && r_dPdv != NULL) {
+    /* Handle zero derivatives the same way as single point queries do, see
+     * #BKE_subdiv_eval_limit_point_and_derivatives. */
+    for (int i = 0; i < num_patch_coords; i++) {
+      if (is_zero_v3(r_dPdu[i]) || is_zero_v3(r_dPdv[i])) {
+        const OpenSubdiv_PatchCoord *patch_coord = &patch_coords[i];
+        BKE_subdiv_eval_limit_point_and_derivatives(subdiv,
+                                                    patch_coord->ptex_face,
+                                                    patch_coord->u,
+                                                    patch_coord->v,
+                                                    r_P[i],
+                                                    r_dPdu[i],
+                                                    r_dPdv[i]);
+      }
+    }
+  }
+}
+
 /* ===================  Patch queries at given resolution =================== */
 
 /* Move buffer forward by a given number of bytes. */
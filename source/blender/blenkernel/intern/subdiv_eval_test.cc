@@ -0,0 +1,188 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BLI_array.hh"
+#include "BLI_float3.hh"
+#include "BLI_math_vector.h"
+#include "BLI_vector.hh"
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_subdiv.h"
+#include "BKE_subdiv_eval.h"
+#include "BKE_subdiv_mesh.h"
+
+#include "opensubdiv_capi_type.h"
+
+#ifdef WITH_OPENSUBDIV
+namespace blender::bke::tests {
+
+/* A cube with one vertex moved, so the limit surface isn't symmetric. */
+static Mesh *cube_mesh_create()
+{
+  const float co[8][3] = {{-1.0f, -1.0f, -1.0f},
+                          {1.0f, -1.0f, -1.0f},
+                          {1.0f, 1.0f, -1.0f},
+                          {-1.0f, 1.0f, -1.0f},
+                          {-1.0f, -1.0f, 1.0f},
+                          {1.0f, -1.0f, 1.0f},
+                          {1.0f, 1.0f, 1.0f},
+                          {-1.3f, 1.2f, 1.4f}};
+  const int faces[6][4] = {
+      {0, 3, 2, 1}, {4, 5, 6, 7}, {0, 1, 5, 4}, {1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7}};
+
+  Mesh *mesh = BKE_mesh_new_nomain(8, 0, 0, 24, 6);
+  for (int i = 0; i < 8; i++) {
+    copy_v3_v3(mesh->mvert[i].co, co[i]);
+  }
+  for (int i = 0; i < 6; i++) {
+    mesh->mpoly[i].loopstart = i * 4;
+    mesh->mpoly[i].totloop = 4;
+    for (int j = 0; j < 4; j++) {
+      mesh->mloop[i * 4 + j].v = faces[i][j];
+    }
+  }
+  BKE_mesh_calc_edges(mesh, false, false);
+  return mesh;
+}
+
+static Subdiv *subdiv_create(const Mesh *mesh, const eSubdivEvaluatorType evaluator_type)
+{
+  SubdivSettings settings = {false};
+  settings.is_simple = false;
+  settings.is_adaptive = true;
+  settings.level = 3;
+  settings.use_creases = false;
+  settings.vtx_boundary_interpolation = SUBDIV_VTX_BOUNDARY_EDGE_ONLY;
+  settings.fvar_linear_interpolation = SUBDIV_FVAR_LINEAR_INTERPOLATION_ALL;
+  settings.evaluator_type = evaluator_type;
+  Subdiv *subdiv = BKE_subdiv_new_from_mesh(&settings, mesh);
+  EXPECT_NE(subdiv, nullptr);
+  if (subdiv) {
+    EXPECT_TRUE(BKE_subdiv_eval_begin_from_mesh(subdiv, mesh, nullptr));
+  }
+  return subdiv;
+}
+
+class SubdivEvalTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+    BKE_subdiv_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BKE_subdiv_exit();
+  }
+
+ protected:
+  Mesh *mesh;
+  Subdiv *subdiv_cpu;
+  Subdiv *subdiv_threaded;
+
+  void SetUp() override
+  {
+    mesh = cube_mesh_create();
+    subdiv_cpu = subdiv_create(mesh, SUBDIV_EVALUATOR_TYPE_CPU);
+    subdiv_threaded = subdiv_create(mesh, SUBDIV_EVALUATOR_TYPE_THREADED);
+  }
+
+  void TearDown() override
+  {
+    if (subdiv_cpu) {
+      BKE_subdiv_free(subdiv_cpu);
+    }
+    if (subdiv_threaded) {
+      BKE_subdiv_free(subdiv_threaded);
+    }
+    BKE_id_free(nullptr, mesh);
+  }
+};
+
+static const float eps = 1e-5f;
+
+TEST_F(SubdivEvalTest, LimitPointsMatchCPU)
+{
+  ASSERT_NE(subdiv_cpu, nullptr);
+  ASSERT_NE(subdiv_threaded, nullptr);
+
+  /* Enough points for the threaded evaluator to split the work. */
+  const int resolution = 64;
+  Vector<OpenSubdiv_PatchCoord> patch_coords;
+  for (int ptex_face = 0; ptex_face < 6; ptex_face++) {
+    for (int y = 0; y < resolution; y++) {
+      for (int x = 0; x < resolution; x++) {
+        OpenSubdiv_PatchCoord coord;
+        coord.ptex_face = ptex_face;
+        coord.u = x / (float)(resolution - 1);
+        coord.v = y / (float)(resolution - 1);
+        patch_coords.append(coord);
+      }
+    }
+  }
+
+  const int num = patch_coords.size();
+  Array<float3> P_cpu(num), dPdu_cpu(num), dPdv_cpu(num);
+  Array<float3> P_threaded(num), dPdu_threaded(num), dPdv_threaded(num);
+  BKE_subdiv_eval_limit_points_and_derivatives(subdiv_cpu,
+                                               patch_coords.data(),
+                                               num,
+                                               (float(*)[3])P_cpu.data(),
+                                               (float(*)[3])dPdu_cpu.data(),
+                                               (float(*)[3])dPdv_cpu.data());
+  BKE_subdiv_eval_limit_points_and_derivatives(subdiv_threaded,
+                                               patch_coords.data(),
+                                               num,
+                                               (float(*)[3])P_threaded.data(),
+                                               (float(*)[3])dPdu_threaded.data(),
+                                               (float(*)[3])dPdv_threaded.data());
+
+  for (int i = 0; i < num; i++) {
+    EXPECT_V3_NEAR(P_cpu[i], P_threaded[i], eps);
+    EXPECT_V3_NEAR(dPdu_cpu[i], dPdu_threaded[i], eps);
+    EXPECT_V3_NEAR(dPdv_cpu[i], dPdv_threaded[i], eps);
+  }
+
+  /* Batches agree with single point queries. */
+  for (int i = 0; i < num; i += 97) {
+    float3 P;
+    BKE_subdiv_eval_limit_point(
+        subdiv_threaded, patch_coords[i].ptex_face, patch_coords[i].u, patch_coords[i].v, P);
+    EXPECT_V3_NEAR(P, P_cpu[i], eps);
+  }
+}
+
+TEST_F(SubdivEvalTest, SubdivMeshMatchesCPU)
+{
+  ASSERT_NE(subdiv_cpu, nullptr);
+  ASSERT_NE(subdiv_threaded, nullptr);
+
+  SubdivToMeshSettings mesh_settings;
+  mesh_settings.resolution = (1 << 4) + 1;
+  mesh_settings.use_optimal_display = false;
+  Mesh *result_cpu = BKE_subdiv_to_mesh(subdiv_cpu, &mesh_settings, mesh);
+  Mesh *result_threaded = BKE_subdiv_to_mesh(subdiv_threaded, &mesh_settings, mesh);
+  ASSERT_NE(result_cpu, nullptr);
+  ASSERT_NE(result_threaded, nullptr);
+
+  ASSERT_EQ(result_cpu->totvert, result_threaded->totvert);
+  EXPECT_EQ(result_cpu->totpoly, result_threaded->totpoly);
+  for (int i = 0; i < result_cpu->totvert; i++) {
+    EXPECT_V3_NEAR(result_cpu->mvert[i].co, result_threaded->mvert[i].co, eps);
+  }
+
+  BKE_id_free(nullptr, result_cpu);
+  BKE_id_free(nullptr, result_threaded);
+}
+
+}  // namespace blender::bke::tests
+#endif
@@ -41,6 +41,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "opensubdiv_capi_type.h"
+
 /* -------------------------------------------------------------------- */
 /** \name Subdivision Context
  * \{ */
@@ -425,7 +427,12 @@ static void loop_interpolation_end(LoopsForInterpolation *loop_interpolation)
 /** \name TLS
  * \{ */
 
+/* Number of inner vertices which limit surface is evaluated at once. */
+#define INNER_VERTICES_BATCH_SIZE 256
+
 typedef struct SubdivMeshTLS {
+  SubdivMeshContext *ctx;
+
   bool vertex_interpolation_initialized;
   VerticesForInterpolation vertex_interpolation;
   const MPoly *vertex_interpolation_coarse_poly;
@@ -435,37 +442,73 @@ typedef struct SubdivMeshTLS {
   LoopsForInterpolation loop_interpolation;
   const MPoly *loop_interpolation_coarse_poly;
   int loop_interpolation_coarse_corner;
+
+  /* Inner vertices which position and normal are not evaluated yet. Evaluating the limit surface
+   * for many points at once is much cheaper than doing it one point at a time. */
+  int num_inner_vertices;
+  int inner_vertex_indices[INNER_VERTICES_BATCH_SIZE];
+  OpenSubdiv_PatchCoord inner_vertex_patch_coords[INNER_VERTICES_BATCH_SIZE];
 } SubdivMeshTLS;
 
-static void subdiv_mesh_tls_free(void *tls_v)
+static void subdiv_mesh_inner_vertices_flush(SubdivMeshTLS *tls)
 {
-  SubdivMeshTLS *tls = tls_v;
-  if (tls->vertex_interpolation_initialized) {
-    vertex_interpolation_end(&tls->vertex_interpolation);
+  const int num_vertices = tls->num_inner_vertices;
+  if (num_vertices == 0) {
+    return;
   }
-  if (tls->loop_interpolation_initialized) {
-    loop_interpolation_end(&tls->loop_interpolation);
+  SubdivMeshContext *ctx = tls->ctx;
+  Subdiv *subdiv = ctx->subdiv;
+  MVert *subdiv_mvert = ctx->subdiv_mesh->mvert;
+  float P[INNER_VERTICES_BATCH_SIZE][3];
+  float dPdu[INNER_VERTICES_BATCH_SIZE][3], dPdv[INNER_VERTICES_BATCH_SIZE][3];
+  BKE_subdiv_eval_limit_points_and_derivatives(
+      subdiv, tls->inner_vertex_patch_coords, num_vertices, P, dPdu, dPdv);
+  for (int i = 0; i < num_vertices; i++) {
+    const OpenSubdiv_PatchCoord *patch_coord = &tls->inner_vertex_patch_coords[i];
+    MVert *subdiv_vert = &subdiv_mvert[tls->inner_vertex_indices[i]];
+    copy_v3_v3(subdiv_vert->co, P[i]);
+    if (ctx->have_displacement) {
+      float D[3];
+      BKE_subdiv_eval_displacement(
+          subdiv, patch_coord->ptex_face, patch_coord->u, patch_coord->v, dPdu[i], dPdv[i], D);
+      add_v3_v3(subdiv_vert->co, D);
+    }
+    else {
+      float N[3];
+      cross_v3_v3v3(N, dPdu[i], dPdv[i]);
+      normalize_v3(N);
+      normal_float_to_short_v3(subdiv_vert->no, N);
+    }
   }
+  tls->num_inner_vertices = 0;
 }
 
-/** \} */
-
-/* -------------------------------------------------------------------- */
-/** \name Evaluation helper functions
- * \{ */
+static void subdiv_mesh_inner_vertex_add(SubdivMeshTLS *tls,
+                                         const int ptex_face_index,
+                                         const float u,
+                                         const float v,
+                                         const int subdiv_vertex_index)
+{
+  if (tls->num_inner_vertices == INNER_VERTICES_BATCH_SIZE) {
+    subdiv_mesh_inner_vertices_flush(tls);
+  }
+  OpenSubdiv_PatchCoord *patch_coord = &tls->inner_vertex_patch_coords[tls->num_inner_vertices];
+  patch_coord->ptex_face = ptex_face_index;
+  patch_coord->u = u;
+  patch_coord->v = v;
+  tls->inner_vertex_indices[tls->num_inner_vertices] = subdiv_vertex_index;
+  tls->num_inner_vertices++;
+}
 
-static void eval_final_point_and_vertex_normal(Subdiv *subdiv,
-                                               const int ptex_face_index,
-                                               const float u,
-                                               const float v,
-                                               float r_P[3],
-                                               short r_N[3])
+static void subdiv_mesh_tls_free(void *tls_v)
 {
-  if (subdiv->displacement_evaluator == NULL) {
-    BKE_subdiv_eval_limit_point_and_short_normal(subdiv, ptex_face_index, u, v, r_P, r_N);
+  SubdivMeshTLS *tls = tls_v;
+  subdiv_mesh_inner_vertices_flush(tls);
+  if (tls->vertex_interpolation_initialized) {
+    vertex_interpolation_end(&tls->vertex_interpolation);
   }
-  else {
-    BKE_subdiv_eval_final_point(subdiv, ptex_face_index, u, v, r_P);
+  if (tls->loop_interpolation_initialized) {
+    loop_interpolation_end(&tls->loop_interpolation);
   }
 }
 
@@ -780,7 +823,6 @@ static void subdiv_mesh_vertex_inner(const SubdivForeachContext *foreach_context
 {
   SubdivMeshContext *ctx = foreach_context->user_data;
   SubdivMeshTLS *tls = tls_v;
-  Subdiv *subdiv = ctx->subdiv;
   const Mesh *coarse_mesh = ctx->coarse_mesh;
   const MPoly *coarse_mpoly = coarse_mesh->mpoly;
   const MPoly *coarse_poly = &coarse_mpoly[coarse_poly_index];
@@ -789,8 +831,8 @@ static void subdiv_mesh_vertex_inner(const SubdivForeachContext *foreach_context
   MVert *subdiv_vert = &subdiv_mvert[subdiv_vertex_index];
   subdiv_mesh_ensure_vertex_interpolation(ctx, tls, coarse_poly, coarse_corner);
   subdiv_vertex_data_interpolate(ctx, subdiv_vert, &tls->vertex_interpolation, u, v);
-  eval_final_point_and_vertex_normal(
-      subdiv, ptex_face_index, u, v, subdiv_vert->co, subdiv_vert->no);
+  /* Position and normal are evaluated in a batch, when the TLS is full or freed. */
+  subdiv_mesh_inner_vertex_add(tls, ptex_face_index, u, v, subdiv_vertex_index);
   subdiv_mesh_tag_center_vertex(coarse_poly, subdiv_vert, u, v);
 }
 
@@ -1219,6 +1261,7 @@ Mesh *BKE_subdiv_to_mesh(Subdiv *subdiv,
   SubdivForeachContext foreach_context;
   setup_foreach_callbacks(&subdiv_context, &foreach_context);
   SubdivMeshTLS tls = {0};
+  tls.ctx = &subdiv_context;
   foreach_context.user_data = &subdiv_context;
   foreach_context.user_data_tls_size = sizeof(SubdivMeshTLS);
   foreach_context.user_data_tls = &tls;
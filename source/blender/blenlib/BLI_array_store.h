@@ -28,14 +28,30 @@ extern "C" {
 typedef struct BArrayState BArrayState;
 typedef struct BArrayStore BArrayStore;
 
+/** Statistics of the states added to a store, to measure how well arrays are de-duplicated. */
+typedef struct BArrayStoreStats {
+  /** Number of states added. */
+  size_t states_added_num;
+  /** Total size of the arrays added. */
+  size_t size_added;
+  /** Size of the chunks created for the added arrays, the rest of the data is shared. */
+  size_t size_added_unique;
+  /** Time spent adding states, in seconds. */
+  double time_added;
+} BArrayStoreStats;
+
 BArrayStore *BLI_array_store_create(unsigned int stride, unsigned int chunk_count);
 void BLI_array_store_destroy(BArrayStore *bs);
 void BLI_array_store_clear(BArrayStore *bs);
+void BLI_array_store_use_threading_set(BArrayStore *bs, const bool use_threading);
 
 /* find the memory used by all states (expanded & real) */
 size_t BLI_array_store_calc_size_expanded_get(const BArrayStore *bs);
 size_t BLI_array_store_calc_size_compacted_get(const BArrayStore *bs);
 
+void BLI_array_store_stats_get(const BArrayStore *bs, BArrayStoreStats *r_stats);
+void BLI_array_store_stats_add(BArrayStoreStats *stats_a, const BArrayStoreStats *stats_b);
+
 BArrayState *BLI_array_store_state_add(BArrayStore *bs,
                                        const void *data,
                                        const size_t data_len,
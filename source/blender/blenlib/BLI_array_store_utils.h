@@ -25,6 +25,7 @@ extern "C" {
 #endif
 
 struct BArrayStore;
+struct BArrayStoreStats;
 
 struct BArrayStore_AtSize {
   struct BArrayStore **stride_table;
@@ -43,6 +44,9 @@ void BLI_array_store_at_size_calc_memory_usage(struct BArrayStore_AtSize *bs_str
                                                size_t *r_size_expanded,
                                                size_t *r_size_compacted);
 
+void BLI_array_store_at_size_stats_get(struct BArrayStore_AtSize *bs_stride,
+                                       struct BArrayStoreStats *r_stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,244 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * A `blender::ConcurrentMap<Key, Value>` is an unordered associative container that allows adding,
+ * modifying and removing keys from multiple threads at the same time. This is useful for parallel
+ * algorithms that would otherwise have to build a map per thread and merge them afterwards.
+ *
+ * The map is split into a fixed number of shards, each of which is a `blender::Map` protected by
+ * its own mutex. The shard of a key is chosen by the high bits of its hash, within a shard the
+ * same hashing and probing strategies as in a single `blender::Map` are used. With enough shards,
+ * threads rarely wait for each other.
+ *
+ * Some noteworthy information:
+ * - Methods that add, modify or remove keys are thread-safe.
+ * - Lookups and iteration are not synchronized, they may only be used when no thread changes the
+ *   map at the same time. Typically a parallel algorithm has a build phase followed by a lookup
+ *   phase.
+ * - The callbacks of `add_or_modify` run while the shard is locked, so they should be cheap and
+ *   must not access the map.
+ * - Iteration order depends on the order in which keys were added, algorithms that need
+ *   deterministic results should not depend on it.
+ * - Shards can be accessed by index, to process them in parallel.
+ */
+
+#include <mutex>
+
+#include "BLI_array.hh"
+#include "BLI_map.hh"
+
+namespace blender {
+
+template<
+    /** Type of the keys stored in the map, see #Map. */
+    typename Key,
+    /** Type of the value that is stored per key, see #Map. */
+    typename Value,
+    /**
+     * The number of independently locked shards, has to be a power of two. More shards reduce
+     * contention, but add memory overhead for small maps.
+     */
+    int64_t ShardsNum = 64,
+    /** The strategy used to deal with collisions within a shard. */
+    typename ProbingStrategy = DefaultProbingStrategy,
+    /** The hash function, it is used to choose the shard and the slot within the shard. */
+    typename Hash = DefaultHash<Key>,
+    /** The equality operator used to compare keys. */
+    typename IsEqual = DefaultEquality,
+    /** What is stored in the hash table array of every shard. */
+    typename Slot = typename DefaultMapSlot<Key, Value>::type,
+    /** The allocator used by this map. */
+    typename Allocator = GuardedAllocator>
+class ConcurrentMap {
+ public:
+  using ShardMap = Map<Key, Value, 0, ProbingStrategy, Hash, IsEqual, Slot, Allocator>;
+
+ private:
+  /** Keep shards on separate cache lines, so threads using different shards don't interfere. */
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    ShardMap map;
+  };
+
+  Array<Shard, 0, Allocator> shards_;
+  Hash hash_;
+
+ public:
+  ConcurrentMap() : shards_(ShardsNum)
+  {
+  }
+
+  ConcurrentMap(const ConcurrentMap &other) = delete;
+  ConcurrentMap &operator=(const ConcurrentMap &other) = delete;
+
+  /**
+   * Add a key-value pair to the map, when the key does not exist already.
+   * Returns true when the key has been added.
+   */
+  bool add(const Key &key, const Value &value)
+  {
+    return this->add_as(key, value);
+  }
+  bool add(Key &&key, Value &&value)
+  {
+    return this->add_as(std::move(key), std::move(value));
+  }
+  template<typename ForwardKey, typename ForwardValue>
+  bool add_as(ForwardKey &&key, ForwardValue &&value)
+  {
+    Shard &shard = this->shard_for_key(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.map.add_as(std::forward<ForwardKey>(key), std::forward<ForwardValue>(value));
+  }
+
+  /**
+   * Add or modify the value of a key, see #Map::add_or_modify.
+   * Both callbacks are called while the shard of the key is locked.
+   */
+  template<typename CreateValueF, typename ModifyValueF>
+  auto add_or_modify(const Key &key,
+                     const CreateValueF &create_value,
+                     const ModifyValueF &modify_value) -> decltype(create_value(nullptr))
+  {
+    Shard &shard = this->shard_for_key(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.map.add_or_modify(key, create_value, modify_value);
+  }
+
+  /**
+   * Remove the key from the map.
+   * Returns true when the key has been removed, false when it did not exist.
+   */
+  bool remove(const Key &key)
+  {
+    Shard &shard = this->shard_for_key(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.map.remove(key);
+  }
+
+  /**
+   * Returns true when the key is in the map.
+   * Not thread-safe while other threads change the map.
+   */
+  bool contains(const Key &key) const
+  {
+    return this->shard_for_key(key).map.contains(key);
+  }
+
+  /**
+   * Get a pointer to the value corresponding to the key, or null when the key does not exist.
+   * Not thread-safe while other threads change the map.
+   */
+  const Value *lookup_ptr(const Key &key) const
+  {
+    return this->shard_for_key(key).map.lookup_ptr(key);
+  }
+  Value *lookup_ptr(const Key &key)
+  {
+    return this->shard_for_key(key).map.lookup_ptr(key);
+  }
+
+  /**
+   * Get a copy of the value corresponding to the key, or the default when the key does not exist.
+   * Not thread-safe while other threads change the map.
+   */
+  Value lookup_default(const Key &key, const Value &default_value) const
+  {
+    return this->shard_for_key(key).map.lookup_default(key, default_value);
+  }
+
+  /**
+   * Call the function for every key-value pair, one shard after another.
+   * Not thread-safe while other threads change the map.
+   */
+  template<typename FuncT> void foreach_item(const FuncT &func) const
+  {
+    for (const Shard &shard : shards_) {
+      shard.map.foreach_item(func);
+    }
+  }
+
+  /**
+   * Access a single shard, to iterate over the map in parallel.
+   * Not thread-safe while other threads change the map.
+   */
+  static constexpr int64_t shards_num()
+  {
+    return ShardsNum;
+  }
+  const ShardMap &shard(const int64_t index) const
+  {
+    return shards_[index].map;
+  }
+
+  /**
+   * Return the number of key-value pairs in the map.
+   * Not thread-safe while other threads change the map.
+   */
+  int64_t size() const
+  {
+    int64_t size = 0;
+    for (const Shard &shard : shards_) {
+      size += shard.map.size();
+    }
+    return size;
+  }
+
+  bool is_empty() const
+  {
+    return this->size() == 0;
+  }
+
+  /**
+   * Allocate memory such that at least n elements can be added without growing, assuming keys are
+   * spread evenly over the shards. Not thread-safe.
+   */
+  void reserve(const int64_t n)
+  {
+    /* Leave some room for an uneven distribution of keys. */
+    const int64_t n_per_shard = n / ShardsNum + n / ShardsNum / 8;
+    for (Shard &shard : shards_) {
+      shard.map.reserve(n_per_shard);
+    }
+  }
+
+  /**
+   * Remove all key-value pairs. Not thread-safe.
+   */
+  void clear()
+  {
+    for (Shard &shard : shards_) {
+      shard.map.clear();
+    }
+  }
+
+ private:
+  template<typename ForwardKey> Shard &shard_for_key(const ForwardKey &key)
+  {
+    return shards_[concurrent_shard_index<ShardsNum>(hash_(key))];
+  }
+  template<typename ForwardKey> const Shard &shard_for_key(const ForwardKey &key) const
+  {
+    return shards_[concurrent_shard_index<ShardsNum>(hash_(key))];
+  }
+};
+
+}  // namespace blender
@@ -0,0 +1,192 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * A `blender::ConcurrentSet<Key>` is an unordered container for unique keys that allows adding
+ * and removing keys from multiple threads at the same time.
+ *
+ * Like #ConcurrentMap, it is split into a fixed number of shards that are `blender::Set`s
+ * protected by their own mutex, chosen by the high bits of the hash of a key. Methods that add or
+ * remove keys are thread-safe, lookups and iteration may only be used when no thread changes the
+ * set at the same time.
+ */
+
+#include <mutex>
+
+#include "BLI_array.hh"
+#include "BLI_set.hh"
+
+namespace blender {
+
+template<
+    /** Type of the elements that are stored in this set, see #Set. */
+    typename Key,
+    /** The number of independently locked shards, has to be a power of two. */
+    int64_t ShardsNum = 64,
+    /** The strategy used to deal with collisions within a shard. */
+    typename ProbingStrategy = DefaultProbingStrategy,
+    /** The hash function, it is used to choose the shard and the slot within the shard. */
+    typename Hash = DefaultHash<Key>,
+    /** The equality operator used to compare keys. */
+    typename IsEqual = DefaultEquality,
+    /** What is stored in the hash table array of every shard. */
+    typename Slot = typename DefaultSetSlot<Key>::type,
+    /** The allocator used by this set. */
+    typename Allocator = GuardedAllocator>
+class ConcurrentSet {
+ public:
+  using ShardSet = Set<Key, 0, ProbingStrategy, Hash, IsEqual, Slot, Allocator>;
+
+ private:
+  /** Keep shards on separate cache lines, so threads using different shards don't interfere. */
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    ShardSet set;
+  };
+
+  Array<Shard, 0, Allocator> shards_;
+  Hash hash_;
+
+ public:
+  ConcurrentSet() : shards_(ShardsNum)
+  {
+  }
+
+  ConcurrentSet(const ConcurrentSet &other) = delete;
+  ConcurrentSet &operator=(const ConcurrentSet &other) = delete;
+
+  /**
+   * Add a key to the set, when it does not exist already.
+   * Returns true when the key has been added.
+   */
+  bool add(const Key &key)
+  {
+    return this->add_as(key);
+  }
+  bool add(Key &&key)
+  {
+    return this->add_as(std::move(key));
+  }
+  template<typename ForwardKey> bool add_as(ForwardKey &&key)
+  {
+    Shard &shard = this->shard_for_key(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.set.add_as(std::forward<ForwardKey>(key));
+  }
+
+  /**
+   * Remove the key from the set.
+   * Returns true when the key has been removed, false when it did not exist.
+   */
+  bool remove(const Key &key)
+  {
+    Shard &shard = this->shard_for_key(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.set.remove(key);
+  }
+
+  /**
+   * Returns true when the key is in the set.
+   * Not thread-safe while other threads change the set.
+   */
+  bool contains(const Key &key) const
+  {
+    return this->shard_for_key(key).set.contains(key);
+  }
+
+  /**
+   * Call the function for every key, one shard after another.
+   * Not thread-safe while other threads change the set.
+   */
+  template<typename FuncT> void foreach_key(const FuncT &func) const
+  {
+    for (const Shard &shard : shards_) {
+      for (const Key &key : shard.set) {
+        func(key);
+      }
+    }
+  }
+
+  /**
+   * Access a single shard, to iterate over the set in parallel.
+   * Not thread-safe while other threads change the set.
+   */
+  static constexpr int64_t shards_num()
+  {
+    return ShardsNum;
+  }
+  const ShardSet &shard(const int64_t index) const
+  {
+    return shards_[index].set;
+  }
+
+  /**
+   * Return the number of keys in the set.
+   * Not thread-safe while other threads change the set.
+   */
+  int64_t size() const
+  {
+    int64_t size = 0;
+    for (const Shard &shard : shards_) {
+      size += shard.set.size();
+    }
+    return size;
+  }
+
+  bool is_empty() const
+  {
+    return this->size() == 0;
+  }
+
+  /**
+   * Allocate memory such that at least n keys can be added without growing, assuming keys are
+   * spread evenly over the shards. Not thread-safe.
+   */
+  void reserve(const int64_t n)
+  {
+    /* Leave some room for an uneven distribution of keys. */
+    const int64_t n_per_shard = n / ShardsNum + n / ShardsNum / 8;
+    for (Shard &shard : shards_) {
+      shard.set.reserve(n_per_shard);
+    }
+  }
+
+  /**
+   * Remove all keys. Not thread-safe.
+   */
+  void clear()
+  {
+    for (Shard &shard : shards_) {
+      shard.set.clear();
+    }
+  }
+
+ private:
+  template<typename ForwardKey> Shard &shard_for_key(const ForwardKey &key)
+  {
+    return shards_[concurrent_shard_index<ShardsNum>(hash_(key))];
+  }
+  template<typename ForwardKey> const Shard &shard_for_key(const ForwardKey &key) const
+  {
+    return shards_[concurrent_shard_index<ShardsNum>(hash_(key))];
+  }
+};
+
+}  // namespace blender
@@ -258,6 +258,27 @@ template<typename Pointer> struct PointerKeyInfo {
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Concurrent Shards
+ * \{ */
+
+/**
+ * Choose one of `ShardsNum` shards of a concurrent hash table from the hash of a key.
+ *
+ * Slots within a shard are chosen by the low bits of the same hash, so the shard is chosen by the
+ * high bits of the hash scrambled with Fibonacci hashing. This also works for hash functions that
+ * don't use the high bits, like the identity hash of integers.
+ */
+template<int64_t ShardsNum> inline int64_t concurrent_shard_index(const uint64_t hash)
+{
+  BLI_STATIC_ASSERT(ShardsNum >= 2 && is_power_of_2_constexpr(ShardsNum),
+                    "the number of shards has to be a power of two");
+  return static_cast<int64_t>((hash * 11400714819323198485llu) >>
+                              (64 - log2_floor_constexpr(ShardsNum)));
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Hash Table Stats
  *
@@ -122,6 +122,10 @@ typedef bool (*BVHTree_OverlapCallback)(void *userdata, int index_a, int index_b
 /* callback to range search query */
 typedef void (*BVHTree_RangeQuery)(void *userdata, int index, const float co[3], float dist_sq);
 
+/* callback to batched range search query, query_index is the index of co in the batch */
+typedef void (*BVHTree_RangeQueryBatch)(
+    void *userdata, int query_index, int index, const float co[3], float dist_sq);
+
 /* callback to find nearest projected */
 typedef void (*BVHTree_NearestProjectedCallback)(void *userdata,
                                                  int index,
@@ -148,6 +152,8 @@ void BLI_bvhtree_free(BVHTree *tree);
 /* construct: first insert points, then call balance */
 void BLI_bvhtree_insert(BVHTree *tree, int index, const float co[3], int numpoints);
 void BLI_bvhtree_balance(BVHTree *tree);
+/* optional: after balance, build a flattened layout used by the batched queries */
+void BLI_bvhtree_flatten(BVHTree *tree);
 
 /* update: first update points/nodes, then call update_tree to refit the bounding volumes */
 bool BLI_bvhtree_update_node(
@@ -241,6 +247,31 @@ float BLI_bvhtree_bb_raycast(const float bv[6],
 int BLI_bvhtree_range_query(
     BVHTree *tree, const float co[3], float radius, BVHTree_RangeQuery callback, void *userdata);
 
+/* batched queries: answer many queries on the same tree in parallel
+ * (callbacks must be thread-safe!) */
+void BLI_bvhtree_find_nearest_batch(BVHTree *tree,
+                                    const float (*co)[3],
+                                    int co_len,
+                                    BVHTreeNearest *nearest,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata);
+void BLI_bvhtree_ray_cast_batch(BVHTree *tree,
+                                const float (*co)[3],
+                                const float (*dir)[3],
+                                int rays_len,
+                                float radius,
+                                BVHTreeRayHit *hit,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag);
+void BLI_bvhtree_range_query_batch(BVHTree *tree,
+                                   const float (*co)[3],
+                                   int co_len,
+                                   float radius,
+                                   int *r_hits,
+                                   BVHTree_RangeQueryBatch callback,
+                                   void *userdata);
+
 int BLI_bvhtree_find_nearest_projected(BVHTree *tree,
                                        float projmat[4][4],
                                        float winsize[2],
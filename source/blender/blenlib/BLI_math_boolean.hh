@@ -54,6 +54,14 @@ int insphere(
 int insphere_fast(
     const double3 &a, const double3 &b, const double3 &c, const double3 &d, const double3 &e);
 
+/* The filter versions take double approximations (within one ulp, as given by `get_d()`)
+ * of exactly represented coordinates and evaluate the predicate in double arithmetic with
+ * an error bound. They return the sign of the exact predicate if the bound proves it,
+ * and 0 if they are unsure, in which case the exact predicate has to be evaluated. */
+int orient2d_filter(const double2 &a, const double2 &b, const double2 &c);
+int incircle_filter(const double2 &a, const double2 &b, const double2 &c, const double2 &d);
+int orient3d_filter(const double3 &a, const double3 &b, const double3 &c, const double3 &d);
+
 #ifdef WITH_GMP
 int orient2d(const mpq2 &a, const mpq2 &b, const mpq2 &c);
 int incircle(const mpq2 &a, const mpq2 &b, const mpq2 &c, const mpq2 &d);
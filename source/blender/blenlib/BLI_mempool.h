@@ -32,8 +32,10 @@ extern "C" {
 
 struct BLI_mempool;
 struct BLI_mempool_chunk;
+struct BLI_mempool_local;
 
 typedef struct BLI_mempool BLI_mempool;
+typedef struct BLI_mempool_local BLI_mempool_local;
 
 BLI_mempool *BLI_mempool_create(unsigned int esize,
                                 unsigned int totelem,
@@ -62,6 +64,16 @@ void *BLI_mempool_as_arrayN(BLI_mempool *pool,
 void BLI_mempool_set_memory_debug(void);
 #endif
 
+/** Per-thread allocation from pools created with #BLI_MEMPOOL_THREADSAFE. */
+BLI_mempool_local *BLI_mempool_local_create(BLI_mempool *pool) ATTR_WARN_UNUSED_RESULT
+    ATTR_NONNULL(1);
+void BLI_mempool_local_destroy(BLI_mempool_local *local) ATTR_NONNULL(1);
+void *BLI_mempool_local_alloc(BLI_mempool_local *local) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_NONNULL(1);
+void *BLI_mempool_local_calloc(BLI_mempool_local *local) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_NONNULL(1);
+void BLI_mempool_local_free(BLI_mempool_local *local, void *addr) ATTR_NONNULL(1, 2);
+
 /** iteration stuff.  note: this may easy to produce bugs with */
 /* private structure */
 typedef struct BLI_mempool_iter {
@@ -83,6 +95,13 @@ enum {
    * order of allocation when no chunks have been freed.
    */
   BLI_MEMPOOL_ALLOW_ITER = (1 << 0),
+  /** Allow allocating and freeing from multiple threads at once,
+   * using a #BLI_mempool_local for each thread.
+   *
+   * \note the regular alloc and free functions may still be used,
+   * but not while any thread is using a #BLI_mempool_local.
+   */
+  BLI_MEMPOOL_THREADSAFE = (1 << 1),
 };
 
 void BLI_mempool_iternew(BLI_mempool *pool, BLI_mempool_iter *iter) ATTR_NONNULL();
@@ -0,0 +1,81 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * Lightweight tracing of zones (named time ranges), to see where time is spent on every thread.
+ *
+ * Zones are recorded into a ring buffer per thread, so only the latest zones are kept. They are
+ * exported as Chrome trace JSON, which can be opened in `chrome://tracing` or Perfetto.
+ *
+ * Recording only happens after #BLI_trace_start, otherwise a zone costs a single check.
+ * The zone macros can be removed entirely by building without `WITH_TRACE`.
+ */
+
+#include "BLI_compiler_compat.h"
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void BLI_trace_start(void);
+void BLI_trace_stop(void);
+void BLI_trace_clear(void);
+
+char *BLI_trace_json(void);
+bool BLI_trace_write_json(const char *filepath);
+void BLI_trace_write_json_at_exit(const char *filepath);
+
+bool BLI_trace_zone_begin(const char *name, const char *detail);
+void BLI_trace_zone_end(void);
+
+/* Only exposed so #BLI_trace_is_running can be inlined. */
+extern bool bli_trace_is_running;
+
+BLI_INLINE bool BLI_trace_is_running(void)
+{
+  return bli_trace_is_running;
+}
+
+/**
+ * Zones in C code, \a name must be a static string, \a detail is copied and may be NULL:
+ *
+ * \code{.c}
+ * BLI_TRACE_ZONE_BEGIN(zone, "Read File", filepath);
+ * ...
+ * BLI_TRACE_ZONE_END(zone);
+ * \endcode
+ */
+#ifdef WITH_TRACE
+#  define BLI_TRACE_ZONE_BEGIN(zone, name, detail) \
+    const bool zone = BLI_trace_is_running() && BLI_trace_zone_begin(name, detail)
+#  define BLI_TRACE_ZONE_END(zone) \
+    if (zone) { \
+      BLI_trace_zone_end(); \
+    } \
+    ((void)0)
+#else
+#  define BLI_TRACE_ZONE_BEGIN(zone, name, detail) ((void)0)
+#  define BLI_TRACE_ZONE_END(zone) ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
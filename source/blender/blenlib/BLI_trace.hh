@@ -0,0 +1,61 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * Scoped zones for C++ code, see `BLI_trace.h`.
+ */
+
+#include "BLI_trace.h"
+
+namespace blender::trace {
+
+/** Records a zone from construction until destruction, when tracing is running. */
+class ScopedZone {
+ private:
+  bool is_open_;
+
+ public:
+  ScopedZone(const char *name, const char *detail = nullptr)
+      : is_open_(BLI_trace_is_running() && BLI_trace_zone_begin(name, detail))
+  {
+  }
+
+  ~ScopedZone()
+  {
+    if (is_open_) {
+      BLI_trace_zone_end();
+    }
+  }
+
+  ScopedZone(const ScopedZone &other) = delete;
+  ScopedZone &operator=(const ScopedZone &other) = delete;
+};
+
+}  // namespace blender::trace
+
+#ifdef WITH_TRACE
+#  define TRACE_SCOPE(name) blender::trace::ScopedZone trace_scoped_zone(name)
+/** The \a detail expression is only evaluated while tracing is running. */
+#  define TRACE_SCOPE_DETAIL(name, detail) \
+    blender::trace::ScopedZone trace_scoped_zone(name, BLI_trace_is_running() ? (detail) : nullptr)
+#else
+#  define TRACE_SCOPE(name) ((void)0)
+#  define TRACE_SCOPE_DETAIL(name, detail) ((void)0)
+#endif
@@ -40,6 +40,10 @@
 
 #include <assert.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_alloca.h"
@@ -63,6 +67,13 @@
 
 #define MAX_TREETYPE 32
 
+/* Number of children of the flattened nodes used by batched queries,
+ * tested together in groups of 4. */
+#define BVH_FLAT_WIDTH_MAX 8
+#define BVH_FLAT_STACK_SIZE 256
+/* Marks unused children of flattened nodes. */
+#define BVH_FLAT_EMPTY INT_MIN
+
 /* Setting zero so we can catch bugs in BLI_task/KDOPBVH.
  * TODO(sergey): Deduplicate the limits with PBVH from BKE.
  */
@@ -90,12 +101,29 @@ typedef struct BVHNode {
   char main_axis; /* Axis used to split this node */
 } BVHNode;
 
+/**
+ * Flattened copy of the tree for batched queries, see #BLI_bvhtree_flatten.
+ *
+ * Nodes are stored in depth first order, each with the axis aligned bounds of all its
+ * children as structure of arrays, so they can be tested together with SIMD.
+ * Binary trees are collapsed to fill the width, using grandchildren as children.
+ */
+typedef struct BVHFlat {
+  /* Per node: min x, y, z then max x, y, z for each of the `width` children. */
+  float *bounds;
+  /* Per node: index of the child node, `-1 - index` for leafs or #BVH_FLAT_EMPTY. */
+  int *child;
+  int width;
+  int nodes_len;
+} BVHFlat;
+
 /* keep under 26 bytes for speed purposes */
 struct BVHTree {
   BVHNode **nodes;
   BVHNode *nodearray;  /* pre-alloc branch nodes */
   BVHNode **nodechild; /* pre-alloc children for nodes */
   float *nodebv;       /* pre-alloc bounding-volumes for nodes */
+  BVHFlat *flat;       /* optional layout for batched queries */
   float epsilon;       /* epslion is used for inflation of the k-dop      */
   int totleaf;         /* leafs */
   int totbranch;
@@ -105,8 +133,8 @@ struct BVHTree {
 };
 
 /* optimization, ensure we stay small */
-BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 48) ||
-                      (sizeof(void *) == 4 && sizeof(BVHTree) <= 32),
+BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 56) ||
+                      (sizeof(void *) == 4 && sizeof(BVHTree) <= 36),
                   "over sized")
 
 /* avoid duplicating vars in BVHOverlapData_Thread */
@@ -865,6 +893,113 @@ static void non_recursive_bvh_div_nodes(const BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Flattened Layout
+ *
+ * A compact copy of the tree, used by the batched queries.
+ * \{ */
+
+static int bvh_flat_build_recursive(BVHFlat *flat, const BVHNode *node)
+{
+  const BVHNode *children[BVH_FLAT_WIDTH_MAX];
+  int children_len = node->totnode;
+  memcpy(children, node->children, sizeof(*children) * (size_t)children_len);
+
+  /* Pull grandchildren up one level at a time while they fit,
+   * so binary trees fill the width of a node. */
+  bool expanded = true;
+  while (expanded) {
+    expanded = false;
+    const int level_len = children_len;
+    for (int i = 0; i < level_len; i++) {
+      const BVHNode *child = children[i];
+      if (child->totnode > 0 && children_len - 1 + child->totnode <= flat->width) {
+        children[i] = child->children[0];
+        for (int j = 1; j < child->totnode; j++) {
+          children[children_len++] = child->children[j];
+        }
+        expanded = true;
+      }
+    }
+  }
+
+  const int node_index = flat->nodes_len++;
+  const int width = flat->width;
+
+  for (int i = 0; i < width; i++) {
+    float *bounds = &flat->bounds[node_index * 6 * width + i];
+    int child_index = BVH_FLAT_EMPTY;
+    if (i < children_len) {
+      const BVHNode *child = children[i];
+      for (int axis = 0; axis < 3; axis++) {
+        bounds[axis * width] = child->bv[2 * axis];
+        bounds[(axis + 3) * width] = child->bv[2 * axis + 1];
+      }
+      if (child->totnode == 0) {
+        BLI_assert(child->index >= 0);
+        child_index = -1 - child->index;
+      }
+      else {
+        child_index = bvh_flat_build_recursive(flat, child);
+      }
+    }
+    else {
+      for (int axis = 0; axis < 6; axis++) {
+        bounds[axis * width] = 0.0f;
+      }
+    }
+    flat->child[node_index * width + i] = child_index;
+  }
+
+  return node_index;
+}
+
+static void bvh_flat_free(BVHTree *tree)
+{
+  if (tree->flat) {
+    MEM_freeN(tree->flat->bounds);
+    MEM_freeN(tree->flat->child);
+    MEM_freeN(tree->flat);
+    tree->flat = NULL;
+  }
+}
+
+static void bvh_flat_build(BVHTree *tree)
+{
+  /* The bounds use the first 3 axes, like the other queries. All trees but 18-DOP trees
+   * (which start at axis 7) include them, no matter how many axes they have. */
+  if (tree->totbranch == 0 || tree->tree_type > BVH_FLAT_WIDTH_MAX || tree->start_axis != 0) {
+    return;
+  }
+
+  BVHFlat *flat = MEM_mallocN(sizeof(*flat), __func__);
+  flat->width = (tree->tree_type <= 4) ? 4 : BVH_FLAT_WIDTH_MAX;
+  flat->nodes_len = 0;
+  /* Every flattened node uses at least one branch. */
+  flat->bounds = MEM_mallocN_aligned(
+      sizeof(float) * (size_t)(6 * flat->width * tree->totbranch), 16, __func__);
+  flat->child = MEM_mallocN(sizeof(int) * (size_t)(flat->width * tree->totbranch), __func__);
+
+  bvh_flat_build_recursive(flat, tree->nodes[tree->totleaf]);
+  tree->flat = flat;
+}
+
+/**
+ * Update the bounds after the tree has been refit. The topology is unchanged,
+ * so the depth first walk visits the nodes in the same order and the arrays are reused.
+ */
+static void bvh_flat_refit(BVHTree *tree)
+{
+  BVHFlat *flat = tree->flat;
+  const int nodes_len = flat->nodes_len;
+  flat->nodes_len = 0;
+  bvh_flat_build_recursive(flat, tree->nodes[tree->totleaf]);
+  BLI_assert(flat->nodes_len == nodes_len);
+  UNUSED_VARS_NDEBUG(nodes_len);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree API
  * \{ */
@@ -951,6 +1086,7 @@ void BLI_bvhtree_free(BVHTree *tree)
     MEM_SAFE_FREE(tree->nodearray);
     MEM_SAFE_FREE(tree->nodebv);
     MEM_SAFE_FREE(tree->nodechild);
+    bvh_flat_free(tree);
     MEM_freeN(tree);
   }
 }
@@ -987,6 +1123,19 @@ void BLI_bvhtree_balance(BVHTree *tree)
 #endif
 }
 
+/**
+ * Build a flattened copy of the tree after #BLI_bvhtree_balance, which the batched queries
+ * traverse much faster. It is kept up to date by #BLI_bvhtree_update_tree.
+ *
+ * \note Only supported for trees with a `tree_type` up to 8 which include the first 3 axes,
+ * the batched queries fall back to regular traversal for other trees.
+ */
+void BLI_bvhtree_flatten(BVHTree *tree)
+{
+  bvh_flat_free(tree);
+  bvh_flat_build(tree);
+}
+
 static void bvhtree_node_inflate(const BVHTree *tree, BVHNode *node, const float dist)
 {
   axis_t axis_iter;
@@ -1055,6 +1204,10 @@ void BLI_bvhtree_update_tree(BVHTree *tree)
   for (; index >= root; index--) {
     node_join(tree, *index);
   }
+
+  if (tree->flat) {
+    bvh_flat_refit(tree);
+  }
 }
 /**
  * Number of times #BLI_bvhtree_insert has been called.
@@ -2145,6 +2298,490 @@ int BLI_bvhtree_range_query(
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree_*_batch
+ *
+ * Answer many queries on the same tree, in parallel. Trees flattened with
+ * #BLI_bvhtree_flatten are traversed iteratively with an explicit stack per query,
+ * testing the bounds of a group of 4 children at once. Other trees use the regular
+ * single query functions.
+ *
+ * \{ */
+
+/* Squared distances from co to the bounds of 4 children of a flattened node. */
+static void bvh_flat_nearest_dist_sq(const float *bounds,
+                                     const int width,
+                                     const float co[3],
+                                     float r_dist_sq[4])
+{
+#ifdef __SSE2__
+  __m128 dist_sq = _mm_setzero_ps();
+  for (int axis = 0; axis < 3; axis++) {
+    const __m128 val = _mm_set1_ps(co[axis]);
+    const __m128 bv_min = _mm_load_ps(&bounds[axis * width]);
+    const __m128 bv_max = _mm_load_ps(&bounds[(axis + 3) * width]);
+    const __m128 d = _mm_sub_ps(val, _mm_min_ps(_mm_max_ps(val, bv_min), bv_max));
+    dist_sq = _mm_add_ps(dist_sq, _mm_mul_ps(d, d));
+  }
+  _mm_storeu_ps(r_dist_sq, dist_sq);
+#else
+  for (int i = 0; i < 4; i++) {
+    r_dist_sq[i] = 0.0f;
+    for (int axis = 0; axis < 3; axis++) {
+      const float val = co[axis];
+      const float d = val - min_ff(max_ff(val, bounds[axis * width + i]),
+                                   bounds[(axis + 3) * width + i]);
+      r_dist_sq[i] += d * d;
+    }
+  }
+#endif
+}
+
+/**
+ * Distances along the ray to the bounds of 4 children of a flattened node (expanded by the ray
+ * radius), or #FLT_MAX when they are missed or further away than the current hit.
+ *
+ * Like #ray_nearest_hit, axes the ray is parallel to only test whether the origin is inside the
+ * slab, instead of multiplying with #BVHRayCastData.idot_axis.
+ */
+static void bvh_flat_ray_dist(const float *bounds,
+                              const int width,
+                              const BVHRayCastData *data,
+                              float r_dist[4])
+{
+#ifdef __SSE2__
+  const __m128 radius = _mm_set1_ps(data->ray.radius);
+  __m128 dist_near = _mm_setzero_ps();
+  __m128 dist_far = _mm_set1_ps(data->hit.dist);
+  __m128 miss = _mm_setzero_ps();
+  for (int axis = 0; axis < 3; axis++) {
+    const __m128 origin = _mm_set1_ps(data->ray.origin[axis]);
+    const __m128 bv_min = _mm_sub_ps(_mm_load_ps(&bounds[axis * width]), radius);
+    const __m128 bv_max = _mm_add_ps(_mm_load_ps(&bounds[(axis + 3) * width]), radius);
+    if (data->ray_dot_axis[axis] == 0.0f) {
+      /* axis aligned ray */
+      miss = _mm_or_ps(miss, _mm_cmplt_ps(origin, bv_min));
+      miss = _mm_or_ps(miss, _mm_cmpgt_ps(origin, bv_max));
+      continue;
+    }
+    const __m128 idot = _mm_set1_ps(data->idot_axis[axis]);
+    const __m128 t1 = _mm_mul_ps(_mm_sub_ps(bv_min, origin), idot);
+    const __m128 t2 = _mm_mul_ps(_mm_sub_ps(bv_max, origin), idot);
+    dist_near = _mm_max_ps(dist_near, _mm_min_ps(t1, t2));
+    dist_far = _mm_min_ps(dist_far, _mm_max_ps(t1, t2));
+  }
+  miss = _mm_or_ps(miss, _mm_cmpgt_ps(dist_near, dist_far));
+  const __m128 dist = _mm_or_ps(_mm_and_ps(miss, _mm_set1_ps(FLT_MAX)),
+                                _mm_andnot_ps(miss, dist_near));
+  _mm_storeu_ps(r_dist, dist);
+#else
+  for (int i = 0; i < 4; i++) {
+    float dist_near = 0.0f;
+    float dist_far = data->hit.dist;
+    bool miss = false;
+    for (int axis = 0; axis < 3; axis++) {
+      const float bv_min = bounds[axis * width + i] - data->ray.radius;
+      const float bv_max = bounds[(axis + 3) * width + i] + data->ray.radius;
+      if (data->ray_dot_axis[axis] == 0.0f) {
+        /* axis aligned ray */
+        miss |= (data->ray.origin[axis] < bv_min || data->ray.origin[axis] > bv_max);
+        continue;
+      }
+      const float t1 = (bv_min - data->ray.origin[axis]) * data->idot_axis[axis];
+      const float t2 = (bv_max - data->ray.origin[axis]) * data->idot_axis[axis];
+      dist_near = max_ff(dist_near, min_ff(t1, t2));
+      dist_far = min_ff(dist_far, max_ff(t1, t2));
+    }
+    r_dist[i] = (miss || dist_near > dist_far) ? FLT_MAX : dist_near;
+  }
+#endif
+}
+
+typedef struct BVHFlatStackItem {
+  int node;
+  float dist;
+} BVHFlatStackItem;
+
+typedef struct BVHFlatCandidate {
+  int child;
+  int lane;
+  float dist;
+} BVHFlatCandidate;
+
+/**
+ * Find the used children of a flattened node with a distance below \a dist_max, sorted from
+ * closest to furthest. Returns the number of candidates.
+ */
+static int bvh_flat_candidates_sorted(const int *child,
+                                      const int width,
+                                      const float *dist,
+                                      const float dist_max,
+                                      BVHFlatCandidate r_candidates[BVH_FLAT_WIDTH_MAX])
+{
+  int candidates_len = 0;
+  for (int i = 0; i < width; i++) {
+    if (child[i] == BVH_FLAT_EMPTY || dist[i] >= dist_max) {
+      continue;
+    }
+    /* Insertion sort, there are few candidates. */
+    int j = candidates_len++;
+    for (; j > 0 && r_candidates[j - 1].dist > dist[i]; j--) {
+      r_candidates[j] = r_candidates[j - 1];
+    }
+    r_candidates[j].child = child[i];
+    r_candidates[j].lane = i;
+    r_candidates[j].dist = dist[i];
+  }
+  return candidates_len;
+}
+
+/* Push the branch candidates, furthest first so the closest one is popped first. */
+static void bvh_flat_stack_push_branches(BVHFlatStackItem *stack,
+                                         int *stack_len,
+                                         const BVHFlatCandidate *candidates,
+                                         const int candidates_len)
+{
+  for (int i = candidates_len - 1; i >= 0; i--) {
+    if (candidates[i].child >= 0) {
+      BLI_assert(*stack_len < BVH_FLAT_STACK_SIZE);
+      stack[*stack_len].node = candidates[i].child;
+      stack[*stack_len].dist = candidates[i].dist;
+      (*stack_len)++;
+    }
+  }
+}
+
+static void bvh_flat_find_nearest(const BVHFlat *flat,
+                                  const float co[3],
+                                  BVHTreeNearest *nearest,
+                                  BVHTree_NearestPointCallback callback,
+                                  void *userdata)
+{
+  const int width = flat->width;
+  BVHFlatStackItem stack[BVH_FLAT_STACK_SIZE];
+  int stack_len = 1;
+  stack[0].node = 0;
+  stack[0].dist = 0.0f;
+
+  while (stack_len > 0) {
+    const BVHFlatStackItem item = stack[--stack_len];
+    if (item.dist >= nearest->dist_sq) {
+      continue;
+    }
+
+    const float *bounds = &flat->bounds[item.node * 6 * width];
+    const int *child = &flat->child[item.node * width];
+    float dist_sq[BVH_FLAT_WIDTH_MAX];
+    for (int i = 0; i < width; i += 4) {
+      bvh_flat_nearest_dist_sq(bounds + i, width, co, &dist_sq[i]);
+    }
+
+    BVHFlatCandidate candidates[BVH_FLAT_WIDTH_MAX];
+    const int candidates_len = bvh_flat_candidates_sorted(
+        child, width, dist_sq, nearest->dist_sq, candidates);
+
+    /* Leafs first, they can only make the remaining search smaller. */
+    for (int i = 0; i < candidates_len; i++) {
+      const BVHFlatCandidate *candidate = &candidates[i];
+      if (candidate->child >= 0 || candidate->dist >= nearest->dist_sq) {
+        continue;
+      }
+      const int index = -1 - candidate->child;
+      if (callback) {
+        callback(userdata, index, co, nearest);
+      }
+      else {
+        nearest->index = index;
+        nearest->dist_sq = candidate->dist;
+        for (int axis = 0; axis < 3; axis++) {
+          nearest->co[axis] = min_ff(max_ff(co[axis], bounds[axis * width + candidate->lane]),
+                                     bounds[(axis + 3) * width + candidate->lane]);
+        }
+      }
+    }
+    bvh_flat_stack_push_branches(stack, &stack_len, candidates, candidates_len);
+  }
+}
+
+static void bvh_flat_ray_cast(const BVHFlat *flat, BVHRayCastData *data)
+{
+  const int width = flat->width;
+  BVHFlatStackItem stack[BVH_FLAT_STACK_SIZE];
+  int stack_len = 1;
+  stack[0].node = 0;
+  stack[0].dist = 0.0f;
+
+  while (stack_len > 0) {
+    const BVHFlatStackItem item = stack[--stack_len];
+    if (item.dist >= data->hit.dist) {
+      continue;
+    }
+
+    const float *bounds = &flat->bounds[item.node * 6 * width];
+    const int *child = &flat->child[item.node * width];
+    float dist[BVH_FLAT_WIDTH_MAX];
+    for (int i = 0; i < width; i += 4) {
+      bvh_flat_ray_dist(bounds + i, width, data, &dist[i]);
+    }
+
+    BVHFlatCandidate candidates[BVH_FLAT_WIDTH_MAX];
+    const int candidates_len = bvh_flat_candidates_sorted(
+        child, width, dist, data->hit.dist, candidates);
+
+    for (int i = 0; i < candidates_len; i++) {
+      const BVHFlatCandidate *candidate = &candidates[i];
+      if (candidate->child >= 0 || candidate->dist >= data->hit.dist) {
+        continue;
+      }
+      const int index = -1 - candidate->child;
+      if (data->callback) {
+        data->callback(data->userdata, index, &data->ray, &data->hit);
+      }
+      else {
+        data->hit.index = index;
+        data->hit.dist = candidate->dist;
+        madd_v3_v3v3fl(data->hit.co, data->ray.origin, data->ray.direction, candidate->dist);
+      }
+    }
+    bvh_flat_stack_push_branches(stack, &stack_len, candidates, candidates_len);
+  }
+}
+
+static int bvh_flat_range_query(const BVHFlat *flat,
+                                const float co[3],
+                                const float radius_sq,
+                                const int query_index,
+                                BVHTree_RangeQueryBatch callback,
+                                void *userdata)
+{
+  const int width = flat->width;
+  BVHFlatStackItem stack[BVH_FLAT_STACK_SIZE];
+  int stack_len = 1;
+  int hits = 0;
+  stack[0].node = 0;
+
+  while (stack_len > 0) {
+    const int node = stack[--stack_len].node;
+    const float *bounds = &flat->bounds[node * 6 * width];
+    const int *child = &flat->child[node * width];
+    float dist_sq[BVH_FLAT_WIDTH_MAX];
+    for (int i = 0; i < width; i += 4) {
+      bvh_flat_nearest_dist_sq(bounds + i, width, co, &dist_sq[i]);
+    }
+
+    for (int i = 0; i < width; i++) {
+      if (child[i] == BVH_FLAT_EMPTY || dist_sq[i] >= radius_sq) {
+        continue;
+      }
+      if (child[i] < 0) {
+        hits++;
+        callback(userdata, query_index, -1 - child[i], co, dist_sq[i]);
+      }
+      else {
+        BLI_assert(stack_len < BVH_FLAT_STACK_SIZE);
+        stack[stack_len++].node = child[i];
+      }
+    }
+  }
+  return hits;
+}
+
+typedef struct BVHBatchData {
+  BVHTree *tree;
+  const float (*co)[3];
+  void *userdata;
+
+  /* find nearest */
+  BVHTreeNearest *nearest;
+  BVHTree_NearestPointCallback nearest_callback;
+
+  /* ray cast */
+  const float (*dir)[3];
+  float radius;
+  int flag;
+  BVHTreeRayHit *hit;
+  BVHTree_RayCastCallback raycast_callback;
+
+  /* range query */
+  int *hits;
+  BVHTree_RangeQueryBatch range_callback;
+} BVHBatchData;
+
+static void bvhtree_find_nearest_batch_cb(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHBatchData *data = userdata;
+  BVHTree *tree = data->tree;
+
+  if (tree->flat) {
+    bvh_flat_find_nearest(
+        tree->flat, data->co[i], &data->nearest[i], data->nearest_callback, data->userdata);
+  }
+  else {
+    BLI_bvhtree_find_nearest(
+        tree, data->co[i], &data->nearest[i], data->nearest_callback, data->userdata);
+  }
+}
+
+static void bvhtree_ray_cast_batch_cb(void *__restrict userdata,
+                                      const int i,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHBatchData *data = userdata;
+  BVHTree *tree = data->tree;
+
+  if (tree->flat) {
+    BVHRayCastData ray_data;
+    ray_data.tree = tree;
+    ray_data.callback = data->raycast_callback;
+    ray_data.userdata = data->userdata;
+    copy_v3_v3(ray_data.ray.origin, data->co[i]);
+    copy_v3_v3(ray_data.ray.direction, data->dir[i]);
+    ray_data.ray.radius = data->radius;
+    bvhtree_ray_cast_data_precalc(&ray_data, data->flag);
+    ray_data.hit = data->hit[i];
+
+    bvh_flat_ray_cast(tree->flat, &ray_data);
+
+    data->hit[i] = ray_data.hit;
+  }
+  else {
+    BLI_bvhtree_ray_cast_ex(tree,
+                            data->co[i],
+                            data->dir[i],
+                            data->radius,
+                            &data->hit[i],
+                            data->raycast_callback,
+                            data->userdata,
+                            data->flag);
+  }
+}
+
+typedef struct BVHRangeQueryBatchItem {
+  BVHBatchData *data;
+  int query_index;
+} BVHRangeQueryBatchItem;
+
+static void bvhtree_range_query_batch_item_cb(void *userdata,
+                                              int index,
+                                              const float co[3],
+                                              float dist_sq)
+{
+  BVHRangeQueryBatchItem *item = userdata;
+  item->data->range_callback(item->data->userdata, item->query_index, index, co, dist_sq);
+}
+
+static void bvhtree_range_query_batch_cb(void *__restrict userdata,
+                                         const int i,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHBatchData *data = userdata;
+  BVHTree *tree = data->tree;
+  int hits;
+
+  if (tree->flat) {
+    hits = bvh_flat_range_query(tree->flat,
+                                data->co[i],
+                                data->radius * data->radius,
+                                i,
+                                data->range_callback,
+                                data->userdata);
+  }
+  else {
+    BVHRangeQueryBatchItem item = {data, i};
+    hits = BLI_bvhtree_range_query(
+        tree, data->co[i], data->radius, bvhtree_range_query_batch_item_cb, &item);
+  }
+
+  if (data->hits) {
+    data->hits[i] = hits;
+  }
+}
+
+static void bvhtree_batch_run(BVHBatchData *data, int len, TaskParallelRangeFunc func)
+{
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (len > KDOPBVH_THREAD_LEAF_THRESHOLD);
+  settings.min_iter_per_thread = 64;
+  BLI_task_parallel_range(0, len, data, func, &settings);
+}
+
+/**
+ * Find the nearest node for each of \a co, like #BLI_bvhtree_find_nearest.
+ * \a nearest must be initialized, with the index and squared distance to search within.
+ */
+void BLI_bvhtree_find_nearest_batch(BVHTree *tree,
+                                    const float (*co)[3],
+                                    int co_len,
+                                    BVHTreeNearest *nearest,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata)
+{
+  BVHBatchData data = {
+      .tree = tree,
+      .co = co,
+      .userdata = userdata,
+      .nearest = nearest,
+      .nearest_callback = callback,
+  };
+  bvhtree_batch_run(&data, co_len, bvhtree_find_nearest_batch_cb);
+}
+
+/**
+ * Cast a ray from each of \a co in the direction \a dir, like #BLI_bvhtree_ray_cast_ex.
+ * \a hit must be initialized, with the index and distance to search within.
+ */
+void BLI_bvhtree_ray_cast_batch(BVHTree *tree,
+                                const float (*co)[3],
+                                const float (*dir)[3],
+                                int rays_len,
+                                float radius,
+                                BVHTreeRayHit *hit,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag)
+{
+  BVHBatchData data = {
+      .tree = tree,
+      .co = co,
+      .userdata = userdata,
+      .dir = dir,
+      .radius = radius,
+      .flag = flag,
+      .hit = hit,
+      .raycast_callback = callback,
+  };
+  bvhtree_batch_run(&data, rays_len, bvhtree_ray_cast_batch_cb);
+}
+
+/**
+ * Call \a callback for all nodes within \a radius of each of \a co,
+ * like #BLI_bvhtree_range_query. The number of hits per query is written to \a r_hits
+ * when it is not NULL.
+ */
+void BLI_bvhtree_range_query_batch(BVHTree *tree,
+                                   const float (*co)[3],
+                                   int co_len,
+                                   float radius,
+                                   int *r_hits,
+                                   BVHTree_RangeQueryBatch callback,
+                                   void *userdata)
+{
+  BVHBatchData data = {
+      .tree = tree,
+      .co = co,
+      .userdata = userdata,
+      .radius = radius,
+      .hits = r_hits,
+      .range_callback = callback,
+  };
+  bvhtree_batch_run(&data, co_len, bvhtree_range_query_batch_cb);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree_nearest_projected
  * \{ */
@@ -27,6 +27,8 @@
  * - Freeing chunks.
  * - Iterating over allocated chunks
  *   (optionally when using the #BLI_MEMPOOL_ALLOW_ITER flag).
+ * - Allocating and freeing from multiple threads
+ *   (optionally when using the #BLI_MEMPOOL_THREADSAFE flag).
  */
 
 #include <stdlib.h>
@@ -82,6 +84,12 @@
 /* optimize pool size */
 #define USE_CHUNK_POW2
 
+/**
+ * Number of chunks worth of free elements a #BLI_mempool_local keeps,
+ * before handing them back to the pool for other threads to use.
+ */
+#define LOCAL_FREE_CHUNKS_MAX 2
+
 #ifndef NDEBUG
 static bool mempool_debug_memset = false;
 #endif
@@ -125,7 +133,9 @@ struct BLI_mempool {
   uint flag;
   /* keeps aligned to 16 bits */
 
-  /** Free element list. Interleaved into chunk datas. */
+  /** Free element list. Interleaved into chunk datas.
+   * With #BLI_MEMPOOL_THREADSAFE this is shared between threads,
+   * elements are only pushed on with atomic operations and the whole list taken at once. */
   BLI_freenode *free;
   /** Use to know how many chunks to keep for #BLI_mempool_clear. */
   uint maxchunks;
@@ -135,6 +145,23 @@ struct BLI_mempool {
   /** Number of elements allocated in total. */
   uint totalloc;
 #endif
+  /** Protects the chunk list with #BLI_MEMPOOL_THREADSAFE, see #mempool_chunk_lock. */
+  uint32_t chunk_lock;
+};
+
+/**
+ * Allocation state for a single thread, the free list is only accessed by its owner.
+ */
+struct BLI_mempool_local {
+  BLI_mempool *pool;
+  /** Elements from chunks allocated by this thread or taken from the shared free list. */
+  BLI_freenode *free;
+  /** Elements freed by this thread, reused first and handed back to the pool when too long. */
+  BLI_freenode *freed;
+  BLI_freenode *freed_tail;
+  uint freed_len;
+  /** Elements allocated minus freed, added to #BLI_mempool.totused on destruction. */
+  int totused_delta;
 };
 
 #define MEMPOOL_ELEM_SIZE_MIN (sizeof(void *) * 2)
@@ -184,24 +211,8 @@ static BLI_mempool_chunk *mempool_chunk_alloc(BLI_mempool *pool)
   return MEM_mallocN(sizeof(BLI_mempool_chunk) + (size_t)pool->csize, "BLI_Mempool Chunk");
 }
 
-/**
- * Initialize a chunk and add into \a pool->chunks
- *
- * \param pool: The pool to add the chunk into.
- * \param mpchunk: The new uninitialized chunk (can be malloc'd)
- * \param last_tail: The last element of the previous chunk
- * (used when building free chunks initially)
- * \return The last chunk,
- */
-static BLI_freenode *mempool_chunk_add(BLI_mempool *pool,
-                                       BLI_mempool_chunk *mpchunk,
-                                       BLI_freenode *last_tail)
+static void mempool_chunk_append(BLI_mempool *pool, BLI_mempool_chunk *mpchunk)
 {
-  const uint esize = pool->esize;
-  BLI_freenode *curnode = CHUNK_DATA(mpchunk);
-  uint j;
-
-  /* append */
   if (pool->chunk_tail) {
     pool->chunk_tail->next = mpchunk;
   }
@@ -212,10 +223,34 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool,
 
   mpchunk->next = NULL;
   pool->chunk_tail = mpchunk;
+}
 
-  if (UNLIKELY(pool->free == NULL)) {
-    pool->free = curnode;
+/**
+ * Lock the chunk list, only held while appending a chunk.
+ * Uses atomics directly since this file is also built without the threading API (makesdna).
+ */
+static void mempool_chunk_lock(BLI_mempool *pool)
+{
+  while (atomic_cas_uint32(&pool->chunk_lock, 0, 1) != 0) {
+    /* pass */
   }
+}
+
+static void mempool_chunk_unlock(BLI_mempool *pool)
+{
+  atomic_fetch_and_and_uint32(&pool->chunk_lock, 0);
+}
+
+/**
+ * Build the free list of a new chunk.
+ *
+ * \return The last free element of the chunk.
+ */
+static BLI_freenode *mempool_chunk_build_free(BLI_mempool *pool, BLI_mempool_chunk *mpchunk)
+{
+  const uint esize = pool->esize;
+  BLI_freenode *curnode = CHUNK_DATA(mpchunk);
+  uint j;
 
   /* loop through the allocated data, building the pointer structures */
   j = pool->pchunk;
@@ -238,6 +273,32 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool,
   curnode = NODE_STEP_PREV(curnode);
   curnode->next = NULL;
 
+  return curnode;
+}
+
+/**
+ * Initialize a chunk and add into \a pool->chunks
+ *
+ * \param pool: The pool to add the chunk into.
+ * \param mpchunk: The new uninitialized chunk (can be malloc'd)
+ * \param last_tail: The last element of the previous chunk
+ * (used when building free chunks initially)
+ * \return The last chunk,
+ */
+static BLI_freenode *mempool_chunk_add(BLI_mempool *pool,
+                                       BLI_mempool_chunk *mpchunk,
+                                       BLI_freenode *last_tail)
+{
+  BLI_freenode *curnode = CHUNK_DATA(mpchunk);
+
+  mempool_chunk_append(pool, mpchunk);
+
+  if (UNLIKELY(pool->free == NULL)) {
+    pool->free = curnode;
+  }
+
+  curnode = mempool_chunk_build_free(pool, mpchunk);
+
 #ifdef USE_TOTALLOC
   pool->totalloc += pool->pchunk;
 #endif
@@ -316,6 +377,8 @@ BLI_mempool *BLI_mempool_create(uint esize, uint totelem, uint pchunk, uint flag
 #endif
   pool->totused = 0;
 
+  pool->chunk_lock = 0;
+
   if (totelem) {
     /* Allocate the actual chunks. */
     for (i = 0; i < maxchunks; i++) {
@@ -451,6 +514,178 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
   }
 }
 
+/* Thread local allocation:
+ *
+ * Each thread allocates from its own free list, filled from chunks it allocates itself
+ * or by taking the whole shared free list of the pool at once.
+ * Taking all elements avoids the ABA problem of popping single elements from a lock-free list,
+ * so only pushing onto the shared list needs to loop on compare-and-swap.
+ * The chunk list is only locked when a thread allocates a new chunk. */
+
+static void mempool_free_list_push(BLI_mempool *pool, BLI_freenode *head, BLI_freenode *tail)
+{
+  BLI_freenode *free_prev;
+  do {
+    free_prev = pool->free;
+    tail->next = free_prev;
+  } while (atomic_cas_ptr((void **)&pool->free, free_prev, head) != free_prev);
+}
+
+static BLI_freenode *mempool_free_list_take(BLI_mempool *pool)
+{
+  BLI_freenode *free_prev;
+  do {
+    free_prev = pool->free;
+  } while (free_prev && atomic_cas_ptr((void **)&pool->free, free_prev, NULL) != free_prev);
+  return free_prev;
+}
+
+/**
+ * Create the allocation state for a single thread,
+ * the pool must be created with #BLI_MEMPOOL_THREADSAFE.
+ *
+ * \note #BLI_mempool_len and iteration only account for elements
+ * of thread local allocators which have been destroyed.
+ */
+BLI_mempool_local *BLI_mempool_local_create(BLI_mempool *pool)
+{
+  BLI_assert(pool->flag & BLI_MEMPOOL_THREADSAFE);
+
+  BLI_mempool_local *local = MEM_mallocN(sizeof(*local), __func__);
+  local->pool = pool;
+  local->free = NULL;
+  local->freed = NULL;
+  local->freed_tail = NULL;
+  local->freed_len = 0;
+  local->totused_delta = 0;
+  return local;
+}
+
+/**
+ * Hand the free elements of \a local back to the pool,
+ * allocated elements stay valid.
+ */
+void BLI_mempool_local_destroy(BLI_mempool_local *local)
+{
+  BLI_mempool *pool = local->pool;
+
+  if (local->freed) {
+    mempool_free_list_push(pool, local->freed, local->freed_tail);
+  }
+  if (local->free) {
+    BLI_freenode *tail = local->free;
+    while (tail->next) {
+      tail = tail->next;
+    }
+    mempool_free_list_push(pool, local->free, tail);
+  }
+
+  atomic_add_and_fetch_uint32((uint32_t *)&pool->totused, (uint32_t)local->totused_delta);
+
+  MEM_freeN(local);
+}
+
+void *BLI_mempool_local_alloc(BLI_mempool_local *local)
+{
+  BLI_mempool *pool = local->pool;
+  BLI_freenode *free_pop;
+
+  if (local->freed) {
+    free_pop = local->freed;
+    local->freed = free_pop->next;
+    if (local->freed == NULL) {
+      local->freed_tail = NULL;
+    }
+    local->freed_len--;
+  }
+  else {
+    if (UNLIKELY(local->free == NULL)) {
+      local->free = mempool_free_list_take(pool);
+    }
+    if (UNLIKELY(local->free == NULL)) {
+      /* Need to allocate a new chunk, owned by this thread until its elements are freed. */
+      BLI_mempool_chunk *mpchunk = mempool_chunk_alloc(pool);
+      mempool_chunk_build_free(pool, mpchunk);
+      local->free = CHUNK_DATA(mpchunk);
+
+      mempool_chunk_lock(pool);
+      mempool_chunk_append(pool, mpchunk);
+#ifdef USE_TOTALLOC
+      pool->totalloc += pool->pchunk;
+#endif
+      mempool_chunk_unlock(pool);
+    }
+    free_pop = local->free;
+    local->free = free_pop->next;
+  }
+
+  if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+    free_pop->freeword = USEDWORD;
+  }
+
+  local->totused_delta++;
+
+#ifdef WITH_MEM_VALGRIND
+  VALGRIND_MEMPOOL_ALLOC(pool, free_pop, pool->esize);
+#endif
+
+  return (void *)free_pop;
+}
+
+void *BLI_mempool_local_calloc(BLI_mempool_local *local)
+{
+  void *retval = BLI_mempool_local_alloc(local);
+  memset(retval, 0, (size_t)local->pool->esize);
+  return retval;
+}
+
+/**
+ * Free an element allocated from any thread of the same pool.
+ *
+ * \note unlike #BLI_mempool_free, chunks are never freed here.
+ */
+void BLI_mempool_local_free(BLI_mempool_local *local, void *addr)
+{
+  BLI_mempool *pool = local->pool;
+  BLI_freenode *newhead = addr;
+
+#ifndef NDEBUG
+  /* Enable for debugging. */
+  if (UNLIKELY(mempool_debug_memset)) {
+    memset(addr, 255, pool->esize);
+  }
+#endif
+
+  if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+#ifndef NDEBUG
+    /* This will detect double free's. */
+    BLI_assert(newhead->freeword != FREEWORD);
+#endif
+    newhead->freeword = FREEWORD;
+  }
+
+  if (local->freed == NULL) {
+    local->freed_tail = newhead;
+  }
+  newhead->next = local->freed;
+  local->freed = newhead;
+  local->freed_len++;
+
+  local->totused_delta--;
+
+#ifdef WITH_MEM_VALGRIND
+  VALGRIND_MEMPOOL_FREE(pool, addr);
+#endif
+
+  /* Let other threads use the elements when this thread frees more than it allocates. */
+  if (UNLIKELY(local->freed_len > LOCAL_FREE_CHUNKS_MAX * pool->pchunk)) {
+    mempool_free_list_push(pool, local->freed, local->freed_tail);
+    local->freed = NULL;
+    local->freed_tail = NULL;
+    local->freed_len = 0;
+  }
+}
+
 int BLI_mempool_len(BLI_mempool *pool)
 {
   return (int)pool->totused;
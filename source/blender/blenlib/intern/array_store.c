@@ -104,6 +104,9 @@
 
 #include "BLI_listbase.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
+
+#include "PIL_time.h"
 
 #include "BLI_strict_flags.h"
 
@@ -172,6 +175,12 @@
  */
 #define BCHUNK_HASH_TABLE_MUL 3
 
+#ifdef USE_HASH_TABLE_ACCUMULATE
+/* Hash large arrays in parallel, in blocks of this many elements.
+ */
+#  define HASH_ARRAY_PARALLEL_BLOCK_LEN 65536
+#endif
+
 /* Merge too small/large chunks:
  *
  * Using this means chunks below a threshold will be merged together.
@@ -225,7 +234,12 @@ typedef struct BArrayInfo {
 #ifdef USE_HASH_TABLE_ACCUMULATE
   size_t accum_steps;
   size_t accum_read_ahead_len;
+  /** Multiplier of every byte of an element, see #hash_data_stride. */
+  uint *hash_stride_mul;
+  uint hash_stride_init;
 #endif
+  /** Hash large arrays in parallel, see #BLI_array_store_use_threading_set. */
+  bool use_threading;
 } BArrayInfo;
 
 typedef struct BArrayMemory {
@@ -248,6 +262,8 @@ struct BArrayStore {
    * #BArrayState may be in any order (logic should never depend on state order).
    */
   ListBase states;
+
+  BArrayStoreStats stats;
 };
 
 /**
@@ -748,6 +764,7 @@ BLI_INLINE uint hash_data_single(const uchar p)
   return ((HASH_INIT << 5) + HASH_INIT) + (unsigned int)(*((signed char *)&p));
 }
 
+#ifndef USE_HASH_TABLE_ACCUMULATE
 /* hash bytes, from BLI_ghashutil_strhash_n */
 static uint hash_data(const uchar *key, size_t n)
 {
@@ -760,18 +777,81 @@ static uint hash_data(const uchar *key, size_t n)
 
   return h;
 }
+#endif
+
+#ifdef USE_HASH_TABLE_ACCUMULATE
+/**
+ * Calculate the multipliers that give the same result as hashing the bytes of an element
+ * one at a time (see #BLI_ghashutil_strhash_n),
+ * written as a sum of every byte multiplied by a power of 33 (wrapping like the hash does).
+ */
+static void hash_data_stride_init(BArrayInfo *info)
+{
+  const size_t stride = info->chunk_stride;
+  info->hash_stride_mul = MEM_mallocN(sizeof(*info->hash_stride_mul) * stride, __func__);
+  uint mul = 1;
+  for (size_t i = stride; i--;) {
+    info->hash_stride_mul[i] = mul;
+    mul *= 33u;
+  }
+  info->hash_stride_init = HASH_INIT * mul;
+}
+#endif
 
 #undef HASH_INIT
 
 #ifdef USE_HASH_TABLE_ACCUMULATE
+/**
+ * Hash every element of \a data, see #hash_data_stride_init.
+ * Unlike hashing one byte at a time, the bytes don't depend on the hash of the previous bytes,
+ * so the bytes of an element can be processed at once using SIMD instructions.
+ * Common strides are passed as constants, so the compiler can unroll and vectorize the loop.
+ */
+BLI_INLINE void hash_data_stride(const uchar *data,
+                                 const size_t elem_len,
+                                 const size_t stride,
+                                 const uint *stride_mul,
+                                 const uint stride_init,
+                                 hash_key *hash_array)
+{
+  for (size_t i = 0; i < elem_len; i++) {
+    const signed char *p = (const signed char *)&data[i * stride];
+    uint h = stride_init;
+    for (size_t j = 0; j < stride; j++) {
+      h += (uint)p[j] * stride_mul[j];
+    }
+    hash_array[i] = h;
+  }
+}
+
 static void hash_array_from_data(const BArrayInfo *info,
                                  const uchar *data_slice,
                                  const size_t data_slice_len,
                                  hash_key *hash_array)
 {
   if (info->chunk_stride != 1) {
-    for (size_t i = 0, i_step = 0; i_step < data_slice_len; i++, i_step += info->chunk_stride) {
-      hash_array[i] = hash_data(&data_slice[i_step], info->chunk_stride);
+    const size_t elem_len = data_slice_len / info->chunk_stride;
+    const uint *mul = info->hash_stride_mul;
+    const uint init = info->hash_stride_init;
+    switch (info->chunk_stride) {
+      case 2:
+        hash_data_stride(data_slice, elem_len, 2, mul, init, hash_array);
+        break;
+      case 4:
+        hash_data_stride(data_slice, elem_len, 4, mul, init, hash_array);
+        break;
+      case 8:
+        hash_data_stride(data_slice, elem_len, 8, mul, init, hash_array);
+        break;
+      case 12:
+        hash_data_stride(data_slice, elem_len, 12, mul, init, hash_array);
+        break;
+      case 16:
+        hash_data_stride(data_slice, elem_len, 16, mul, init, hash_array);
+        break;
+      default:
+        hash_data_stride(data_slice, elem_len, info->chunk_stride, mul, init, hash_array);
+        break;
     }
   }
   else {
@@ -821,13 +901,79 @@ static void hash_accum(hash_key *hash_array, const size_t hash_array_len, size_t
   const size_t hash_array_search_len = hash_array_len - iter_steps;
   while (iter_steps != 0) {
     const size_t hash_offset = iter_steps;
-    for (uint i = 0; i < hash_array_search_len; i++) {
+    for (size_t i = 0; i < hash_array_search_len; i++) {
       hash_array[i] += (hash_array[i + hash_offset]) * ((hash_array[i] & 0xff) + 1);
     }
     iter_steps -= 1;
   }
 }
 
+typedef struct HashArrayAccumData {
+  const BArrayInfo *info;
+  const uchar *data;
+  hash_key *hash_array;
+  size_t hash_array_len;
+} HashArrayAccumData;
+
+static void hash_array_from_data_accum_block_cb(void *__restrict userdata,
+                                                const int block,
+                                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const HashArrayAccumData *data = userdata;
+  const BArrayInfo *info = data->info;
+
+  /* Each hash accumulates the hashes up to the read-ahead length after it,
+   * which themselves are only accumulated when they are before the last accumulation steps.
+   * Hashing this many elements past the end of the block gives the same result
+   * as accumulating the whole array at once. */
+  const size_t overlap_len = info->accum_read_ahead_len + info->accum_steps;
+  const size_t start = (size_t)block * HASH_ARRAY_PARALLEL_BLOCK_LEN;
+  const size_t end = MIN2(start + HASH_ARRAY_PARALLEL_BLOCK_LEN, data->hash_array_len);
+  const size_t end_overlap = MIN2(end + overlap_len, data->hash_array_len);
+
+  hash_key *hash_block = MEM_mallocN(sizeof(*hash_block) * (end_overlap - start), __func__);
+  hash_array_from_data(info,
+                       &data->data[start * info->chunk_stride],
+                       (end_overlap - start) * info->chunk_stride,
+                       hash_block);
+  hash_accum(hash_block, end_overlap - start, info->accum_steps);
+  memcpy(&data->hash_array[start], hash_block, sizeof(*hash_block) * (end - start));
+  MEM_freeN(hash_block);
+}
+
+/**
+ * Hash every element of \a data and accumulate the hashes,
+ * in parallel for large arrays.
+ */
+static void hash_array_from_data_accum(const BArrayInfo *info,
+                                       const uchar *data,
+                                       const size_t data_len,
+                                       hash_key *hash_array)
+{
+  const size_t hash_array_len = data_len / info->chunk_stride;
+  if (!info->use_threading || hash_array_len < HASH_ARRAY_PARALLEL_BLOCK_LEN * 2) {
+    hash_array_from_data(info, data, data_len, hash_array);
+    hash_accum(hash_array, hash_array_len, info->accum_steps);
+    return;
+  }
+
+  HashArrayAccumData accum_data = {
+      .info = info,
+      .data = data,
+      .hash_array = hash_array,
+      .hash_array_len = hash_array_len,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(
+      0,
+      (int)((hash_array_len + HASH_ARRAY_PARALLEL_BLOCK_LEN - 1) / HASH_ARRAY_PARALLEL_BLOCK_LEN),
+      &accum_data,
+      hash_array_from_data_accum_block_cb,
+      &settings);
+}
+
 /**
  * When we only need a single value, can use a small optimization.
  * we can avoid accumulating the tail of the array a little, each iteration.
@@ -846,7 +992,7 @@ static void hash_accum_single(hash_key *hash_array, const size_t hash_array_len,
   while (iter_steps != 0) {
     const size_t hash_array_search_len = hash_array_len - iter_steps_sub;
     const size_t hash_offset = iter_steps;
-    for (uint i = 0; i < hash_array_search_len; i++) {
+    for (size_t i = 0; i < hash_array_search_len; i++) {
       hash_array[i] += (hash_array[i + hash_offset]) * ((hash_array[i] & 0xff) + 1);
     }
     iter_steps -= 1;
@@ -1200,9 +1346,7 @@ static BChunkList *bchunk_list_from_data_merge(const BArrayInfo *info,
     const size_t table_hash_array_len = (data_len - i_prev) / info->chunk_stride;
     hash_key *table_hash_array = MEM_mallocN(sizeof(*table_hash_array) * table_hash_array_len,
                                              __func__);
-    hash_array_from_data(info, &data[i_prev], data_len - i_prev, table_hash_array);
-
-    hash_accum(table_hash_array, table_hash_array_len, info->accum_steps);
+    hash_array_from_data_accum(info, &data[i_prev], data_len - i_prev, table_hash_array);
 #else
     /* dummy vars */
     uint i_table_start = 0;
@@ -1421,6 +1565,7 @@ BArrayStore *BLI_array_store_create(uint stride, uint chunk_count)
   // bs->info.chunk_count = chunk_count;
 
   bs->info.chunk_byte_size = chunk_count * stride;
+  bs->info.use_threading = true;
 #ifdef USE_MERGE_CHUNKS
   bs->info.chunk_byte_size_min = MAX2(1u, chunk_count / BCHUNK_SIZE_MIN_DIV) * stride;
   bs->info.chunk_byte_size_max = (chunk_count * BCHUNK_SIZE_MAX_MUL) * stride;
@@ -1433,6 +1578,7 @@ BArrayStore *BLI_array_store_create(uint stride, uint chunk_count)
   bs->info.accum_read_ahead_len = (uint)(
       (((bs->info.accum_steps * (bs->info.accum_steps + 1))) / 2) + 1);
   bs->info.accum_read_ahead_bytes = bs->info.accum_read_ahead_len * stride;
+  hash_data_stride_init(&bs->info);
 #else
   bs->info.accum_read_ahead_bytes = BCHUNK_HASH_LEN * stride;
 #endif
@@ -1477,6 +1623,10 @@ void BLI_array_store_destroy(BArrayStore *bs)
   BLI_mempool_destroy(bs->memory.chunk_ref);
   BLI_mempool_destroy(bs->memory.chunk);
 
+#ifdef USE_HASH_TABLE_ACCUMULATE
+  MEM_freeN(bs->info.hash_stride_mul);
+#endif
+
   MEM_freeN(bs);
 }
 
@@ -1492,6 +1642,17 @@ void BLI_array_store_clear(BArrayStore *bs)
   BLI_mempool_clear(bs->memory.chunk_list);
   BLI_mempool_clear(bs->memory.chunk_ref);
   BLI_mempool_clear(bs->memory.chunk);
+
+  memset(&bs->stats, 0, sizeof(bs->stats));
+}
+
+/**
+ * Large arrays are hashed in parallel by default, which gives the same result as hashing them
+ * on a single thread.
+ */
+void BLI_array_store_use_threading_set(BArrayStore *bs, const bool use_threading)
+{
+  bs->info.use_threading = use_threading;
 }
 
 /** \} */
@@ -1528,6 +1689,25 @@ size_t BLI_array_store_calc_size_compacted_get(const BArrayStore *bs)
   return size_total;
 }
 
+/**
+ * Get the statistics of all states added since the store was created or cleared.
+ */
+void BLI_array_store_stats_get(const BArrayStore *bs, BArrayStoreStats *r_stats)
+{
+  *r_stats = bs->stats;
+}
+
+/**
+ * Add the statistics of \a stats_b to \a stats_a, to combine statistics of multiple stores.
+ */
+void BLI_array_store_stats_add(BArrayStoreStats *stats_a, const BArrayStoreStats *stats_b)
+{
+  stats_a->states_added_num += stats_b->states_added_num;
+  stats_a->size_added += stats_b->size_added;
+  stats_a->size_added_unique += stats_b->size_added_unique;
+  stats_a->time_added += stats_b->time_added;
+}
+
 /** \} */
 
 /** \name BArrayState Access
@@ -1559,6 +1739,8 @@ BArrayState *BLI_array_store_state_add(BArrayStore *bs,
   }
 #endif
 
+  const double time_start = PIL_check_seconds_timer();
+
   BChunkList *chunk_list;
   if (state_reference) {
     chunk_list = bchunk_list_from_data_merge(&bs->info,
@@ -1575,6 +1757,18 @@ BArrayState *BLI_array_store_state_add(BArrayStore *bs,
 
   chunk_list->users += 1;
 
+  /* Chunks only used by this list were created for it, others are shared with other states. */
+  bs->stats.states_added_num += 1;
+  bs->stats.size_added += data_len;
+  if (chunk_list->users == 1) {
+    LISTBASE_FOREACH (const BChunkRef *, cref, &chunk_list->chunk_refs) {
+      if (cref->link->users == 1) {
+        bs->stats.size_added_unique += cref->link->data_len;
+      }
+    }
+  }
+  bs->stats.time_added += PIL_check_seconds_timer() - time_start;
+
   BArrayState *state = MEM_callocN(sizeof(BArrayState), __func__);
   state->chunk_list = chunk_list;
 
@@ -19,6 +19,8 @@
  * \brief Helper functions for BLI_array_store API.
  */
 
+#include <string.h>
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_utildefines.h"
@@ -90,3 +92,17 @@ void BLI_array_store_at_size_calc_memory_usage(struct BArrayStore_AtSize *bs_str
   *r_size_expanded = size_expanded;
   *r_size_compacted = size_compacted;
 }
+
+void BLI_array_store_at_size_stats_get(struct BArrayStore_AtSize *bs_stride,
+                                       BArrayStoreStats *r_stats)
+{
+  memset(r_stats, 0, sizeof(*r_stats));
+  for (int i = 0; i < bs_stride->stride_table_len; i++) {
+    BArrayStore *bs = bs_stride->stride_table[i];
+    if (bs) {
+      BArrayStoreStats stats;
+      BLI_array_store_stats_get(bs, &stats);
+      BLI_array_store_stats_add(r_stats, &stats);
+    }
+  }
+}
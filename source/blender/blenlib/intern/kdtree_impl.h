@@ -18,10 +18,15 @@
  * \ingroup bli
  */
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_kdtree_impl.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_strict_flags.h"
 #include "BLI_utildefines.h"
 
@@ -56,6 +61,16 @@ struct KDTree {
 #define KD_NEAR_ALLOC_INC 100 /* alloc increment for collecting nearest */
 #define KD_FOUND_ALLOC_INC 50 /* alloc increment for collecting nearest */
 
+/* Subtrees with at least this many nodes are balanced in parallel. */
+#define KD_BALANCE_THREAD_MIN 10000
+
+/* Subtrees with at most this many nodes are tested as a single bucket by batch queries. */
+#define KD_BATCH_BUCKET_SIZE 16
+/* Enough for a full depth first traversal, as the tree depth is at most 32. */
+#define KD_BATCH_STACK_SIZE 64
+/* Batch queries with at least this many coordinates run in parallel. */
+#define KD_BATCH_THREAD_MIN 256
+
 #define KD_NODE_UNSET ((uint)-1)
 
 /**
@@ -145,19 +160,14 @@ void BLI_kdtree_nd_(insert)(KDTree *tree, int index, const float co[KD_DIMS])
 #endif
 }
 
-static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
+/**
+ * Partition \a nodes around their median on \a axis, returns the median.
+ */
+static uint kdtree_balance_partition(KDTreeNode *nodes, uint nodes_len, uint axis)
 {
-  KDTreeNode *node;
   float co;
   uint left, right, median, i, j;
 
-  if (nodes_len <= 0) {
-    return KD_NODE_UNSET;
-  }
-  else if (nodes_len == 1) {
-    return 0 + ofs;
-  }
-
   /* quicksort style sorting around median */
   left = 0;
   right = nodes_len - 1;
@@ -190,9 +200,30 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
     }
   }
 
+  nodes[median].d = axis;
+  return median;
+}
+
+/**
+ * \note Every subtree is stored contiguously with its root at the median of its range,
+ * batch queries depend on this to find nodes without following the left & right links.
+ */
+static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
+{
+  KDTreeNode *node;
+  uint median;
+
+  if (nodes_len <= 0) {
+    return KD_NODE_UNSET;
+  }
+  else if (nodes_len == 1) {
+    return 0 + ofs;
+  }
+
+  median = kdtree_balance_partition(nodes, nodes_len, axis);
+
   /* set node and sort subnodes */
   node = &nodes[median];
-  node->d = axis;
   axis = (axis + 1) % KD_DIMS;
   node->left = kdtree_balance(nodes, median, axis, ofs);
   node->right = kdtree_balance(
@@ -201,6 +232,53 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
   return median + ofs;
 }
 
+typedef struct KDTreeBalanceTask {
+  KDTreeNode *nodes;
+  uint nodes_len;
+  uint axis;
+  uint ofs;
+  uint *r_root;
+} KDTreeBalanceTask;
+
+static void kdtree_balance_parallel(
+    TaskPool *pool, KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs, uint *r_root);
+
+static void kdtree_balance_task(TaskPool *__restrict pool, void *taskdata)
+{
+  KDTreeBalanceTask *task = taskdata;
+  kdtree_balance_parallel(pool, task->nodes, task->nodes_len, task->axis, task->ofs, task->r_root);
+}
+
+/**
+ * Both halves of a partition are independent,
+ * so balance the right half in a new task while this one continues with the left.
+ * Each subtree only writes to its own range of nodes and to the link of its parent.
+ */
+static void kdtree_balance_parallel(
+    TaskPool *pool, KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs, uint *r_root)
+{
+  if (nodes_len < KD_BALANCE_THREAD_MIN) {
+    *r_root = kdtree_balance(nodes, nodes_len, axis, ofs);
+    return;
+  }
+
+  const uint median = kdtree_balance_partition(nodes, nodes_len, axis);
+  KDTreeNode *node = &nodes[median];
+  axis = (axis + 1) % KD_DIMS;
+
+  KDTreeBalanceTask *task = MEM_mallocN(sizeof(*task), __func__);
+  task->nodes = nodes + median + 1;
+  task->nodes_len = nodes_len - (median + 1);
+  task->axis = axis;
+  task->ofs = (median + 1) + ofs;
+  task->r_root = &node->right;
+  BLI_task_pool_push(pool, kdtree_balance_task, task, true, NULL);
+
+  kdtree_balance_parallel(pool, nodes, median, axis, ofs, &node->left);
+
+  *r_root = median + ofs;
+}
+
 void BLI_kdtree_nd_(balance)(KDTree *tree)
 {
   if (tree->root != KD_NODE_ROOT_IS_INIT) {
@@ -210,7 +288,15 @@ void BLI_kdtree_nd_(balance)(KDTree *tree)
     }
   }
 
-  tree->root = kdtree_balance(tree->nodes, tree->nodes_len, 0, 0);
+  if (tree->nodes_len < KD_BALANCE_THREAD_MIN) {
+    tree->root = kdtree_balance(tree->nodes, tree->nodes_len, 0, 0);
+  }
+  else {
+    TaskPool *pool = BLI_task_pool_create(NULL, TASK_PRIORITY_HIGH);
+    kdtree_balance_parallel(pool, tree->nodes, tree->nodes_len, 0, 0, &tree->root);
+    BLI_task_pool_work_and_wait(pool);
+    BLI_task_pool_free(pool);
+  }
 
 #ifdef DEBUG
   tree->is_balanced = true;
@@ -806,6 +892,308 @@ finally:
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_kdtree_3d_*_batch
+ *
+ * Run many queries at once, in parallel and without allocating memory per query.
+ *
+ * Rather than following the node links, these traverse ranges of nodes,
+ * every subtree being stored contiguously with its root at the median of its range
+ * (see #kdtree_balance). Small subtrees are tested as a single bucket in a flat loop, which
+ * computes distances to 4 nodes at once with SSE2.
+ * \{ */
+
+typedef struct KDTreeBatchStackItem {
+  uint begin, end;
+  /* Lower bound of the squared distance to nodes in the range. */
+  float dist_sq;
+} KDTreeBatchStackItem;
+
+BLI_INLINE void kdtree_batch_stack_push(KDTreeBatchStackItem *stack,
+                                        uint *stack_len,
+                                        const uint begin,
+                                        const uint end,
+                                        const float dist_sq)
+{
+  if (begin != end) {
+    BLI_assert(*stack_len < KD_BATCH_STACK_SIZE);
+    KDTreeBatchStackItem *item = &stack[(*stack_len)++];
+    item->begin = begin;
+    item->end = end;
+    item->dist_sq = dist_sq;
+  }
+}
+
+/**
+ * Squared distances from \a co to the nodes of a bucket. With SSE2 the distances to 4 nodes are
+ * computed at once, the remaining nodes one by one.
+ */
+static void kdtree_batch_bucket_dist_sq(const KDTreeNode *nodes,
+                                        const uint nodes_len,
+                                        const float co[KD_DIMS],
+                                        float r_dist_sq[KD_BATCH_BUCKET_SIZE])
+{
+  uint i = 0;
+#ifdef __SSE2__
+  for (; i + 4 <= nodes_len; i += 4) {
+    __m128 dist_sq = _mm_setzero_ps();
+    for (uint d = 0; d < KD_DIMS; d++) {
+      const __m128 node_co = _mm_setr_ps(
+          nodes[i].co[d], nodes[i + 1].co[d], nodes[i + 2].co[d], nodes[i + 3].co[d]);
+      const __m128 delta = _mm_sub_ps(node_co, _mm_set1_ps(co[d]));
+      dist_sq = _mm_add_ps(dist_sq, _mm_mul_ps(delta, delta));
+    }
+    _mm_storeu_ps(&r_dist_sq[i], dist_sq);
+  }
+#endif
+  for (; i < nodes_len; i++) {
+    r_dist_sq[i] = len_squared_vnvn(nodes[i].co, co);
+  }
+}
+
+static uint kdtree_batch_find_nearest_n(const KDTree *tree,
+                                        const float co[KD_DIMS],
+                                        KDTreeNearest *r_nearest,
+                                        const uint nearest_len_capacity)
+{
+  const KDTreeNode *nodes = tree->nodes;
+  KDTreeBatchStackItem stack[KD_BATCH_STACK_SIZE];
+  uint stack_len = 0;
+  uint nearest_len = 0;
+
+  kdtree_batch_stack_push(stack, &stack_len, 0, tree->nodes_len, 0.0f);
+
+  while (stack_len) {
+    const KDTreeBatchStackItem item = stack[--stack_len];
+
+    if (nearest_len == nearest_len_capacity &&
+        item.dist_sq >= r_nearest[nearest_len - 1].dist) {
+      continue;
+    }
+
+    if (item.end - item.begin <= KD_BATCH_BUCKET_SIZE) {
+      const KDTreeNode *bucket = &nodes[item.begin];
+      const uint bucket_len = item.end - item.begin;
+      float bucket_dist_sq[KD_BATCH_BUCKET_SIZE];
+      kdtree_batch_bucket_dist_sq(bucket, bucket_len, co, bucket_dist_sq);
+      for (uint i = 0; i < bucket_len; i++) {
+        const float dist_sq = bucket_dist_sq[i];
+        if (nearest_len < nearest_len_capacity || dist_sq < r_nearest[nearest_len - 1].dist) {
+          nearest_ordered_insert(r_nearest,
+                                 &nearest_len,
+                                 nearest_len_capacity,
+                                 bucket[i].index,
+                                 dist_sq,
+                                 bucket[i].co);
+        }
+      }
+      continue;
+    }
+
+    const uint median = item.begin + (item.end - item.begin) / 2;
+    const KDTreeNode *node = &nodes[median];
+    const float dist_sq = len_squared_vnvn(node->co, co);
+    if (nearest_len < nearest_len_capacity || dist_sq < r_nearest[nearest_len - 1].dist) {
+      nearest_ordered_insert(
+          r_nearest, &nearest_len, nearest_len_capacity, node->index, dist_sq, node->co);
+    }
+
+    /* Push the far side first, so the near side is searched first. */
+    const float dist_split = co[node->d] - node->co[node->d];
+    const float dist_split_sq = max_ff(item.dist_sq, dist_split * dist_split);
+    if (dist_split < 0.0f) {
+      kdtree_batch_stack_push(stack, &stack_len, median + 1, item.end, dist_split_sq);
+      kdtree_batch_stack_push(stack, &stack_len, item.begin, median, item.dist_sq);
+    }
+    else {
+      kdtree_batch_stack_push(stack, &stack_len, item.begin, median, dist_split_sq);
+      kdtree_batch_stack_push(stack, &stack_len, median + 1, item.end, item.dist_sq);
+    }
+  }
+
+  for (uint i = 0; i < nearest_len; i++) {
+    r_nearest[i].dist = sqrtf(r_nearest[i].dist);
+  }
+
+  return nearest_len;
+}
+
+static void kdtree_batch_range_search_cb(
+    const KDTree *tree,
+    const float co[KD_DIMS],
+    const float range,
+    bool (*search_cb)(
+        void *user_data, int co_index, int index, const float co[KD_DIMS], float dist_sq),
+    void *user_data,
+    const int co_index)
+{
+  const KDTreeNode *nodes = tree->nodes;
+  const float range_sq = range * range;
+  KDTreeBatchStackItem stack[KD_BATCH_STACK_SIZE];
+  uint stack_len = 0;
+
+  kdtree_batch_stack_push(stack, &stack_len, 0, tree->nodes_len, 0.0f);
+
+  while (stack_len) {
+    const KDTreeBatchStackItem item = stack[--stack_len];
+
+    if (item.end - item.begin <= KD_BATCH_BUCKET_SIZE) {
+      const KDTreeNode *bucket = &nodes[item.begin];
+      const uint bucket_len = item.end - item.begin;
+      float bucket_dist_sq[KD_BATCH_BUCKET_SIZE];
+      kdtree_batch_bucket_dist_sq(bucket, bucket_len, co, bucket_dist_sq);
+      for (uint i = 0; i < bucket_len; i++) {
+        const float dist_sq = bucket_dist_sq[i];
+        if (dist_sq <= range_sq) {
+          if (search_cb(user_data, co_index, bucket[i].index, bucket[i].co, dist_sq) == false) {
+            return;
+          }
+        }
+      }
+      continue;
+    }
+
+    const uint median = item.begin + (item.end - item.begin) / 2;
+    const KDTreeNode *node = &nodes[median];
+
+    if (co[node->d] + range < node->co[node->d]) {
+      kdtree_batch_stack_push(stack, &stack_len, item.begin, median, 0.0f);
+    }
+    else if (co[node->d] - range > node->co[node->d]) {
+      kdtree_batch_stack_push(stack, &stack_len, median + 1, item.end, 0.0f);
+    }
+    else {
+      const float dist_sq = len_squared_vnvn(node->co, co);
+      if (dist_sq <= range_sq) {
+        if (search_cb(user_data, co_index, node->index, node->co, dist_sq) == false) {
+          return;
+        }
+      }
+      kdtree_batch_stack_push(stack, &stack_len, item.begin, median, 0.0f);
+      kdtree_batch_stack_push(stack, &stack_len, median + 1, item.end, 0.0f);
+    }
+  }
+}
+
+typedef struct KDTreeBatchData {
+  const KDTree *tree;
+  const float (*co)[KD_DIMS];
+
+  /* Find nearest. */
+  KDTreeNearest *r_nearest;
+  int *r_nearest_len;
+  uint nearest_len_capacity;
+
+  /* Range search. */
+  float range;
+  bool (*search_cb)(
+      void *user_data, int co_index, int index, const float co[KD_DIMS], float dist_sq);
+  void *user_data;
+} KDTreeBatchData;
+
+static void kdtree_batch_find_nearest_n_task(void *__restrict userdata,
+                                             const int i,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBatchData *data = userdata;
+  data->r_nearest_len[i] = (int)kdtree_batch_find_nearest_n(
+      data->tree,
+      data->co[i],
+      &data->r_nearest[(uint)i * data->nearest_len_capacity],
+      data->nearest_len_capacity);
+}
+
+static void kdtree_batch_range_search_cb_task(void *__restrict userdata,
+                                              const int i,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBatchData *data = userdata;
+  kdtree_batch_range_search_cb(
+      data->tree, data->co[i], data->range, data->search_cb, data->user_data, i);
+}
+
+static void kdtree_batch_run(KDTreeBatchData *data,
+                             const uint co_len,
+                             TaskParallelRangeFunc func)
+{
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (co_len >= KD_BATCH_THREAD_MIN);
+  settings.min_iter_per_thread = 64;
+  BLI_task_parallel_range(0, (int)co_len, data, func, &settings);
+}
+
+/**
+ * Find the \a nearest_len_capacity nearest points to each of the \a co_len coordinates in \a co.
+ *
+ * \param r_nearest: An array sized at least `co_len * nearest_len_capacity`,
+ * the nearest points to `co[i]` are stored from `r_nearest[i * nearest_len_capacity]`,
+ * sorted by distance.
+ * \param r_nearest_len: An array sized \a co_len, the number of nearest points found for each.
+ */
+void BLI_kdtree_nd_(find_nearest_n_batch)(const KDTree *tree,
+                                          const float (*co)[KD_DIMS],
+                                          const uint co_len,
+                                          KDTreeNearest *r_nearest,
+                                          int *r_nearest_len,
+                                          const uint nearest_len_capacity)
+{
+#ifdef DEBUG
+  BLI_assert(tree->is_balanced == true);
+#endif
+
+  if (UNLIKELY(tree->root == KD_NODE_UNSET || nearest_len_capacity == 0)) {
+    copy_vn_i(r_nearest_len, (int)co_len, 0);
+    return;
+  }
+
+  KDTreeBatchData data = {
+      .tree = tree,
+      .co = co,
+      .r_nearest = r_nearest,
+      .r_nearest_len = r_nearest_len,
+      .nearest_len_capacity = nearest_len_capacity,
+  };
+  kdtree_batch_run(&data, co_len, kdtree_batch_find_nearest_n_task);
+}
+
+/**
+ * A version of #BLI_kdtree_3d_range_search_cb which searches around each of the
+ * \a co_len coordinates in \a co.
+ *
+ * \param search_cb: Called for every node found in \a range of `co[co_index]`,
+ * false return value ends the search for that coordinate.
+ * Searches run in parallel, so the callback must be thread-safe.
+ */
+void BLI_kdtree_nd_(range_search_batch_cb)(
+    const KDTree *tree,
+    const float (*co)[KD_DIMS],
+    const uint co_len,
+    const float range,
+    bool (*search_cb)(
+        void *user_data, int co_index, int index, const float co[KD_DIMS], float dist_sq),
+    void *user_data)
+{
+#ifdef DEBUG
+  BLI_assert(tree->is_balanced == true);
+#endif
+
+  if (UNLIKELY(tree->root == KD_NODE_UNSET)) {
+    return;
+  }
+
+  KDTreeBatchData data = {
+      .tree = tree,
+      .co = co,
+      .range = range,
+      .search_cb = search_cb,
+      .user_data = user_data,
+  };
+  kdtree_batch_run(&data, co_len, kdtree_batch_range_search_cb_task);
+}
+
+/** \} */
+
 /**
  * Use when we want to loop over nodes ordered by index.
  * Requires indices to be aligned with nodes.
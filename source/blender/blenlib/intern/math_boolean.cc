@@ -18,6 +18,9 @@
  * \ingroup bli
  */
 
+#include <cfloat>
+#include <cmath>
+
 #include "BLI_double2.hh"
 #include "BLI_double3.hh"
 #include "BLI_float2.hh"
@@ -2524,6 +2527,113 @@ int insphere(
   return sgn(robust_pred::insphere(a, b, c, d, e));
 }
 
+/**
+ * The filter functions evaluate a predicate in double arithmetic on approximations of exact
+ * (e.g., rational) coordinates, and use the error bounds from the paper
+ * EXACT GEOMETRIC COMPUTATION USING CASCADING, by Burnikel, Funke, and Seel,
+ * to decide whether the sign of the result must be the same as the exact one:
+ *
+ *     |E_exact - E| <= supremum(E) * index(E) * DBL_EPSILON
+ *
+ * The supremum is the same expression evaluated on absolute values with every - replaced
+ * by +, and the index follows the rules
+ *    index(x op y) = 1 + max(index(x), index(y)) for op + or -
+ *    index(x * y)  = 1 + index(x) + index(y)
+ * with index 1 for the inputs, since they are only approximations.
+ * If the bound underflows it is no longer valid, so the filter gives up in that case.
+ */
+static int filter_sign(double det, double supremum, int index)
+{
+  double err_bound = supremum * index * DBL_EPSILON;
+  if (err_bound >= DBL_MIN && fabs(det) > err_bound) {
+    return det > 0 ? 1 : -1;
+  }
+  return 0;
+}
+
+constexpr int index_orient2d = 6;
+
+int orient2d_filter(const double2 &a, const double2 &b, const double2 &c)
+{
+  double acx = a[0] - c[0];
+  double bcx = b[0] - c[0];
+  double acy = a[1] - c[1];
+  double bcy = b[1] - c[1];
+  double det = acx * bcy - acy * bcx;
+
+  double acx_sup = fabs(a[0]) + fabs(c[0]);
+  double bcx_sup = fabs(b[0]) + fabs(c[0]);
+  double acy_sup = fabs(a[1]) + fabs(c[1]);
+  double bcy_sup = fabs(b[1]) + fabs(c[1]);
+  double supremum = acx_sup * bcy_sup + acy_sup * bcx_sup;
+
+  return filter_sign(det, supremum, index_orient2d);
+}
+
+constexpr int index_incircle = 15;
+
+int incircle_filter(const double2 &a, const double2 &b, const double2 &c, const double2 &d)
+{
+  double adx = a[0] - d[0];
+  double bdx = b[0] - d[0];
+  double cdx = c[0] - d[0];
+  double ady = a[1] - d[1];
+  double bdy = b[1] - d[1];
+  double cdy = c[1] - d[1];
+  double alift = adx * adx + ady * ady;
+  double blift = bdx * bdx + bdy * bdy;
+  double clift = cdx * cdx + cdy * cdy;
+  double det = alift * (bdx * cdy - cdx * bdy) + blift * (cdx * ady - adx * cdy) +
+               clift * (adx * bdy - bdx * ady);
+
+  double adx_sup = fabs(a[0]) + fabs(d[0]);
+  double bdx_sup = fabs(b[0]) + fabs(d[0]);
+  double cdx_sup = fabs(c[0]) + fabs(d[0]);
+  double ady_sup = fabs(a[1]) + fabs(d[1]);
+  double bdy_sup = fabs(b[1]) + fabs(d[1]);
+  double cdy_sup = fabs(c[1]) + fabs(d[1]);
+  double alift_sup = adx_sup * adx_sup + ady_sup * ady_sup;
+  double blift_sup = bdx_sup * bdx_sup + bdy_sup * bdy_sup;
+  double clift_sup = cdx_sup * cdx_sup + cdy_sup * cdy_sup;
+  double supremum = alift_sup * (bdx_sup * cdy_sup + cdx_sup * bdy_sup) +
+                    blift_sup * (cdx_sup * ady_sup + adx_sup * cdy_sup) +
+                    clift_sup * (adx_sup * bdy_sup + bdx_sup * ady_sup);
+
+  return filter_sign(det, supremum, index_incircle);
+}
+
+constexpr int index_orient3d = 11;
+
+int orient3d_filter(const double3 &a, const double3 &b, const double3 &c, const double3 &d)
+{
+  double adx = a[0] - d[0];
+  double bdx = b[0] - d[0];
+  double cdx = c[0] - d[0];
+  double ady = a[1] - d[1];
+  double bdy = b[1] - d[1];
+  double cdy = c[1] - d[1];
+  double adz = a[2] - d[2];
+  double bdz = b[2] - d[2];
+  double cdz = c[2] - d[2];
+  double det = adz * (bdx * cdy - cdx * bdy) + bdz * (cdx * ady - adx * cdy) +
+               cdz * (adx * bdy - bdx * ady);
+
+  double adx_sup = fabs(a[0]) + fabs(d[0]);
+  double bdx_sup = fabs(b[0]) + fabs(d[0]);
+  double cdx_sup = fabs(c[0]) + fabs(d[0]);
+  double ady_sup = fabs(a[1]) + fabs(d[1]);
+  double bdy_sup = fabs(b[1]) + fabs(d[1]);
+  double cdy_sup = fabs(c[1]) + fabs(d[1]);
+  double adz_sup = fabs(a[2]) + fabs(d[2]);
+  double bdz_sup = fabs(b[2]) + fabs(d[2]);
+  double cdz_sup = fabs(c[2]) + fabs(d[2]);
+  double supremum = adz_sup * (bdx_sup * cdy_sup + cdx_sup * bdy_sup) +
+                    bdz_sup * (cdx_sup * ady_sup + adx_sup * cdy_sup) +
+                    cdz_sup * (adx_sup * bdy_sup + bdx_sup * ady_sup);
+
+  return filter_sign(det, supremum, index_orient3d);
+}
+
 int insphere_fast(
     const double3 &a, const double3 &b, const double3 &c, const double3 &d, const double3 &e)
 {
@@ -37,6 +37,7 @@
 #  include "BLI_set.hh"
 #  include "BLI_span.hh"
 #  include "BLI_stack.hh"
+#  include "BLI_task.h"
 #  include "BLI_vector.hh"
 #  include "BLI_vector_set.hh"
 
@@ -840,9 +841,6 @@ static int sort_tris_class(const Face &tri, const Face &tri0, const Edge e)
   if (dbg_level > 0) {
     std::cout << "classify  e = " << e << "\n";
   }
-  mpq3 a0 = tri0[0]->co_exact;
-  mpq3 a1 = tri0[1]->co_exact;
-  mpq3 a2 = tri0[2]->co_exact;
   bool rev;
   bool rev0;
   const Vert *flapv0 = find_flap_vert(tri0, e, &rev0);
@@ -854,9 +852,12 @@ static int sort_tris_class(const Face &tri, const Face &tri0, const Edge e)
     std::cout << " rev = " << rev << " flapv = " << flapv << "\n";
   }
   BLI_assert(flapv != nullptr && flapv0 != nullptr);
-  const mpq3 flap = flapv->co_exact;
-  /* orient will be positive if flap is below oriented plane of a0,a1,a2. */
-  int orient = orient3d(a0, a1, a2, flap);
+  /* orient will be positive if flap is below oriented plane of tri0.
+   * Only calculate it exactly if the double approximation can't decide. */
+  int orient = orient3d_filter(tri0[0]->co, tri0[1]->co, tri0[2]->co, flapv->co);
+  if (orient == 0) {
+    orient = orient3d(tri0[0]->co_exact, tri0[1]->co_exact, tri0[2]->co_exact, flapv->co_exact);
+  }
   int ans;
   if (orient > 0) {
     ans = rev0 ? 4 : 3;
@@ -2036,7 +2037,7 @@ static void propagate_windings_and_in_output_volume(PatchesInfo &pinfo,
  *   Intersection: all the winding numbers must be nonzero.
  *   Union: at least one winding number must be nonzero.
  *   Difference (first shape minus the rest): first winding number must be nonzero
- *      and the rest must have at least one zero winding number.
+ *      and all the rest must be zero.
  */
 static bool apply_bool_op(BoolOpType bool_optype, const Array<int> &winding)
 {
@@ -2064,15 +2065,12 @@ static bool apply_bool_op(BoolOpType bool_optype, const Array<int> &winding)
       if (winding[0] == 0) {
         return false;
       }
-      if (nw == 1) {
-        return true;
-      }
       for (int i = 1; i < nw; ++i) {
-        if (winding[i] == 0) {
-          return true;
+        if (winding[i] != 0) {
+          return false;
         }
       }
-      return false;
+      return true;
     }
     default:
       return false;
@@ -2290,81 +2288,77 @@ static mpq3 calc_point_inside_tri(const Face &tri)
 }
 
 /**
- * Return the Generalized Winding Number of point \a testp with respect to the
- * volume implied by the faces for which shape_fn returns the value shape.
+ * Fill \a r_gwn with the Generalized Winding Numbers of point \a testp with respect to
+ * the volumes implied by the faces of each shape (as given by \a shape_fn).
  * See "Robust Inside-Outside Segmentation using Generalized Winding Numbers"
  * by Jacobson, Kavan, and Sorkine-Hornung.
  * This is like a winding number in that if it is positive, the point
  * is inside the volume. But it is tolerant of not-completely-watertight
  * volumes, still doing a passable job of classifying inside/outside
  * as we intuitively understand that to mean.
+ * All shapes are done in one pass over the triangles.
  *
  * TOOD: speed up this calculation using the hierarchical algorithm in that paper.
  */
-static double generalized_winding_number(const IMesh &tm,
-                                         std::function<int(int)> shape_fn,
-                                         const double3 &testp,
-                                         int shape)
+static void generalized_winding_numbers(const IMesh &tm,
+                                        const std::function<int(int)> &shape_fn,
+                                        const double3 &testp,
+                                        MutableSpan<double> r_gwn)
 {
   constexpr int dbg_level = 0;
   if (dbg_level > 0) {
-    std::cout << "GENERALIZED_WINDING_NUMBER testp = " << testp << ", shape = " << shape << "\n";
+    std::cout << "GENERALIZED_WINDING_NUMBERS testp = " << testp << "\n";
   }
-  double gwn = 0;
+  r_gwn.fill(0.0);
   for (int t : tm.face_index_range()) {
     const Face *f = tm.face(t);
     const Face &tri = *f;
-    if (shape_fn(tri.orig) == shape) {
-      if (dbg_level > 0) {
-        std::cout << "accumulate for tri t = " << t << " = " << f << "\n";
-      }
-      const Vert *v0 = tri.vert[0];
-      const Vert *v1 = tri.vert[1];
-      const Vert *v2 = tri.vert[2];
-      double3 a = v0->co - testp;
-      double3 b = v1->co - testp;
-      double3 c = v2->co - testp;
-      /* Calculate the solid angle of abc relative to origin.
-       * See "The Solid Angle of a Plane Triangle" by Oosterom and Strackee
-       * for the derivation of the formula. */
-      double alen = a.length();
-      double blen = b.length();
-      double clen = c.length();
-      double3 bxc = double3::cross_high_precision(b, c);
-      double num = double3::dot(a, bxc);
-      double denom = alen * blen * clen + double3::dot(a, b) * clen + double3::dot(a, c) * blen +
-                     double3::dot(b, c) * alen;
-      if (denom == 0.0) {
-        if (dbg_level > 0) {
-          std::cout << "denom == 0, skipping this tri\n";
-        }
-        continue;
-      }
-      double x = atan2(num, denom);
-      double fgwn = 2.0 * x;
+    const int shape = shape_fn(tri.orig);
+    if (shape < 0 || shape >= r_gwn.size()) {
+      continue;
+    }
+    if (dbg_level > 0) {
+      std::cout << "accumulate for tri t = " << t << " = " << f << ", shape = " << shape << "\n";
+    }
+    const Vert *v0 = tri.vert[0];
+    const Vert *v1 = tri.vert[1];
+    const Vert *v2 = tri.vert[2];
+    double3 a = v0->co - testp;
+    double3 b = v1->co - testp;
+    double3 c = v2->co - testp;
+    /* Calculate the solid angle of abc relative to origin.
+     * See "The Solid Angle of a Plane Triangle" by Oosterom and Strackee
+     * for the derivation of the formula. */
+    double alen = a.length();
+    double blen = b.length();
+    double clen = c.length();
+    double3 bxc = double3::cross_high_precision(b, c);
+    double num = double3::dot(a, bxc);
+    double denom = alen * blen * clen + double3::dot(a, b) * clen + double3::dot(a, c) * blen +
+                   double3::dot(b, c) * alen;
+    if (denom == 0.0) {
       if (dbg_level > 0) {
-        std::cout << "tri contributes " << fgwn << "\n";
+        std::cout << "denom == 0, skipping this tri\n";
       }
-      gwn += fgwn;
+      continue;
+    }
+    double x = atan2(num, denom);
+    double fgwn = 2.0 * x;
+    if (dbg_level > 0) {
+      std::cout << "tri contributes " << fgwn << "\n";
     }
+    r_gwn[shape] += fgwn;
   }
-  gwn = gwn / (M_PI * 4.0);
-  if (dbg_level > 0) {
-    std::cout << "final gwn = " << gwn << "\n";
+  for (double &gwn : r_gwn) {
+    gwn = gwn / (M_PI * 4.0);
   }
-  return gwn;
 }
 
 /**
- * Return true if point \a testp is inside the volume implied by the
- * faces for which the shape_fn returns the value shape.
+ * Is a point with Generalized Winding Number \a gwn inside the volume?
  */
-static bool point_is_inside_shape(const IMesh &tm,
-                                  std::function<int(int)> shape_fn,
-                                  const double3 &testp,
-                                  int shape)
+static bool gwn_is_inside(double gwn)
 {
-  double gwn = generalized_winding_number(tm, shape_fn, testp, shape);
   /* Due to floating point error, an outside point should get a value
    * of zero for gwn, but may have a very slightly positive value instead.
    * It is not important to get this epsilon very small, because practical
@@ -2372,10 +2366,71 @@ static bool point_is_inside_shape(const IMesh &tm,
   return (gwn > 0.01);
 }
 
+/**
+ * Data needed for parallelization of the patch classification in #gwn_boolean.
+ */
+struct GwnClassifyData {
+  const IMesh &tm;
+  BoolOpType op;
+  int nshapes;
+  const std::function<int(int)> &shape_fn;
+  const PatchesInfo &pinfo;
+  /** Per patch results. */
+  MutableSpan<bool> do_remove;
+  MutableSpan<bool> do_flip;
+};
+
+static void gwn_classify_patch_range_func(void *__restrict userdata,
+                                          const int p,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  constexpr int dbg_level = 0;
+  GwnClassifyData *data = static_cast<GwnClassifyData *>(userdata);
+  const Patch &patch = data->pinfo.patch(p);
+  /* For test triangle, choose one in the middle of patch list
+   * as the ones near the beginning may be very near other patches. */
+  int test_t_index = patch.tri(patch.tot_tri() / 2);
+  Face &tri_test = *data->tm.face(test_t_index);
+  /* Assume all triangles in a patch are in the same shape. */
+  int shape = data->shape_fn(tri_test.orig);
+  if (dbg_level > 0) {
+    std::cout << "process patch " << p << " = " << patch << "\n";
+    std::cout << "test tri = " << test_t_index << " = " << &tri_test << "\n";
+    std::cout << "shape = " << shape << "\n";
+  }
+  if (shape == -1) {
+    data->do_remove[p] = true;
+    data->do_flip[p] = false;
+    return;
+  }
+  mpq3 test_point = calc_point_inside_tri(tri_test);
+  double3 test_point_db(test_point[0].get_d(), test_point[1].get_d(), test_point[2].get_d());
+  Array<double> gwn(data->nshapes);
+  generalized_winding_numbers(data->tm, data->shape_fn, test_point_db, gwn);
+  Array<int> winding(data->nshapes);
+  for (int i = 0; i < data->nshapes; ++i) {
+    winding[i] = gwn_is_inside(gwn[i]) ? 1 : 0;
+  }
+  /* The patch is on the boundary of its own shape: it is outside of the shape on the side
+   * its normal points to, and inside on the other. Keep it if exactly one of those sides is in
+   * the output volume, flipped if that is the side outside of the shape. */
+  winding[shape] = 0;
+  const bool in_output_volume_above = apply_bool_op(data->op, winding);
+  winding[shape] = 1;
+  const bool in_output_volume_below = apply_bool_op(data->op, winding);
+  data->do_remove[p] = (in_output_volume_above == in_output_volume_below);
+  data->do_flip[p] = !data->do_remove[p] && in_output_volume_above;
+  if (dbg_level > 0) {
+    std::cout << "result for patch " << p << ": remove=" << data->do_remove[p]
+              << ", flip=" << data->do_flip[p] << "\n";
+  }
+}
+
 /**
  * Use the Generalized Winding Number method for deciding if a patch of the
  * mesh is supposed to be included or excluded in the boolean result,
  * and return the mesh that is the boolean result.
+ * The patches are classified in parallel.
  */
 static IMesh gwn_boolean(const IMesh &tm,
                          BoolOpType op,
@@ -2391,75 +2446,33 @@ static IMesh gwn_boolean(const IMesh &tm,
   IMesh ans;
   Vector<Face *> out_faces;
   out_faces.reserve(tm.face_size());
-  BLI_assert(nshapes == 2); /* TODO: generalize. */
-  UNUSED_VARS_NDEBUG(nshapes);
+  Array<bool> do_remove(pinfo.tot_patch());
+  Array<bool> do_flip(pinfo.tot_patch());
+  GwnClassifyData data = {tm, op, nshapes, shape_fn, pinfo, do_remove, do_flip};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, pinfo.tot_patch(), &data, gwn_classify_patch_range_func, &settings);
   for (int p : pinfo.index_range()) {
-    const Patch &patch = pinfo.patch(p);
-    /* For test triangle, choose one in the middle of patch list
-     * as the ones near the beginning may be very near other patches. */
-    int test_t_index = patch.tri(patch.tot_tri() / 2);
-    Face &tri_test = *tm.face(test_t_index);
-    /* Assume all triangles in a patch are in the same shape. */
-    int shape = shape_fn(tri_test.orig);
-    if (dbg_level > 0) {
-      std::cout << "process patch " << p << " = " << patch << "\n";
-      std::cout << "test tri = " << test_t_index << " = " << &tri_test << "\n";
-      std::cout << "shape = " << shape << "\n";
-    }
-    if (shape == -1) {
+    if (do_remove[p]) {
       continue;
     }
-    mpq3 test_point = calc_point_inside_tri(tri_test);
-    double3 test_point_db(test_point[0].get_d(), test_point[1].get_d(), test_point[2].get_d());
-    if (dbg_level > 0) {
-      std::cout << "test point = " << test_point_db << "\n";
-    }
-    int other_shape = 1 - shape;
-    bool inside = point_is_inside_shape(tm, shape_fn, test_point_db, other_shape);
-    if (dbg_level > 0) {
-      std::cout << "test point is " << (inside ? "inside\n" : "outside\n");
-    }
-    bool do_remove;
-    bool do_flip;
-    switch (op) {
-      case BoolOpType::Intersect:
-        do_remove = !inside;
-        do_flip = false;
-        break;
-      case BoolOpType::Union:
-        do_remove = inside;
-        do_flip = false;
-        break;
-      case BoolOpType::Difference:
-        do_remove = (shape == 0) ? inside : !inside;
-        do_flip = (shape == 1);
-        break;
-      default:
-        do_remove = false;
-        do_flip = false;
-        BLI_assert(false);
-    }
-    if (dbg_level > 0) {
-      std::cout << "result for patch " << p << ": remove=" << do_remove << ", flip=" << do_flip
-                << "\n";
-    }
-    if (!do_remove) {
-      for (int t : patch.tris()) {
-        Face *f = tm.face(t);
-        if (!do_flip) {
-          out_faces.append(f);
-        }
-        else {
-          Face &tri = *f;
-          /* We need flipped version of f. */
-          Array<const Vert *> flipped_vs = {tri[0], tri[2], tri[1]};
-          Array<int> flipped_e_origs = {tri.edge_orig[2], tri.edge_orig[1], tri.edge_orig[0]};
-          Array<bool> flipped_is_intersect = {
-              tri.is_intersect[2], tri.is_intersect[1], tri.is_intersect[0]};
-          Face *flipped_f = arena->add_face(
-              flipped_vs, f->orig, flipped_e_origs, flipped_is_intersect);
-          out_faces.append(flipped_f);
-        }
+    const Patch &patch = pinfo.patch(p);
+    for (int t : patch.tris()) {
+      Face *f = tm.face(t);
+      if (!do_flip[p]) {
+        out_faces.append(f);
+      }
+      else {
+        Face &tri = *f;
+        /* We need flipped version of f. */
+        Array<const Vert *> flipped_vs = {tri[0], tri[2], tri[1]};
+        Array<int> flipped_e_origs = {tri.edge_orig[2], tri.edge_orig[1], tri.edge_orig[0]};
+        Array<bool> flipped_is_intersect = {
+            tri.is_intersect[2], tri.is_intersect[1], tri.is_intersect[0]};
+        Face *flipped_f = arena->add_face(
+            flipped_vs, f->orig, flipped_e_origs, flipped_is_intersect);
+        out_faces.append(flipped_f);
       }
     }
   }
@@ -32,6 +32,7 @@
 #include "BLI_mempool.h"
 #include "BLI_task.h"
 #include "BLI_threads.h"
+#include "BLI_trace.hh"
 
 #ifdef WITH_TBB
 /* Quiet top level deprecation message, unrelated to API usage here. */
@@ -114,6 +115,7 @@ class Task {
   /* Execute task. */
   void operator()() const
   {
+    TRACE_SCOPE("Task Pool");
 #ifdef WITH_TBB
     tbb::this_task_arena::isolate([this] { run(pool, taskdata); });
 #else
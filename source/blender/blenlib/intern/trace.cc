@@ -0,0 +1,317 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_fileops.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+#include "BLI_trace.h"
+
+bool bli_trace_is_running = false;
+
+namespace blender::trace {
+
+using Clock = std::chrono::steady_clock;
+
+/** Number of zones kept per thread, older zones are overwritten. */
+static constexpr int64_t EVENTS_PER_THREAD = 1 << 14;
+/** Maximum depth of nested zones, deeper zones are not recorded. */
+static constexpr int ZONE_STACK_MAX = 64;
+static constexpr int DETAIL_MAX = 64;
+
+struct Zone {
+  const char *name;
+  char detail[DETAIL_MAX];
+  int64_t begin_ns;
+  int64_t end_ns;
+};
+
+struct ThreadBuffer {
+  int thread_index;
+  bool is_main_thread;
+
+  /** Ring buffer of finished zones, only written by the owning thread. */
+  std::unique_ptr<Zone[]> zones;
+  /** Number of zones written in total, the ring buffer index is this modulo its size. */
+  std::atomic<int64_t> zones_written;
+  /** Zones written before this were cleared. */
+  std::atomic<int64_t> zones_cleared;
+
+  /** Open zones, written to the ring buffer when they end. */
+  Zone stack[ZONE_STACK_MAX];
+  int stack_len;
+  /** Zones opened beyond #ZONE_STACK_MAX, ignored. */
+  int stack_overflow;
+};
+
+/* Standard containers, as the registry is never freed it would be reported as a leak. */
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  const Clock::time_point epoch = Clock::now();
+};
+
+/* Never freed, so zones can still be written from `atexit` handlers. */
+static Registry &registry()
+{
+  static Registry *registry = new Registry();
+  return *registry;
+}
+
+static thread_local ThreadBuffer *thread_buffer = nullptr;
+
+static ThreadBuffer &thread_buffer_ensure()
+{
+  if (thread_buffer == nullptr) {
+    std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>();
+    buffer->is_main_thread = BLI_thread_is_main();
+    buffer->zones.reset(new Zone[EVENTS_PER_THREAD]);
+    buffer->zones_written = 0;
+    buffer->zones_cleared = 0;
+    buffer->stack_len = 0;
+    buffer->stack_overflow = 0;
+
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    buffer->thread_index = static_cast<int>(reg.buffers.size());
+    thread_buffer = buffer.get();
+    reg.buffers.push_back(std::move(buffer));
+  }
+  return *thread_buffer;
+}
+
+static int64_t time_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - registry().epoch)
+      .count();
+}
+
+static void json_append_string(std::stringstream &ss, const char *str)
+{
+  ss << '"';
+  for (const char *c = str; *c; c++) {
+    switch (*c) {
+      case '"':
+        ss << "\\\"";
+        break;
+      case '\\':
+        ss << "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20) {
+          char hex[8];
+          BLI_snprintf(hex, sizeof(hex), "\\u%04x", *c);
+          ss << hex;
+        }
+        else {
+          ss << *c;
+        }
+        break;
+    }
+  }
+  ss << '"';
+}
+
+static std::string trace_json()
+{
+  std::stringstream ss;
+  ss << "{\"traceEvents\":[";
+  bool first = true;
+
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  for (const std::unique_ptr<ThreadBuffer> &buffer : reg.buffers) {
+    if (!first) {
+      ss << ",";
+    }
+    first = false;
+    ss << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->thread_index
+       << ",\"args\":{\"name\":\"";
+    if (buffer->is_main_thread) {
+      ss << "Main";
+    }
+    else {
+      ss << "Thread " << buffer->thread_index;
+    }
+    ss << "\"}}";
+
+    /* Zones may be written while reading, the oldest may then be overwritten already. */
+    const int64_t end = buffer->zones_written.load(std::memory_order_acquire);
+    const int64_t start = std::max(buffer->zones_cleared.load(), end - EVENTS_PER_THREAD);
+    for (int64_t i = start; i < end; i++) {
+      const Zone &zone = buffer->zones[i % EVENTS_PER_THREAD];
+      ss << ",\n{\"name\":";
+      json_append_string(ss, zone.name);
+      char times[128];
+      BLI_snprintf(times,
+                   sizeof(times),
+                   ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%d",
+                   static_cast<double>(zone.begin_ns) * 1e-3,
+                   static_cast<double>(zone.end_ns - zone.begin_ns) * 1e-3,
+                   buffer->thread_index);
+      ss << times;
+      if (zone.detail[0]) {
+        ss << ",\"args\":{\"detail\":";
+        json_append_string(ss, zone.detail);
+        ss << "}";
+      }
+      ss << "}";
+    }
+  }
+  ss << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return ss.str();
+}
+
+static char *exit_filepath = nullptr;
+
+static void trace_exit_write()
+{
+  if (exit_filepath) {
+    if (!BLI_trace_write_json(exit_filepath)) {
+      fprintf(stderr, "Failed to write trace to \"%s\"\n", exit_filepath);
+    }
+    free(exit_filepath);
+    exit_filepath = nullptr;
+  }
+}
+
+}  // namespace blender::trace
+
+using namespace blender::trace;
+
+/**
+ * Start recording zones, zones recorded before are kept.
+ */
+void BLI_trace_start(void)
+{
+  /* Initialize the time of the first zone. */
+  registry();
+  bli_trace_is_running = true;
+}
+
+/**
+ * Stop recording zones, zones that are open keep recording until they end.
+ */
+void BLI_trace_stop(void)
+{
+  bli_trace_is_running = false;
+}
+
+/**
+ * Remove all recorded zones.
+ */
+void BLI_trace_clear(void)
+{
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  for (std::unique_ptr<ThreadBuffer> &buffer : reg.buffers) {
+    buffer->zones_cleared = buffer->zones_written.load();
+  }
+}
+
+/**
+ * \return The recorded zones as Chrome trace JSON, to be freed with #MEM_freeN.
+ */
+char *BLI_trace_json(void)
+{
+  const std::string json = trace_json();
+  return BLI_strdupn(json.c_str(), json.size());
+}
+
+bool BLI_trace_write_json(const char *filepath)
+{
+  FILE *file = BLI_fopen(filepath, "w");
+  if (file == nullptr) {
+    return false;
+  }
+  const std::string json = trace_json();
+  const bool ok = fwrite(json.c_str(), 1, json.size(), file) == json.size();
+  return (fclose(file) == 0) && ok;
+}
+
+/**
+ * Write the recorded zones to \a filepath when the process exits.
+ */
+void BLI_trace_write_json_at_exit(const char *filepath)
+{
+  if (exit_filepath == nullptr) {
+    atexit(trace_exit_write);
+  }
+  free(exit_filepath);
+  exit_filepath = strdup(filepath);
+}
+
+/**
+ * Begin a zone on this thread, prefer the `BLI_TRACE_ZONE_BEGIN` and `TRACE_SCOPE` macros.
+ *
+ * \param name: Static string, it isn't copied.
+ * \param detail: Copied (and truncated), may be NULL.
+ * \return True when the zone was opened, it must be ended with #BLI_trace_zone_end.
+ */
+bool BLI_trace_zone_begin(const char *name, const char *detail)
+{
+  if (!bli_trace_is_running) {
+    return false;
+  }
+  ThreadBuffer &buffer = thread_buffer_ensure();
+  if (buffer.stack_len == ZONE_STACK_MAX) {
+    buffer.stack_overflow++;
+    return true;
+  }
+  Zone &zone = buffer.stack[buffer.stack_len++];
+  zone.name = name;
+  if (detail) {
+    BLI_strncpy(zone.detail, detail, sizeof(zone.detail));
+  }
+  else {
+    zone.detail[0] = '\0';
+  }
+  zone.begin_ns = time_ns();
+  return true;
+}
+
+void BLI_trace_zone_end(void)
+{
+  ThreadBuffer &buffer = thread_buffer_ensure();
+  if (buffer.stack_overflow) {
+    buffer.stack_overflow--;
+    return;
+  }
+  if (buffer.stack_len == 0) {
+    return;
+  }
+  Zone &zone = buffer.stack[--buffer.stack_len];
+  zone.end_ns = time_ns();
+
+  const int64_t index = buffer.zones_written.load(std::memory_order_relaxed);
+  buffer.zones[index % EVENTS_PER_THREAD] = zone;
+  buffer.zones_written.store(index + 1, std::memory_order_release);
+}
@@ -733,12 +733,16 @@ static void random_chunk_generate(ListBase *lb,
 
 /**
  * Add random chunks, then re-order them to ensure chunk de-duplication is working.
+ *
+ * \param r_stats: When not null, the statistics of the store after adding all states.
  */
 static void random_chunk_mutate_helper(const int chunks_per_buffer,
                                        const int items_total,
                                        const int stride,
                                        const int chunk_count,
-                                       const int random_seed)
+                                       const int random_seed,
+                                       const bool use_threading = true,
+                                       BArrayStoreStats *r_stats = nullptr)
 {
   /* generate random chunks */
 
@@ -774,11 +778,16 @@ static void random_chunk_mutate_helper(const int chunks_per_buffer,
   MEM_freeN(chunks_array);
 
   BArrayStore *bs = BLI_array_store_create(stride, chunk_count);
+  BLI_array_store_use_threading_set(bs, use_threading);
   testbuffer_run_tests_single(bs, &lb);
 
   size_t expected_size = chunks_per_buffer * chunk_count * stride;
   EXPECT_EQ(BLI_array_store_calc_size_compacted_get(bs), expected_size);
 
+  if (r_stats) {
+    BLI_array_store_stats_get(bs, r_stats);
+  }
+
   BLI_array_store_destroy(bs);
 
   testbuffer_list_free(&lb);
@@ -800,6 +809,65 @@ TEST(array_store, TestChunk_Rand31_Stride11_Chunk21)
 {
   random_chunk_mutate_helper(31, 100, 11, 21, 7117);
 }
+/* Large enough for the hashing to be split into blocks,
+ * which must de-duplicate exactly like hashing on a single thread. */
+TEST(array_store, TestChunk_Rand2048_Stride12_Chunk128)
+{
+  BArrayStoreStats stats_parallel, stats_serial;
+  random_chunk_mutate_helper(2048, 4, 12, 128, 3331, true, &stats_parallel);
+  random_chunk_mutate_helper(2048, 4, 12, 128, 3331, false, &stats_serial);
+  EXPECT_EQ(stats_parallel.states_added_num, stats_serial.states_added_num);
+  EXPECT_EQ(stats_parallel.size_added, stats_serial.size_added);
+  EXPECT_EQ(stats_parallel.size_added_unique, stats_serial.size_added_unique);
+}
+
+/* -------------------------------------------------------------------- */
+/* Statistics Test */
+
+TEST(array_store, Stats)
+{
+  BArrayStore *bs = BLI_array_store_create(4, 32);
+  BArrayStoreStats stats;
+  BLI_array_store_stats_get(bs, &stats);
+  EXPECT_EQ(stats.states_added_num, 0);
+  EXPECT_EQ(stats.size_added, 0);
+
+  const size_t data_len = 4096;
+  char *data = (char *)MEM_mallocN(data_len, __func__);
+  RNG *rng = BLI_rng_new(1);
+  BLI_rng_get_char_n(rng, data, data_len);
+  BLI_rng_free(rng);
+
+  /* All data of the first state is unique. */
+  BArrayState *state_a = BLI_array_store_state_add(bs, data, data_len, NULL);
+  BLI_array_store_stats_get(bs, &stats);
+  EXPECT_EQ(stats.states_added_num, 1);
+  EXPECT_EQ(stats.size_added, data_len);
+  EXPECT_EQ(stats.size_added_unique, data_len);
+
+  /* None of the same data is unique. */
+  BLI_array_store_state_add(bs, data, data_len, state_a);
+  BLI_array_store_stats_get(bs, &stats);
+  EXPECT_EQ(stats.states_added_num, 2);
+  EXPECT_EQ(stats.size_added, data_len * 2);
+  EXPECT_EQ(stats.size_added_unique, data_len);
+
+  /* Only the chunks around a change are unique. */
+  data[data_len / 2] ^= 1;
+  BLI_array_store_state_add(bs, data, data_len, state_a);
+  BLI_array_store_stats_get(bs, &stats);
+  EXPECT_EQ(stats.states_added_num, 3);
+  EXPECT_GT(stats.size_added_unique, data_len);
+  EXPECT_LT(stats.size_added_unique, data_len + data_len / 2);
+  EXPECT_GE(stats.time_added, 0.0);
+
+  BLI_array_store_clear(bs);
+  BLI_array_store_stats_get(bs, &stats);
+  EXPECT_EQ(stats.states_added_num, 0);
+
+  MEM_freeN(data);
+  BLI_array_store_destroy(bs);
+}
 
 #if 0
 /* -------------------------------------------------------------------- */
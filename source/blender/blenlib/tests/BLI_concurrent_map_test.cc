@@ -0,0 +1,140 @@
+/* Apache License, Version 2.0 */
+
+#include <mutex>
+#include <thread>
+
+#include "BLI_concurrent_map.hh"
+#include "BLI_map.hh"
+#include "BLI_rand.h"
+#include "BLI_timeit.hh"
+#include "BLI_vector.hh"
+#include "testing/testing.h"
+
+namespace blender::tests {
+
+/* Run the function on multiple threads, each getting its thread index. */
+template<typename FuncT> static void run_threaded(const int threads_num, const FuncT &func)
+{
+  Vector<std::thread> threads;
+  for (int i = 0; i < threads_num; i++) {
+    threads.append(std::thread(func, i));
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(concurrent_map, AddLookup)
+{
+  ConcurrentMap<int, int> map;
+  EXPECT_TRUE(map.is_empty());
+  EXPECT_TRUE(map.add(1, 10));
+  EXPECT_TRUE(map.add(2, 20));
+  EXPECT_FALSE(map.add(1, 30));
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_TRUE(map.contains(1));
+  EXPECT_FALSE(map.contains(3));
+  EXPECT_EQ(map.lookup_default(1, 0), 10);
+  EXPECT_EQ(map.lookup_default(3, 0), 0);
+  EXPECT_EQ(map.lookup_ptr(3), nullptr);
+  *map.lookup_ptr(2) = 25;
+  EXPECT_EQ(map.lookup_default(2, 0), 25);
+  EXPECT_TRUE(map.remove(1));
+  EXPECT_FALSE(map.remove(1));
+  EXPECT_EQ(map.size(), 1);
+  map.clear();
+  EXPECT_TRUE(map.is_empty());
+}
+
+TEST(concurrent_map, ShardsAreUsed)
+{
+  ConcurrentMap<int, int, 16> map;
+  for (int i = 0; i < 1000; i++) {
+    map.add(i, i);
+  }
+  /* Consecutive integers have consecutive hashes, they should still be spread out. */
+  for (int i = 0; i < map.shards_num(); i++) {
+    EXPECT_GT(map.shard(i).size(), 20);
+  }
+  int64_t count = 0;
+  map.foreach_item([&](const int key, const int value) {
+    EXPECT_EQ(key, value);
+    count++;
+  });
+  EXPECT_EQ(count, 1000);
+}
+
+TEST(concurrent_map, ThreadedAddOrModify)
+{
+  const int threads_num = 4;
+  const int keys_num = 10000;
+
+  ConcurrentMap<int, int> map;
+  map.reserve(keys_num);
+  run_threaded(threads_num, [&](const int thread) {
+    /* Every thread adds all keys, in a different order. */
+    for (int i = 0; i < keys_num; i++) {
+      const int key = (thread % 2) ? i : keys_num - 1 - i;
+      map.add_or_modify(
+          key, [&](int *value) { *value = thread; }, [&](int *value) { *value += thread; });
+    }
+  });
+
+  EXPECT_EQ(map.size(), keys_num);
+  for (int i = 0; i < keys_num; i++) {
+    EXPECT_EQ(map.lookup_default(i, -1), 0 + 1 + 2 + 3);
+  }
+}
+
+/**
+ * Set this to 1 to activate the benchmark. It is disabled by default, because it prints a lot.
+ */
+#if 0
+static Vector<int> random_ints(const int amount)
+{
+  RNG *rng = BLI_rng_new(0);
+  Vector<int> values;
+  for (int i = 0; i < amount; i++) {
+    values.append(BLI_rng_get_int(rng));
+  }
+  BLI_rng_free(rng);
+  return values;
+}
+
+TEST(concurrent_map, Benchmark)
+{
+  const int threads_num = std::max<int>(std::thread::hardware_concurrency(), 1);
+  const Vector<int> values = random_ints(4000000);
+  const int64_t values_per_thread = values.size() / threads_num;
+
+  for (int i = 0; i < 3; i++) {
+    {
+      Map<int, int> map;
+      std::mutex mutex;
+      SCOPED_TIMER("Map with mutex, add");
+      run_threaded(threads_num, [&](const int thread) {
+        const Span<int> thread_values = values.as_span().slice(thread * values_per_thread,
+                                                               values_per_thread);
+        for (const int value : thread_values) {
+          std::lock_guard<std::mutex> lock(mutex);
+          map.add(value, value);
+        }
+      });
+    }
+    {
+      ConcurrentMap<int, int> map;
+      SCOPED_TIMER("ConcurrentMap, add");
+      run_threaded(threads_num, [&](const int thread) {
+        const Span<int> thread_values = values.as_span().slice(thread * values_per_thread,
+                                                               values_per_thread);
+        for (const int value : thread_values) {
+          map.add(value, value);
+        }
+      });
+    }
+  }
+}
+
+#endif /* Benchmark */
+
+}  // namespace blender::tests
@@ -0,0 +1,57 @@
+/* Apache License, Version 2.0 */
+
+#include <atomic>
+#include <thread>
+
+#include "BLI_concurrent_set.hh"
+#include "BLI_vector.hh"
+#include "testing/testing.h"
+
+namespace blender::tests {
+
+TEST(concurrent_set, AddContainsRemove)
+{
+  ConcurrentSet<int> set;
+  EXPECT_TRUE(set.is_empty());
+  EXPECT_TRUE(set.add(5));
+  EXPECT_FALSE(set.add(5));
+  EXPECT_TRUE(set.add(6));
+  EXPECT_EQ(set.size(), 2);
+  EXPECT_TRUE(set.contains(5));
+  EXPECT_FALSE(set.contains(7));
+  EXPECT_TRUE(set.remove(5));
+  EXPECT_FALSE(set.remove(5));
+  EXPECT_FALSE(set.contains(5));
+  EXPECT_EQ(set.size(), 1);
+}
+
+TEST(concurrent_set, ThreadedAdd)
+{
+  const int threads_num = 4;
+  const int keys_num = 10000;
+
+  ConcurrentSet<int> set;
+  std::atomic<int> added_num(0);
+  Vector<std::thread> threads;
+  for (int thread = 0; thread < threads_num; thread++) {
+    threads.append(std::thread([&]() {
+      for (int i = 0; i < keys_num; i++) {
+        if (set.add(i)) {
+          added_num++;
+        }
+      }
+    }));
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  /* Every key is only added by one of the threads. */
+  EXPECT_EQ(added_num, keys_num);
+  EXPECT_EQ(set.size(), keys_num);
+  int64_t sum = 0;
+  set.foreach_key([&](const int key) { sum += key; });
+  EXPECT_EQ(sum, int64_t(keys_num) * (keys_num - 1) / 2);
+}
+
+}  // namespace blender::tests
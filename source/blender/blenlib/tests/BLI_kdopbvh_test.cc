@@ -132,3 +132,327 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+/* -------------------------------------------------------------------- */
+/* Batched Queries */
+
+static BVHTree *batch_test_tree_new(
+    float (*points)[3], int points_len, float radius, int tree_type, bool flatten)
+{
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, (char)tree_type, 8);
+  for (int i = 0; i < points_len; i++) {
+    float co[2][3];
+    copy_v3_v3(co[0], points[i]);
+    copy_v3_v3(co[1], points[i]);
+    add_v3_fl(co[0], -radius);
+    add_v3_fl(co[1], radius);
+    BLI_bvhtree_insert(tree, i, co[0], 2);
+  }
+  BLI_bvhtree_balance(tree);
+  if (flatten) {
+    BLI_bvhtree_flatten(tree);
+  }
+  return tree;
+}
+
+static void batch_nearest_callback(void *userdata,
+                                   int index,
+                                   const float co[3],
+                                   BVHTreeNearest *nearest)
+{
+  float(*points)[3] = (float(*)[3])userdata;
+  const float dist_sq = len_squared_v3v3(co, points[index]);
+  if (dist_sq < nearest->dist_sq) {
+    nearest->index = index;
+    nearest->dist_sq = dist_sq;
+    copy_v3_v3(nearest->co, points[index]);
+  }
+}
+
+/* Treat the points as spheres of #BATCH_TEST_RADIUS. */
+#define BATCH_TEST_RADIUS 0.01f
+
+static void batch_raycast_callback(void *userdata,
+                                   int index,
+                                   const BVHTreeRay *ray,
+                                   BVHTreeRayHit *hit)
+{
+  float(*points)[3] = (float(*)[3])userdata;
+  float offset[3];
+  sub_v3_v3v3(offset, points[index], ray->origin);
+  const float dist_along = dot_v3v3(offset, ray->direction);
+  const float dist_perp_sq = len_squared_v3(offset) - dist_along * dist_along;
+  const float radius_sq = BATCH_TEST_RADIUS * BATCH_TEST_RADIUS;
+  if (dist_perp_sq > radius_sq) {
+    return;
+  }
+  const float dist = dist_along - sqrtf(radius_sq - dist_perp_sq);
+  if (dist >= 0.0f && dist < hit->dist) {
+    hit->index = index;
+    hit->dist = dist;
+  }
+}
+
+static void batch_range_single_callback(void *userdata,
+                                        int index,
+                                        const float UNUSED(co[3]),
+                                        float UNUSED(dist_sq))
+{
+  *(int *)userdata += index;
+}
+
+static void batch_range_callback(void *userdata,
+                                 int query_index,
+                                 int index,
+                                 const float UNUSED(co[3]),
+                                 float UNUSED(dist_sq))
+{
+  /* Each query only writes its own sum, so this is thread-safe. */
+  ((int *)userdata)[query_index] += index;
+}
+
+static void batch_queries_test(int points_len, int queries_len, int tree_type, bool flatten)
+{
+  struct RNG *rng = BLI_rng_new(points_len);
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  float(*co)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * queries_len, __func__);
+  float(*dir)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * queries_len, __func__);
+
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+  }
+  for (int i = 0; i < queries_len; i++) {
+    rng_v3_round(co[i], 3, rng, 1000, 1.5f);
+    /* Aim near a point, so rays hit something. */
+    sub_v3_v3v3(dir[i], points[i % points_len], co[i]);
+    normalize_v3(dir[i]);
+  }
+
+  BVHTree *tree = batch_test_tree_new(points, points_len, BATCH_TEST_RADIUS, tree_type, flatten);
+
+  BVHTreeNearest *nearest = (BVHTreeNearest *)MEM_mallocN(sizeof(*nearest) * queries_len,
+                                                          __func__);
+  BVHTreeRayHit *hit = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hit) * queries_len, __func__);
+  int *hits = (int *)MEM_mallocN(sizeof(int) * queries_len, __func__);
+  int *index_sum = (int *)MEM_callocN(sizeof(int) * queries_len, __func__);
+  for (int i = 0; i < queries_len; i++) {
+    nearest[i].index = -1;
+    nearest[i].dist_sq = FLT_MAX;
+    hit[i].index = -1;
+    hit[i].dist = BVH_RAYCAST_DIST_MAX;
+  }
+
+  BLI_bvhtree_find_nearest_batch(tree, co, queries_len, nearest, batch_nearest_callback, points);
+  BLI_bvhtree_ray_cast_batch(tree,
+                             co,
+                             dir,
+                             queries_len,
+                             0.0f,
+                             hit,
+                             batch_raycast_callback,
+                             points,
+                             BVH_RAYCAST_DEFAULT);
+  BLI_bvhtree_range_query_batch(
+      tree, co, queries_len, 0.2f, hits, batch_range_callback, index_sum);
+
+  for (int i = 0; i < queries_len; i++) {
+    BVHTreeNearest nearest_single;
+    nearest_single.index = -1;
+    nearest_single.dist_sq = FLT_MAX;
+    BLI_bvhtree_find_nearest(tree, co[i], &nearest_single, batch_nearest_callback, points);
+    EXPECT_EQ(nearest[i].index, nearest_single.index);
+    EXPECT_FLOAT_EQ(nearest[i].dist_sq, nearest_single.dist_sq);
+
+    BVHTreeRayHit hit_single;
+    hit_single.index = -1;
+    hit_single.dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(
+        tree, co[i], dir[i], 0.0f, &hit_single, batch_raycast_callback, points);
+    EXPECT_EQ(hit[i].index, hit_single.index);
+    EXPECT_NE(hit[i].index, -1);
+
+    int index_sum_single = 0;
+    const int hits_single = BLI_bvhtree_range_query(
+        tree, co[i], 0.2f, batch_range_single_callback, &index_sum_single);
+    EXPECT_EQ(hits[i], hits_single);
+    EXPECT_EQ(index_sum[i], index_sum_single);
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+  MEM_freeN(co);
+  MEM_freeN(dir);
+  MEM_freeN(nearest);
+  MEM_freeN(hit);
+  MEM_freeN(hits);
+  MEM_freeN(index_sum);
+}
+
+TEST(kdopbvh, BatchQueries_Binary)
+{
+  batch_queries_test(1000, 2000, 2, false);
+}
+TEST(kdopbvh, BatchQueries_BinaryFlat)
+{
+  batch_queries_test(1000, 2000, 2, true);
+}
+TEST(kdopbvh, BatchQueries_QuadFlat)
+{
+  batch_queries_test(1000, 2000, 4, true);
+}
+TEST(kdopbvh, BatchQueries_OctFlat)
+{
+  batch_queries_test(1000, 2000, 8, true);
+}
+TEST(kdopbvh, BatchQueries_SingleFlat)
+{
+  batch_queries_test(1, 10, 4, true);
+}
+
+/* Rays parallel to the axes, which only test the origin against the slabs of those axes. */
+static void batch_axis_aligned_ray_test(int tree_type)
+{
+  const int grid = 8;
+  const int points_len = grid * grid * grid;
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  for (int i = 0; i < points_len; i++) {
+    points[i][0] = (float)(i % grid);
+    points[i][1] = (float)((i / grid) % grid);
+    points[i][2] = (float)(i / (grid * grid));
+  }
+
+  BVHTree *tree = batch_test_tree_new(points, points_len, BATCH_TEST_RADIUS, tree_type, true);
+
+  /* For every axis, a ray through each row of points along it, and a ray between rows. */
+  const int rows_len = grid * grid;
+  const int queries_len = 3 * 2 * rows_len;
+  float(*co)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * queries_len, __func__);
+  float(*dir)[3] = (float(*)[3])MEM_callocN(sizeof(float[3]) * queries_len, __func__);
+  int *expect_index = (int *)MEM_mallocN(sizeof(int) * queries_len, __func__);
+  BVHTreeRayHit *hit = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hit) * queries_len, __func__);
+
+  int q = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    const int axis_u = (axis + 1) % 3;
+    const int axis_v = (axis + 2) % 3;
+    for (int row = 0; row < rows_len; row++) {
+      for (int between = 0; between < 2; between++, q++) {
+        co[q][axis] = -1.0f;
+        co[q][axis_u] = (float)(row % grid) + (between ? 0.5f : 0.0f);
+        co[q][axis_v] = (float)(row / grid);
+        dir[q][axis] = 1.0f;
+
+        if (between) {
+          expect_index[q] = -1;
+        }
+        else {
+          int co_index[3];
+          co_index[axis] = 0;
+          co_index[axis_u] = row % grid;
+          co_index[axis_v] = row / grid;
+          expect_index[q] = co_index[0] + co_index[1] * grid + co_index[2] * grid * grid;
+        }
+
+        hit[q].index = -1;
+        hit[q].dist = BVH_RAYCAST_DIST_MAX;
+      }
+    }
+  }
+
+  BLI_bvhtree_ray_cast_batch(tree,
+                             co,
+                             dir,
+                             queries_len,
+                             0.0f,
+                             hit,
+                             batch_raycast_callback,
+                             points,
+                             BVH_RAYCAST_DEFAULT);
+
+  for (int i = 0; i < queries_len; i++) {
+    EXPECT_EQ(hit[i].index, expect_index[i]);
+
+    BVHTreeRayHit hit_single;
+    hit_single.index = -1;
+    hit_single.dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(
+        tree, co[i], dir[i], 0.0f, &hit_single, batch_raycast_callback, points);
+    EXPECT_EQ(hit[i].index, hit_single.index);
+  }
+
+  BLI_bvhtree_free(tree);
+  MEM_freeN(points);
+  MEM_freeN(co);
+  MEM_freeN(dir);
+  MEM_freeN(expect_index);
+  MEM_freeN(hit);
+}
+
+TEST(kdopbvh, BatchRayCastAxisAligned_QuadFlat)
+{
+  batch_axis_aligned_ray_test(4);
+}
+TEST(kdopbvh, BatchRayCastAxisAligned_OctFlat)
+{
+  batch_axis_aligned_ray_test(8);
+}
+
+/* Moving the points and refitting must update the flattened bounds too. */
+static void batch_refit_test(int points_len, int queries_len, int tree_type)
+{
+  struct RNG *rng = BLI_rng_new(points_len);
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  float(*co)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * queries_len, __func__);
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+  }
+  for (int i = 0; i < queries_len; i++) {
+    rng_v3_round(co[i], 3, rng, 1000, 1.5f);
+  }
+
+  BVHTree *tree = batch_test_tree_new(points, points_len, BATCH_TEST_RADIUS, tree_type, true);
+
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+    float bounds[2][3];
+    copy_v3_v3(bounds[0], points[i]);
+    copy_v3_v3(bounds[1], points[i]);
+    add_v3_fl(bounds[0], -BATCH_TEST_RADIUS);
+    add_v3_fl(bounds[1], BATCH_TEST_RADIUS);
+    BLI_bvhtree_update_node(tree, i, bounds[0], nullptr, 2);
+  }
+  BLI_bvhtree_update_tree(tree);
+
+  BVHTreeNearest *nearest = (BVHTreeNearest *)MEM_mallocN(sizeof(*nearest) * queries_len,
+                                                          __func__);
+  for (int i = 0; i < queries_len; i++) {
+    nearest[i].index = -1;
+    nearest[i].dist_sq = FLT_MAX;
+  }
+  BLI_bvhtree_find_nearest_batch(tree, co, queries_len, nearest, batch_nearest_callback, points);
+
+  for (int i = 0; i < queries_len; i++) {
+    BVHTreeNearest nearest_single;
+    nearest_single.index = -1;
+    nearest_single.dist_sq = FLT_MAX;
+    BLI_bvhtree_find_nearest(tree, co[i], &nearest_single, batch_nearest_callback, points);
+    EXPECT_EQ(nearest[i].index, nearest_single.index);
+    EXPECT_FLOAT_EQ(nearest[i].dist_sq, nearest_single.dist_sq);
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+  MEM_freeN(co);
+  MEM_freeN(nearest);
+}
+
+TEST(kdopbvh, BatchRefit_BinaryFlat)
+{
+  batch_refit_test(1000, 2000, 2);
+}
+TEST(kdopbvh, BatchRefit_OctFlat)
+{
+  batch_refit_test(1000, 2000, 8);
+}
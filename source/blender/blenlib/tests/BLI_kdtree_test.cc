@@ -0,0 +1,220 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+static KDTree_3d *kdtree_random_new(float (*points)[3], int points_len, struct RNG *rng)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new((uint)points_len);
+  for (int i = 0; i < points_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, points[i]);
+    mul_v3_fl(points[i], BLI_rng_get_float(rng));
+    BLI_kdtree_3d_insert(tree, i, points[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  return tree;
+}
+
+static bool range_search_count_cb(void *user_data,
+                                  int co_index,
+                                  int UNUSED(index),
+                                  const float UNUSED(co[3]),
+                                  float UNUSED(dist_sq))
+{
+  /* Each coordinate only writes its own count, so this is thread-safe. */
+  ((int *)user_data)[co_index]++;
+  return true;
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+static void find_nearest_test(int points_len, int queries_len)
+{
+  struct RNG *rng = BLI_rng_new(points_len);
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  KDTree_3d *tree = kdtree_random_new(points, points_len, rng);
+
+  for (int i = 0; i < queries_len; i++) {
+    float co[3];
+    BLI_rng_get_float_unit_v3(rng, co);
+
+    int index_expect = -1;
+    float dist_sq_expect = FLT_MAX;
+    for (int j = 0; j < points_len; j++) {
+      const float dist_sq = len_squared_v3v3(co, points[j]);
+      if (dist_sq < dist_sq_expect) {
+        dist_sq_expect = dist_sq;
+        index_expect = j;
+      }
+    }
+
+    KDTreeNearest_3d nearest;
+    EXPECT_EQ(BLI_kdtree_3d_find_nearest(tree, co, &nearest), index_expect);
+    EXPECT_FLOAT_EQ(nearest.dist, sqrtf(dist_sq_expect));
+  }
+
+  BLI_kdtree_3d_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+}
+
+TEST(kdtree, FindNearest_Small)
+{
+  find_nearest_test(1000, 100);
+}
+/* Large enough to be balanced in parallel. */
+TEST(kdtree, FindNearest_Large)
+{
+  find_nearest_test(100000, 100);
+}
+
+static void batch_test(int points_len, int queries_len, uint nearest_len_capacity, float range)
+{
+  struct RNG *rng = BLI_rng_new(points_len);
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  float(*co)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * queries_len, __func__);
+  KDTree_3d *tree = kdtree_random_new(points, points_len, rng);
+
+  for (int i = 0; i < queries_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, co[i]);
+    mul_v3_fl(co[i], 1.25f * BLI_rng_get_float(rng));
+  }
+
+  KDTreeNearest_3d *nearest = (KDTreeNearest_3d *)MEM_mallocN(
+      sizeof(*nearest) * queries_len * nearest_len_capacity, __func__);
+  KDTreeNearest_3d *nearest_single = (KDTreeNearest_3d *)MEM_mallocN(
+      sizeof(*nearest_single) * nearest_len_capacity, __func__);
+  int *nearest_len = (int *)MEM_mallocN(sizeof(int) * queries_len, __func__);
+  int *range_len = (int *)MEM_callocN(sizeof(int) * queries_len, __func__);
+
+  BLI_kdtree_3d_find_nearest_n_batch(
+      tree, co, (uint)queries_len, nearest, nearest_len, nearest_len_capacity);
+  BLI_kdtree_3d_range_search_batch_cb(
+      tree, co, (uint)queries_len, range, range_search_count_cb, range_len);
+
+  for (int i = 0; i < queries_len; i++) {
+    const int nearest_single_len = BLI_kdtree_3d_find_nearest_n(
+        tree, co[i], nearest_single, nearest_len_capacity);
+    EXPECT_EQ(nearest_len[i], nearest_single_len);
+    for (int j = 0; j < nearest_single_len; j++) {
+      const KDTreeNearest_3d *n = &nearest[i * nearest_len_capacity + j];
+      EXPECT_EQ(n->index, nearest_single[j].index);
+      EXPECT_FLOAT_EQ(n->dist, nearest_single[j].dist);
+      EXPECT_V3_NEAR(n->co, points[n->index], 0.0f);
+    }
+
+    KDTreeNearest_3d *range_single = NULL;
+    const int range_single_len = BLI_kdtree_3d_range_search(tree, co[i], &range_single, range);
+    EXPECT_EQ(range_len[i], range_single_len);
+    MEM_SAFE_FREE(range_single);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+  MEM_freeN(co);
+  MEM_freeN(nearest);
+  MEM_freeN(nearest_single);
+  MEM_freeN(nearest_len);
+  MEM_freeN(range_len);
+}
+
+TEST(kdtree, Batch_Single)
+{
+  batch_test(1, 10, 4, 0.5f);
+}
+TEST(kdtree, Batch_Bucket)
+{
+  batch_test(10, 100, 4, 0.5f);
+}
+TEST(kdtree, Batch_Nearest)
+{
+  batch_test(10000, 1000, 1, 0.05f);
+}
+TEST(kdtree, Batch_NearestN)
+{
+  batch_test(10000, 1000, 16, 0.1f);
+}
+TEST(kdtree, Batch_NearestN_Large)
+{
+  batch_test(100000, 1000, 32, 0.05f);
+}
+
+/* Compare batch queries with brute force, for trees with buckets of every size from the SIMD
+ * width of 4 nodes up to the largest bucket, so both the SIMD and remainder paths are used. */
+static void batch_brute_force_test(int points_len, uint nearest_len_capacity, float range)
+{
+  const int queries_len = 100;
+  struct RNG *rng = BLI_rng_new(points_len);
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  float(*co)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * queries_len, __func__);
+  KDTree_3d *tree = kdtree_random_new(points, points_len, rng);
+
+  for (int i = 0; i < queries_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, co[i]);
+    mul_v3_fl(co[i], 1.25f * BLI_rng_get_float(rng));
+  }
+
+  KDTreeNearest_3d *nearest = (KDTreeNearest_3d *)MEM_mallocN(
+      sizeof(*nearest) * queries_len * nearest_len_capacity, __func__);
+  int *nearest_len = (int *)MEM_mallocN(sizeof(int) * queries_len, __func__);
+  int *range_len = (int *)MEM_callocN(sizeof(int) * queries_len, __func__);
+  int *order = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+  float *dist_sq = (float *)MEM_mallocN(sizeof(float) * points_len, __func__);
+
+  BLI_kdtree_3d_find_nearest_n_batch(
+      tree, co, (uint)queries_len, nearest, nearest_len, nearest_len_capacity);
+  BLI_kdtree_3d_range_search_batch_cb(
+      tree, co, (uint)queries_len, range, range_search_count_cb, range_len);
+
+  for (int i = 0; i < queries_len; i++) {
+    int range_len_expect = 0;
+    for (int j = 0; j < points_len; j++) {
+      order[j] = j;
+      dist_sq[j] = len_squared_v3v3(co[i], points[j]);
+      range_len_expect += (dist_sq[j] <= range * range);
+    }
+    std::sort(order, order + points_len, [&](int a, int b) { return dist_sq[a] < dist_sq[b]; });
+
+    const int nearest_len_expect = min_ii(points_len, (int)nearest_len_capacity);
+    EXPECT_EQ(nearest_len[i], nearest_len_expect);
+    for (int j = 0; j < nearest_len_expect; j++) {
+      const KDTreeNearest_3d *n = &nearest[i * nearest_len_capacity + j];
+      EXPECT_EQ(n->index, order[j]);
+      EXPECT_FLOAT_EQ(n->dist, sqrtf(dist_sq[order[j]]));
+    }
+    EXPECT_EQ(range_len[i], range_len_expect);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+  MEM_freeN(co);
+  MEM_freeN(nearest);
+  MEM_freeN(nearest_len);
+  MEM_freeN(range_len);
+  MEM_freeN(order);
+  MEM_freeN(dist_sq);
+}
+
+TEST(kdtree, BatchBruteForce_Buckets)
+{
+  for (int points_len = 4; points_len <= 40; points_len++) {
+    batch_brute_force_test(points_len, 8, 0.5f);
+  }
+}
+TEST(kdtree, BatchBruteForce_Large)
+{
+  batch_brute_force_test(5000, 16, 0.1f);
+}
@@ -0,0 +1,166 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_double2.hh"
+#include "BLI_double3.hh"
+#include "BLI_math_boolean.hh"
+#include "BLI_math_mpq.hh"
+#include "BLI_mpq2.hh"
+#include "BLI_mpq3.hh"
+#include "BLI_rand.hh"
+
+#ifdef WITH_GMP
+namespace blender::tests {
+
+static double2 approx(const mpq2 &p)
+{
+  return double2(p.x.get_d(), p.y.get_d());
+}
+
+static double3 approx(const mpq3 &p)
+{
+  return double3(p.x.get_d(), p.y.get_d(), p.z.get_d());
+}
+
+/* A rational that is not exactly representable as a double in most cases. */
+static mpq_class random_mpq(RandomNumberGenerator &rng)
+{
+  return mpq_class(rng.get_int32(2001) - 1000, rng.get_int32(97) + 3);
+}
+
+static mpq2 random_mpq2(RandomNumberGenerator &rng)
+{
+  return mpq2(random_mpq(rng), random_mpq(rng));
+}
+
+static mpq3 random_mpq3(RandomNumberGenerator &rng)
+{
+  return mpq3(random_mpq(rng), random_mpq(rng), random_mpq(rng));
+}
+
+/* The filter must either be unsure, or agree with the exact predicate. */
+static void expect_filter_valid(int filter, int exact)
+{
+  if (filter != 0) {
+    EXPECT_EQ(filter, exact);
+  }
+}
+
+TEST(math_boolean, Orient2dFilterClear)
+{
+  double2 a(0.0, 0.0);
+  double2 b(1.0, 0.0);
+  double2 c(0.0, 1.0);
+  EXPECT_EQ(orient2d_filter(a, b, c), 1);
+  EXPECT_EQ(orient2d_filter(a, c, b), -1);
+  EXPECT_EQ(orient2d_filter(a, b, c), orient2d(a, b, c));
+}
+
+TEST(math_boolean, Orient2dFilterDegenerate)
+{
+  /* Exactly collinear, but not representable in doubles. */
+  mpq2 a(mpq_class(1, 3), mpq_class(1, 7));
+  mpq2 b(mpq_class(5, 3), mpq_class(9, 7));
+  mpq2 c = a + (b - a) * mpq_class(2, 11);
+  EXPECT_EQ(orient2d(a, b, c), 0);
+  EXPECT_EQ(orient2d_filter(approx(a), approx(b), approx(c)), 0);
+
+  /* Underflowing error bound. */
+  double2 t0(0.0, 0.0);
+  double2 t1(1e-300, 0.0);
+  double2 t2(0.0, 1e-300);
+  EXPECT_EQ(orient2d_filter(t0, t1, t2), 0);
+}
+
+TEST(math_boolean, Orient2dFilterRandom)
+{
+  RandomNumberGenerator rng(1);
+  int num_decided = 0;
+  for (int i = 0; i < 1000; i++) {
+    mpq2 a = random_mpq2(rng);
+    mpq2 b = random_mpq2(rng);
+    mpq2 c = random_mpq2(rng);
+    /* Every other point is moved very close to the line through a and b. */
+    if (i % 2) {
+      c = a + (b - a) * random_mpq(rng) + mpq2(mpq_class(1, 1000000000), 0);
+    }
+    const int filter = orient2d_filter(approx(a), approx(b), approx(c));
+    expect_filter_valid(filter, orient2d(a, b, c));
+    num_decided += (filter != 0);
+  }
+  /* Generic points must be decided by the filter. */
+  EXPECT_GE(num_decided, 450);
+}
+
+TEST(math_boolean, IncircleFilterClear)
+{
+  double2 a(1.0, 0.0);
+  double2 b(0.0, 1.0);
+  double2 c(-1.0, 0.0);
+  EXPECT_EQ(incircle_filter(a, b, c, double2(0.0, 0.0)), 1);
+  EXPECT_EQ(incircle_filter(a, b, c, double2(2.0, 2.0)), -1);
+  EXPECT_EQ(incircle_filter(a, b, c, double2(0.0, -1.0)), 0);
+}
+
+TEST(math_boolean, IncircleFilterRandom)
+{
+  RandomNumberGenerator rng(2);
+  int num_decided = 0;
+  for (int i = 0; i < 1000; i++) {
+    mpq2 a = random_mpq2(rng);
+    mpq2 b = random_mpq2(rng);
+    mpq2 c = random_mpq2(rng);
+    mpq2 d = random_mpq2(rng);
+    /* Every other set of points are the corners of a rectangle, which are on a circle. */
+    if (i % 2) {
+      c = mpq2(a.x, b.y);
+      d = mpq2(b.x, a.y);
+    }
+    const int filter = incircle_filter(approx(a), approx(b), approx(c), approx(d));
+    expect_filter_valid(filter, incircle(a, b, c, d));
+    num_decided += (filter != 0);
+  }
+  EXPECT_GE(num_decided, 400);
+}
+
+TEST(math_boolean, Orient3dFilterClear)
+{
+  double3 a(0.0, 0.0, 0.0);
+  double3 b(1.0, 0.0, 0.0);
+  double3 c(0.0, 1.0, 0.0);
+  double3 above(0.0, 0.0, 1.0);
+  double3 below(0.0, 0.0, -1.0);
+  double3 on(0.5, 0.5, 0.0);
+  EXPECT_NE(orient3d_filter(a, b, c, above), 0);
+  EXPECT_EQ(orient3d_filter(a, b, c, above), orient3d(a, b, c, above));
+  EXPECT_EQ(orient3d_filter(a, b, c, below), orient3d(a, b, c, below));
+  EXPECT_EQ(orient3d_filter(a, b, c, on), 0);
+}
+
+TEST(math_boolean, Orient3dFilterRandom)
+{
+  RandomNumberGenerator rng(3);
+  int num_decided = 0;
+  for (int i = 0; i < 1000; i++) {
+    mpq3 a = random_mpq3(rng);
+    mpq3 b = random_mpq3(rng);
+    mpq3 c = random_mpq3(rng);
+    mpq3 d = random_mpq3(rng);
+    /* Every other point is exactly on the plane through a, b and c. */
+    if (i % 2) {
+      d = a + (b - a) * random_mpq(rng) + (c - a) * random_mpq(rng);
+    }
+    const int filter = orient3d_filter(approx(a), approx(b), approx(c), approx(d));
+    const int exact = orient3d(a, b, c, d);
+    expect_filter_valid(filter, exact);
+    if (i % 2) {
+      EXPECT_EQ(filter, 0);
+    }
+    num_decided += (filter != 0);
+  }
+  EXPECT_GE(num_decided, 400);
+}
+
+}  // namespace blender::tests
+#endif
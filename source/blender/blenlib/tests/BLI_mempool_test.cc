@@ -0,0 +1,115 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_mempool.h"
+#include "BLI_utildefines.h"
+
+namespace {
+
+struct Elem {
+  int thread;
+  int index;
+};
+
+void alloc_elems(BLI_mempool *pool, const int thread, const int len, std::vector<Elem *> &r_elems)
+{
+  BLI_mempool_local *local = BLI_mempool_local_create(pool);
+  for (int i = 0; i < len; i++) {
+    Elem *elem = (Elem *)((i % 2) ? BLI_mempool_local_alloc(local) :
+                                    BLI_mempool_local_calloc(local));
+    elem->thread = thread;
+    elem->index = i;
+    r_elems.push_back(elem);
+    /* Free some right away, so elements are reused. */
+    if (i % 5 == 4) {
+      BLI_mempool_local_free(local, r_elems.back());
+      r_elems.pop_back();
+    }
+  }
+  BLI_mempool_local_destroy(local);
+}
+
+}  // namespace
+
+TEST(mempool, ThreadsafeAllocFree)
+{
+  const int threads_num = 4;
+  const int len = 20000;
+
+  BLI_mempool *pool = BLI_mempool_create(
+      sizeof(Elem), 0, 512, BLI_MEMPOOL_ALLOW_ITER | BLI_MEMPOOL_THREADSAFE);
+
+  std::vector<std::vector<Elem *>> elems(threads_num);
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < threads_num; thread++) {
+    threads.emplace_back(alloc_elems, pool, thread, len, std::ref(elems[thread]));
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+
+  int elems_len = 0;
+  for (int thread = 0; thread < threads_num; thread++) {
+    for (const Elem *elem : elems[thread]) {
+      EXPECT_EQ(elem->thread, thread);
+      EXPECT_NE(elem->index % 5, 4);
+    }
+    elems_len += (int)elems[thread].size();
+  }
+  EXPECT_EQ(BLI_mempool_len(pool), elems_len);
+
+  /* Iterate from multiple threads. */
+  std::atomic<int> iter_len(0);
+  BLI_mempool_iter *iters = BLI_mempool_iter_threadsafe_create(pool, threads_num);
+  for (int thread = 0; thread < threads_num; thread++) {
+    threads.emplace_back([&, thread]() {
+      int len_local = 0;
+      for (Elem *elem = (Elem *)BLI_mempool_iterstep(&iters[thread]); elem;
+           elem = (Elem *)BLI_mempool_iterstep(&iters[thread])) {
+        EXPECT_LT(elem->thread, threads_num);
+        len_local++;
+      }
+      iter_len += len_local;
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+  BLI_mempool_iter_threadsafe_free(iters);
+  EXPECT_EQ(iter_len, elems_len);
+
+  /* Free elements allocated by other threads. */
+  for (int thread = 0; thread < threads_num; thread++) {
+    threads.emplace_back([&, thread]() {
+      BLI_mempool_local *local = BLI_mempool_local_create(pool);
+      for (Elem *elem : elems[(thread + 1) % threads_num]) {
+        BLI_mempool_local_free(local, elem);
+      }
+      BLI_mempool_local_destroy(local);
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(BLI_mempool_len(pool), 0);
+
+  /* Freed elements are reused by the single threaded API. */
+  BLI_mempool_iter iter;
+  BLI_mempool_iternew(pool, &iter);
+  EXPECT_EQ(BLI_mempool_iterstep(&iter), nullptr);
+  void *elem = BLI_mempool_alloc(pool);
+  EXPECT_EQ(BLI_mempool_len(pool), 1);
+  BLI_mempool_free(pool, elem);
+  EXPECT_EQ(BLI_mempool_len(pool), 0);
+
+  BLI_mempool_destroy(pool);
+}
@@ -906,5 +906,135 @@ TEST(boolean_polymesh, CubePlane)
   }
 }
 
+TEST(boolean_polymesh, CubeCubeCubeDiff)
+{
+  /* Big cube minus two small cubes at opposite corners. */
+  const char *spec = R"(24 18
+  0 0 0
+  0 0 4
+  0 4 0
+  0 4 4
+  4 0 0
+  4 0 4
+  4 4 0
+  4 4 4
+  -1 -1 -1
+  -1 -1 1
+  -1 1 -1
+  -1 1 1
+  1 -1 -1
+  1 -1 1
+  1 1 -1
+  1 1 1
+  3 3 3
+  3 3 5
+  3 5 3
+  3 5 5
+  5 3 3
+  5 3 5
+  5 5 3
+  5 5 5
+  0 1 3 2
+  2 3 7 6
+  6 7 5 4
+  4 5 1 0
+  2 6 4 0
+  7 3 1 5
+  8 9 11 10
+  10 11 15 14
+  14 15 13 12
+  12 13 9 8
+  10 14 12 8
+  15 11 9 13
+  16 17 19 18
+  18 19 23 22
+  22 23 21 20
+  20 21 17 16
+  18 22 20 16
+  23 19 17 21
+  )";
+
+  IMeshBuilder mb(spec);
+  IMesh out = boolean_mesh(
+      mb.imesh,
+      BoolOpType::Difference,
+      3,
+      [](int t) { return t / 6; },
+      false,
+      nullptr,
+      &mb.arena);
+  out.populate_vert();
+  EXPECT_EQ(out.vert_size(), 20);
+  EXPECT_EQ(out.face_size(), 12);
+  /* Both corners are cut away. */
+  for (const Vert *v : out.vertices()) {
+    EXPECT_FALSE(v->co_exact == mpq3(0, 0, 0));
+    EXPECT_FALSE(v->co_exact == mpq3(4, 4, 4));
+  }
+  if (DO_OBJ) {
+    write_obj_mesh(out, "cubecubecubediff");
+  }
+}
+
+TEST(boolean_polymesh, CubeCubePlaneDiff)
+{
+  /* Not PWN because of the plane, the third shape which is outside of the others. */
+  const char *spec = R"(20 13
+  0 0 0
+  0 0 4
+  0 4 0
+  0 4 4
+  4 0 0
+  4 0 4
+  4 4 0
+  4 4 4
+  3 3 3
+  3 3 5
+  3 5 3
+  3 5 5
+  5 3 3
+  5 3 5
+  5 5 3
+  5 5 5
+  -1 -1 100
+  1 -1 100
+  -1 1 100
+  1 1 100
+  0 1 3 2
+  2 3 7 6
+  6 7 5 4
+  4 5 1 0
+  2 6 4 0
+  7 3 1 5
+  8 9 11 10
+  10 11 15 14
+  14 15 13 12
+  12 13 9 8
+  10 14 12 8
+  15 11 9 13
+  16 17 19 18
+  )";
+
+  IMeshBuilder mb(spec);
+  IMesh out = boolean_mesh(
+      mb.imesh,
+      BoolOpType::Difference,
+      3,
+      [](int t) { return t < 12 ? t / 6 : 2; },
+      false,
+      nullptr,
+      &mb.arena);
+  out.populate_vert();
+  EXPECT_EQ(out.vert_size(), 14);
+  EXPECT_EQ(out.face_size(), 9);
+  for (const Vert *v : out.vertices()) {
+    EXPECT_FALSE(v->co_exact == mpq3(4, 4, 4));
+    EXPECT_FALSE(v->co_exact[2] == 100);
+  }
+  if (DO_OBJ) {
+    write_obj_mesh(out, "cubecubeplanediff");
+  }
+}
+
 }  // namespace blender::meshintersect::tests
 #endif
@@ -924,6 +924,53 @@ static void spheresphere_test(int nrings, double y_offset, bool use_self)
   BLI_task_scheduler_exit();
 }
 
+/**
+ * Self intersect a chain of \a nspheres uvspheres, each overlapping the next one,
+ * as a large self-intersecting mesh where most of the intersection tests are not degenerate.
+ */
+static void spherechain_self_test(int nspheres, int nrings)
+{
+  if (nspheres < 1 || nrings < 2) {
+    return;
+  }
+  BLI_task_scheduler_init(); /* Without this, no parallelism. */
+  double time_start = PIL_check_seconds_timer();
+  IMeshArena arena;
+  int nsegs = 2 * nrings;
+  int num_sphere_verts;
+  int num_sphere_tris;
+  get_sphere_params(nrings, nsegs, true, &num_sphere_verts, &num_sphere_tris);
+  Array<Face *> tris(nspheres * num_sphere_tris);
+  arena.reserve(nspheres * num_sphere_verts, nspheres * num_sphere_tris);
+  for (int i = 0; i < nspheres; ++i) {
+    /* Offsets that are not nicely representable, so intersection points are far from exact
+     * doubles and the intersection tests are done on rationals with large denominators. */
+    double3 center(i * 0.73, i * 0.11, i * 0.07);
+    fill_sphere_data(nrings,
+                     nsegs,
+                     center,
+                     1.0,
+                     true,
+                     MutableSpan<Face *>(tris.begin() + i * num_sphere_tris, num_sphere_tris),
+                     i * num_sphere_verts,
+                     i * num_sphere_tris,
+                     &arena);
+  }
+  IMesh mesh(tris);
+  double time_create = PIL_check_seconds_timer();
+  IMesh out = trimesh_self_intersect(mesh, &arena);
+  double time_intersect = PIL_check_seconds_timer();
+  std::cout << "Input: " << mesh.face_size() << " tris, output: " << out.face_size()
+            << " tris\n";
+  std::cout << "Create time: " << time_create - time_start << "\n";
+  std::cout << "Intersect time: " << time_intersect - time_create << "\n";
+  std::cout << "Total time: " << time_intersect - time_start << "\n";
+  if (DO_OBJ) {
+    write_obj_mesh(out, "spherechain");
+  }
+  BLI_task_scheduler_exit();
+}
+
 static void get_grid_params(
     int x_subdiv, int y_subdiv, bool triangulate, int *r_num_verts, int *r_num_faces)
 {
@@ -1068,6 +1115,11 @@ TEST(mesh_intersect_perf, SphereGrid)
   spheregrid_test(512, 4, 0.1, false);
 }
 
+TEST(mesh_intersect_perf, SphereChainSelf)
+{
+  spherechain_self_test(8, 64);
+}
+
 #  endif
 
 }  // namespace blender::meshintersect::tests
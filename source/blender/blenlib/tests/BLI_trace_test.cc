@@ -0,0 +1,108 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <string>
+#include <thread>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_trace.h"
+#include "BLI_trace.hh"
+
+namespace blender::tests {
+
+static std::string trace_json_get()
+{
+  char *json = BLI_trace_json();
+  std::string result = json;
+  MEM_freeN(json);
+  return result;
+}
+
+static int count_occurrences(const std::string &str, const std::string &part)
+{
+  int count = 0;
+  for (size_t pos = str.find(part); pos != std::string::npos; pos = str.find(part, pos + 1)) {
+    count++;
+  }
+  return count;
+}
+
+TEST(trace, NotRunning)
+{
+  BLI_trace_stop();
+  BLI_trace_clear();
+  {
+    blender::trace::ScopedZone zone("Not Recorded");
+  }
+  EXPECT_EQ(trace_json_get().find("Not Recorded"), std::string::npos);
+}
+
+TEST(trace, Nested)
+{
+  BLI_trace_clear();
+  BLI_trace_start();
+  {
+    blender::trace::ScopedZone outer("Outer");
+    {
+      blender::trace::ScopedZone inner("Inner", "de\"tail");
+    }
+  }
+  BLI_TRACE_ZONE_BEGIN(zone, "From C", nullptr);
+  BLI_TRACE_ZONE_END(zone);
+  BLI_trace_stop();
+
+  const std::string json = trace_json_get();
+  EXPECT_NE(json.find("\"traceEvents\""), std::string::npos);
+  /* Inner zones end first. */
+  const size_t inner = json.find("\"name\":\"Inner\"");
+  const size_t outer = json.find("\"name\":\"Outer\"");
+  EXPECT_NE(inner, std::string::npos);
+  EXPECT_NE(outer, std::string::npos);
+  EXPECT_LT(inner, outer);
+  EXPECT_NE(json.find("\"detail\":\"de\\\"tail\""), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"From C\""), std::string::npos);
+
+  BLI_trace_clear();
+  EXPECT_EQ(trace_json_get().find("\"name\":\"Outer\""), std::string::npos);
+}
+
+TEST(trace, Threads)
+{
+  BLI_trace_clear();
+  BLI_trace_start();
+  std::thread threads[4];
+  for (std::thread &thread : threads) {
+    thread = std::thread([]() {
+      for (int i = 0; i < 100; i++) {
+        blender::trace::ScopedZone zone("Thread Zone");
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  BLI_trace_stop();
+
+  EXPECT_EQ(count_occurrences(trace_json_get(), "\"name\":\"Thread Zone\""), 400);
+  BLI_trace_clear();
+}
+
+TEST(trace, RingBufferOverflow)
+{
+  BLI_trace_clear();
+  BLI_trace_start();
+  for (int i = 0; i < 100000; i++) {
+    blender::trace::ScopedZone zone("Many");
+  }
+  BLI_trace_stop();
+
+  /* Only the most recent zones are kept. */
+  const int count = count_occurrences(trace_json_get(), "\"name\":\"Many\"");
+  EXPECT_GT(count, 0);
+  EXPECT_LT(count, 100000);
+  BLI_trace_clear();
+}
+
+}  // namespace blender::tests
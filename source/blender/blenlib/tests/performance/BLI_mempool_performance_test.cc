@@ -0,0 +1,113 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_mempool.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+
+/* Compare allocating and freeing mempool elements from multiple threads,
+ * using a lock around the single threaded API and using thread local allocators. */
+
+#define ELEM_SIZE 64
+#define BATCH_LEN 1024
+#define BATCHES_NUM 2000
+
+/* Allocate a batch of elements and free them again, like splitting and collapsing edges. */
+template<typename AllocFn, typename FreeFn> static void alloc_free_loop(AllocFn alloc, FreeFn free)
+{
+  std::vector<void *> elems(BATCH_LEN);
+  for (int batch = 0; batch < BATCHES_NUM; batch++) {
+    for (void *&elem : elems) {
+      elem = alloc();
+      memset(elem, batch, ELEM_SIZE);
+    }
+    /* Free in a different order than allocated. */
+    for (int i = 0; i < BATCH_LEN; i++) {
+      free(elems[(i * 7) % BATCH_LEN]);
+    }
+  }
+}
+
+static double mempool_locked_run(const int threads_num)
+{
+  BLI_mempool *pool = BLI_mempool_create(ELEM_SIZE, 0, 512, BLI_MEMPOOL_ALLOW_ITER);
+  std::mutex mutex;
+
+  const double start = PIL_check_seconds_timer();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < threads_num; i++) {
+    threads.emplace_back([&]() {
+      alloc_free_loop(
+          [&]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return BLI_mempool_alloc(pool);
+          },
+          [&](void *elem) {
+            std::lock_guard<std::mutex> lock(mutex);
+            BLI_mempool_free(pool, elem);
+          });
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  const double time = PIL_check_seconds_timer() - start;
+
+  EXPECT_EQ(BLI_mempool_len(pool), 0);
+  BLI_mempool_destroy(pool);
+  return time;
+}
+
+static double mempool_local_run(const int threads_num)
+{
+  BLI_mempool *pool = BLI_mempool_create(
+      ELEM_SIZE, 0, 512, BLI_MEMPOOL_ALLOW_ITER | BLI_MEMPOOL_THREADSAFE);
+
+  const double start = PIL_check_seconds_timer();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < threads_num; i++) {
+    threads.emplace_back([&]() {
+      BLI_mempool_local *local = BLI_mempool_local_create(pool);
+      alloc_free_loop([&]() { return BLI_mempool_local_alloc(local); },
+                      [&](void *elem) { BLI_mempool_local_free(local, elem); });
+      BLI_mempool_local_destroy(local);
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  const double time = PIL_check_seconds_timer() - start;
+
+  EXPECT_EQ(BLI_mempool_len(pool), 0);
+  BLI_mempool_destroy(pool);
+  return time;
+}
+
+TEST(mempool, ThreadsafeScaling)
+{
+  const int threads_max = std::max((int)std::thread::hardware_concurrency(), 1);
+
+  printf("\n========== STARTING mempool threaded alloc/free ==========\n");
+  for (int threads_num = 1;; threads_num = std::min(threads_num * 2, threads_max)) {
+    const double ops = 2.0 * BATCH_LEN * BATCHES_NUM * threads_num;
+    const double time_locked = mempool_locked_run(threads_num);
+    const double time_local = mempool_local_run(threads_num);
+    printf("%d threads: locked %.2f, thread local %.2f M alloc & free per second\n",
+           threads_num,
+           ops / time_locked * 1e-6,
+           ops / time_local * 1e-6);
+    if (threads_num == threads_max) {
+      break;
+    }
+  }
+  printf("========== ENDED mempool threaded alloc/free ==========\n\n");
+}
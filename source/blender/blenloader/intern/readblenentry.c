@@ -35,6 +35,7 @@
 #include "BLI_linklist.h"
 #include "BLI_listbase.h"
 #include "BLI_string.h"
+#include "BLI_trace.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_genfile.h"
@@ -312,6 +313,7 @@ BlendFileData *BLO_read_from_file(const char *filepath,
   BlendFileData *bfd = NULL;
   FileData *fd;
 
+  BLI_TRACE_ZONE_BEGIN(trace_zone, "Read File", filepath);
   fd = blo_filedata_from_file(filepath, reports);
   if (fd) {
     fd->reports = reports;
@@ -319,6 +321,7 @@ BlendFileData *BLO_read_from_file(const char *filepath,
     bfd = blo_read_file_internal(fd, filepath);
     blo_filedata_free(fd);
   }
+  BLI_TRACE_ZONE_END(trace_zone);
 
   return bfd;
 }
@@ -149,6 +149,7 @@
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_mempool.h"
+#include "BLI_trace.h"
 #include "MEM_guardedalloc.h"  // MEM_freeN
 
 #include "BKE_action.h"
@@ -3956,7 +3957,9 @@ bool BLO_write_file(Main *mainvar,
   }
 
   /* actual file writing */
+  BLI_TRACE_ZONE_BEGIN(trace_zone, "Write File", filepath);
   const bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, use_userdef, thumb);
+  BLI_TRACE_ZONE_END(trace_zone);
 
   ww.close(&ww);
 
@@ -4002,8 +4005,10 @@ bool BLO_write_file_mem(Main *mainvar, MemFile *compare, MemFile *current, int w
 {
   bool use_userdef = false;
 
+  BLI_TRACE_ZONE_BEGIN(trace_zone, "Write Undo MemFile", NULL);
   const bool err = write_file_handle(
       mainvar, NULL, compare, current, write_flags, use_userdef, NULL);
+  BLI_TRACE_ZONE_END(trace_zone);
 
   return (err == 0);
 }
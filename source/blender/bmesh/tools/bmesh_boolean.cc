@@ -331,6 +331,7 @@ static bool bmesh_boolean(BMesh *bm,
                           const int looptris_tot,
                           int (*test_fn)(BMFace *f, void *user_data),
                           void *user_data,
+                          const int nshapes,
                           const bool use_self,
                           const bool use_separate_all,
                           const BoolOpType boolean_mode)
@@ -339,10 +340,8 @@ static bool bmesh_boolean(BMesh *bm,
   IMesh m_triangulated;
   IMesh m_in = mesh_from_bm(bm, looptris, looptris_tot, &m_triangulated, &arena);
   std::function<int(int)> shape_fn;
-  int nshapes;
   if (use_self) {
     /* Unary boolean operation. Want every face where test_fn doesn't return -1. */
-    nshapes = 1;
     shape_fn = [bm, test_fn, user_data](int f) {
       BMFace *bmf = BM_face_at_index(bm, f);
       if (test_fn(bmf, user_data) != -1) {
@@ -352,21 +351,23 @@ static bool bmesh_boolean(BMesh *bm,
     };
   }
   else {
-    nshapes = 2;
-    shape_fn = [bm, test_fn, user_data](int f) {
+    /* The shape function is called from multiple threads, so \a test_fn must be thread-safe. */
+    shape_fn = [bm, test_fn, user_data, nshapes](int f) {
       BMFace *bmf = BM_face_at_index(bm, f);
       int test_val = test_fn(bmf, user_data);
-      if (test_val == 0) {
-        return 0;
-      }
-      if (test_val == 1) {
-        return 1;
+      if (test_val >= 0 && test_val < nshapes) {
+        return test_val;
       }
       return -1;
     };
   }
-  IMesh m_out = boolean_mesh(
-      m_in, boolean_mode, nshapes, shape_fn, use_self, &m_triangulated, &arena);
+  IMesh m_out = boolean_mesh(m_in,
+                             boolean_mode,
+                             use_self ? 1 : nshapes,
+                             shape_fn,
+                             use_self,
+                             &m_triangulated,
+                             &arena);
   bool any_change = apply_mesh_output_to_bmesh(bm, m_out);
   if (use_separate_all) {
     /* We are supposed to separate all faces that are incident on intersection edges. */
@@ -384,18 +385,17 @@ extern "C" {
 /**
  * Perform the boolean operation specified by boolean_mode on the mesh bm.
  * The inputs to the boolean operation are either one sub-mesh (if use_self is true),
- * or two sub-meshes. The sub-meshes are specified by providing a test_fn which takes
- * a face and the supplied user_data and says with 'side' of the boolean operation
- * that face is for: 0 for the first side (side A), 1 for the second side (side B),
- * and -1 if the face is to be ignored completely in the boolean operation.
+ * or nshapes sub-meshes. The sub-meshes are specified by providing a test_fn which takes
+ * a face and the supplied user_data and says which operand of the boolean operation
+ * that face is for: 0 for the first operand (side A), 1 for the second (side B) and so on
+ * up to nshapes - 1, and -1 if the face is to be ignored completely in the boolean operation.
+ * The test_fn may be called from multiple threads.
  *
  * If use_self is true, all operations do the same: the sub-mesh is self-intersected
  * and all pieces inside that result are removed.
  * Otherwise, the operations can be one of #BMESH_ISECT_BOOLEAN_ISECT, #BMESH_ISECT_BOOLEAN_UNION,
- * or #BMESH_ISECT_BOOLEAN_DIFFERENCE.
- *
- * (The actual library function called to do the boolean is internally capable of handling
- * n-ary operands, so maybe in the future we can expose that functionality to users.)
+ * or #BMESH_ISECT_BOOLEAN_DIFFERENCE. With more than two operands the difference is
+ * the first operand minus the union of the others.
  */
 #ifdef WITH_GMP
 bool BM_mesh_boolean(BMesh *bm,
@@ -403,6 +403,7 @@ bool BM_mesh_boolean(BMesh *bm,
                      const int looptris_tot,
                      int (*test_fn)(BMFace *f, void *user_data),
                      void *user_data,
+                     const int nshapes,
                      const bool use_self,
                      const int boolean_mode)
 {
@@ -412,6 +413,7 @@ bool BM_mesh_boolean(BMesh *bm,
       looptris_tot,
       test_fn,
       user_data,
+      nshapes,
       use_self,
       false,
       static_cast<blender::meshintersect::BoolOpType>(boolean_mode));
@@ -438,6 +440,7 @@ bool BM_mesh_boolean_knife(BMesh *bm,
                                                looptris_tot,
                                                test_fn,
                                                user_data,
+                                               2,
                                                use_self,
                                                use_separate_all,
                                                blender::meshintersect::BoolOpType::None);
@@ -448,6 +451,7 @@ bool BM_mesh_boolean(BMesh *UNUSED(bm),
                      const int UNUSED(looptris_tot),
                      int (*test_fn)(BMFace *, void *),
                      void *UNUSED(user_data),
+                     const int UNUSED(nshapes),
                      const bool UNUSED(use_self),
                      const int UNUSED(boolean_mode))
 {
@@ -30,6 +30,7 @@
 #include "BLI_compiler_attrs.h"
 #include "BLI_gsqueue.h"
 #include "BLI_task.h"
+#include "BLI_trace.hh"
 #include "BLI_utildefines.h"
 
 #include "BKE_global.h"
@@ -104,6 +105,7 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
 
   /* Sanity checks. */
   BLI_assert(!operation_node->is_noop() && "NOOP nodes should not actually be scheduled");
+  TRACE_SCOPE_DETAIL("Depsgraph Operation", operation_node->full_identifier().c_str());
   /* Perform operation. */
   if (state->do_stats) {
     const double start_time = PIL_check_seconds_timer();
@@ -34,6 +34,7 @@
 #include "BLI_math_vector.h"
 #include "BLI_string.h"
 #include "BLI_task.h"
+#include "BLI_trace.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_mesh_types.h"
@@ -5287,6 +5288,7 @@ static void extract_init(ExtractTaskData *data)
 static void extract_run(void *__restrict taskdata)
 {
   ExtractTaskData *data = (ExtractTaskData *)taskdata;
+  BLI_TRACE_ZONE_BEGIN(trace_zone, "Mesh Extract", NULL);
   if (data->tasktype == EXTRACT_MESH_EXTRACT) {
     mesh_extract_iter(data->mr,
                       data->iter_type,
@@ -5304,6 +5306,7 @@ static void extract_run(void *__restrict taskdata)
   else if (data->tasktype == EXTRACT_LINES_LOOSE) {
     extract_lines_loose_subbuffer(data->mr, data->cache);
   }
+  BLI_TRACE_ZONE_END(trace_zone);
 }
 
 static void extract_init_and_run(void *__restrict taskdata)
@@ -66,7 +66,7 @@
 #  define USE_ARRAY_STORE_THREAD
 #endif
 
-#ifdef USE_ARRAY_STORE_THREAD
+#ifdef USE_ARRAY_STORE
 #  include "BLI_task.h"
 #endif
 
@@ -133,10 +133,91 @@ static struct {
 
 } um_arraystore = {{NULL}};
 
+/**
+ * An array to add to the store of its stride.
+ *
+ * Adding is deferred until all arrays of the undo step are known,
+ * so arrays in different stores can be de-duplicated in parallel.
+ */
+typedef struct UMArrayStoreJob {
+  struct UMArrayStoreJob *next, *prev;
+  int stride;
+  /** Owned by the job, freed once added. */
+  void *data;
+  size_t data_len;
+  BArrayState *state_reference;
+  BArrayState **r_state;
+} UMArrayStoreJob;
+
+static void um_arraystore_job_add(ListBase *jobs,
+                                  const int stride,
+                                  void *data,
+                                  const size_t data_len,
+                                  BArrayState *state_reference,
+                                  BArrayState **r_state)
+{
+  /* Ensure the store now, the table of stores can't be resized while jobs run. */
+  BLI_array_store_at_size_ensure(&um_arraystore.bs_stride, stride, ARRAY_CHUNK_SIZE);
+
+  UMArrayStoreJob *job = MEM_mallocN(sizeof(*job), __func__);
+  job->stride = stride;
+  job->data = data;
+  job->data_len = data_len;
+  job->state_reference = state_reference;
+  job->r_state = r_state;
+  BLI_addtail(jobs, job);
+}
+
+static void um_arraystore_jobs_run_cb(void *__restrict userdata,
+                                      const int i,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ListBase *jobs_per_store = userdata;
+  LISTBASE_FOREACH_MUTABLE (UMArrayStoreJob *, job, &jobs_per_store[i]) {
+    BArrayStore *bs = BLI_array_store_at_size_get(&um_arraystore.bs_stride, job->stride);
+    *job->r_state = BLI_array_store_state_add(bs, job->data, job->data_len, job->state_reference);
+    if (job->data) {
+      MEM_freeN(job->data);
+    }
+    MEM_freeN(job);
+  }
+}
+
+/**
+ * Add the arrays of all jobs, one task per store since a store can only be used by one thread.
+ * Large arrays are split further by the store itself.
+ */
+static void um_arraystore_jobs_run(ListBase *jobs)
+{
+  const int stores_len = um_arraystore.bs_stride.stride_table_len;
+  ListBase *jobs_per_store = MEM_callocN(sizeof(*jobs_per_store) * (size_t)stores_len, __func__);
+  LISTBASE_FOREACH_MUTABLE (UMArrayStoreJob *, job, jobs) {
+    BLI_addtail(&jobs_per_store[job->stride - 1], job);
+  }
+  BLI_listbase_clear(jobs);
+
+  /* Move the stores with jobs to the start, so there is a task for each of them. */
+  int jobs_per_store_len = 0;
+  for (int i = 0; i < stores_len; i++) {
+    if (!BLI_listbase_is_empty(&jobs_per_store[i])) {
+      jobs_per_store[jobs_per_store_len++] = jobs_per_store[i];
+    }
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(
+      0, jobs_per_store_len, jobs_per_store, um_arraystore_jobs_run_cb, &settings);
+
+  MEM_freeN(jobs_per_store);
+}
+
 static void um_arraystore_cd_compact(struct CustomData *cdata,
                                      const size_t data_len,
                                      bool create,
                                      const BArrayCustomData *bcd_reference,
+                                     ListBase *jobs,
                                      BArrayCustomData **r_bcd_first)
 {
   if (data_len == 0) {
@@ -156,9 +237,6 @@ static void um_arraystore_cd_compact(struct CustomData *cdata,
     }
 
     const int stride = CustomData_sizeof(type);
-    BArrayStore *bs = create ? BLI_array_store_at_size_ensure(
-                                   &um_arraystore.bs_stride, stride, ARRAY_CHUNK_SIZE) :
-                               NULL;
     const int layer_len = layer_end - layer_start;
 
     if (create) {
@@ -206,8 +284,13 @@ static void um_arraystore_cd_compact(struct CustomData *cdata,
                                           i < bcd_reference_current->states_len) ?
                                              bcd_reference_current->states[i] :
                                              NULL;
-          bcd->states[i] = BLI_array_store_state_add(
-              bs, layer->data, (size_t)data_len * stride, state_reference);
+          um_arraystore_job_add(jobs,
+                                stride,
+                                layer->data,
+                                (size_t)data_len * stride,
+                                state_reference,
+                                &bcd->states[i]);
+          layer->data = NULL;
         }
         else {
           bcd->states[i] = NULL;
@@ -284,21 +367,35 @@ static void um_arraystore_cd_free(BArrayCustomData *bcd)
 static void um_arraystore_compact_ex(UndoMesh *um, const UndoMesh *um_ref, bool create)
 {
   Mesh *me = &um->me;
-
-  um_arraystore_cd_compact(
-      &me->vdata, me->totvert, create, um_ref ? um_ref->store.vdata : NULL, &um->store.vdata);
-  um_arraystore_cd_compact(
-      &me->edata, me->totedge, create, um_ref ? um_ref->store.edata : NULL, &um->store.edata);
-  um_arraystore_cd_compact(
-      &me->ldata, me->totloop, create, um_ref ? um_ref->store.ldata : NULL, &um->store.ldata);
-  um_arraystore_cd_compact(
-      &me->pdata, me->totpoly, create, um_ref ? um_ref->store.pdata : NULL, &um->store.pdata);
+  ListBase jobs = {NULL, NULL};
+
+  um_arraystore_cd_compact(&me->vdata,
+                           me->totvert,
+                           create,
+                           um_ref ? um_ref->store.vdata : NULL,
+                           &jobs,
+                           &um->store.vdata);
+  um_arraystore_cd_compact(&me->edata,
+                           me->totedge,
+                           create,
+                           um_ref ? um_ref->store.edata : NULL,
+                           &jobs,
+                           &um->store.edata);
+  um_arraystore_cd_compact(&me->ldata,
+                           me->totloop,
+                           create,
+                           um_ref ? um_ref->store.ldata : NULL,
+                           &jobs,
+                           &um->store.ldata);
+  um_arraystore_cd_compact(&me->pdata,
+                           me->totpoly,
+                           create,
+                           um_ref ? um_ref->store.pdata : NULL,
+                           &jobs,
+                           &um->store.pdata);
 
   if (me->key && me->key->totkey) {
-    const size_t stride = me->key->elemsize;
-    BArrayStore *bs = create ? BLI_array_store_at_size_ensure(
-                                   &um_arraystore.bs_stride, stride, ARRAY_CHUNK_SIZE) :
-                               NULL;
+    const int stride = me->key->elemsize;
     if (create) {
       um->store.keyblocks = MEM_mallocN(me->key->totkey * sizeof(*um->store.keyblocks), __func__);
     }
@@ -308,8 +405,13 @@ static void um_arraystore_compact_ex(UndoMesh *um, const UndoMesh *um_ref, bool
         BArrayState *state_reference = (um_ref && um_ref->me.key && (i < um_ref->me.key->totkey)) ?
                                            um_ref->store.keyblocks[i] :
                                            NULL;
-        um->store.keyblocks[i] = BLI_array_store_state_add(
-            bs, keyblock->data, (size_t)keyblock->totelem * stride, state_reference);
+        um_arraystore_job_add(&jobs,
+                              stride,
+                              keyblock->data,
+                              (size_t)keyblock->totelem * stride,
+                              state_reference,
+                              &um->store.keyblocks[i]);
+        keyblock->data = NULL;
       }
 
       if (keyblock->data) {
@@ -323,19 +425,24 @@ static void um_arraystore_compact_ex(UndoMesh *um, const UndoMesh *um_ref, bool
     BLI_assert(create == (um->store.mselect == NULL));
     if (create) {
       BArrayState *state_reference = um_ref ? um_ref->store.mselect : NULL;
-      const size_t stride = sizeof(*me->mselect);
-      BArrayStore *bs = BLI_array_store_at_size_ensure(
-          &um_arraystore.bs_stride, stride, ARRAY_CHUNK_SIZE);
-      um->store.mselect = BLI_array_store_state_add(
-          bs, me->mselect, (size_t)me->totselect * stride, state_reference);
+      const int stride = sizeof(*me->mselect);
+      um_arraystore_job_add(&jobs,
+                            stride,
+                            me->mselect,
+                            (size_t)me->totselect * stride,
+                            state_reference,
+                            &um->store.mselect);
+    }
+    else {
+      MEM_freeN(me->mselect);
     }
 
     /* keep me->totselect for validation */
-    MEM_freeN(me->mselect);
     me->mselect = NULL;
   }
 
   if (create) {
+    um_arraystore_jobs_run(&jobs);
     um_arraystore.users += 1;
   }
 
@@ -352,6 +459,9 @@ static void um_arraystore_compact(UndoMesh *um, const UndoMesh *um_ref)
 
 static void um_arraystore_compact_with_info(UndoMesh *um, const UndoMesh *um_ref)
 {
+  BArrayStoreStats stats_prev;
+  BLI_array_store_at_size_stats_get(&um_arraystore.bs_stride, &stats_prev);
+
 #  ifdef DEBUG_PRINT
   size_t size_expanded_prev, size_compacted_prev;
   BLI_array_store_at_size_calc_memory_usage(
@@ -368,6 +478,22 @@ static void um_arraystore_compact_with_info(UndoMesh *um, const UndoMesh *um_ref
   TIMEIT_END(mesh_undo_compact);
 #  endif
 
+  {
+    BArrayStoreStats stats;
+    BLI_array_store_at_size_stats_get(&um_arraystore.bs_stride, &stats);
+
+    /* The time is summed over the stores, which may have been used in parallel. */
+    const size_t size_step = stats.size_added - stats_prev.size_added;
+    const size_t size_unique_step = stats.size_added_unique - stats_prev.size_added_unique;
+    CLOG_INFO(&LOG,
+              1,
+              "compacted %zu bytes to %zu unique bytes (%.2f%%), %.6f seconds",
+              size_step,
+              size_unique_step,
+              size_step ? ((double)size_unique_step / (double)size_step) * 100.0 : 0.0,
+              stats.time_added - stats_prev.time_added);
+  }
+
 #  ifdef DEBUG_PRINT
   {
     size_t size_expanded, size_compacted;
@@ -53,6 +53,11 @@ typedef struct CustomDataLayer {
   char name[64];
   /** Layer data. */
   void *data;
+  /**
+   * Run-time reference count when the data is shared with layers of other #CustomData,
+   * NULL when the data isn't shared.
+   */
+  struct CustomDataLayerSharing *sharing_info;
 } CustomDataLayer;
 
 #define MAX_CUSTOMDATA_LAYER_NAME 64
@@ -106,6 +106,16 @@ typedef struct Mesh_Runtime {
   /** Non-manifold boundary data for Shrinkwrap Target Project. */
   struct ShrinkwrapBoundaryData *shrinkwrap_data;
 
+  /** `MeshTopologyMaps` defined in 'mesh_runtime.c', see #BKE_mesh_runtime_vert_poly_map_ensure. */
+  struct MeshTopologyMaps *topology_maps;
+
+  /** Vertex group weights in contiguous arrays, see #BKE_mesh_runtime_deform_weights_ensure.
+   * A list, with the weights for each mapping of groups to bones. */
+  struct MeshDeformWeights *deform_weights;
+
+  /** Smooth fans for split normals, see #BKE_mesh_calc_normals_split_cached. */
+  struct MeshSmoothFans *smooth_fans;
+
   /** Set by modifier stack if only deformed from original. */
   char deformed_only;
   /**
@@ -861,9 +861,11 @@ typedef struct BooleanModifierData {
   ModifierData modifier;
 
   struct Object *object;
+  struct Collection *collection;
   char operation;
   char solver;
-  char _pad[1];
+  /** #BooleanModifierOperandType. */
+  char operand_type;
   char bm_flag;
   float double_threshold;
 } BooleanModifierData;
@@ -879,6 +881,11 @@ typedef enum {
   eBooleanModifierSolver_Exact = 1,
 } BooleanModifierSolver;
 
+typedef enum {
+  eBooleanModifierOperandType_Object = 0,
+  eBooleanModifierOperandType_Collection = 1,
+} BooleanModifierOperandType;
+
 /* bm_flag only used when G_DEBUG. */
 enum {
   eBooleanModifierBMeshFlag_BMesh_Separate = (1 << 0),
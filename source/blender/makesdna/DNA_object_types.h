@@ -44,6 +44,7 @@ struct GpencilBatchCache;
 struct Ipo;
 struct Material;
 struct Mesh;
+struct ModifierStackCache;
 struct Object;
 struct PartDeflect;
 struct Path;
@@ -177,6 +178,9 @@ typedef struct Object_Runtime {
   /** Runtime evaluated curve-specific data, not stored in the file. */
   struct CurveCache *curve_cache;
 
+  /** Results of the mesh modifier stack, kept between evaluations (see #U.modifier_cache_limit). */
+  struct ModifierStackCache *modifier_cache;
+
   unsigned short local_collections_bits;
   short _pad2[3];
 } Object_Runtime;
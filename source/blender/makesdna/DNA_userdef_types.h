@@ -748,7 +748,8 @@ typedef struct UserDef {
   int prefetchframes;
   /** Control the rotation step of the view when PAD2, PAD4, PAD6&PAD8 is use. */
   float pad_rot_angle;
-  char _pad12[4];
+  /** Memory for mesh modifier results kept between evaluations (in megabytes), 0 disables. */
+  int modifier_cache_limit;
   /** Rotating view icon size. */
   short rvisize;
   /** Rotating view icon brightness. */
@@ -1296,6 +1297,7 @@ typedef enum eOpensubdiv_Computee_Type {
   USER_OPENSUBDIV_COMPUTE_CUDA = 4,
   USER_OPENSUBDIV_COMPUTE_GLSL_TRANSFORM_FEEDBACK = 5,
   USER_OPENSUBDIV_COMPUTE_GLSL_COMPUTE = 6,
+  USER_OPENSUBDIV_COMPUTE_TBB = 7,
 } eOpensubdiv_Computee_Type;
 
 /** #UserDef.factor_display_type */
@@ -54,8 +54,12 @@
 
 #ifdef WITH_OPENSUBDIV
 static const EnumPropertyItem opensubdiv_compute_type_items[] = {
-    {USER_OPENSUBDIV_COMPUTE_NONE, "NONE", 0, "None", ""},
-    {USER_OPENSUBDIV_COMPUTE_CPU, "CPU", 0, "CPU", ""},
+    {USER_OPENSUBDIV_COMPUTE_NONE,
+     "NONE",
+     0,
+     "Automatic",
+     "Use the threaded evaluator when available"},
+    {USER_OPENSUBDIV_COMPUTE_CPU, "CPU", 0, "CPU", "Evaluate on a single thread"},
     {USER_OPENSUBDIV_COMPUTE_OPENMP, "OPENMP", 0, "OpenMP", ""},
     {USER_OPENSUBDIV_COMPUTE_OPENCL, "OPENCL", 0, "OpenCL", ""},
     {USER_OPENSUBDIV_COMPUTE_CUDA, "CUDA", 0, "CUDA", ""},
@@ -65,6 +69,7 @@ static const EnumPropertyItem opensubdiv_compute_type_items[] = {
      "GLSL Transform Feedback",
      ""},
     {USER_OPENSUBDIV_COMPUTE_GLSL_COMPUTE, "GLSL_COMPUTE", 0, "GLSL Compute", ""},
+    {USER_OPENSUBDIV_COMPUTE_TBB, "TBB", 0, "Threaded", "Evaluate on multiple threads"},
     {0, NULL, 0, NULL, NULL},
 };
 #endif
@@ -720,6 +725,7 @@ static const EnumPropertyItem *rna_userdef_opensubdiv_compute_type_itemf(bContex
   APPEND_COMPUTE(CUDA);
   APPEND_COMPUTE(GLSL_TRANSFORM_FEEDBACK);
   APPEND_COMPUTE(GLSL_COMPUTE);
+  APPEND_COMPUTE(TBB);
 
 #    undef APPEND_COMPUTE
 
@@ -735,8 +741,9 @@ static void rna_userdef_opensubdiv_update(Main *bmain,
 {
   Object *object;
 
+  /* Subdivision modifiers create their evaluator with the new type. */
   for (object = bmain->objects.first; object; object = object->id.next) {
-    DEG_id_tag_update(&object->id, ID_RECALC_TRANSFORM);
+    DEG_id_tag_update(&object->id, ID_RECALC_GEOMETRY);
   }
   USERDEF_TAG_DIRTY;
 }
@@ -5293,6 +5300,14 @@ static void rna_def_userdef_system(BlenderRNA *brna)
   RNA_def_property_ui_text(prop, "Memory Cache Limit", "Memory cache limit (in megabytes)");
   RNA_def_property_update(prop, 0, "rna_Userdef_memcache_update");
 
+  prop = RNA_def_property(srna, "modifier_cache_limit", PROP_INT, PROP_NONE);
+  RNA_def_property_range(prop, 0, max_memory_in_megabytes_int());
+  RNA_def_property_ui_text(prop,
+                           "Modifier Cache Limit",
+                           "Memory for keeping the results of mesh modifiers between evaluations, "
+                           "so only modifiers after a change are evaluated again "
+                           "(in megabytes, 0 disables the cache)");
+
   /* Sequencer disk cache */
 
   prop = RNA_def_property(srna, "use_sequencer_disk_cache", PROP_BOOLEAN, PROP_NONE);
@@ -5491,7 +5506,7 @@ static void rna_def_userdef_system(BlenderRNA *brna)
   RNA_def_property_enum_items(prop, opensubdiv_compute_type_items);
   RNA_def_property_enum_funcs(prop, NULL, NULL, "rna_userdef_opensubdiv_compute_type_itemf");
   RNA_def_property_ui_text(
-      prop, "OpenSubdiv Compute Type", "Type of computer back-end used with OpenSubdiv");
+      prop, "OpenSubdiv Compute Type", "Evaluator used by subdivision surface and multires");
   RNA_def_property_update(prop, NC_SPACE | ND_SPACE_PROPERTIES, "rna_userdef_opensubdiv_update");
 #  endif
 
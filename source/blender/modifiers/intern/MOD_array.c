@@ -28,6 +28,7 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -146,17 +147,47 @@ static int svert_sum_cmp(const void *e1, const void *e2)
   return 0;
 }
 
-static void svert_from_mvert(SortVertsElem *sv,
-                             const MVert *mv,
-                             const int i_begin,
-                             const int i_end)
+/**
+ * Fill \a sv with the vertices in the [i_begin, i_end) range that are inside the given bounds.
+ * \return The number of vertices added.
+ */
+static int svert_from_mvert_in_bounds(SortVertsElem *sv,
+                                      const MVert *mverts,
+                                      const int i_begin,
+                                      const int i_end,
+                                      const float min[3],
+                                      const float max[3])
 {
-  int i;
-  for (i = i_begin; i < i_end; i++, sv++, mv++) {
+  int i, len = 0;
+  for (i = i_begin; i < i_end; i++) {
+    const float *co = mverts[i].co;
+    if (co[0] < min[0] || co[1] < min[1] || co[2] < min[2] || co[0] > max[0] ||
+        co[1] > max[1] || co[2] > max[2]) {
+      continue;
+    }
     sv->vertex_num = i;
-    copy_v3_v3(sv->co, mv->co);
-    sv->sum_co = sum_v3(mv->co);
+    copy_v3_v3(sv->co, co);
+    sv->sum_co = sum_v3(co);
+    sv++;
+    len++;
+  }
+  return len;
+}
+
+static void mvert_bounds_expanded(const MVert *mverts,
+                                  const int i_begin,
+                                  const int i_end,
+                                  const float dist,
+                                  float r_min[3],
+                                  float r_max[3])
+{
+  int i;
+  INIT_MINMAX(r_min, r_max);
+  for (i = i_begin; i < i_end; i++) {
+    minmax_v3v3_v3(r_min, r_max, mverts[i].co);
   }
+  add_v3_fl(r_min, -dist);
+  add_v3_fl(r_max, dist);
 }
 
 /**
@@ -165,13 +196,16 @@ static void svert_from_mvert(SortVertsElem *sv,
  * It builds a mapping for all vertices within source,
  * to vertices within target, or -1 if no double found.
  * The int doubles_map[num_verts_source] array must have been allocated by caller.
+ *
+ * Only the vertices of each set that are within \a dist of the bounds of the other set are
+ * sorted and tested, this is usually the seam between two copies.
  */
 static void dm_mvert_map_doubles(int *doubles_map,
                                  const MVert *mverts,
                                  const int target_start,
-                                 const int target_num_verts,
+                                 int target_num_verts,
                                  const int source_start,
-                                 const int source_num_verts,
+                                 int source_num_verts,
                                  const float dist)
 {
   const float dist3 = ((float)M_SQRT3 + 0.00005f) * dist; /* Just above sqrt(3) */
@@ -179,19 +213,38 @@ static void dm_mvert_map_doubles(int *doubles_map,
   SortVertsElem *sorted_verts_target, *sorted_verts_source;
   SortVertsElem *sve_source, *sve_target, *sve_target_low_bound;
   bool target_scan_completed;
+  float min[3], max[3];
 
   target_end = target_start + target_num_verts;
   source_end = source_start + source_num_verts;
 
+  if (target_num_verts == 0 || source_num_verts == 0) {
+    return;
+  }
+
   /* build array of MVerts to be tested for merging */
   sorted_verts_target = MEM_malloc_arrayN(target_num_verts, sizeof(SortVertsElem), __func__);
   sorted_verts_source = MEM_malloc_arrayN(source_num_verts, sizeof(SortVertsElem), __func__);
 
-  /* Copy target vertices index and cos into SortVertsElem array */
-  svert_from_mvert(sorted_verts_target, mverts + target_start, target_start, target_end);
+  /* Copy source vertices close to the target into SortVertsElem array */
+  mvert_bounds_expanded(mverts, target_start, target_end, dist, min, max);
+  source_num_verts = svert_from_mvert_in_bounds(
+      sorted_verts_source, mverts, source_start, source_end, min, max);
 
-  /* Copy source vertices index and cos into SortVertsElem array */
-  svert_from_mvert(sorted_verts_source, mverts + source_start, source_start, source_end);
+  /* Copy target vertices close to those source vertices into SortVertsElem array */
+  if (source_num_verts != 0) {
+    INIT_MINMAX(min, max);
+    for (i_source = 0; i_source < source_num_verts; i_source++) {
+      minmax_v3v3_v3(min, max, sorted_verts_source[i_source].co);
+    }
+    add_v3_fl(min, -dist);
+    add_v3_fl(max, dist);
+    target_num_verts = svert_from_mvert_in_bounds(
+        sorted_verts_target, mverts, target_start, target_end, min, max);
+  }
+  else {
+    target_num_verts = 0;
+  }
 
   /* sort arrays according to sum of vertex coordinates (sumco) */
   qsort(sorted_verts_target, target_num_verts, sizeof(SortVertsElem), svert_sum_cmp);
@@ -362,16 +415,97 @@ static void mesh_merge_transform(Mesh *result,
   }
 }
 
+typedef struct ArrayCopyData {
+  const Mesh *mesh;
+  Mesh *result;
+  /** Cumulative offset of each copy. */
+  const float (*offsets)[4][4];
+  const float *uv_offset;
+  int totuv;
+  bool use_recalc_normals;
+} ArrayCopyData;
+
+/* Fill the geometry of a copy, all copies write to separate ranges of the result. */
+static void array_copy_task(void *__restrict userdata,
+                            const int c,
+                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ArrayCopyData *data = userdata;
+  const Mesh *mesh = data->mesh;
+  Mesh *result = data->result;
+  const int chunk_nverts = mesh->totvert;
+  const int chunk_nedges = mesh->totedge;
+  const int chunk_nloops = mesh->totloop;
+  const int chunk_npolys = mesh->totpoly;
+  const float(*current_offset)[4] = data->offsets[c];
+  MVert *mv;
+  MEdge *me;
+  MLoop *ml;
+  MPoly *mp;
+  int i;
+
+  /* copy customdata to new geometry */
+  CustomData_copy_data(&mesh->vdata, &result->vdata, 0, c * chunk_nverts, chunk_nverts);
+  CustomData_copy_data(&mesh->edata, &result->edata, 0, c * chunk_nedges, chunk_nedges);
+  CustomData_copy_data(&mesh->ldata, &result->ldata, 0, c * chunk_nloops, chunk_nloops);
+  CustomData_copy_data(&mesh->pdata, &result->pdata, 0, c * chunk_npolys, chunk_npolys);
+
+  /* apply offset to all new verts */
+  mv = result->mvert + c * chunk_nverts;
+  for (i = 0; i < chunk_nverts; i++, mv++) {
+    mul_m4_v3(current_offset, mv->co);
+
+    /* We have to correct normals too, if we do not tag them as dirty! */
+    if (!data->use_recalc_normals) {
+      float no[3];
+      normal_short_to_float_v3(no, mv->no);
+      mul_mat3_m4_v3(current_offset, no);
+      normalize_v3(no);
+      normal_float_to_short_v3(mv->no, no);
+    }
+  }
+
+  /* adjust edge vertex indices */
+  me = result->medge + c * chunk_nedges;
+  for (i = 0; i < chunk_nedges; i++, me++) {
+    me->v1 += c * chunk_nverts;
+    me->v2 += c * chunk_nverts;
+  }
+
+  mp = result->mpoly + c * chunk_npolys;
+  for (i = 0; i < chunk_npolys; i++, mp++) {
+    mp->loopstart += c * chunk_nloops;
+  }
+
+  /* adjust loop vertex and edge indices */
+  ml = result->mloop + c * chunk_nloops;
+  for (i = 0; i < chunk_nloops; i++, ml++) {
+    ml->v += c * chunk_nverts;
+    ml->e += c * chunk_nedges;
+  }
+
+  /* handle UVs */
+  for (i = 0; i < data->totuv; i++) {
+    MLoopUV *dmloopuv = CustomData_get_layer_n(&result->ldata, CD_MLOOPUV, i);
+    const float uv_offset[2] = {
+        data->uv_offset[0] * (float)c,
+        data->uv_offset[1] * (float)c,
+    };
+    int l_index = chunk_nloops;
+    for (dmloopuv += c * chunk_nloops; l_index-- != 0; dmloopuv++) {
+      dmloopuv->uv[0] += uv_offset[0];
+      dmloopuv->uv[1] += uv_offset[1];
+    }
+  }
+}
+
 static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
                                    const ModifierEvalContext *ctx,
                                    Mesh *mesh)
 {
   const MVert *src_mvert;
-  MVert *mv, *mv_prev, *result_dm_verts;
+  MVert *result_dm_verts;
 
-  MEdge *me;
-  MLoop *ml;
-  MPoly *mp;
   int i, j, c, count;
   float length = amd->length;
   /* offset matrix */
@@ -380,6 +514,7 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
   bool offset_has_scale;
   float current_offset[4][4];
   float final_offset[4][4];
+  float(*offsets)[4][4];
   int *full_doubles_map = NULL;
   int tot_doubles;
 
@@ -576,110 +711,87 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
   first_chunk_start = 0;
   first_chunk_nverts = chunk_nverts;
 
-  unit_m4(current_offset);
+  /* Cumulative offsets of all copies, so they can be filled in parallel. */
+  offsets = MEM_malloc_arrayN(count, sizeof(*offsets), "mod array offsets");
+  unit_m4(offsets[0]);
   for (c = 1; c < count; c++) {
-    /* copy customdata to new geometry */
-    CustomData_copy_data(&mesh->vdata, &result->vdata, 0, c * chunk_nverts, chunk_nverts);
-    CustomData_copy_data(&mesh->edata, &result->edata, 0, c * chunk_nedges, chunk_nedges);
-    CustomData_copy_data(&mesh->ldata, &result->ldata, 0, c * chunk_nloops, chunk_nloops);
-    CustomData_copy_data(&mesh->pdata, &result->pdata, 0, c * chunk_npolys, chunk_npolys);
-
-    mv_prev = result_dm_verts;
-    mv = mv_prev + c * chunk_nverts;
-
-    /* recalculate cumulative offset here */
-    mul_m4_m4m4(current_offset, current_offset, offset);
-
-    /* apply offset to all new verts */
-    for (i = 0; i < chunk_nverts; i++, mv++, mv_prev++) {
-      mul_m4_v3(current_offset, mv->co);
-
-      /* We have to correct normals too, if we do not tag them as dirty! */
-      if (!use_recalc_normals) {
-        float no[3];
-        normal_short_to_float_v3(no, mv->no);
-        mul_mat3_m4_v3(current_offset, no);
-        normalize_v3(no);
-        normal_float_to_short_v3(mv->no, no);
-      }
-    }
-
-    /* adjust edge vertex indices */
-    me = result->medge + c * chunk_nedges;
-    for (i = 0; i < chunk_nedges; i++, me++) {
-      me->v1 += c * chunk_nverts;
-      me->v2 += c * chunk_nverts;
-    }
-
-    mp = result->mpoly + c * chunk_npolys;
-    for (i = 0; i < chunk_npolys; i++, mp++) {
-      mp->loopstart += c * chunk_nloops;
+    mul_m4_m4m4(offsets[c], offsets[c - 1], offset);
+  }
+  copy_m4_m4(current_offset, offsets[count - 1]);
+
+  if (count > 1) {
+    ArrayCopyData data = {
+        .mesh = mesh,
+        .result = result,
+        .offsets = (const float(*)[4][4])offsets,
+        .uv_offset = amd->uv_offset,
+        .totuv = 0,
+        .use_recalc_normals = use_recalc_normals,
+    };
+    if (chunk_nloops > 0 && is_zero_v2(amd->uv_offset) == false) {
+      data.totuv = CustomData_number_of_layers(&result->ldata, CD_MLOOPUV);
     }
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = ((count - 1) * (chunk_nverts + chunk_nloops) > 1024);
+    BLI_task_parallel_range(1, count, &data, array_copy_task, &settings);
+  }
+  MEM_freeN(offsets);
 
-    /* adjust loop vertex and edge indices */
-    ml = result->mloop + c * chunk_nloops;
-    for (i = 0; i < chunk_nloops; i++, ml++) {
-      ml->v += c * chunk_nverts;
-      ml->e += c * chunk_nedges;
+  /* Handle merge between chunk n and n-1 */
+  if (use_merge && (count > 1)) {
+    dm_mvert_map_doubles(full_doubles_map,
+                         result_dm_verts,
+                         0,
+                         chunk_nverts,
+                         chunk_nverts,
+                         chunk_nverts,
+                         amd->merge_dist);
+  }
+  if (use_merge && (count > 2) && !offset_has_scale) {
+    /* Mapping chunk 3 to chunk 2 is a translation of mapping 2 to 1
+     * ... that is except if scaling makes the distance grow.
+     * Only vertices of the seam between the first two chunks can be mapped in later chunks. */
+    int *seam_verts = MEM_malloc_arrayN(chunk_nverts, sizeof(int), "mod array seam verts");
+    int seam_nverts = 0;
+    for (i = 0; i < chunk_nverts; i++) {
+      if (full_doubles_map[chunk_nverts + i] != -1) {
+        seam_verts[seam_nverts++] = i;
+      }
     }
-
-    /* Handle merge between chunk n and n-1 */
-    if (use_merge && (c >= 1)) {
-      if (!offset_has_scale && (c >= 2)) {
-        /* Mapping chunk 3 to chunk 2 is a translation of mapping 2 to 1
-         * ... that is except if scaling makes the distance grow */
-        int k;
-        int this_chunk_index = c * chunk_nverts;
-        int prev_chunk_index = (c - 1) * chunk_nverts;
-        for (k = 0; k < chunk_nverts; k++, this_chunk_index++, prev_chunk_index++) {
-          int target = full_doubles_map[prev_chunk_index];
-          if (target != -1) {
-            target += chunk_nverts; /* translate mapping */
-            while (target != -1 && !ELEM(full_doubles_map[target], -1, target)) {
-              /* If target is already mapped, we only follow that mapping if final target remains
-               * close enough from current vert (otherwise no mapping at all). */
-              if (compare_len_v3v3(result_dm_verts[this_chunk_index].co,
-                                   result_dm_verts[full_doubles_map[target]].co,
-                                   amd->merge_dist)) {
-                target = full_doubles_map[target];
-              }
-              else {
-                target = -1;
-              }
+    for (c = 2; c < count; c++) {
+      for (j = 0; j < seam_nverts; j++) {
+        int this_chunk_index = c * chunk_nverts + seam_verts[j];
+        int target = full_doubles_map[this_chunk_index - chunk_nverts];
+        if (target != -1) {
+          target += chunk_nverts; /* translate mapping */
+          while (target != -1 && !ELEM(full_doubles_map[target], -1, target)) {
+            /* If target is already mapped, we only follow that mapping if final target remains
+             * close enough from current vert (otherwise no mapping at all). */
+            if (compare_len_v3v3(result_dm_verts[this_chunk_index].co,
+                                 result_dm_verts[full_doubles_map[target]].co,
+                                 amd->merge_dist)) {
+              target = full_doubles_map[target];
+            }
+            else {
+              target = -1;
             }
           }
-          full_doubles_map[this_chunk_index] = target;
         }
-      }
-      else {
-        dm_mvert_map_doubles(full_doubles_map,
-                             result_dm_verts,
-                             (c - 1) * chunk_nverts,
-                             chunk_nverts,
-                             c * chunk_nverts,
-                             chunk_nverts,
-                             amd->merge_dist);
+        full_doubles_map[this_chunk_index] = target;
       }
     }
+    MEM_freeN(seam_verts);
   }
-
-  /* handle UVs */
-  if (chunk_nloops > 0 && is_zero_v2(amd->uv_offset) == false) {
-    const int totuv = CustomData_number_of_layers(&result->ldata, CD_MLOOPUV);
-    for (i = 0; i < totuv; i++) {
-      MLoopUV *dmloopuv = CustomData_get_layer_n(&result->ldata, CD_MLOOPUV, i);
-      dmloopuv += chunk_nloops;
-      for (c = 1; c < count; c++) {
-        const float uv_offset[2] = {
-            amd->uv_offset[0] * (float)c,
-            amd->uv_offset[1] * (float)c,
-        };
-        int l_index = chunk_nloops;
-        for (; l_index-- != 0; dmloopuv++) {
-          dmloopuv->uv[0] += uv_offset[0];
-          dmloopuv->uv[1] += uv_offset[1];
-        }
-      }
+  else if (use_merge) {
+    for (c = 2; c < count; c++) {
+      dm_mvert_map_doubles(full_doubles_map,
+                           result_dm_verts,
+                           (c - 1) * chunk_nverts,
+                           chunk_nverts,
+                           c * chunk_nverts,
+                           chunk_nverts,
+                           amd->merge_dist);
     }
   }
 
@@ -28,17 +28,23 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_alloca.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_listbase.h"
 #include "BLI_math_geom.h"
 #include "BLI_math_matrix.h"
 
 #include "BLT_translation.h"
 
+#include "DNA_collection_types.h"
+#include "DNA_layer_types.h"
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
 #include "DNA_object_types.h"
 #include "DNA_screen_types.h"
 
+#include "BKE_collection.h"
 #include "BKE_context.h"
+#include "BKE_customdata.h"
 #include "BKE_global.h" /* only to check G.debug */
 #include "BKE_lib_id.h"
 #include "BKE_lib_query.h"
@@ -89,6 +95,10 @@ static bool isDisabled(const struct Scene *UNUSED(scene),
 {
   BooleanModifierData *bmd = (BooleanModifierData *)md;
 
+  if (bmd->operand_type == eBooleanModifierOperandType_Collection) {
+    return !bmd->collection;
+  }
+
   /* The object type check is only needed here in case we have a placeholder
    * object assigned (because the library containing the mesh is missing).
    *
@@ -104,10 +114,31 @@ static void foreachObjectLink(ModifierData *md, Object *ob, ObjectWalkFunc walk,
   walk(userData, ob, &bmd->object, IDWALK_CB_NOP);
 }
 
+static void foreachIDLink(ModifierData *md, Object *ob, IDWalkFunc walk, void *userData)
+{
+  BooleanModifierData *bmd = (BooleanModifierData *)md;
+
+  walk(userData, ob, (ID **)&bmd->collection, IDWALK_CB_USER);
+
+  foreachObjectLink(md, ob, (ObjectWalkFunc)walk, userData);
+}
+
 static void updateDepsgraph(ModifierData *md, const ModifierUpdateDepsgraphContext *ctx)
 {
   BooleanModifierData *bmd = (BooleanModifierData *)md;
-  if (bmd->object != NULL) {
+  if (bmd->operand_type == eBooleanModifierOperandType_Collection) {
+    if (bmd->collection != NULL) {
+      FOREACH_COLLECTION_OBJECT_RECURSIVE_BEGIN (bmd->collection, operand_ob) {
+        if (operand_ob->type == OB_MESH && operand_ob != ctx->object) {
+          DEG_add_object_relation(
+              ctx->node, operand_ob, DEG_OB_COMP_TRANSFORM, "Boolean Modifier");
+          DEG_add_object_relation(ctx->node, operand_ob, DEG_OB_COMP_GEOMETRY, "Boolean Modifier");
+        }
+      }
+      FOREACH_COLLECTION_OBJECT_RECURSIVE_END;
+    }
+  }
+  else if (bmd->object != NULL) {
     DEG_add_object_relation(ctx->node, bmd->object, DEG_OB_COMP_TRANSFORM, "Boolean Modifier");
     DEG_add_object_relation(ctx->node, bmd->object, DEG_OB_COMP_GEOMETRY, "Boolean Modifier");
   }
@@ -171,203 +202,654 @@ static int bm_face_isect_pair(BMFace *f, void *UNUSED(user_data))
   return BM_elem_flag_test(f, BM_FACE_TAG) ? 1 : 0;
 }
 
-static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *ctx, Mesh *mesh)
+/**
+ * Operand of an n-ary boolean, the faces are looked up in an array of shapes.
+ * Called from multiple threads by the exact solver.
+ */
+static int bm_face_isect_shape(BMFace *f, void *user_data)
 {
-  BooleanModifierData *bmd = (BooleanModifierData *)md;
-  Mesh *result = mesh;
+  const int *face_shape = user_data;
+  return face_shape[BM_elem_index_get(f)];
+}
 
-  Mesh *mesh_other;
+typedef struct BooleanOperand {
+  Object *ob;
+  Mesh *mesh;
+} BooleanOperand;
 
-  if (bmd->object == NULL) {
-    return result;
+/**
+ * Apply the boolean operation between \a mesh and all \a operands at once, as an n-ary operation
+ * for the exact solver. The fast solver only supports a single operand.
+ */
+static Mesh *boolean_operands_eval(BooleanModifierData *bmd,
+                                   const ModifierEvalContext *ctx,
+                                   Mesh *mesh,
+                                   const BooleanOperand *operands,
+                                   const int operands_len,
+                                   const bool use_exact)
+{
+  BLI_assert(use_exact || operands_len == 1);
+  Object *object = ctx->object;
+  Mesh *result;
+
+  BMesh *bm;
+  BMAllocTemplate allocsize = BMALLOC_TEMPLATE_FROM_ME(mesh);
+  for (int i = 0; i < operands_len; i++) {
+    const Mesh *mesh_other = operands[i].mesh;
+    allocsize.totvert += mesh_other->totvert;
+    allocsize.totedge += mesh_other->totedge;
+    allocsize.totloop += mesh_other->totloop;
+    allocsize.totface += mesh_other->totpoly;
   }
 
-  Object *other = bmd->object;
-  mesh_other = BKE_modifier_get_evaluated_mesh_from_evaluated_object(other, false);
-  if (mesh_other) {
-    Object *object = ctx->object;
-
-    /* XXX This is utterly non-optimal, we may go from a bmesh to a mesh back to a bmesh!
-     * But for 2.90 better not try to be smart here. */
-    BKE_mesh_wrapper_ensure_mdata(mesh_other);
-
-    /* when one of objects is empty (has got no faces) we could speed up
-     * calculation a bit returning one of objects' derived meshes (or empty one)
-     * Returning mesh is depended on modifiers operation (sergey) */
-    result = get_quick_mesh(object, mesh, other, mesh_other, bmd->operation);
-
-    if (result == NULL) {
-      const bool is_flip = (is_negative_m4(object->obmat) != is_negative_m4(other->obmat));
-
-      BMesh *bm;
-      const BMAllocTemplate allocsize = BMALLOC_TEMPLATE_FROM_ME(mesh, mesh_other);
-
 #ifdef DEBUG_TIME
-      TIMEIT_START(boolean_bmesh);
+  TIMEIT_START(boolean_bmesh);
 #endif
-      bm = BM_mesh_create(&allocsize,
-                          &((struct BMeshCreateParams){
-                              .use_toolflags = false,
-                          }));
-
-      BM_mesh_bm_from_me(bm,
-                         mesh_other,
-                         &((struct BMeshFromMeshParams){
-                             .calc_face_normal = true,
-                         }));
-
-      if (UNLIKELY(is_flip)) {
-        const int cd_loop_mdisp_offset = CustomData_get_offset(&bm->ldata, CD_MDISPS);
-        BMIter iter;
-        BMFace *efa;
-        BM_ITER_MESH (efa, &iter, bm, BM_FACES_OF_MESH) {
+  bm = BM_mesh_create(&allocsize,
+                      &((struct BMeshCreateParams){
+                          .use_toolflags = false,
+                      }));
+
+  /* Operand faces first, followed by the faces of the modified mesh. */
+  bool *is_flip = MEM_malloc_arrayN(operands_len, sizeof(*is_flip), __func__);
+  bool use_flip = false;
+  for (int i = 0; i < operands_len; i++) {
+    is_flip[i] = (is_negative_m4(object->obmat) != is_negative_m4(operands[i].ob->obmat));
+    use_flip |= is_flip[i];
+
+    BM_mesh_bm_from_me(bm,
+                       operands[i].mesh,
+                       &((struct BMeshFromMeshParams){
+                           .calc_face_normal = true,
+                       }));
+  }
+
+  if (UNLIKELY(use_flip)) {
+    const int cd_loop_mdisp_offset = CustomData_get_offset(&bm->ldata, CD_MDISPS);
+    BMIter iter;
+    BMFace *efa = BM_iter_new(&iter, bm, BM_FACES_OF_MESH, NULL);
+    for (int operand_index = 0; operand_index < operands_len; operand_index++) {
+      const int faces_len = operands[operand_index].mesh->totpoly;
+      for (int i = 0; i < faces_len; i++, efa = BM_iter_step(&iter)) {
+        if (is_flip[operand_index]) {
           BM_face_normal_flip_ex(bm, efa, cd_loop_mdisp_offset, true);
         }
       }
+    }
+  }
 
-      BM_mesh_bm_from_me(bm,
-                         mesh,
-                         &((struct BMeshFromMeshParams){
-                             .calc_face_normal = true,
-                         }));
+  BM_mesh_bm_from_me(bm,
+                     mesh,
+                     &((struct BMeshFromMeshParams){
+                         .calc_face_normal = true,
+                     }));
 
-      /* main bmesh intersection setup */
-      {
-        /* create tessface & intersect */
-        const int looptris_tot = poly_to_tri_count(bm->totface, bm->totloop);
-        int tottri;
-        BMLoop *(*looptris)[3];
+  /* main bmesh intersection setup */
+  {
+    /* create tessface & intersect */
+    const int looptris_tot = poly_to_tri_count(bm->totface, bm->totloop);
+    int tottri;
+    BMLoop *(*looptris)[3];
 
-        looptris = MEM_malloc_arrayN(looptris_tot, sizeof(*looptris), __func__);
+    looptris = MEM_malloc_arrayN(looptris_tot, sizeof(*looptris), __func__);
 
-        BM_mesh_calc_tessellation_beauty(bm, looptris, &tottri);
+    BM_mesh_calc_tessellation_beauty(bm, looptris, &tottri);
 
-        /* postpone this until after tessellating
-         * so we can use the original normals before the vertex are moved */
-        {
-          BMIter iter;
-          int i;
-          const int i_verts_end = mesh_other->totvert;
-          const int i_faces_end = mesh_other->totpoly;
+    /* Shape of each face for the exact solver, 0 for the modified mesh. */
+    int *face_shape = use_exact ? MEM_malloc_arrayN(bm->totface, sizeof(*face_shape), __func__) :
+                                  NULL;
 
-          float imat[4][4];
-          float omat[4][4];
+    /* postpone this until after tessellating
+     * so we can use the original normals before the vertex are moved */
+    {
+      float imat[4][4];
+      invert_m4_m4(imat, object->obmat);
 
-          invert_m4_m4(imat, object->obmat);
-          mul_m4_m4m4(omat, imat, other->obmat);
+      BMIter viter;
+      BMIter fiter;
+      BMVert *eve = BM_iter_new(&viter, bm, BM_VERTS_OF_MESH, NULL);
+      BMFace *efa = BM_iter_new(&fiter, bm, BM_FACES_OF_MESH, NULL);
+      int f_index = 0;
 
-          BMVert *eve;
-          i = 0;
-          BM_ITER_MESH (eve, &iter, bm, BM_VERTS_OF_MESH) {
-            mul_m4_v3(omat, eve->co);
-            if (++i == i_verts_end) {
-              break;
-            }
-          }
+      for (int operand_index = 0; operand_index < operands_len; operand_index++) {
+        Object *other = operands[operand_index].ob;
+        const Mesh *mesh_other = operands[operand_index].mesh;
 
-          /* we need face normals because of 'BM_face_split_edgenet'
-           * we could calculate on the fly too (before calling split). */
-          {
-            float nmat[3][3];
-            copy_m3_m4(nmat, omat);
-            invert_m3(nmat);
-
-            if (UNLIKELY(is_flip)) {
-              negate_m3(nmat);
-            }
-
-            const short ob_src_totcol = other->totcol;
-            short *material_remap = BLI_array_alloca(material_remap,
-                                                     ob_src_totcol ? ob_src_totcol : 1);
-
-            /* Using original (not evaluated) object here since we are writing to it. */
-            /* XXX Pretty sure comment above is fully wrong now with CoW & co ? */
-            BKE_object_material_remap_calc(ctx->object, other, material_remap);
-
-            BMFace *efa;
-            i = 0;
-            BM_ITER_MESH (efa, &iter, bm, BM_FACES_OF_MESH) {
-              mul_transposed_m3_v3(nmat, efa->no);
-              normalize_v3(efa->no);
-
-              /* Temp tag to test which side split faces are from. */
-              BM_elem_flag_enable(efa, BM_FACE_TAG);
-
-              /* remap material */
-              if (LIKELY(efa->mat_nr < ob_src_totcol)) {
-                efa->mat_nr = material_remap[efa->mat_nr];
-              }
-
-              if (++i == i_faces_end) {
-                break;
-              }
-            }
-          }
+        float omat[4][4];
+        mul_m4_m4m4(omat, imat, other->obmat);
+
+        for (int i = 0; i < mesh_other->totvert; i++, eve = BM_iter_step(&viter)) {
+          mul_m4_v3(omat, eve->co);
+        }
+
+        /* we need face normals because of 'BM_face_split_edgenet'
+         * we could calculate on the fly too (before calling split). */
+        float nmat[3][3];
+        copy_m3_m4(nmat, omat);
+        invert_m3(nmat);
+
+        if (UNLIKELY(is_flip[operand_index])) {
+          negate_m3(nmat);
         }
 
-        /* not needed, but normals for 'dm' will be invalid,
-         * currently this is ok for 'BM_mesh_intersect' */
-        // BM_mesh_normals_update(bm);
+        const short ob_src_totcol = other->totcol;
+        short *material_remap = MEM_malloc_arrayN(
+            ob_src_totcol ? ob_src_totcol : 1, sizeof(*material_remap), __func__);
+
+        /* Using original (not evaluated) object here since we are writing to it. */
+        /* XXX Pretty sure comment above is fully wrong now with CoW & co ? */
+        BKE_object_material_remap_calc(ctx->object, other, material_remap);
 
-        bool use_separate = false;
-        bool use_dissolve = true;
-        bool use_island_connect = true;
+        for (int i = 0; i < mesh_other->totpoly; i++, efa = BM_iter_step(&fiter), f_index++) {
+          mul_transposed_m3_v3(nmat, efa->no);
+          normalize_v3(efa->no);
 
-        /* change for testing */
-        if (G.debug & G_DEBUG) {
-          use_separate = (bmd->bm_flag & eBooleanModifierBMeshFlag_BMesh_Separate) != 0;
-          use_dissolve = (bmd->bm_flag & eBooleanModifierBMeshFlag_BMesh_NoDissolve) == 0;
-          use_island_connect = (bmd->bm_flag & eBooleanModifierBMeshFlag_BMesh_NoConnectRegions) ==
-                               0;
+          if (face_shape) {
+            face_shape[f_index] = operand_index + 1;
+          }
+          else {
+            /* Temp tag to test which side split faces are from. */
+            BM_elem_flag_enable(efa, BM_FACE_TAG);
+          }
+
+          /* remap material */
+          if (LIKELY(efa->mat_nr < ob_src_totcol)) {
+            efa->mat_nr = material_remap[efa->mat_nr];
+          }
         }
 
-#ifdef WITH_GMP
-        bool use_exact = bmd->solver == eBooleanModifierSolver_Exact;
-#else
-        if (bmd->solver == eBooleanModifierSolver_Exact) {
-          BKE_modifier_set_error(md, "Compiled without GMP, using fast solver");
+        MEM_freeN(material_remap);
+      }
+
+      if (face_shape) {
+        for (; f_index < bm->totface; f_index++) {
+          face_shape[f_index] = 0;
         }
-        bool use_exact = false;
+      }
+    }
+
+    /* not needed, but normals for 'dm' will be invalid,
+     * currently this is ok for 'BM_mesh_intersect' */
+    // BM_mesh_normals_update(bm);
+
+    bool use_separate = false;
+    bool use_dissolve = true;
+    bool use_island_connect = true;
+
+    /* change for testing */
+    if (G.debug & G_DEBUG) {
+      use_separate = (bmd->bm_flag & eBooleanModifierBMeshFlag_BMesh_Separate) != 0;
+      use_dissolve = (bmd->bm_flag & eBooleanModifierBMeshFlag_BMesh_NoDissolve) == 0;
+      use_island_connect = (bmd->bm_flag & eBooleanModifierBMeshFlag_BMesh_NoConnectRegions) ==
+                           0;
+    }
+
+    if (use_exact) {
+      BM_mesh_boolean(bm,
+                      looptris,
+                      tottri,
+                      bm_face_isect_shape,
+                      face_shape,
+                      operands_len + 1,
+                      false,
+                      bmd->operation);
+      MEM_freeN(face_shape);
+    }
+    else {
+      BM_mesh_intersect(bm,
+                        looptris,
+                        tottri,
+                        bm_face_isect_pair,
+                        NULL,
+                        false,
+                        use_separate,
+                        use_dissolve,
+                        use_island_connect,
+                        false,
+                        false,
+                        bmd->operation,
+                        bmd->double_threshold);
+    }
+
+    MEM_freeN(looptris);
+  }
+
+  MEM_freeN(is_flip);
+
+  result = BKE_mesh_from_bmesh_for_eval_nomain(bm, NULL, mesh);
+
+  BM_mesh_free(bm);
+
+  result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+
+#ifdef DEBUG_TIME
+  TIMEIT_END(boolean_bmesh);
 #endif
 
-        if (use_exact) {
-          BM_mesh_boolean(bm, looptris, tottri, bm_face_isect_pair, NULL, false, bmd->operation);
-        }
-        else {
-          BM_mesh_intersect(bm,
-                            looptris,
-                            tottri,
-                            bm_face_isect_pair,
-                            NULL,
-                            false,
-                            use_separate,
-                            use_dissolve,
-                            use_island_connect,
-                            false,
-                            false,
-                            bmd->operation,
-                            bmd->double_threshold);
+  return result;
+}
+
+/**
+ * Apply the boolean operation with all \a operands to \a mesh. The exact solver does this in
+ * one n-ary operation, the fast solver applies them one after the other.
+ *
+ * \return The result, which may be \a mesh itself.
+ */
+static Mesh *boolean_operands_apply(BooleanModifierData *bmd,
+                                    const ModifierEvalContext *ctx,
+                                    Mesh *mesh,
+                                    const BooleanOperand *operands,
+                                    const int operands_len,
+                                    const bool use_exact)
+{
+  if (operands_len == 0) {
+    return mesh;
+  }
+
+  if (!use_exact || operands_len == 1) {
+    Mesh *result = mesh;
+    for (int i = 0; i < operands_len; i++) {
+      /* when one of objects is empty (has got no faces) we could speed up
+       * calculation a bit returning one of objects' derived meshes (or empty one)
+       * Returning mesh is depended on modifiers operation (sergey) */
+      Mesh *result_next = get_quick_mesh(
+          ctx->object, result, operands[i].ob, operands[i].mesh, bmd->operation);
+      if (result_next == NULL) {
+        result_next = boolean_operands_eval(bmd, ctx, result, &operands[i], 1, use_exact);
+      }
+      if (!ELEM(result, mesh, result_next)) {
+        BKE_id_free(NULL, result);
+      }
+      result = result_next;
+    }
+    return result;
+  }
+
+  /* Operands without faces don't change the result, except for intersections. */
+  BooleanOperand *operands_nonempty = MEM_malloc_arrayN(
+      operands_len, sizeof(*operands_nonempty), __func__);
+  int operands_nonempty_len = 0;
+  for (int i = 0; i < operands_len; i++) {
+    if (operands[i].mesh->totpoly != 0) {
+      operands_nonempty[operands_nonempty_len++] = operands[i];
+    }
+    else if (bmd->operation == eBooleanModifierOp_Intersect) {
+      MEM_freeN(operands_nonempty);
+      return BKE_mesh_new_nomain(0, 0, 0, 0, 0);
+    }
+  }
+
+  Mesh *result;
+  if (mesh->totpoly == 0 && bmd->operation != eBooleanModifierOp_Union) {
+    result = (bmd->operation == eBooleanModifierOp_Intersect) ?
+                 BKE_mesh_new_nomain(0, 0, 0, 0, 0) :
+                 mesh;
+  }
+  else if (operands_nonempty_len == 1) {
+    result = boolean_operands_apply(bmd, ctx, mesh, operands_nonempty, 1, use_exact);
+  }
+  else if (operands_nonempty_len != 0) {
+    result = boolean_operands_eval(
+        bmd, ctx, mesh, operands_nonempty, operands_nonempty_len, use_exact);
+  }
+  else {
+    result = mesh;
+  }
+
+  MEM_freeN(operands_nonempty);
+  return result;
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Boolean Modifier Runtime
+ *
+ * For collection operands the result is kept, so viewport evaluations with the same mesh and
+ * operands don't repeat the operation. Cached results are only used when they give exactly the
+ * same mesh as evaluating all operands again, like render does:
+ * - The exact solver applies all operands in one n-ary operation, which gives another topology
+ *   than applying some of them to the result of the others. Only the whole result is kept.
+ * - The fast solver applies the operands one after the other, so the result of the leading
+ *   operands that didn't change since the last evaluation is kept, and only the operands
+ *   after them are applied again.
+ * \{ */
+
+/**
+ * Identifies a mesh and what else a result depends on. The size and bounds are compared along
+ * with the hash, so a hash collision alone doesn't reuse a wrong result.
+ */
+typedef struct BooleanMeshKey {
+  uint hash;
+  int totvert;
+  int totpoly;
+  float min[3];
+  float max[3];
+} BooleanMeshKey;
+
+typedef struct BooleanOperandKey {
+  /** #ID.session_uuid of the operand object. */
+  uint session_uuid;
+  /** Key of the operand mesh, hashing its materials and its transform relative to the object. */
+  BooleanMeshKey mesh;
+} BooleanOperandKey;
+
+typedef struct BooleanRuntimeData {
+  /** Key of the modified mesh, hashing the settings. */
+  BooleanMeshKey self_key;
+  /** Operands of the last evaluation, to find the ones that didn't change since. */
+  BooleanOperandKey *operands;
+  int operands_len;
+  /** Result of the operation with the leading #partial_operands, NULL when there is none. */
+  Mesh *partial;
+  BooleanOperandKey *partial_operands;
+  int partial_operands_len;
+} BooleanRuntimeData;
+
+static void boolean_runtime_partial_free(BooleanRuntimeData *runtime_data)
+{
+  if (runtime_data->partial != NULL) {
+    BKE_id_free(NULL, runtime_data->partial);
+    MEM_freeN(runtime_data->partial_operands);
+    runtime_data->partial = NULL;
+    runtime_data->partial_operands = NULL;
+    runtime_data->partial_operands_len = 0;
+  }
+}
+
+static void freeRuntimeData(void *runtime_data_v)
+{
+  if (runtime_data_v == NULL) {
+    return;
+  }
+  BooleanRuntimeData *runtime_data = (BooleanRuntimeData *)runtime_data_v;
+  boolean_runtime_partial_free(runtime_data);
+  MEM_SAFE_FREE(runtime_data->operands);
+  MEM_freeN(runtime_data);
+}
+
+static void freeData(ModifierData *md)
+{
+  freeRuntimeData(md->runtime);
+  md->runtime = NULL;
+}
+
+static void mesh_customdata_hash(BLI_HashMurmur2A *mm2, const CustomData *data, const int count)
+{
+  for (int i = 0; i < data->totlayer; i++) {
+    const CustomDataLayer *layer = &data->layers[i];
+    BLI_hash_mm2a_add_int(mm2, layer->type);
+    /* Whether the data is owned doesn't matter. */
+    BLI_hash_mm2a_add_int(mm2, layer->flag & ~CD_FLAG_NOFREE);
+    BLI_hash_mm2a_add_int(mm2, layer->active);
+    BLI_hash_mm2a_add_int(mm2, layer->active_rnd);
+    BLI_hash_mm2a_add_int(mm2, layer->active_clone);
+    BLI_hash_mm2a_add_int(mm2, layer->active_mask);
+    BLI_hash_mm2a_add(mm2, (const uchar *)layer->name, strlen(layer->name));
+    if (layer->data == NULL || count == 0) {
+      continue;
+    }
+    if (layer->type == CD_MDEFORMVERT) {
+      const MDeformVert *dvert = layer->data;
+      for (int j = 0; j < count; j++, dvert++) {
+        BLI_hash_mm2a_add_int(mm2, dvert->totweight);
+        if (dvert->totweight) {
+          BLI_hash_mm2a_add(
+              mm2, (const uchar *)dvert->dw, sizeof(*dvert->dw) * (size_t)dvert->totweight);
         }
+      }
+    }
+    else if (!ELEM(layer->type, CD_MDISPS, CD_GRID_PAINT_MASK)) {
+      BLI_hash_mm2a_add(mm2, layer->data, (size_t)CustomData_sizeof(layer->type) * (size_t)count);
+    }
+  }
+}
 
-        MEM_freeN(looptris);
+/**
+ * Hash of all the geometry and attributes of \a mesh, which end up in the result.
+ */
+static void mesh_hash(BLI_HashMurmur2A *mm2, const Mesh *mesh)
+{
+  BLI_hash_mm2a_add_int(mm2, mesh->totvert);
+  BLI_hash_mm2a_add_int(mm2, mesh->totedge);
+  BLI_hash_mm2a_add_int(mm2, mesh->totloop);
+  BLI_hash_mm2a_add_int(mm2, mesh->totpoly);
+  mesh_customdata_hash(mm2, &mesh->vdata, mesh->totvert);
+  mesh_customdata_hash(mm2, &mesh->edata, mesh->totedge);
+  mesh_customdata_hash(mm2, &mesh->ldata, mesh->totloop);
+  mesh_customdata_hash(mm2, &mesh->pdata, mesh->totpoly);
+}
+
+static void boolean_mesh_key_init(BooleanMeshKey *key, const Mesh *mesh, const uint hash)
+{
+  key->hash = hash;
+  key->totvert = mesh->totvert;
+  key->totpoly = mesh->totpoly;
+  INIT_MINMAX(key->min, key->max);
+  BKE_mesh_minmax(mesh, key->min, key->max);
+}
+
+static bool boolean_mesh_key_equals(const BooleanMeshKey *key_a, const BooleanMeshKey *key_b)
+{
+  return (key_a->hash == key_b->hash && key_a->totvert == key_b->totvert &&
+          key_a->totpoly == key_b->totpoly && equals_v3v3(key_a->min, key_b->min) &&
+          equals_v3v3(key_a->max, key_b->max));
+}
+
+static BooleanMeshKey boolean_self_key(const BooleanModifierData *bmd, const Mesh *mesh)
+{
+  BLI_HashMurmur2A mm2;
+  BLI_hash_mm2a_init(&mm2, 0);
+  mesh_hash(&mm2, mesh);
+  BLI_hash_mm2a_add_int(&mm2, bmd->operation);
+  BLI_hash_mm2a_add_int(&mm2, bmd->solver);
+  BLI_hash_mm2a_add_int(&mm2, bmd->bm_flag);
+  BLI_hash_mm2a_add(&mm2, (const uchar *)&bmd->double_threshold, sizeof(bmd->double_threshold));
+
+  BooleanMeshKey key;
+  boolean_mesh_key_init(&key, mesh, BLI_hash_mm2a_end(&mm2));
+  return key;
+}
+
+static BooleanOperandKey boolean_operand_key(Object *object, const BooleanOperand *operand)
+{
+  Object *other = operand->ob;
+  BLI_HashMurmur2A mm2;
+  BLI_hash_mm2a_init(&mm2, 0);
+  mesh_hash(&mm2, operand->mesh);
+
+  float imat[4][4];
+  float omat[4][4];
+  invert_m4_m4(imat, object->obmat);
+  mul_m4_m4m4(omat, imat, other->obmat);
+  BLI_hash_mm2a_add(&mm2, (const uchar *)omat, sizeof(omat));
+  /* Also changes when the object is flipped. */
+  BLI_hash_mm2a_add_int(&mm2, is_negative_m4(object->obmat));
+
+  const short ob_src_totcol = other->totcol;
+  short *material_remap = BLI_array_alloca(material_remap, ob_src_totcol ? ob_src_totcol : 1);
+  BKE_object_material_remap_calc(object, other, material_remap);
+  BLI_hash_mm2a_add(
+      &mm2, (const uchar *)material_remap, sizeof(*material_remap) * (size_t)ob_src_totcol);
+
+  BooleanOperandKey key = {.session_uuid = other->id.session_uuid};
+  boolean_mesh_key_init(&key.mesh, operand->mesh, BLI_hash_mm2a_end(&mm2));
+  return key;
+}
+
+/**
+ * The number of leading operands which are the same in \a keys_a and \a keys_b.
+ */
+static int boolean_operand_keys_prefix_len(const BooleanOperandKey *keys_a,
+                                           const int keys_a_len,
+                                           const BooleanOperandKey *keys_b,
+                                           const int keys_b_len)
+{
+  const int keys_len = min_ii(keys_a_len, keys_b_len);
+  int i = 0;
+  while (i < keys_len && keys_a[i].session_uuid == keys_b[i].session_uuid &&
+         boolean_mesh_key_equals(&keys_a[i].mesh, &keys_b[i].mesh)) {
+    i++;
+  }
+  return i;
+}
+
+/**
+ * Apply the boolean operation with collection \a operands, starting from the cached result
+ * when the mesh and the operands it was computed with didn't change.
+ */
+static Mesh *boolean_operands_apply_cached(BooleanModifierData *bmd,
+                                           const ModifierEvalContext *ctx,
+                                           Mesh *mesh,
+                                           const BooleanOperand *operands,
+                                           const int operands_len,
+                                           const bool use_exact)
+{
+  BooleanRuntimeData *runtime_data = (BooleanRuntimeData *)bmd->modifier.runtime;
+  if (runtime_data == NULL) {
+    runtime_data = MEM_callocN(sizeof(*runtime_data), "boolean runtime");
+    bmd->modifier.runtime = runtime_data;
+  }
+
+  const BooleanMeshKey self_key = boolean_self_key(bmd, mesh);
+  const bool self_changed = (runtime_data->operands == NULL ||
+                             !boolean_mesh_key_equals(&runtime_data->self_key, &self_key));
+
+  BooleanOperandKey *keys = MEM_malloc_arrayN(operands_len, sizeof(*keys), __func__);
+  for (int i = 0; i < operands_len; i++) {
+    keys[i] = boolean_operand_key(ctx->object, &operands[i]);
+  }
+
+  /* The cached result can be used while the mesh and the operands it was computed with
+   * didn't change and come first, the operands after them are applied to it. */
+  bool use_partial = false;
+  if (!self_changed && runtime_data->partial != NULL) {
+    const int partial_len = runtime_data->partial_operands_len;
+    use_partial = (boolean_operand_keys_prefix_len(runtime_data->partial_operands,
+                                                   partial_len,
+                                                   keys,
+                                                   operands_len) == partial_len) &&
+                  (!use_exact || partial_len == operands_len);
+  }
+
+  int partial_len;
+  if (use_partial) {
+    partial_len = runtime_data->partial_operands_len;
+  }
+  else {
+    boolean_runtime_partial_free(runtime_data);
+
+    partial_len = operands_len;
+    if (!use_exact && !self_changed) {
+      /* Some of the operands after the ones that didn't change are likely to change again in
+       * the next evaluations, so keep the result of the ones before them. */
+      const int static_len = boolean_operand_keys_prefix_len(
+          runtime_data->operands, runtime_data->operands_len, keys, operands_len);
+      if (static_len != 0) {
+        partial_len = static_len;
       }
+    }
 
-      result = BKE_mesh_from_bmesh_for_eval_nomain(bm, NULL, mesh);
+    Mesh *partial = boolean_operands_apply(bmd, ctx, mesh, operands, partial_len, use_exact);
+    if (partial != mesh) {
+      runtime_data->partial = partial;
+      runtime_data->partial_operands = MEM_dupallocN(keys);
+      runtime_data->partial_operands_len = partial_len;
+    }
+  }
 
-      BM_mesh_free(bm);
+  Mesh *mesh_start = (runtime_data->partial != NULL) ? runtime_data->partial : mesh;
+  Mesh *result = boolean_operands_apply(
+      bmd, ctx, mesh_start, operands + partial_len, operands_len - partial_len, use_exact);
+  if (result == runtime_data->partial) {
+    result = BKE_mesh_copy_for_eval(result, false);
+  }
+  if (result != mesh) {
+    /* The cached result may have been computed from a mesh with other settings,
+     * which aren't part of the key. */
+    BKE_mesh_copy_settings(result, mesh);
+  }
 
-      result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  MEM_SAFE_FREE(runtime_data->operands);
+  runtime_data->operands = keys;
+  runtime_data->operands_len = operands_len;
+  runtime_data->self_key = self_key;
 
-#ifdef DEBUG_TIME
-      TIMEIT_END(boolean_bmesh);
+  return result;
+}
+
+/** \} */
+
+static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *ctx, Mesh *mesh)
+{
+  BooleanModifierData *bmd = (BooleanModifierData *)md;
+  Object *object = ctx->object;
+
+#ifdef WITH_GMP
+  const bool use_exact = bmd->solver == eBooleanModifierSolver_Exact;
+#else
+  if (bmd->solver == eBooleanModifierSolver_Exact) {
+    BKE_modifier_set_error(md, "Compiled without GMP, using fast solver");
+  }
+  const bool use_exact = false;
 #endif
+
+  if (bmd->operand_type == eBooleanModifierOperandType_Collection) {
+    if (bmd->collection == NULL) {
+      return mesh;
+    }
+
+    const ListBase collection_objects = BKE_collection_object_cache_get(bmd->collection);
+    BooleanOperand *operands = MEM_malloc_arrayN(
+        BLI_listbase_count(&collection_objects), sizeof(*operands), __func__);
+    int operands_len = 0;
+    FOREACH_COLLECTION_OBJECT_RECURSIVE_BEGIN (bmd->collection, operand_ob) {
+      if (operand_ob->type != OB_MESH || operand_ob == object) {
+        continue;
+      }
+      Mesh *mesh_operand = BKE_modifier_get_evaluated_mesh_from_evaluated_object(operand_ob,
+                                                                                 false);
+      if (mesh_operand == NULL) {
+        continue;
+      }
+      BKE_mesh_wrapper_ensure_mdata(mesh_operand);
+      operands[operands_len].ob = operand_ob;
+      operands[operands_len].mesh = mesh_operand;
+      operands_len++;
     }
+    FOREACH_COLLECTION_OBJECT_RECURSIVE_END;
 
-    /* if new mesh returned, return it; otherwise there was
-     * an error, so delete the modifier object */
-    if (result == NULL) {
-      BKE_modifier_set_error(md, "Cannot execute boolean operation");
+    Mesh *result;
+    if (ctx->flag & MOD_APPLY_RENDER) {
+      /* Render evaluations don't repeat, all operands are done at once. */
+      result = boolean_operands_apply(bmd, ctx, mesh, operands, operands_len, use_exact);
     }
+    else {
+      result = boolean_operands_apply_cached(bmd, ctx, mesh, operands, operands_len, use_exact);
+    }
+    MEM_freeN(operands);
+    return result;
+  }
+
+  if (bmd->object == NULL) {
+    return mesh;
+  }
+
+  Object *other = bmd->object;
+  Mesh *mesh_other = BKE_modifier_get_evaluated_mesh_from_evaluated_object(other, false);
+  if (mesh_other == NULL) {
+    return mesh;
+  }
+
+  /* XXX This is utterly non-optimal, we may go from a bmesh to a mesh back to a bmesh!
+   * But for 2.90 better not try to be smart here. */
+  BKE_mesh_wrapper_ensure_mdata(mesh_other);
+
+  const BooleanOperand operand = {other, mesh_other};
+  Mesh *result = boolean_operands_apply(bmd, ctx, mesh, &operand, 1, use_exact);
+
+  /* if new mesh returned, return it; otherwise there was
+   * an error, so delete the modifier object */
+  if (result == NULL) {
+    BKE_modifier_set_error(md, "Cannot execute boolean operation");
   }
 
   return result;
@@ -395,7 +877,13 @@ static void panel_draw(const bContext *C, Panel *panel)
 
   const bool use_exact = RNA_enum_get(&ptr, "solver") == eBooleanModifierSolver_Exact;
 
-  uiItemR(layout, &ptr, "object", 0, NULL, ICON_NONE);
+  uiItemR(layout, &ptr, "operand_type", UI_ITEM_R_EXPAND, NULL, ICON_NONE);
+  if (RNA_enum_get(&ptr, "operand_type") == eBooleanModifierOperandType_Collection) {
+    uiItemR(layout, &ptr, "collection", 0, NULL, ICON_NONE);
+  }
+  else {
+    uiItemR(layout, &ptr, "object", 0, NULL, ICON_NONE);
+  }
   uiItemR(layout, &ptr, "solver", UI_ITEM_R_EXPAND, NULL, ICON_NONE);
 
   if (!use_exact) {
@@ -435,15 +923,15 @@ ModifierTypeInfo modifierType_Boolean = {
 
     /* initData */ initData,
     /* requiredDataMask */ requiredDataMask,
-    /* freeData */ NULL,
+    /* freeData */ freeData,
     /* isDisabled */ isDisabled,
     /* updateDepsgraph */ updateDepsgraph,
     /* dependsOnTime */ NULL,
     /* dependsOnNormals */ NULL,
     /* foreachObjectLink */ foreachObjectLink,
-    /* foreachIDLink */ NULL,
+    /* foreachIDLink */ foreachIDLink,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
     /* panelRegister */ panelRegister,
     /* blendWrite */ NULL,
     /* blendRead */ NULL,
@@ -0,0 +1,283 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_collection_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math_matrix.h"
+#include "BLI_math_vector.h"
+#include "BLI_threads.h"
+
+#include "BKE_collection.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_modifier.h"
+
+namespace blender::modifiers::tests {
+
+/* A cube centered at the origin, with faces pointing outwards. */
+static Mesh *cube_mesh_create(const float size)
+{
+  const int quads[6][4] = {
+      {0, 4, 6, 2}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 2, 3, 1}, {4, 5, 7, 6}};
+
+  Mesh *mesh = BKE_mesh_new_nomain(8, 0, 0, 24, 6);
+  for (int i = 0; i < 8; i++) {
+    for (int axis = 0; axis < 3; axis++) {
+      mesh->mvert[i].co[axis] = ((i >> axis) & 1) ? size : -size;
+    }
+  }
+  for (int i = 0; i < 6; i++) {
+    mesh->mpoly[i].loopstart = i * 4;
+    mesh->mpoly[i].totloop = 4;
+    for (int j = 0; j < 4; j++) {
+      mesh->mloop[i * 4 + j].v = quads[i][j];
+    }
+  }
+  BKE_mesh_calc_edges(mesh, false, false);
+  return mesh;
+}
+
+/* Operands cutting into the sides of the cube, without touching each other. */
+static const float OPERAND_CO[4][3] = {
+    {1.0f, -0.5f, 0.1f}, {1.0f, 0.5f, -0.1f}, {-1.0f, 0.2f, 0.3f}, {0.1f, 1.0f, -0.4f}};
+
+class BooleanModifierTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+    BKE_idtype_init();
+    BKE_modifier_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BLI_threadapi_exit();
+  }
+
+ protected:
+  Object *ob;
+  Mesh *mesh;
+  Collection *collection;
+  BooleanModifierData *bmd;
+
+  void SetUp() override
+  {
+    ob = static_cast<Object *>(BKE_id_new_nomain(ID_OB, "Object"));
+    ob->type = OB_MESH;
+    unit_m4(ob->obmat);
+    mesh = cube_mesh_create(1.0f);
+    collection = static_cast<Collection *>(BKE_id_new_nomain(ID_GR, "Collection"));
+
+    bmd = reinterpret_cast<BooleanModifierData *>(BKE_modifier_new(eModifierType_Boolean));
+    bmd->operand_type = eBooleanModifierOperandType_Collection;
+    bmd->collection = collection;
+    BLI_addtail(&ob->modifiers, bmd);
+  }
+
+  void TearDown() override
+  {
+    while (collection->gobject.first) {
+      remove_operand(0);
+    }
+    BKE_id_free(nullptr, collection);
+    BKE_id_free(nullptr, mesh);
+    BKE_id_free(nullptr, ob);
+  }
+
+  void add_operand(const float co[3])
+  {
+    Object *ob_operand = static_cast<Object *>(BKE_id_new_nomain(ID_OB, "Operand"));
+    ob_operand->type = OB_MESH;
+    unit_m4(ob_operand->obmat);
+    copy_v3_v3(ob_operand->obmat[3], co);
+    ob_operand->runtime.data_eval = &cube_mesh_create(0.3f)->id;
+
+    CollectionObject *cob = static_cast<CollectionObject *>(
+        MEM_callocN(sizeof(*cob), "CollectionObject"));
+    cob->ob = ob_operand;
+    BLI_addtail(&collection->gobject, cob);
+    BKE_collection_object_cache_free(collection);
+  }
+
+  Object *operand_get(const int index)
+  {
+    return static_cast<CollectionObject *>(BLI_findlink(&collection->gobject, index))->ob;
+  }
+
+  void remove_operand(const int index)
+  {
+    CollectionObject *cob = static_cast<CollectionObject *>(
+        BLI_findlink(&collection->gobject, index));
+    Object *ob_operand = cob->ob;
+    BLI_freelinkN(&collection->gobject, cob);
+    BKE_collection_object_cache_free(collection);
+
+    BKE_id_free(nullptr, ob_operand->runtime.data_eval);
+    ob_operand->runtime.data_eval = nullptr;
+    BKE_id_free(nullptr, ob_operand);
+  }
+
+  Mesh *evaluate(const ModifierApplyFlag flag)
+  {
+    const ModifierTypeInfo *mti = BKE_modifier_get_info(eModifierType_Boolean);
+    ModifierEvalContext ctx = {nullptr, ob, flag};
+    return mti->modifyMesh(&bmd->modifier, &ctx, mesh);
+  }
+
+  /* The viewport evaluation may use the cached result, which must be the same as evaluating
+   * all operands again for render. */
+  void expect_same_as_render()
+  {
+    Mesh *result = evaluate(ModifierApplyFlag(0));
+    Mesh *result_render = evaluate(MOD_APPLY_RENDER);
+    ASSERT_NE(result, nullptr);
+    ASSERT_NE(result_render, nullptr);
+
+    ASSERT_EQ(result->totvert, result_render->totvert);
+    ASSERT_EQ(result->totedge, result_render->totedge);
+    ASSERT_EQ(result->totloop, result_render->totloop);
+    ASSERT_EQ(result->totpoly, result_render->totpoly);
+    for (int i = 0; i < result->totvert; i++) {
+      for (int axis = 0; axis < 3; axis++) {
+        EXPECT_EQ(result->mvert[i].co[axis], result_render->mvert[i].co[axis]);
+      }
+    }
+    for (int i = 0; i < result->totloop; i++) {
+      EXPECT_EQ(result->mloop[i].v, result_render->mloop[i].v);
+    }
+    for (int i = 0; i < result->totpoly; i++) {
+      EXPECT_EQ(result->mpoly[i].loopstart, result_render->mpoly[i].loopstart);
+      EXPECT_EQ(result->mpoly[i].totloop, result_render->mpoly[i].totloop);
+      EXPECT_EQ(result->mpoly[i].mat_nr, result_render->mpoly[i].mat_nr);
+    }
+
+    if (result != mesh) {
+      BKE_id_free(nullptr, result);
+    }
+    if (result_render != mesh) {
+      BKE_id_free(nullptr, result_render);
+    }
+  }
+
+  void move_operand_test(const BooleanModifierSolver solver)
+  {
+    bmd->solver = solver;
+    for (int i = 0; i < 3; i++) {
+      add_operand(OPERAND_CO[i]);
+    }
+    expect_same_as_render();
+    expect_same_as_render();
+
+    /* The operands before it didn't change. */
+    Object *ob_last = operand_get(2);
+    ob_last->obmat[3][1] -= 0.1f;
+    expect_same_as_render();
+    ob_last->obmat[3][2] += 0.1f;
+    expect_same_as_render();
+    expect_same_as_render();
+
+    /* Cached results with the first operand can't be used anymore. */
+    operand_get(0)->obmat[3][2] -= 0.2f;
+    expect_same_as_render();
+    ob_last->obmat[3][1] += 0.1f;
+    expect_same_as_render();
+
+    /* The operands move back to where they were before. */
+    operand_get(0)->obmat[3][2] += 0.2f;
+    ob_last->obmat[3][2] -= 0.1f;
+    expect_same_as_render();
+  }
+
+  void add_remove_operands_test(const BooleanModifierSolver solver)
+  {
+    bmd->solver = solver;
+    expect_same_as_render();
+    for (int i = 0; i < 4; i++) {
+      add_operand(OPERAND_CO[i]);
+      expect_same_as_render();
+    }
+
+    remove_operand(3);
+    expect_same_as_render();
+    remove_operand(0);
+    expect_same_as_render();
+    add_operand(OPERAND_CO[0]);
+    expect_same_as_render();
+
+    while (collection->gobject.first) {
+      remove_operand(0);
+      expect_same_as_render();
+    }
+  }
+
+  void self_change_test(const BooleanModifierSolver solver)
+  {
+    bmd->solver = solver;
+    for (int i = 0; i < 3; i++) {
+      add_operand(OPERAND_CO[i]);
+    }
+    expect_same_as_render();
+
+    /* Change an operand, so there is a cached result with the others. */
+    operand_get(2)->obmat[3][1] -= 0.1f;
+    expect_same_as_render();
+
+    for (int i = 0; i < mesh->totvert; i++) {
+      mul_v3_fl(mesh->mvert[i].co, 1.1f);
+    }
+    expect_same_as_render();
+
+    /* Only changes the attributes, not the geometry. */
+    mesh->mpoly[1].mat_nr = 1;
+    expect_same_as_render();
+
+    bmd->operation = eBooleanModifierOp_Union;
+    expect_same_as_render();
+    bmd->operation = eBooleanModifierOp_Intersect;
+    expect_same_as_render();
+  }
+};
+
+TEST_F(BooleanModifierTest, MoveOperand_Fast)
+{
+  move_operand_test(eBooleanModifierSolver_Fast);
+}
+
+TEST_F(BooleanModifierTest, AddRemoveOperands_Fast)
+{
+  add_remove_operands_test(eBooleanModifierSolver_Fast);
+}
+
+TEST_F(BooleanModifierTest, SelfChange_Fast)
+{
+  self_change_test(eBooleanModifierSolver_Fast);
+}
+
+#ifdef WITH_GMP
+TEST_F(BooleanModifierTest, MoveOperand_Exact)
+{
+  move_operand_test(eBooleanModifierSolver_Exact);
+}
+
+TEST_F(BooleanModifierTest, AddRemoveOperands_Exact)
+{
+  add_remove_operands_test(eBooleanModifierSolver_Exact);
+}
+
+TEST_F(BooleanModifierTest, SelfChange_Exact)
+{
+  self_change_test(eBooleanModifierSolver_Exact);
+}
+#endif
+
+}  // namespace blender::modifiers::tests
@@ -23,6 +23,7 @@
 
 #include "BLI_utildefines.h"
 
+#include "BLI_hash_mm2a.h"
 #include "BLI_math.h"
 #include "BLI_task.h"
 
@@ -64,6 +65,36 @@
 #  include <emmintrin.h>
 #endif
 
+/**
+ * Static bind influences packed for evaluation: the cage vertices and the weights, normalized by
+ * the total weight of their vertex, are stored in separate arrays indexed like
+ * #MeshDeformModifierData.bindinfluences. Kept in the modifier runtime data while the bind data
+ * doesn't change.
+ *
+ * The runtime data outlives copy-on-write copies of the modifier, and new bind data can be
+ * allocated where freed bind data was, so the bind data is identified by its content.
+ */
+typedef struct MeshDeformRuntimeData {
+  /** Bind data the influences were packed from. */
+  uint bind_hash;
+  int totvert;
+  int totinfluence;
+
+  int *cage_verts;
+  float *weights;
+} MeshDeformRuntimeData;
+
+static void freeRuntimeData(void *runtime_data_v)
+{
+  if (runtime_data_v == NULL) {
+    return;
+  }
+  MeshDeformRuntimeData *runtime_data = (MeshDeformRuntimeData *)runtime_data_v;
+  MEM_SAFE_FREE(runtime_data->cage_verts);
+  MEM_SAFE_FREE(runtime_data->weights);
+  MEM_freeN(runtime_data);
+}
+
 static void initData(ModifierData *md)
 {
   MeshDeformModifierData *mmd = (MeshDeformModifierData *)md;
@@ -99,6 +130,8 @@ static void freeData(ModifierData *md)
   if (mmd->bindcos) {
     MEM_freeN(mmd->bindcos); /* deprecated */
   }
+  freeRuntimeData(md->runtime);
+  md->runtime = NULL;
 }
 
 static void copyData(const ModifierData *md, ModifierData *target, const int flag)
@@ -275,6 +308,9 @@ typedef struct MeshdeformUserdata {
   float (*vertexCos)[3];
   float (*cagemat)[4];
   float (*icagemat)[3];
+  /* Packed static bind influences, see #MeshDeformRuntimeData. */
+  const int *cage_verts;
+  const float *weights;
 } MeshdeformUserdata;
 
 static void meshdeform_vert_task(void *__restrict userdata,
@@ -286,11 +322,10 @@ static void meshdeform_vert_task(void *__restrict userdata,
   const MDeformVert *dvert = data->dvert;
   const int defgrp_index = data->defgrp_index;
   const int *offsets = mmd->bindoffsets;
-  const MDefInfluence *__restrict influences = mmd->bindinfluences;
   /*const*/ float(*__restrict dco)[3] = data->dco;
   float(*vertexCos)[3] = data->vertexCos;
   float co[3];
-  float weight, totweight, fac = 1.0f;
+  float totweight, fac = 1.0f;
 
   if (mmd->flag & MOD_MDEF_DYNAMIC_BIND) {
     if (!mmd->dynverts[iter]) {
@@ -316,16 +351,27 @@ static void meshdeform_vert_task(void *__restrict userdata,
     totweight = meshdeform_dynamic_bind(mmd, dco, co);
   }
   else {
-    totweight = 0.0f;
-    zero_v3(co);
-    int start = offsets[iter];
-    int end = offsets[iter + 1];
+    const int *__restrict cage_verts = data->cage_verts;
+    const float *__restrict weights = data->weights;
+    const int start = offsets[iter];
+    const int end = offsets[iter + 1];
 
+    /* Weights are normalized already, they're all zero for vertices without influence. */
+#ifdef __SSE2__
+    __m128 co_r = _mm_setzero_ps();
     for (int a = start; a < end; a++) {
-      weight = influences[a].weight;
-      madd_v3_v3fl(co, dco[influences[a].vertex], weight);
-      totweight += weight;
+      /* This will load one extra element, dco has one extra element for this. */
+      const __m128 cageco_r = _mm_loadu_ps(dco[cage_verts[a]]);
+      co_r = _mm_add_ps(co_r, _mm_mul_ps(cageco_r, _mm_set1_ps(weights[a])));
     }
+    copy_v3_v3(co, (float *)&co_r);
+#else
+    zero_v3(co);
+    for (int a = start; a < end; a++) {
+      madd_v3_v3fl(co, dco[cage_verts[a]], weights[a]);
+    }
+#endif
+    totweight = 1.0f;
   }
 
   if (totweight > 0.0f) {
@@ -335,6 +381,71 @@ static void meshdeform_vert_task(void *__restrict userdata,
   }
 }
 
+static void meshdeform_pack_influences_task(void *__restrict userdata,
+                                            const int iter,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const MeshDeformModifierData *mmd = userdata;
+  MeshDeformRuntimeData *runtime_data = mmd->modifier.runtime;
+  const MDefInfluence *influences = mmd->bindinfluences;
+  const int start = mmd->bindoffsets[iter];
+  const int end = mmd->bindoffsets[iter + 1];
+  float totweight = 0.0f;
+
+  for (int a = start; a < end; a++) {
+    totweight += influences[a].weight;
+  }
+  for (int a = start; a < end; a++) {
+    runtime_data->cage_verts[a] = influences[a].vertex;
+    runtime_data->weights[a] = (totweight > 0.0f) ? influences[a].weight / totweight : 0.0f;
+  }
+}
+
+static uint meshdeform_bind_hash(const MeshDeformModifierData *mmd, const int totinfluence)
+{
+  BLI_HashMurmur2A mm2;
+  BLI_hash_mm2a_init(&mm2, 0);
+  BLI_hash_mm2a_add(&mm2,
+                    (const uchar *)mmd->bindoffsets,
+                    sizeof(*mmd->bindoffsets) * (size_t)(mmd->totvert + 1));
+  BLI_hash_mm2a_add(&mm2,
+                    (const uchar *)mmd->bindinfluences,
+                    sizeof(*mmd->bindinfluences) * (size_t)totinfluence);
+  return BLI_hash_mm2a_end(&mm2);
+}
+
+static const MeshDeformRuntimeData *meshdeform_runtime_ensure(MeshDeformModifierData *mmd)
+{
+  MeshDeformRuntimeData *runtime_data = mmd->modifier.runtime;
+  const int totinfluence = mmd->bindoffsets[mmd->totvert];
+  const uint bind_hash = meshdeform_bind_hash(mmd, totinfluence);
+  if (runtime_data == NULL) {
+    runtime_data = MEM_callocN(sizeof(*runtime_data), "meshdeform runtime");
+    mmd->modifier.runtime = runtime_data;
+  }
+  else if (runtime_data->cage_verts != NULL && runtime_data->bind_hash == bind_hash &&
+           runtime_data->totvert == mmd->totvert && runtime_data->totinfluence == totinfluence) {
+    return runtime_data;
+  }
+
+  MEM_SAFE_FREE(runtime_data->cage_verts);
+  MEM_SAFE_FREE(runtime_data->weights);
+  runtime_data->cage_verts = MEM_malloc_arrayN(
+      totinfluence, sizeof(*runtime_data->cage_verts), __func__);
+  runtime_data->weights = MEM_malloc_arrayN(
+      totinfluence, sizeof(*runtime_data->weights), __func__);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, mmd->totvert, mmd, meshdeform_pack_influences_task, &settings);
+
+  runtime_data->bind_hash = bind_hash;
+  runtime_data->totvert = mmd->totvert;
+  runtime_data->totinfluence = totinfluence;
+  return runtime_data;
+}
+
 static void meshdeformModifier_do(ModifierData *md,
                                   const ModifierEvalContext *ctx,
                                   Mesh *mesh,
@@ -389,6 +500,9 @@ static void meshdeformModifier_do(ModifierData *md,
       goto finally;
     }
     if (!recursive_bind_sentinel) {
+      /* Packed influences of a previous bind must not be reused. */
+      freeRuntimeData(md->runtime);
+      md->runtime = NULL;
       recursive_bind_sentinel = 1;
       mmd->bindfunc(mmd, cagemesh, (float *)vertexCos, numVerts, cagemat);
       recursive_bind_sentinel = 0;
@@ -443,6 +557,13 @@ static void meshdeformModifier_do(ModifierData *md,
   data.vertexCos = vertexCos;
   data.cagemat = cagemat;
   data.icagemat = icagemat;
+  data.cage_verts = NULL;
+  data.weights = NULL;
+  if (!(mmd->flag & MOD_MDEF_DYNAMIC_BIND)) {
+    const MeshDeformRuntimeData *runtime_data = meshdeform_runtime_ensure(mmd);
+    data.cage_verts = runtime_data->cage_verts;
+    data.weights = runtime_data->weights;
+  }
 
   /* Do deformation. */
   TaskParallelSettings settings;
@@ -655,7 +776,7 @@ ModifierTypeInfo modifierType_MeshDeform = {
     /* foreachObjectLink */ foreachObjectLink,
     /* foreachIDLink */ NULL,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
     /* panelRegister */ panelRegister,
     /* blendWrite */ blendWrite,
     /* blendRead */ blendRead,
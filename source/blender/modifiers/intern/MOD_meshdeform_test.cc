@@ -0,0 +1,134 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math_matrix.h"
+#include "BLI_math_vector.h"
+#include "BLI_threads.h"
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_modifier.h"
+
+namespace blender::modifiers::tests {
+
+static const int VERTS_NUM = 4;
+
+class MeshDeformModifierTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+    BKE_idtype_init();
+    BKE_modifier_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BLI_threadapi_exit();
+  }
+
+ protected:
+  Object *ob;
+  Object *ob_cage;
+  Mesh *mesh;
+  Mesh *mesh_cage;
+  MeshDeformModifierData *mmd;
+
+  void SetUp() override
+  {
+    mesh = BKE_mesh_new_nomain(VERTS_NUM, 0, 0, 0, 0);
+    ob = static_cast<Object *>(BKE_id_new_nomain(ID_OB, "Object"));
+    ob->type = OB_MESH;
+    unit_m4(ob->obmat);
+
+    /* The cage moved every vertex along X by one more than the previous one since binding. */
+    mesh_cage = BKE_mesh_new_nomain(VERTS_NUM, 0, 0, 0, 0);
+    ob_cage = static_cast<Object *>(BKE_id_new_nomain(ID_OB, "Cage"));
+    ob_cage->type = OB_MESH;
+    unit_m4(ob_cage->obmat);
+    ob_cage->runtime.data_eval = &mesh_cage->id;
+    for (int i = 0; i < VERTS_NUM; i++) {
+      mesh_cage->mvert[i].co[0] = (float)(i + 1);
+    }
+
+    mmd = reinterpret_cast<MeshDeformModifierData *>(BKE_modifier_new(eModifierType_MeshDeform));
+    BLI_addtail(&ob->modifiers, mmd);
+    mmd->object = ob_cage;
+    unit_m4(mmd->bindmat);
+    mmd->totvert = VERTS_NUM;
+    mmd->totcagevert = VERTS_NUM;
+    mmd->bindcagecos = static_cast<float *>(
+        MEM_calloc_arrayN(VERTS_NUM, sizeof(float[3]), __func__));
+  }
+
+  void TearDown() override
+  {
+    ob_cage->runtime.data_eval = nullptr;
+    BKE_id_free(nullptr, ob);
+    BKE_id_free(nullptr, ob_cage);
+    BKE_id_free(nullptr, mesh);
+    BKE_id_free(nullptr, mesh_cage);
+  }
+
+  /* Bind every vertex to one cage vertex, as a new bind does. */
+  void bind(const int cage_vert_offset)
+  {
+    MEM_SAFE_FREE(mmd->bindinfluences);
+    MEM_SAFE_FREE(mmd->bindoffsets);
+    mmd->bindinfluences = static_cast<MDefInfluence *>(
+        MEM_calloc_arrayN(VERTS_NUM, sizeof(MDefInfluence), __func__));
+    mmd->bindoffsets = static_cast<int *>(MEM_calloc_arrayN(VERTS_NUM + 1, sizeof(int), __func__));
+    for (int i = 0; i < VERTS_NUM; i++) {
+      mmd->bindoffsets[i] = i;
+      mmd->bindinfluences[i].vertex = (i + cage_vert_offset) % VERTS_NUM;
+      mmd->bindinfluences[i].weight = 0.5f;
+    }
+    mmd->bindoffsets[VERTS_NUM] = VERTS_NUM;
+    mmd->totinfluence = VERTS_NUM;
+  }
+
+  void expect_deform(const int cage_vert_offset)
+  {
+    const ModifierTypeInfo *mti = BKE_modifier_get_info(eModifierType_MeshDeform);
+    ModifierEvalContext ctx = {nullptr, ob, ModifierApplyFlag(0)};
+    float vert_coords[VERTS_NUM][3] = {{0.0f}};
+    mti->deformVerts(&mmd->modifier, &ctx, mesh, vert_coords, VERTS_NUM);
+    EXPECT_NE(mmd->modifier.runtime, nullptr);
+    for (int i = 0; i < VERTS_NUM; i++) {
+      const float co[3] = {(float)((i + cage_vert_offset) % VERTS_NUM + 1), 0.0f, 0.0f};
+      EXPECT_V3_NEAR(vert_coords[i], co, 1e-6f);
+    }
+  }
+};
+
+TEST_F(MeshDeformModifierTest, PackedInfluences)
+{
+  bind(0);
+  expect_deform(0);
+  expect_deform(0);
+
+  /* The new bind data may be allocated where the previous one was. */
+  bind(1);
+  expect_deform(1);
+
+  /* Bind data changed in place. */
+  for (int i = 0; i < VERTS_NUM; i++) {
+    mmd->bindinfluences[i].vertex = (i + 2) % VERTS_NUM;
+  }
+  expect_deform(2);
+
+  bind(3);
+  expect_deform(3);
+}
+
+}  // namespace blender::modifiers::tests
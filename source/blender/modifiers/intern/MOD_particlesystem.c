@@ -163,8 +163,9 @@ static void deformVerts(ModifierData *md,
     }
   }
 
-  /* make new mesh */
-  psmd->mesh_final = BKE_mesh_copy_for_eval(mesh_src, false);
+  /* make new mesh, sharing the layers that aren't modified */
+  psmd->mesh_final = BKE_mesh_copy_for_eval(mesh_src, true);
+  BKE_mesh_duplicate_borrowed_layers(psmd->mesh_final);
   BKE_mesh_vert_coords_apply(psmd->mesh_final, vertexCos);
   BKE_mesh_calc_normals(psmd->mesh_final);
 
@@ -194,9 +195,10 @@ static void deformVerts(ModifierData *md,
 
     if (mesh_original) {
       /* Make a persistent copy of the mesh. We don't actually need
-       * all this data, just some topology for remapping. Could be
-       * optimized once. */
-      psmd->mesh_original = BKE_mesh_copy_for_eval(mesh_original, false);
+       * all this data, just some topology for remapping, the layers
+       * are shared with the original mesh. */
+      psmd->mesh_original = BKE_mesh_copy_for_eval(mesh_original, true);
+      BKE_mesh_duplicate_borrowed_layers(psmd->mesh_original);
     }
 
     BKE_mesh_tessface_ensure(psmd->mesh_original);
@@ -83,6 +83,12 @@ static void requiredDataMask(Object *UNUSED(ob),
   }
 }
 
+static void freeData(ModifierData *md)
+{
+  MOD_solidify_free_runtime_data(md->runtime);
+  md->runtime = NULL;
+}
+
 static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *ctx, Mesh *mesh)
 {
   const SolidifyModifierData *smd = (SolidifyModifierData *)md;
@@ -285,7 +291,7 @@ ModifierTypeInfo modifierType_Solidify = {
 
     /* initData */ initData,
     /* requiredDataMask */ requiredDataMask,
-    /* freeData */ NULL,
+    /* freeData */ freeData,
     /* isDisabled */ NULL,
     /* updateDepsgraph */ NULL,
     /* dependsOnTime */ NULL,
@@ -293,7 +299,7 @@ ModifierTypeInfo modifierType_Solidify = {
     /* foreachObjectLink */ NULL,
     /* foreachIDLink */ NULL,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ MOD_solidify_free_runtime_data,
     /* panelRegister */ panelRegister,
     /* blendWrite */ NULL,
     /* blendRead */ NULL,
@@ -22,6 +22,7 @@
 
 #include "BLI_bitmap.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_utildefines_stack.h"
 
 #include "DNA_mesh_types.h"
@@ -179,6 +180,223 @@ static void mesh_calc_hq_normal(Mesh *mesh, float (*poly_nors)[3], float (*r_ver
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Rim Topology
+ *
+ * The boundary edges of the input mesh and their vertices only depend on its topology, they're
+ * kept in the modifier runtime data between evaluations while the topology is unchanged.
+ * \{ */
+
+#define INVALID_UNUSED ((uint)-1)
+#define INVALID_PAIR ((uint)-2)
+
+typedef struct SolidifyRimData {
+  ModMeshTopologyKey topology_key;
+  /** The face using each edge (offset by the face count when the edge is flipped in its loop),
+   * or #INVALID_UNUSED / #INVALID_PAIR when the edge isn't used by exactly one face. */
+  uint *edge_users;
+  /** Index in the loop of its face of every rim edge. */
+  char *edge_order;
+  /** Original vertices and edges of the rim. */
+  uint *new_vert_arr;
+  uint *new_edge_arr;
+  uint new_vert_len;
+  uint new_edge_len;
+  /** Index in #new_vert_arr of every original vertex, or #INVALID_UNUSED. */
+  uint *old_vert_arr;
+} SolidifyRimData;
+
+static void solidify_rim_data_clear(SolidifyRimData *rim)
+{
+  MEM_SAFE_FREE(rim->edge_users);
+  MEM_SAFE_FREE(rim->edge_order);
+  MEM_SAFE_FREE(rim->new_vert_arr);
+  MEM_SAFE_FREE(rim->new_edge_arr);
+  MEM_SAFE_FREE(rim->old_vert_arr);
+}
+
+void MOD_solidify_free_runtime_data(void *runtime_data)
+{
+  if (runtime_data == NULL) {
+    return;
+  }
+  solidify_rim_data_clear(runtime_data);
+  MEM_freeN(runtime_data);
+}
+
+static const SolidifyRimData *solidify_rim_data_ensure(ModifierData *md, const Mesh *mesh)
+{
+  SolidifyRimData *rim = md->runtime;
+  ModMeshTopologyKey topology_key;
+  MOD_mesh_topology_key_calc(mesh, &topology_key);
+
+  if (rim == NULL) {
+    rim = MEM_callocN(sizeof(*rim), __func__);
+    md->runtime = rim;
+  }
+  else if (rim->edge_users != NULL &&
+           MOD_mesh_topology_key_equals(&rim->topology_key, &topology_key)) {
+    return rim;
+  }
+  solidify_rim_data_clear(rim);
+
+  const MEdge *orig_medge = mesh->medge;
+  const MLoop *orig_mloop = mesh->mloop;
+  const MPoly *orig_mpoly = mesh->mpoly;
+  const uint numVerts = (uint)mesh->totvert;
+  const uint numEdges = (uint)mesh->totedge;
+  const uint numPolys = (uint)mesh->totpoly;
+  const MEdge *ed;
+  const MPoly *mp;
+  uint eidx;
+  uint i;
+
+  BLI_bitmap *orig_mvert_tag = BLI_BITMAP_NEW(numVerts, __func__);
+
+  uint *new_vert_arr = MEM_malloc_arrayN(numVerts, sizeof(*new_vert_arr), __func__);
+  STACK_DECLARE(new_vert_arr);
+  uint *new_edge_arr = MEM_malloc_arrayN(numEdges, sizeof(*new_edge_arr), __func__);
+  STACK_DECLARE(new_edge_arr);
+  STACK_INIT(new_vert_arr, numVerts);
+  STACK_INIT(new_edge_arr, numEdges);
+
+  uint *edge_users = MEM_malloc_arrayN(numEdges, sizeof(*edge_users), "solid_mod edges");
+  char *edge_order = MEM_malloc_arrayN(numEdges, sizeof(*edge_order), "solid_mod order");
+  uint *old_vert_arr = MEM_malloc_arrayN(
+      numVerts, sizeof(*old_vert_arr), "old_vert_arr in solidify");
+
+  for (eidx = 0; eidx < numEdges; eidx++) {
+    edge_users[eidx] = INVALID_UNUSED;
+  }
+
+  for (i = 0, mp = orig_mpoly; i < numPolys; i++, mp++) {
+    const MLoop *ml, *ml_prev;
+    int j;
+
+    ml = orig_mloop + mp->loopstart;
+    ml_prev = ml + (mp->totloop - 1);
+
+    for (j = 0; j < mp->totloop; j++, ml++) {
+      /* add edge user */
+      eidx = ml_prev->e;
+      if (edge_users[eidx] == INVALID_UNUSED) {
+        ed = orig_medge + eidx;
+        BLI_assert(ELEM(ml_prev->v, ed->v1, ed->v2) && ELEM(ml->v, ed->v1, ed->v2));
+        edge_users[eidx] = (ml_prev->v > ml->v) == (ed->v1 < ed->v2) ? i : (i + numPolys);
+        edge_order[eidx] = (char)j;
+      }
+      else {
+        edge_users[eidx] = INVALID_PAIR;
+      }
+      ml_prev = ml;
+    }
+  }
+
+  for (eidx = 0, ed = orig_medge; eidx < numEdges; eidx++, ed++) {
+    if (!ELEM(edge_users[eidx], INVALID_UNUSED, INVALID_PAIR)) {
+      BLI_BITMAP_ENABLE(orig_mvert_tag, ed->v1);
+      BLI_BITMAP_ENABLE(orig_mvert_tag, ed->v2);
+      STACK_PUSH(new_edge_arr, eidx);
+    }
+  }
+
+  for (i = 0; i < numVerts; i++) {
+    if (BLI_BITMAP_TEST(orig_mvert_tag, i)) {
+      old_vert_arr[i] = STACK_SIZE(new_vert_arr);
+      STACK_PUSH(new_vert_arr, i);
+    }
+    else {
+      old_vert_arr[i] = INVALID_UNUSED;
+    }
+  }
+
+  MEM_freeN(orig_mvert_tag);
+
+  rim->topology_key = topology_key;
+  rim->edge_users = edge_users;
+  rim->edge_order = edge_order;
+  rim->new_vert_arr = new_vert_arr;
+  rim->new_edge_arr = new_edge_arr;
+  rim->new_vert_len = STACK_SIZE(new_vert_arr);
+  rim->new_edge_len = STACK_SIZE(new_edge_arr);
+  rim->old_vert_arr = old_vert_arr;
+  return rim;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Shell
+ * \{ */
+
+typedef struct SolidifyShellFlipData {
+  const Mesh *mesh;
+  Mesh *result;
+  uint numVerts;
+  uint numEdges;
+  short mat_ofs;
+  short mat_nr_max;
+} SolidifyShellFlipData;
+
+/* Fill the flipped copy of a face of the shell, each face only writes its own loops. */
+static void solidify_shell_flip_poly_task(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SolidifyShellFlipData *data = userdata;
+  const Mesh *mesh = data->mesh;
+  Mesh *result = data->result;
+  MPoly *mp = &result->mpoly[mesh->totpoly + i];
+  const int loop_end = mp->totloop - 1;
+  MLoop *ml2;
+  uint e;
+  int j;
+
+  /* reverses the loop direction (MLoop.v as well as custom-data)
+   * MLoop.e also needs to be corrected too, done in a separate loop below. */
+  ml2 = result->mloop + mp->loopstart + mesh->totloop;
+#if 0
+  for (j = 0; j < mp->totloop; j++) {
+    CustomData_copy_data(&mesh->ldata,
+                         &result->ldata,
+                         mp->loopstart + j,
+                         mp->loopstart + (loop_end - j) + mesh->totloop,
+                         1);
+  }
+#else
+  /* slightly more involved, keep the first vertex the same for the copy,
+   * ensures the diagonals in the new face match the original. */
+  j = 0;
+  for (int j_prev = loop_end; j < mp->totloop; j_prev = j++) {
+    CustomData_copy_data(&mesh->ldata,
+                         &result->ldata,
+                         mp->loopstart + j,
+                         mp->loopstart + (loop_end - j_prev) + mesh->totloop,
+                         1);
+  }
+#endif
+
+  if (data->mat_ofs) {
+    mp->mat_nr += data->mat_ofs;
+    CLAMP(mp->mat_nr, 0, data->mat_nr_max);
+  }
+
+  e = ml2[0].e;
+  for (j = 0; j < loop_end; j++) {
+    ml2[j].e = ml2[j + 1].e;
+  }
+  ml2[loop_end].e = e;
+
+  mp->loopstart += mesh->totloop;
+
+  for (j = 0; j < mp->totloop; j++) {
+    ml2[j].e += data->numEdges;
+    ml2[j].v += data->numVerts;
+  }
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Main Solidify Function
  * \{ */
@@ -203,19 +421,13 @@ Mesh *MOD_solidify_extrude_modifyMesh(ModifierData *md, const ModifierEvalContex
   const short mat_ofs = mat_nr_max ? smd->mat_ofs : 0;
   const short mat_ofs_rim = mat_nr_max ? smd->mat_ofs_rim : 0;
 
-  /* use for edges */
-  /* over-alloc new_vert_arr, old_vert_arr */
-  uint *new_vert_arr = NULL;
-  STACK_DECLARE(new_vert_arr);
-
-  uint *new_edge_arr = NULL;
-  STACK_DECLARE(new_edge_arr);
-
-  uint *old_vert_arr = MEM_calloc_arrayN(
-      numVerts, sizeof(*old_vert_arr), "old_vert_arr in solidify");
+  /* use for edges, owned by the rim data */
+  const uint *new_vert_arr = NULL;
+  const uint *new_edge_arr = NULL;
+  const uint *old_vert_arr = NULL;
+  const char *edge_order = NULL;
 
   uint *edge_users = NULL;
-  char *edge_order = NULL;
 
   float(*vert_nors)[3] = NULL;
   float(*poly_nors)[3] = NULL;
@@ -269,77 +481,16 @@ Mesh *MOD_solidify_extrude_modifyMesh(ModifierData *md, const ModifierEvalContex
                                true);
   }
 
-  STACK_INIT(new_vert_arr, numVerts * 2);
-  STACK_INIT(new_edge_arr, numEdges * 2);
-
   if (do_rim) {
-    BLI_bitmap *orig_mvert_tag = BLI_BITMAP_NEW(numVerts, __func__);
-    uint eidx;
-    uint i;
-
-#define INVALID_UNUSED ((uint)-1)
-#define INVALID_PAIR ((uint)-2)
-
-    new_vert_arr = MEM_malloc_arrayN(numVerts, 2 * sizeof(*new_vert_arr), __func__);
-    new_edge_arr = MEM_malloc_arrayN(((numEdges * 2) + numVerts), sizeof(*new_edge_arr), __func__);
-
-    edge_users = MEM_malloc_arrayN(numEdges, sizeof(*edge_users), "solid_mod edges");
-    edge_order = MEM_malloc_arrayN(numEdges, sizeof(*edge_order), "solid_mod order");
-
-    /* save doing 2 loops here... */
-#if 0
-    copy_vn_i(edge_users, numEdges, INVALID_UNUSED);
-#endif
-
-    for (eidx = 0, ed = orig_medge; eidx < numEdges; eidx++, ed++) {
-      edge_users[eidx] = INVALID_UNUSED;
-    }
-
-    for (i = 0, mp = orig_mpoly; i < numPolys; i++, mp++) {
-      MLoop *ml_prev;
-      int j;
-
-      ml = orig_mloop + mp->loopstart;
-      ml_prev = ml + (mp->totloop - 1);
-
-      for (j = 0; j < mp->totloop; j++, ml++) {
-        /* add edge user */
-        eidx = ml_prev->e;
-        if (edge_users[eidx] == INVALID_UNUSED) {
-          ed = orig_medge + eidx;
-          BLI_assert(ELEM(ml_prev->v, ed->v1, ed->v2) && ELEM(ml->v, ed->v1, ed->v2));
-          edge_users[eidx] = (ml_prev->v > ml->v) == (ed->v1 < ed->v2) ? i : (i + numPolys);
-          edge_order[eidx] = j;
-        }
-        else {
-          edge_users[eidx] = INVALID_PAIR;
-        }
-        ml_prev = ml;
-      }
-    }
-
-    for (eidx = 0, ed = orig_medge; eidx < numEdges; eidx++, ed++) {
-      if (!ELEM(edge_users[eidx], INVALID_UNUSED, INVALID_PAIR)) {
-        BLI_BITMAP_ENABLE(orig_mvert_tag, ed->v1);
-        BLI_BITMAP_ENABLE(orig_mvert_tag, ed->v2);
-        STACK_PUSH(new_edge_arr, eidx);
-        newPolys++;
-        newLoops += 4;
-      }
-    }
-
-    for (i = 0; i < numVerts; i++) {
-      if (BLI_BITMAP_TEST(orig_mvert_tag, i)) {
-        old_vert_arr[i] = STACK_SIZE(new_vert_arr);
-        STACK_PUSH(new_vert_arr, i);
-        rimVerts++;
-      }
-      else {
-        old_vert_arr[i] = INVALID_UNUSED;
-      }
-    }
-
-    MEM_freeN(orig_mvert_tag);
+    const SolidifyRimData *rim = solidify_rim_data_ensure(md, mesh);
+    new_vert_arr = rim->new_vert_arr;
+    new_edge_arr = rim->new_edge_arr;
+    old_vert_arr = rim->old_vert_arr;
+    edge_users = rim->edge_users;
+    edge_order = rim->edge_order;
+    rimVerts = rim->new_vert_len;
+    newPolys = rim->new_edge_len;
+    newLoops = newPolys * 4;
   }
 
   if (do_shell == false) {
@@ -448,55 +599,18 @@ Mesh *MOD_solidify_extrude_modifyMesh(ModifierData *md, const ModifierEvalContex
   if (do_shell) {
     uint i;
 
-    mp = mpoly + numPolys;
-    for (i = 0; i < mesh->totpoly; i++, mp++) {
-      const int loop_end = mp->totloop - 1;
-      MLoop *ml2;
-      uint e;
-      int j;
-
-      /* reverses the loop direction (MLoop.v as well as custom-data)
-       * MLoop.e also needs to be corrected too, done in a separate loop below. */
-      ml2 = mloop + mp->loopstart + mesh->totloop;
-#if 0
-      for (j = 0; j < mp->totloop; j++) {
-        CustomData_copy_data(&mesh->ldata,
-                             &result->ldata,
-                             mp->loopstart + j,
-                             mp->loopstart + (loop_end - j) + mesh->totloop,
-                             1);
-      }
-#else
-      /* slightly more involved, keep the first vertex the same for the copy,
-       * ensures the diagonals in the new face match the original. */
-      j = 0;
-      for (int j_prev = loop_end; j < mp->totloop; j_prev = j++) {
-        CustomData_copy_data(&mesh->ldata,
-                             &result->ldata,
-                             mp->loopstart + j,
-                             mp->loopstart + (loop_end - j_prev) + mesh->totloop,
-                             1);
-      }
-#endif
-
-      if (mat_ofs) {
-        mp->mat_nr += mat_ofs;
-        CLAMP(mp->mat_nr, 0, mat_nr_max);
-      }
-
-      e = ml2[0].e;
-      for (j = 0; j < loop_end; j++) {
-        ml2[j].e = ml2[j + 1].e;
-      }
-      ml2[loop_end].e = e;
-
-      mp->loopstart += mesh->totloop;
-
-      for (j = 0; j < mp->totloop; j++) {
-        ml2[j].e += numEdges;
-        ml2[j].v += numVerts;
-      }
-    }
+    SolidifyShellFlipData data = {
+        .mesh = mesh,
+        .result = result,
+        .numVerts = numVerts,
+        .numEdges = numEdges,
+        .mat_ofs = mat_ofs,
+        .mat_nr_max = mat_nr_max,
+    };
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (numLoops > 1024);
+    BLI_task_parallel_range(0, (int)numPolys, &data, solidify_shell_flip_poly_task, &settings);
 
     for (i = 0, ed = medge + numEdges; i < numEdges; i++, ed++) {
       ed->v1 += numVerts;
@@ -1216,15 +1330,6 @@ Mesh *MOD_solidify_extrude_modifyMesh(ModifierData *md, const ModifierEvalContex
     }
 #endif
 
-    MEM_freeN(new_vert_arr);
-    MEM_freeN(new_edge_arr);
-
-    MEM_freeN(edge_users);
-    MEM_freeN(edge_order);
-  }
-
-  if (old_vert_arr) {
-    MEM_freeN(old_vert_arr);
   }
 
   if (poly_nors) {
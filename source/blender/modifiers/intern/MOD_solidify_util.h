@@ -24,6 +24,7 @@
 Mesh *MOD_solidify_extrude_modifyMesh(ModifierData *md,
                                       const ModifierEvalContext *ctx,
                                       Mesh *mesh);
+void MOD_solidify_free_runtime_data(void *runtime_data);
 
 /* MOD_solidify_nonmanifold.c */
 Mesh *MOD_solidify_nonmanifold_modifyMesh(ModifierData *md,
@@ -163,6 +163,7 @@ static void subdiv_settings_init(SubdivSettings *settings, const SubsurfModifier
   settings->vtx_boundary_interpolation = SUBDIV_VTX_BOUNDARY_EDGE_ONLY;
   settings->fvar_linear_interpolation = BKE_subdiv_fvar_interpolation_from_uv_smooth(
       smd->uv_smooth);
+  settings->evaluator_type = BKE_subdiv_evaluator_type_from_userdef();
 }
 
 /* Main goal of this function is to give usable subdivision surface descriptor
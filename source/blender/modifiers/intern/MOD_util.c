@@ -26,6 +26,7 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_bitmap.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_math_matrix.h"
 #include "BLI_math_vector.h"
 
@@ -267,6 +268,45 @@ void MOD_get_vgroup(
   }
 }
 
+/**
+ * Key of the vertex count, edges, loops and polygons of \a mesh, for modifiers that keep data
+ * derived from the topology of their input mesh between evaluations. The element counts are
+ * stored along with the hash, so data sized for other counts is never used after a collision.
+ */
+void MOD_mesh_topology_key_calc(const Mesh *mesh, ModMeshTopologyKey *r_key)
+{
+  BLI_HashMurmur2A mm2;
+  BLI_hash_mm2a_init(&mm2, 0);
+  BLI_hash_mm2a_add_int(&mm2, mesh->totvert);
+  BLI_hash_mm2a_add_int(&mm2, mesh->totedge);
+  BLI_hash_mm2a_add_int(&mm2, mesh->totloop);
+  BLI_hash_mm2a_add_int(&mm2, mesh->totpoly);
+  if (mesh->totedge) {
+    BLI_hash_mm2a_add(
+        &mm2, (const uchar *)mesh->medge, sizeof(*mesh->medge) * (size_t)mesh->totedge);
+  }
+  if (mesh->totloop) {
+    BLI_hash_mm2a_add(
+        &mm2, (const uchar *)mesh->mloop, sizeof(*mesh->mloop) * (size_t)mesh->totloop);
+  }
+  if (mesh->totpoly) {
+    BLI_hash_mm2a_add(
+        &mm2, (const uchar *)mesh->mpoly, sizeof(*mesh->mpoly) * (size_t)mesh->totpoly);
+  }
+  r_key->hash = BLI_hash_mm2a_end(&mm2);
+  r_key->totvert = mesh->totvert;
+  r_key->totedge = mesh->totedge;
+  r_key->totloop = mesh->totloop;
+  r_key->totpoly = mesh->totpoly;
+}
+
+bool MOD_mesh_topology_key_equals(const ModMeshTopologyKey *key_a, const ModMeshTopologyKey *key_b)
+{
+  return (key_a->hash == key_b->hash && key_a->totvert == key_b->totvert &&
+          key_a->totedge == key_b->totedge && key_a->totloop == key_b->totloop &&
+          key_a->totpoly == key_b->totpoly);
+}
+
 void MOD_depsgraph_update_object_bone_relation(struct DepsNodeHandle *node,
                                                Object *object,
                                                const char *bonename,
@@ -55,6 +55,19 @@ void MOD_get_vgroup(struct Object *ob,
                     struct MDeformVert **dvert,
                     int *defgrp_index);
 
+/** Identifies the topology of a mesh, see #MOD_mesh_topology_key_calc. */
+typedef struct ModMeshTopologyKey {
+  uint hash;
+  int totvert;
+  int totedge;
+  int totloop;
+  int totpoly;
+} ModMeshTopologyKey;
+
+void MOD_mesh_topology_key_calc(const struct Mesh *mesh, ModMeshTopologyKey *r_key);
+bool MOD_mesh_topology_key_equals(const ModMeshTopologyKey *key_a,
+                                  const ModMeshTopologyKey *key_b);
+
 void MOD_depsgraph_update_object_bone_relation(struct DepsNodeHandle *node,
                                                struct Object *object,
                                                const char *bonename,
@@ -34,6 +34,7 @@
 #include "BLI_alloca.h"
 #include "BLI_kdopbvh.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -59,6 +60,7 @@
 
 #include "MOD_modifiertypes.h"
 #include "MOD_ui_common.h"
+#include "MOD_util.h"
 
 //#define USE_WELD_DEBUG
 //#define USE_WELD_NORMALS
@@ -136,6 +138,7 @@ typedef struct WeldMesh {
   /* Group of vertices to be merged. */
   struct WeldGroup *vert_groups;
   uint *vert_groups_buffer;
+  uint vert_groups_len;
   /* From the original index of the vertex, this indicates which group it is or is going to be
    * merged. */
   uint *vert_groups_map;
@@ -143,6 +146,7 @@ typedef struct WeldMesh {
   /* Group of edges to be merged. */
   struct WeldGroupEdge *edge_groups;
   uint *edge_groups_buffer;
+  uint edge_groups_len;
   /* From the original index of the vertex, this indicates which group it is or is going to be
    * merged. */
   uint *edge_groups_map;
@@ -382,6 +386,21 @@ static void weld_assert_poly_len(const WeldPoly *wp, const WeldLoop *wloop)
 /** \name Weld Vert API
  * \{ */
 
+/* Destination of a vertex in context, compressing the path to it on the way. */
+static uint weld_vert_dest_find(uint *vert_dest_map, uint v)
+{
+  uint root = v;
+  while (vert_dest_map[root] != root) {
+    root = vert_dest_map[root];
+  }
+  while (vert_dest_map[v] != root) {
+    const uint v_next = vert_dest_map[v];
+    vert_dest_map[v] = root;
+    v = v_next;
+  }
+  return root;
+}
+
 static void weld_vert_ctx_alloc_and_setup(const uint mvert_len,
                                           const BVHTreeOverlap *overlap,
                                           const uint overlap_len,
@@ -395,6 +414,8 @@ static void weld_vert_ctx_alloc_and_setup(const uint mvert_len,
     *v_dest_iter = OUT_OF_CONTEXT;
   }
 
+  /* Clusters of overlapping vertices are merged with union-find, the root of a cluster is its
+   * destination vertex. */
   uint vert_kill_len = 0;
   const BVHTreeOverlap *overlap_iter = &overlap[0];
   for (uint i = 0; i < overlap_len; i++, overlap_iter++) {
@@ -410,39 +431,31 @@ static void weld_vert_ctx_alloc_and_setup(const uint mvert_len,
         vb_dst = indexA;
         r_vert_dest_map[indexB] = vb_dst;
       }
+      else {
+        vb_dst = weld_vert_dest_find(r_vert_dest_map, indexB);
+      }
       r_vert_dest_map[indexA] = vb_dst;
       vert_kill_len++;
     }
     else if (vb_dst == OUT_OF_CONTEXT) {
-      r_vert_dest_map[indexB] = va_dst;
+      r_vert_dest_map[indexB] = weld_vert_dest_find(r_vert_dest_map, indexA);
       vert_kill_len++;
     }
-    else if (va_dst != vb_dst) {
-      uint v_new, v_old;
-      if (va_dst < vb_dst) {
-        v_new = va_dst;
-        v_old = vb_dst;
-      }
-      else {
-        v_new = vb_dst;
-        v_old = va_dst;
+    else {
+      va_dst = weld_vert_dest_find(r_vert_dest_map, indexA);
+      vb_dst = weld_vert_dest_find(r_vert_dest_map, indexB);
+      if (va_dst != vb_dst) {
+        /* The cluster with the lowest destination is kept. */
+        r_vert_dest_map[MAX2(va_dst, vb_dst)] = MIN2(va_dst, vb_dst);
+        vert_kill_len++;
       }
-      BLI_assert(r_vert_dest_map[v_old] == v_old);
-      BLI_assert(r_vert_dest_map[v_new] == v_new);
-      vert_kill_len++;
+    }
+  }
 
-      const BVHTreeOverlap *overlap_iter_b = &overlap[0];
-      for (uint j = i + 1; j--; overlap_iter_b++) {
-        indexA = overlap_iter_b->indexA;
-        indexB = overlap_iter_b->indexB;
-        va_dst = r_vert_dest_map[indexA];
-        vb_dst = r_vert_dest_map[indexB];
-        if (ELEM(v_old, vb_dst, va_dst)) {
-          r_vert_dest_map[indexA] = v_new;
-          r_vert_dest_map[indexB] = v_new;
-        }
-      }
-      BLI_assert(r_vert_dest_map[v_old] == v_new);
+  v_dest_iter = &r_vert_dest_map[0];
+  for (uint i = 0; i < mvert_len; i++, v_dest_iter++) {
+    if (*v_dest_iter != OUT_OF_CONTEXT) {
+      *v_dest_iter = weld_vert_dest_find(r_vert_dest_map, i);
     }
   }
 
@@ -478,7 +491,8 @@ static void weld_vert_groups_setup(const uint mvert_len,
                                    const uint *vert_dest_map,
                                    uint *r_vert_groups_map,
                                    uint **r_vert_groups_buffer,
-                                   struct WeldGroup **r_vert_groups)
+                                   struct WeldGroup **r_vert_groups,
+                                   uint *r_vert_groups_len)
 {
   /* Get weld vert groups. */
 
@@ -532,6 +546,7 @@ static void weld_vert_groups_setup(const uint mvert_len,
 
   *r_vert_groups = wgroups;
   *r_vert_groups_buffer = groups_buffer;
+  *r_vert_groups_len = wgroups_len;
 }
 
 /** \} */
@@ -714,7 +729,8 @@ static void weld_edge_groups_setup(const uint medge_len,
                                    const uint *wedge_map,
                                    uint *r_edge_groups_map,
                                    uint **r_edge_groups_buffer,
-                                   struct WeldGroupEdge **r_edge_groups)
+                                   struct WeldGroupEdge **r_edge_groups,
+                                   uint *r_edge_groups_len)
 {
 
   /* Get weld edge groups. */
@@ -786,6 +802,7 @@ static void weld_edge_groups_setup(const uint medge_len,
 
   *r_edge_groups_buffer = groups_buffer;
   *r_edge_groups = wegroups;
+  *r_edge_groups_len = wgroups_len;
 }
 
 /** \} */
@@ -1451,7 +1468,8 @@ static void weld_mesh_context_create(const Mesh *mesh,
                          vert_dest_map,
                          vert_dest_map,
                          &r_weld_mesh->vert_groups_buffer,
-                         &r_weld_mesh->vert_groups);
+                         &r_weld_mesh->vert_groups,
+                         &r_weld_mesh->vert_groups_len);
 
   weld_edge_groups_setup(medge_len,
                          r_weld_mesh->edge_kill_len,
@@ -1460,7 +1478,8 @@ static void weld_mesh_context_create(const Mesh *mesh,
                          edge_ctx_map,
                          edge_dest_map,
                          &r_weld_mesh->edge_groups_buffer,
-                         &r_weld_mesh->edge_groups);
+                         &r_weld_mesh->edge_groups,
+                         &r_weld_mesh->edge_groups_len);
 
   r_weld_mesh->vert_groups_map = vert_dest_map;
   r_weld_mesh->edge_groups_map = edge_dest_map;
@@ -1627,6 +1646,96 @@ static void customdata_weld(
   }
 }
 
+typedef struct WeldGroupsInterpData {
+  const WeldMesh *weld_mesh;
+  const Mesh *mesh;
+  Mesh *result;
+  /* Index in the result of each group. */
+  const uint *group_dest;
+  const uint *vert_final;
+} WeldGroupsInterpData;
+
+static void weld_vert_groups_interp_task(void *__restrict userdata,
+                                         const int group_index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const WeldGroupsInterpData *data = userdata;
+  const WeldMesh *weld_mesh = data->weld_mesh;
+  const struct WeldGroup *wgroup = &weld_mesh->vert_groups[group_index];
+  customdata_weld(&data->mesh->vdata,
+                  &data->result->vdata,
+                  &weld_mesh->vert_groups_buffer[wgroup->ofs],
+                  wgroup->len,
+                  data->group_dest[group_index]);
+}
+
+static void weld_edge_groups_interp_task(void *__restrict userdata,
+                                         const int group_index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const WeldGroupsInterpData *data = userdata;
+  const WeldMesh *weld_mesh = data->weld_mesh;
+  const struct WeldGroupEdge *wegrp = &weld_mesh->edge_groups[group_index];
+  const uint dest_index = data->group_dest[group_index];
+  customdata_weld(&data->mesh->edata,
+                  &data->result->edata,
+                  &weld_mesh->edge_groups_buffer[wegrp->group.ofs],
+                  wegrp->group.len,
+                  dest_index);
+  MEdge *me = &data->result->medge[dest_index];
+  me->v1 = data->vert_final[wegrp->v1];
+  me->v2 = data->vert_final[wegrp->v2];
+  me->flag |= ME_LOOSEEDGE;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Weld Modifier Runtime
+ *
+ * The weld context only depends on the topology of the mesh and on the overlapping vertices,
+ * so it's kept between evaluations while those don't change, as for deforming meshes.
+ * \{ */
+
+typedef struct WeldRuntimeData {
+  ModMeshTopologyKey topology_key;
+  /** Overlapping vertices the context was created for, NULL when there is no context. */
+  BVHTreeOverlap *overlap;
+  uint overlap_len;
+  WeldMesh weld_mesh;
+} WeldRuntimeData;
+
+static const WeldMesh *weld_mesh_context_ensure(WeldModifierData *wmd,
+                                                const Mesh *mesh,
+                                                BVHTreeOverlap *overlap,
+                                                const uint overlap_len)
+{
+  WeldRuntimeData *runtime_data = (WeldRuntimeData *)wmd->modifier.runtime;
+  ModMeshTopologyKey topology_key;
+  MOD_mesh_topology_key_calc(mesh, &topology_key);
+
+  if (runtime_data == NULL) {
+    runtime_data = MEM_callocN(sizeof(*runtime_data), "weld runtime");
+    wmd->modifier.runtime = runtime_data;
+  }
+  else if (runtime_data->overlap != NULL) {
+    if (MOD_mesh_topology_key_equals(&runtime_data->topology_key, &topology_key) &&
+        runtime_data->overlap_len == overlap_len &&
+        memcmp(runtime_data->overlap, overlap, sizeof(*overlap) * overlap_len) == 0) {
+      return &runtime_data->weld_mesh;
+    }
+    MEM_freeN(runtime_data->overlap);
+    weld_mesh_context_free(&runtime_data->weld_mesh);
+    runtime_data->overlap = NULL;
+  }
+
+  weld_mesh_context_create(mesh, overlap, overlap_len, &runtime_data->weld_mesh);
+  runtime_data->topology_key = topology_key;
+  runtime_data->overlap = MEM_dupallocN(overlap);
+  runtime_data->overlap_len = overlap_len;
+  return &runtime_data->weld_mesh;
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -1725,8 +1834,7 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
   free_bvhtree_from_mesh(&treedata);
 
   if (overlap_len) {
-    WeldMesh weld_mesh;
-    weld_mesh_context_create(mesh, overlap, overlap_len, &weld_mesh);
+    const WeldMesh *weld_mesh = weld_mesh_context_ensure(wmd, mesh, overlap, overlap_len);
 
     mloop = mesh->mloop;
     mpoly = mesh->mpoly;
@@ -1735,17 +1843,19 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
     totloop = mesh->totloop;
     totpoly = mesh->totpoly;
 
-    const int result_nverts = totvert - weld_mesh.vert_kill_len;
-    const int result_nedges = totedge - weld_mesh.edge_kill_len;
-    const int result_nloops = totloop - weld_mesh.loop_kill_len;
-    const int result_npolys = totpoly - weld_mesh.poly_kill_len + weld_mesh.wpoly_new_len;
+    const int result_nverts = totvert - weld_mesh->vert_kill_len;
+    const int result_nedges = totedge - weld_mesh->edge_kill_len;
+    const int result_nloops = totloop - weld_mesh->loop_kill_len;
+    const int result_npolys = totpoly - weld_mesh->poly_kill_len + weld_mesh->wpoly_new_len;
 
     result = BKE_mesh_new_nomain_from_template(
         mesh, result_nverts, result_nedges, 0, result_nloops, result_npolys);
 
     /* Vertices */
 
-    uint *vert_final = weld_mesh.vert_groups_map;
+    uint *vert_final = MEM_dupallocN(weld_mesh->vert_groups_map);
+    const uint groups_len = MAX2(weld_mesh->vert_groups_len, weld_mesh->edge_groups_len);
+    uint *group_dest = MEM_malloc_arrayN(groups_len, sizeof(*group_dest), __func__);
     uint *index_iter = &vert_final[0];
     int dest_index = 0;
     for (i = 0; i < totvert; i++, index_iter++) {
@@ -1765,12 +1875,7 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
         break;
       }
       if (*index_iter != ELEM_MERGED) {
-        struct WeldGroup *wgroup = &weld_mesh.vert_groups[*index_iter];
-        customdata_weld(&mesh->vdata,
-                        &result->vdata,
-                        &weld_mesh.vert_groups_buffer[wgroup->ofs],
-                        wgroup->len,
-                        dest_index);
+        group_dest[*index_iter] = dest_index;
         *index_iter = dest_index;
         dest_index++;
       }
@@ -1778,9 +1883,24 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
 
     BLI_assert(dest_index == result_nverts);
 
+    /* Only the indices are assigned in order, the merged vertices are interpolated in parallel.
+     * Building the clusters with union-find stays serial. */
+    WeldGroupsInterpData interp_data = {
+        .weld_mesh = weld_mesh,
+        .mesh = mesh,
+        .result = result,
+        .group_dest = group_dest,
+        .vert_final = vert_final,
+    };
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (weld_mesh->vert_groups_len > 1024);
+    BLI_task_parallel_range(
+        0, weld_mesh->vert_groups_len, &interp_data, weld_vert_groups_interp_task, &settings);
+
     /* Edges */
 
-    uint *edge_final = weld_mesh.edge_groups_map;
+    uint *edge_final = MEM_dupallocN(weld_mesh->edge_groups_map);
     index_iter = &edge_final[0];
     dest_index = 0;
     for (i = 0; i < totedge; i++, index_iter++) {
@@ -1805,17 +1925,7 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
         break;
       }
       if (*index_iter != ELEM_MERGED) {
-        struct WeldGroupEdge *wegrp = &weld_mesh.edge_groups[*index_iter];
-        customdata_weld(&mesh->edata,
-                        &result->edata,
-                        &weld_mesh.edge_groups_buffer[wegrp->group.ofs],
-                        wegrp->group.len,
-                        dest_index);
-        MEdge *me = &result->medge[dest_index];
-        me->v1 = vert_final[wegrp->v1];
-        me->v2 = vert_final[wegrp->v2];
-        me->flag |= ME_LOOSEEDGE;
-
+        group_dest[*index_iter] = dest_index;
         *index_iter = dest_index;
         dest_index++;
       }
@@ -1823,6 +1933,11 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
 
     BLI_assert(dest_index == result_nedges);
 
+    settings.use_threading = (weld_mesh->edge_groups_len > 1024);
+    BLI_task_parallel_range(
+        0, weld_mesh->edge_groups_len, &interp_data, weld_edge_groups_interp_task, &settings);
+    MEM_freeN(group_dest);
+
     /* Polys/Loops */
 
     mp = &mpoly[0];
@@ -1830,10 +1945,10 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
     MLoop *r_ml = &result->mloop[0];
     uint r_i = 0;
     int loop_cur = 0;
-    uint *group_buffer = BLI_array_alloca(group_buffer, weld_mesh.max_poly_len);
+    uint *group_buffer = BLI_array_alloca(group_buffer, weld_mesh->max_poly_len);
     for (i = 0; i < totpoly; i++, mp++) {
       int loop_start = loop_cur;
-      uint poly_ctx = weld_mesh.poly_map[i];
+      uint poly_ctx = weld_mesh->poly_map[i];
       if (poly_ctx == OUT_OF_CONTEXT) {
         uint mp_loop_len = mp->totloop;
         CustomData_copy_data(&mesh->ldata, &result->ldata, mp->loopstart, loop_cur, mp_loop_len);
@@ -1844,10 +1959,10 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
         }
       }
       else {
-        WeldPoly *wp = &weld_mesh.wpoly[poly_ctx];
+        const WeldPoly *wp = &weld_mesh->wpoly[poly_ctx];
         WeldLoopOfPolyIter iter;
         if (!weld_iter_loop_of_poly_begin(
-                &iter, wp, weld_mesh.wloop, mloop, weld_mesh.loop_map, group_buffer)) {
+                &iter, wp, weld_mesh->wloop, mloop, weld_mesh->loop_map, group_buffer)) {
           continue;
         }
 
@@ -1876,12 +1991,12 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
       r_i++;
     }
 
-    WeldPoly *wp = &weld_mesh.wpoly_new[0];
-    for (i = 0; i < weld_mesh.wpoly_new_len; i++, wp++) {
+    const WeldPoly *wp = &weld_mesh->wpoly_new[0];
+    for (i = 0; i < weld_mesh->wpoly_new_len; i++, wp++) {
       int loop_start = loop_cur;
       WeldLoopOfPolyIter iter;
       if (!weld_iter_loop_of_poly_begin(
-              &iter, wp, weld_mesh.wloop, mloop, weld_mesh.loop_map, group_buffer)) {
+              &iter, wp, weld_mesh->wloop, mloop, weld_mesh->loop_map, group_buffer)) {
         continue;
       }
 
@@ -1915,13 +2030,33 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
     /* recalculate normals */
     result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
 
-    weld_mesh_context_free(&weld_mesh);
+    MEM_freeN(vert_final);
+    MEM_freeN(edge_final);
   }
 
   MEM_freeN(overlap);
   return result;
 }
 
+static void freeRuntimeData(void *runtime_data_v)
+{
+  if (runtime_data_v == NULL) {
+    return;
+  }
+  WeldRuntimeData *runtime_data = (WeldRuntimeData *)runtime_data_v;
+  if (runtime_data->overlap != NULL) {
+    MEM_freeN(runtime_data->overlap);
+    weld_mesh_context_free(&runtime_data->weld_mesh);
+  }
+  MEM_freeN(runtime_data);
+}
+
+static void freeData(ModifierData *md)
+{
+  freeRuntimeData(md->runtime);
+  md->runtime = NULL;
+}
+
 static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *ctx, Mesh *mesh)
 {
   WeldModifierData *wmd = (WeldModifierData *)md;
@@ -1993,7 +2128,7 @@ ModifierTypeInfo modifierType_Weld = {
 
     /* initData */ initData,
     /* requiredDataMask */ requiredDataMask,
-    /* freeData */ NULL,
+    /* freeData */ freeData,
     /* isDisabled */ NULL,
     /* updateDepsgraph */ NULL,
     /* dependsOnTime */ NULL,
@@ -2001,7 +2136,7 @@ ModifierTypeInfo modifierType_Weld = {
     /* foreachObjectLink */ NULL,
     /* foreachIDLink */ NULL,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
     /* panelRegister */ panelRegister,
     /* blendWrite */ NULL,
     /* blendRead */ NULL,
@@ -0,0 +1,126 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math_vector.h"
+#include "BLI_threads.h"
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_modifier.h"
+
+namespace blender::modifiers::tests {
+
+/* Two triangles, the second one shares the position of two vertices of the first. */
+static Mesh *triangles_mesh_create(const int polys_len)
+{
+  const float co[6][3] = {{0.0f, 0.0f, 0.0f},
+                          {1.0f, 0.0f, 0.0f},
+                          {0.0f, 1.0f, 0.0f},
+                          {1.0f, 0.0f, 0.0f},
+                          {0.0f, 1.0f, 0.0f},
+                          {1.0f, 1.0f, 0.0f}};
+  const int tris[2][3] = {{0, 1, 2}, {3, 5, 4}};
+
+  Mesh *mesh = BKE_mesh_new_nomain(6, 0, 0, polys_len * 3, polys_len);
+  for (int i = 0; i < 6; i++) {
+    copy_v3_v3(mesh->mvert[i].co, co[i]);
+  }
+  for (int i = 0; i < polys_len; i++) {
+    mesh->mpoly[i].loopstart = i * 3;
+    mesh->mpoly[i].totloop = 3;
+    for (int j = 0; j < 3; j++) {
+      mesh->mloop[i * 3 + j].v = tris[i][j];
+    }
+  }
+  BKE_mesh_calc_edges(mesh, false, false);
+  return mesh;
+}
+
+class WeldModifierTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+    BKE_idtype_init();
+    BKE_modifier_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BLI_threadapi_exit();
+  }
+
+ protected:
+  Object *ob;
+  ModifierData *md;
+
+  void SetUp() override
+  {
+    ob = static_cast<Object *>(BKE_id_new_nomain(ID_OB, "Object"));
+    ob->type = OB_MESH;
+    md = BKE_modifier_new(eModifierType_Weld);
+    BLI_addtail(&ob->modifiers, md);
+  }
+
+  void TearDown() override
+  {
+    BKE_id_free(nullptr, ob);
+  }
+
+  void expect_weld(Mesh *mesh, const int totvert, const int totedge, const int totpoly)
+  {
+    const ModifierTypeInfo *mti = BKE_modifier_get_info(eModifierType_Weld);
+    ModifierEvalContext ctx = {nullptr, ob, ModifierApplyFlag(0)};
+    Mesh *result = mti->modifyMesh(md, &ctx, mesh);
+    ASSERT_NE(result, mesh);
+    EXPECT_EQ(result->totvert, totvert);
+    EXPECT_EQ(result->totedge, totedge);
+    EXPECT_EQ(result->totpoly, totpoly);
+    for (int i = 0; i < result->totedge; i++) {
+      EXPECT_LT(result->medge[i].v1, totvert);
+      EXPECT_LT(result->medge[i].v2, totvert);
+    }
+    for (int i = 0; i < result->totloop; i++) {
+      EXPECT_LT(result->mloop[i].v, totvert);
+      EXPECT_LT(result->mloop[i].e, totedge);
+    }
+    BKE_id_free(nullptr, result);
+  }
+};
+
+TEST_F(WeldModifierTest, ReuseAfterTopologyChange)
+{
+  Mesh *mesh_a = triangles_mesh_create(2);
+  Mesh *mesh_b = triangles_mesh_create(1);
+
+  expect_weld(mesh_a, 4, 5, 2);
+  EXPECT_NE(md->runtime, nullptr);
+  expect_weld(mesh_a, 4, 5, 2);
+
+  /* The overlapping vertices are the same, only the faces changed. */
+  expect_weld(mesh_b, 4, 3, 1);
+  expect_weld(mesh_a, 4, 5, 2);
+
+  /* Moving a vertex that doesn't overlap keeps the context. */
+  mesh_a->mvert[5].co[0] = 2.0f;
+  expect_weld(mesh_a, 4, 5, 2);
+
+  /* Moving an overlapping vertex away. */
+  mesh_a->mvert[3].co[0] = 3.0f;
+  expect_weld(mesh_a, 5, 6, 2);
+
+  BKE_id_free(nullptr, mesh_a);
+  BKE_id_free(nullptr, mesh_b);
+}
+
+}  // namespace blender::modifiers::tests
@@ -43,7 +43,9 @@
 
 /* modules */
 #include "bpy_app_icons.h"
+#include "bpy_app_memory_profile.h"
 #include "bpy_app_timers.h"
+#include "bpy_app_trace.h"
 
 #include "BLI_utildefines.h"
 
@@ -121,7 +123,9 @@ static PyStructSequence_Field app_info_fields[] = {
 
     /* Modules (not struct sequence). */
     {"icons", "Manage custom icons"},
+    {"memory_profile", "Sampling memory allocation profiler"},
     {"timers", "Manage timers"},
+    {"trace", "Performance trace recording"},
     {NULL},
 };
 
@@ -135,7 +139,9 @@ PyDoc_STRVAR(bpy_app_doc,
              "\n"
              "   bpy.app.handlers.rst\n"
              "   bpy.app.icons.rst\n"
+             "   bpy.app.memory_profile.rst\n"
              "   bpy.app.timers.rst\n"
+             "   bpy.app.trace.rst\n"
              "   bpy.app.translations.rst\n");
 
 static PyStructSequence_Desc app_info_desc = {
@@ -215,7 +221,9 @@ static PyObject *make_app_info(void)
 
   /* modules */
   SetObjItem(BPY_app_icons_module());
+  SetObjItem(BPY_app_memory_profile_module());
   SetObjItem(BPY_app_timers_module());
+  SetObjItem(BPY_app_trace_module());
 
 #undef SetIntItem
 #undef SetStrItem
@@ -0,0 +1,171 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+/** \file
+ * \ingroup pythonintern
+ *
+ * Sampling allocation profiler access.
+ */
+
+#include <Python.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+
+#include "../generic/py_capi_utils.h"
+
+#include "bpy_app_memory_profile.h"
+
+#define SAMPLE_INTERVAL_DEFAULT (512 * 1024)
+
+PyDoc_STRVAR(bpy_app_memory_profile_start_doc,
+             ".. function:: start(sample_interval=524288)"
+             "\n"
+             "   Start sampling memory allocations, this has a low enough overhead to keep it\n"
+             "   running. Statistics from earlier runs are kept.\n"
+             "\n"
+             "   :arg sample_interval: Average number of bytes allocated between samples.\n"
+             "   :type sample_interval: int\n");
+static PyObject *bpy_app_memory_profile_start(PyObject *UNUSED(self),
+                                              PyObject *args,
+                                              PyObject *kw)
+{
+  Py_ssize_t sample_interval = SAMPLE_INTERVAL_DEFAULT;
+  static const char *_keywords[] = {"sample_interval", NULL};
+  static _PyArg_Parser _parser = {"|n:start", _keywords, 0};
+  if (!_PyArg_ParseTupleAndKeywordsFast(args, kw, &_parser, &sample_interval)) {
+    return NULL;
+  }
+  if (sample_interval < 1) {
+    PyErr_SetString(PyExc_ValueError, "sample_interval must be positive");
+    return NULL;
+  }
+
+  MEM_profile_start((size_t)sample_interval);
+  Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(bpy_app_memory_profile_stop_doc,
+             ".. function:: stop()"
+             "\n"
+             "   Stop sampling memory allocations, the statistics are kept.\n");
+static PyObject *bpy_app_memory_profile_stop(PyObject *UNUSED(self))
+{
+  MEM_profile_stop();
+  Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(bpy_app_memory_profile_is_running_doc,
+             ".. function:: is_running()"
+             "\n"
+             "   :return: True when memory allocations are being sampled.\n"
+             "   :rtype: bool\n");
+static PyObject *bpy_app_memory_profile_is_running(PyObject *UNUSED(self))
+{
+  return PyBool_FromLong(MEM_profile_is_running());
+}
+
+PyDoc_STRVAR(bpy_app_memory_profile_to_json_doc,
+             ".. function:: to_json()"
+             "\n"
+             "   Estimated memory in use, peak and total allocations per allocation name,\n"
+             "   both over all threads and per allocating thread.\n"
+             "\n"
+             "   :return: The statistics as JSON.\n"
+             "   :rtype: str\n");
+static PyObject *bpy_app_memory_profile_to_json(PyObject *UNUSED(self))
+{
+  char *json = MEM_profile_json();
+  if (json == NULL) {
+    PyErr_SetString(PyExc_MemoryError, "failed to create memory profile");
+    return NULL;
+  }
+  PyObject *result = PyC_UnicodeFromByte(json);
+  MEM_freeN(json);
+  return result;
+}
+
+PyDoc_STRVAR(bpy_app_memory_profile_write_doc,
+             ".. function:: write(filepath)"
+             "\n"
+             "   Write the statistics as JSON, see :func:`to_json`.\n"
+             "\n"
+             "   :arg filepath: File to write to.\n"
+             "   :type filepath: str\n");
+static PyObject *bpy_app_memory_profile_write(PyObject *UNUSED(self), PyObject *args, PyObject *kw)
+{
+  const char *filepath;
+  static const char *_keywords[] = {"filepath", NULL};
+  static _PyArg_Parser _parser = {"s:write", _keywords, 0};
+  if (!_PyArg_ParseTupleAndKeywordsFast(args, kw, &_parser, &filepath)) {
+    return NULL;
+  }
+
+  if (!MEM_profile_write_json(filepath)) {
+    PyErr_Format(PyExc_IOError, "failed to write memory profile to \"%s\"", filepath);
+    return NULL;
+  }
+  Py_RETURN_NONE;
+}
+
+static struct PyMethodDef M_AppMemoryProfile_methods[] = {
+    {"start",
+     (PyCFunction)bpy_app_memory_profile_start,
+     METH_VARARGS | METH_KEYWORDS,
+     bpy_app_memory_profile_start_doc},
+    {"stop",
+     (PyCFunction)bpy_app_memory_profile_stop,
+     METH_NOARGS,
+     bpy_app_memory_profile_stop_doc},
+    {"is_running",
+     (PyCFunction)bpy_app_memory_profile_is_running,
+     METH_NOARGS,
+     bpy_app_memory_profile_is_running_doc},
+    {"to_json",
+     (PyCFunction)bpy_app_memory_profile_to_json,
+     METH_NOARGS,
+     bpy_app_memory_profile_to_json_doc},
+    {"write",
+     (PyCFunction)bpy_app_memory_profile_write,
+     METH_VARARGS | METH_KEYWORDS,
+     bpy_app_memory_profile_write_doc},
+    {NULL, NULL, 0, NULL},
+};
+
+static struct PyModuleDef M_AppMemoryProfile_module_def = {
+    PyModuleDef_HEAD_INIT,
+    "bpy.app.memory_profile",   /* m_name */
+    NULL,                       /* m_doc */
+    0,                          /* m_size */
+    M_AppMemoryProfile_methods, /* m_methods */
+    NULL,                       /* m_reload */
+    NULL,                       /* m_traverse */
+    NULL,                       /* m_clear */
+    NULL,                       /* m_free */
+};
+
+PyObject *BPY_app_memory_profile_module(void)
+{
+  PyObject *sys_modules = PyImport_GetModuleDict();
+
+  PyObject *mod = PyModule_Create(&M_AppMemoryProfile_module_def);
+
+  PyDict_SetItem(sys_modules, PyModule_GetNameObject(mod), mod);
+
+  return mod;
+}
@@ -0,0 +1,152 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup pythonintern
+ *
+ * Performance trace recording access.
+ */
+
+#include <Python.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_trace.h"
+#include "BLI_utildefines.h"
+
+#include "../generic/py_capi_utils.h"
+
+#include "bpy_app_trace.h"
+
+PyDoc_STRVAR(bpy_app_trace_start_doc,
+             ".. function:: start()"
+             "\n"
+             "   Start recording the time spent in zones of the code on all threads,\n"
+             "   such as depsgraph operations, modifiers and file reading.\n"
+             "   Zones recorded earlier are kept, older zones are overwritten per thread.\n");
+static PyObject *bpy_app_trace_start(PyObject *UNUSED(self))
+{
+  BLI_trace_start();
+  Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(bpy_app_trace_stop_doc,
+             ".. function:: stop()"
+             "\n"
+             "   Stop recording zones, the recorded zones are kept.\n");
+static PyObject *bpy_app_trace_stop(PyObject *UNUSED(self))
+{
+  BLI_trace_stop();
+  Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(bpy_app_trace_is_running_doc,
+             ".. function:: is_running()"
+             "\n"
+             "   :return: True when zones are being recorded.\n"
+             "   :rtype: bool\n");
+static PyObject *bpy_app_trace_is_running(PyObject *UNUSED(self))
+{
+  return PyBool_FromLong(BLI_trace_is_running());
+}
+
+PyDoc_STRVAR(bpy_app_trace_clear_doc,
+             ".. function:: clear()"
+             "\n"
+             "   Remove all recorded zones.\n");
+static PyObject *bpy_app_trace_clear(PyObject *UNUSED(self))
+{
+  BLI_trace_clear();
+  Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(bpy_app_trace_to_json_doc,
+             ".. function:: to_json()"
+             "\n"
+             "   The recorded zones in the Chrome trace event format,\n"
+             "   which can be viewed with ``chrome://tracing`` or Perfetto.\n"
+             "\n"
+             "   :return: The recorded zones as JSON.\n"
+             "   :rtype: str\n");
+static PyObject *bpy_app_trace_to_json(PyObject *UNUSED(self))
+{
+  char *json = BLI_trace_json();
+  PyObject *result = PyC_UnicodeFromByte(json);
+  MEM_freeN(json);
+  return result;
+}
+
+PyDoc_STRVAR(bpy_app_trace_write_doc,
+             ".. function:: write(filepath)"
+             "\n"
+             "   Write the recorded zones as JSON, see :func:`to_json`.\n"
+             "\n"
+             "   :arg filepath: File to write to.\n"
+             "   :type filepath: str\n");
+static PyObject *bpy_app_trace_write(PyObject *UNUSED(self), PyObject *args, PyObject *kw)
+{
+  const char *filepath;
+  static const char *_keywords[] = {"filepath", NULL};
+  static _PyArg_Parser _parser = {"s:write", _keywords, 0};
+  if (!_PyArg_ParseTupleAndKeywordsFast(args, kw, &_parser, &filepath)) {
+    return NULL;
+  }
+
+  if (!BLI_trace_write_json(filepath)) {
+    PyErr_Format(PyExc_IOError, "failed to write trace to \"%s\"", filepath);
+    return NULL;
+  }
+  Py_RETURN_NONE;
+}
+
+static struct PyMethodDef M_AppTrace_methods[] = {
+    {"start", (PyCFunction)bpy_app_trace_start, METH_NOARGS, bpy_app_trace_start_doc},
+    {"stop", (PyCFunction)bpy_app_trace_stop, METH_NOARGS, bpy_app_trace_stop_doc},
+    {"is_running",
+     (PyCFunction)bpy_app_trace_is_running,
+     METH_NOARGS,
+     bpy_app_trace_is_running_doc},
+    {"clear", (PyCFunction)bpy_app_trace_clear, METH_NOARGS, bpy_app_trace_clear_doc},
+    {"to_json", (PyCFunction)bpy_app_trace_to_json, METH_NOARGS, bpy_app_trace_to_json_doc},
+    {"write",
+     (PyCFunction)bpy_app_trace_write,
+     METH_VARARGS | METH_KEYWORDS,
+     bpy_app_trace_write_doc},
+    {NULL, NULL, 0, NULL},
+};
+
+static struct PyModuleDef M_AppTrace_module_def = {
+    PyModuleDef_HEAD_INIT,
+    "bpy.app.trace",    /* m_name */
+    NULL,               /* m_doc */
+    0,                  /* m_size */
+    M_AppTrace_methods, /* m_methods */
+    NULL,               /* m_reload */
+    NULL,               /* m_traverse */
+    NULL,               /* m_clear */
+    NULL,               /* m_free */
+};
+
+PyObject *BPY_app_trace_module(void)
+{
+  PyObject *sys_modules = PyImport_GetModuleDict();
+
+  PyObject *mod = PyModule_Create(&M_AppTrace_module_def);
+
+  PyDict_SetItem(sys_modules, PyModule_GetNameObject(mod), mod);
+
+  return mod;
+}
@@ -293,6 +293,10 @@ int main(int argc,
         MEM_use_guarded_allocator();
         break;
       }
+      else if (STREQ(argv[i], "--memory-thread-cache")) {
+        MEM_use_thread_cached_allocator();
+        /* Keep looking, the guarded allocator takes precedence. */
+      }
       else if (STREQ(argv[i], "--")) {
         break;
       }
@@ -41,6 +41,7 @@
 #  include "BLI_string_utf8.h"
 #  include "BLI_system.h"
 #  include "BLI_threads.h"
+#  include "BLI_trace.h"
 #  include "BLI_utildefines.h"
 
 #  include "BLO_readfile.h" /* only for BLO_has_bfile_extension */
@@ -598,6 +599,7 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
   BLI_argsPrintArgDoc(ba, "--debug-depsgraph-no-threads");
   BLI_argsPrintArgDoc(ba, "--debug-depsgraph-time");
   BLI_argsPrintArgDoc(ba, "--debug-depsgraph-pretty");
+  BLI_argsPrintArgDoc(ba, "--debug-trace");
   BLI_argsPrintArgDoc(ba, "--debug-gpu");
   BLI_argsPrintArgDoc(ba, "--debug-gpumem");
   BLI_argsPrintArgDoc(ba, "--debug-gpu-shaders");
@@ -620,6 +622,8 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
   BLI_argsPrintArgDoc(ba, "--app-template");
   BLI_argsPrintArgDoc(ba, "--factory-startup");
   BLI_argsPrintArgDoc(ba, "--enable-event-simulate");
+  BLI_argsPrintArgDoc(ba, "--memory-thread-cache");
+  BLI_argsPrintArgDoc(ba, "--memory-profile");
   printf("\n");
   BLI_argsPrintArgDoc(ba, "--env-system-datafiles");
   BLI_argsPrintArgDoc(ba, "--env-system-scripts");
@@ -1100,6 +1104,22 @@ static int arg_handle_debug_value_set(int argc, const char **argv, void *UNUSED(
   }
 }
 
+static const char arg_handle_debug_trace_set_doc[] =
+    "<filepath>\n"
+    "\tRecord the time spent in depsgraph operations, modifiers, draw cache extraction,\n"
+    "\tfile I/O and task pools, and write it as Chrome trace JSON on exit.";
+static int arg_handle_debug_trace_set(int argc, const char **argv, void *UNUSED(data))
+{
+  const char *arg_id = "--debug-trace";
+  if (argc > 1) {
+    BLI_trace_start();
+    BLI_trace_write_json_at_exit(argv[1]);
+    return 1;
+  }
+  printf("\nError: you must specify a filepath after '%s'.\n", arg_id);
+  return 0;
+}
+
 static const char arg_handle_debug_fpe_set_doc[] =
     "\n\t"
     "Enable floating point exceptions.";
@@ -1139,6 +1159,32 @@ static int arg_handle_factory_startup_set(int UNUSED(argc),
   return 0;
 }
 
+static const char arg_handle_memory_thread_cache_set_doc[] =
+    "\n\t"
+    "Cache small memory allocations per thread, for less contention between threads.";
+static int arg_handle_memory_thread_cache_set(int UNUSED(argc),
+                                              const char **UNUSED(argv),
+                                              void *UNUSED(data))
+{
+  /* Handled in main(), before any allocation happened. */
+  return 0;
+}
+
+static const char arg_handle_memory_profile_set_doc[] =
+    "<filepath>\n"
+    "\tSample memory allocations and write statistics per allocation name as JSON on exit.";
+static int arg_handle_memory_profile_set(int argc, const char **argv, void *UNUSED(data))
+{
+  const char *arg_id = "--memory-profile";
+  if (argc > 1) {
+    MEM_profile_start(512 * 1024);
+    MEM_profile_write_json_at_exit(argv[1]);
+    return 1;
+  }
+  printf("\nError: you must specify a filepath after '%s'.\n", arg_id);
+  return 0;
+}
+
 static const char arg_handle_enable_event_simulate_doc[] =
     "\n\t"
     "Enable event simulation testing feature 'bpy.types.Window.event_simulate'.";
@@ -2233,6 +2279,7 @@ void main_args_setup(bContext *C, bArgs *ba)
               "--debug-gpu-force-workarounds",
               CB_EX(arg_handle_debug_mode_generic_set, gpumem),
               (void *)G_DEBUG_GPU_FORCE_WORKAROUNDS);
+  BLI_argsAdd(ba, 1, NULL, "--debug-trace", CB(arg_handle_debug_trace_set), NULL);
   BLI_argsAdd(ba, 1, NULL, "--debug-exit-on-error", CB(arg_handle_debug_exit_on_error), NULL);
 
   BLI_argsAdd(ba, 1, NULL, "--verbose", CB(arg_handle_verbosity_set), NULL);
@@ -2240,6 +2287,9 @@ void main_args_setup(bContext *C, bArgs *ba)
   BLI_argsAdd(ba, 1, NULL, "--app-template", CB(arg_handle_app_template), NULL);
   BLI_argsAdd(ba, 1, NULL, "--factory-startup", CB(arg_handle_factory_startup_set), NULL);
   BLI_argsAdd(ba, 1, NULL, "--enable-event-simulate", CB(arg_handle_enable_event_simulate), NULL);
+  BLI_argsAdd(
+      ba, 1, NULL, "--memory-thread-cache", CB(arg_handle_memory_thread_cache_set), NULL);
+  BLI_argsAdd(ba, 1, NULL, "--memory-profile", CB(arg_handle_memory_profile_set), NULL);
 
   /* TODO, add user env vars? */
   BLI_argsAdd(